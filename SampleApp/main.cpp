@@ -112,6 +112,17 @@ void PrintDevices(const std::vector<DesktopMonitor>& desktopMonitors, const std:
     std::wcout << output << endl;
 }
 
+// A captured sample on its way to the encoder, without one the stream has a gap
+struct EncodeFrame
+{
+    winrt::com_ptr<IMFSample> Sample;
+    std::chrono::high_resolution_clock::time_point CaptureTime;
+
+    // The last gap submitted before the sample. The queue may have dropped it,
+    // then it is signaled before the sample is written.
+    std::chrono::high_resolution_clock::time_point GapBefore{};
+};
+
 void SetupPipelineThread(std::shared_ptr<std::atomic_bool> stop, std::shared_ptr<std::atomic<HRESULT>> threadHResult)
 {
     (void)SetThreadDescription(GetCurrentThread(), L"RecordingThread");
@@ -179,20 +190,52 @@ void PipelineThread(
     }
 
     std::vector<DesktopMonitor> desktopMonitors = virtualDesktop->DesktopMonitors();
-    std::shared_ptr<DesktopPointer> desktopPointer = std::make_shared<DesktopPointer>(virtualDesktop->VirtualDesktopBounds());
-    std::shared_ptr<ScreenDuplicator> duplicator = std::make_shared<ScreenDuplicator>(
-        desktopMonitors[monitorIndex],
-        desktopPointer
-    );
-    
-    RECT bounds = virtualDesktop->VirtualDesktopBounds();
-    LONG width = bounds.right - bounds.left;
-    LONG height = bounds.bottom - bounds.top;
-    std::shared_ptr<SharedSurface> sharedSurface = std::make_shared<SharedSurface>(
-        duplicator->Device(),
-        width,
-        height
-    );
+
+    // optionally record every monitor, each captured on its own thread
+    const bool allMonitors = settings.HasKey(L"allMonitors") && settings.Lookup(L"allMonitors").GetBoolean();
+    const bool pointerTrack = settings.HasKey(L"pointerTrack") && settings.Lookup(L"pointerTrack").GetBoolean();
+
+    // the pointer track is written by the single monitor pipeline only
+    if (allMonitors && pointerTrack)
+    {
+        std::wcerr << L"pointerTrack cannot be combined with allMonitors" << endl;
+        threadHResult->store(E_INVALIDARG);
+        stop->store(true);
+        return;
+    }
+
+    std::shared_ptr<ScreenDuplicator> duplicator;
+    std::shared_ptr<SharedSurface> sharedSurface;
+    std::unique_ptr<MultiMonitorCapture> monitorsCapture;
+    winrt::com_ptr<ID3D11Device> device;
+    if (allMonitors)
+    {
+        monitorsCapture = std::make_unique<MultiMonitorCapture>(
+            desktopMonitors,
+            desktopMonitors[monitorIndex].Adapter().Device(),
+            virtualDesktop->VirtualDesktopBounds()
+        );
+        device = monitorsCapture->Device();
+    }
+    else
+    {
+        std::shared_ptr<DesktopPointer> desktopPointer = std::make_shared<DesktopPointer>(virtualDesktop->VirtualDesktopBounds());
+        duplicator = std::make_shared<ScreenDuplicator>(
+            desktopMonitors[monitorIndex],
+            desktopPointer
+        );
+
+        RECT bounds = virtualDesktop->VirtualDesktopBounds();
+        LONG width = bounds.right - bounds.left;
+        LONG height = bounds.bottom - bounds.top;
+        sharedSurface = std::make_shared<SharedSurface>(
+            duplicator->Device(),
+            width,
+            height
+        );
+        device = duplicator->Device();
+    }
+
     std::unique_ptr<ScreenMediaSinkWriter> writer;
     {
         std::wstring fileNameW{ fileName };
@@ -204,7 +247,7 @@ void PipelineThread(
         encodingContext.bitRate = bitRate;
         encodingContext.videoInputMediaType = videoMediaType;
         encodingContext.audioInputMediaType = audioMediaType;
-        encodingContext.device = duplicator->Device();
+        encodingContext.device = device;
 
         writer = std::make_unique<ScreenMediaSinkWriter>(encodingContext);
     }
@@ -233,6 +276,12 @@ void PipelineThread(
 
     writer->Begin();
 
+    // pointer times are performance counter values, the track starts with the video
+    LARGE_INTEGER counterFrequency;
+    LARGE_INTEGER videoStartTime;
+    QueryPerformanceFrequency(&counterFrequency);
+    QueryPerformanceCounter(&videoStartTime);
+
     if (audioReader)
     {
         audioReader->Start();
@@ -241,25 +290,152 @@ void PipelineThread(
     // Enable away mode and prevent display and system idle timeouts
     (void)SetThreadExecutionState(ES_DISPLAY_REQUIRED | ES_SYSTEM_REQUIRED | ES_AWAYMODE_REQUIRED | ES_CONTINUOUS);
 
-    std::unique_ptr<Pipeline> duplicationPipeline = std::make_unique<Pipeline>(
-        duplicator,
-        sharedSurface,
-        virtualDesktop->VirtualDesktopBounds()
-    );
+    std::unique_ptr<Pipeline> duplicationPipeline;
+    if (!allMonitors)
+    {
+        duplicationPipeline = std::make_unique<Pipeline>(
+            duplicator,
+            sharedSurface,
+            virtualDesktop->VirtualDesktopBounds()
+        );
+    }
+
+    // optionally leave the cursor out of the video and record it next to it
+    if (pointerTrack)
+    {
+        duplicationPipeline->PointerTrack(std::make_shared<PointerTrackWriter>(
+            std::wstring{ fileName } + L".pointer",
+            counterFrequency.QuadPart,
+            videoStartTime.QuadPart));
+    }
+
+    // Ticks come on absolute deadlines. Between ticks capture waits for the desktop
+    // to change instead of sleeping, the sample captured closest to the tick is
+    // written and the others go back to the texture pool.
+    FramePacerOptions pacing;
+    pacing.FrameRate = static_cast<uint32_t>(frameRate);
+    FramePacer pacer{ std::make_shared<SteadyPacerClock>(), pacing };
+    ClosestFrame<EncodeFrame> closestSample;
+    closestSample.Reset(pacer.NextDeadline());
+
+    // Submit to the encoder on its own thread so a slow submit does not hold up
+    // capturing, when it falls behind the oldest waiting frame is dropped. Gaps
+    // share the queue, every sample carries the last gap before it so a dropped
+    // gap still reaches the writer ahead of the next sample.
+    StagedExecutor<EncodeFrame> encoder;
+    StageOptions encodeQueue;
+    encodeQueue.QueueCapacity = 2;
+    encodeQueue.Overflow = StageOverflow::DropOldest;
+    std::chrono::high_resolution_clock::time_point submittedGap{};
+    std::chrono::high_resolution_clock::time_point signaledGap{};
+    encoder.AddStage("encode", [&writer, &stop, &threadHResult, &signaledGap](EncodeFrame& frame)
+    {
+        try
+        {
+            if (frame.Sample == nullptr)
+            {
+                writer->SignalGap(frame.CaptureTime);
+                signaledGap = frame.CaptureTime;
+                return true;
+            }
+
+            if (frame.GapBefore > signaledGap)
+            {
+                writer->SignalGap(frame.GapBefore);
+                signaledGap = frame.GapBefore;
+            }
+
+            frame.Sample->SetGUID(MF_MT_MAJOR_TYPE, MFMediaType_Video);
+            writer->WriteSample(frame.Sample.get(), frame.CaptureTime);
+            return true;
+        }
+        catch (...)
+        {
+            threadHResult->store(winrt::to_hresult());
+            stop->store(true);
+            return false;
+        }
+    }, encodeQueue);
+    encoder.Start();
+
+    if (monitorsCapture)
+    {
+        monitorsCapture->Start();
+    }
+
+    // Only changed frames are composed and encoded. A tick without one signals a gap
+    // in the stream once, and the unchanged desktop is written again every second
+    // so players seeking into a static stretch find a frame nearby.
+    KeepAliveTimer keepAlive;
 
     while (!stop->load())
     {
         try
         {
-            duplicationPipeline->Perform();
-            winrt::com_ptr<IMFSample> sample = duplicationPipeline->Sample();
+            EncodeFrame frame;
+            bool changed = false;
+            if (monitorsCapture)
+            {
+                // the monitors are captured on their own threads, compose what they drew at every tick
+                pacer.WaitForTick();
+                monitorsCapture->Perform();
+                frame = EncodeFrame{ monitorsCapture->Sample(), std::chrono::high_resolution_clock::now() };
+                changed = frame.Sample != nullptr;
+            }
+            else
+            {
+                const auto captureTimeout = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    pacer.UntilNextTick() - pacing.SpinThreshold);
+                if (captureTimeout.count() > 0)
+                {
+                    duplicationPipeline->AcquireTimeout(captureTimeout);
+                    duplicationPipeline->Perform();
+                    winrt::com_ptr<IMFSample> sample = duplicationPipeline->Sample();
+                    if (sample)
+                    {
+                        closestSample.Offer(pacer.Clock().Now(), EncodeFrame{ sample, std::chrono::high_resolution_clock::now() });
+                    }
+                    continue;
+                }
+
+                pacer.WaitForTick();
+                changed = closestSample.Take(frame);
+                closestSample.Reset(pacer.NextDeadline());
+            }
 
-            if (duplicationPipeline->Sample())
+            if (!changed)
             {
-                sample->SetGUID(MF_MT_MAJOR_TYPE, MFMediaType_Video);
-                writer->WriteSample(sample.get());
+                switch (keepAlive.Idle(pacer.Clock().Now()))
+                {
+                case IdleTick::KeepAlive:
+                    if (monitorsCapture)
+                    {
+                        monitorsCapture->KeepAlive();
+                        frame.Sample = monitorsCapture->Sample();
+                    }
+                    else
+                    {
+                        duplicationPipeline->KeepAlive();
+                        frame.Sample = duplicationPipeline->Sample();
+                    }
+                    frame.CaptureTime = std::chrono::high_resolution_clock::now();
+                    break;
+                case IdleTick::SignalGap:
+                    submittedGap = std::chrono::high_resolution_clock::now();
+                    encoder.Submit(EncodeFrame{ nullptr, submittedGap });
+                    break;
+                case IdleTick::Nothing:
+                default:
+                    break;
+                }
+            }
+
+            if (frame.Sample)
+            {
+                keepAlive.Written(pacer.Clock().Now());
+                frame.GapBefore = submittedGap;
+                encoder.Submit(std::move(frame));
             }
-            Sleep(1000 / frameRate);
         }
         catch (...)
         {
@@ -267,6 +443,10 @@ void PipelineThread(
             stop->store(true);
         }
     }
+    // write what is still queued
+    encoder.Stop();
+    monitorsCapture.reset();
+
     // Disable away mode
     (void)SetThreadExecutionState(ES_CONTINUOUS);
 
@@ -285,7 +465,7 @@ void PipelineThread(
         desktopMonitors.clear();
 
         {
-            auto device = duplicator->Device();
+            duplicationPipeline.reset();
             duplicator.reset();
 
             winrt::com_ptr<ID3D11DeviceContext> context;
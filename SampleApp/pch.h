@@ -54,6 +54,9 @@
 
 #include "VideoLibrary\VirtualDesktop.h"
 #include "VideoLibrary\Pipeline.h"
+#include "VideoLibrary\MultiMonitorCapture.h"
+#include "VideoLibrary\FramePacer.h"
+#include "VideoLibrary\StagedExecutor.h"
 #include "VideoLibrary\AsyncMediaSourceReader.h"
 #include "VideoLibrary\ScreenMediaSinkWriter.h"
 #include "VideoLibrary\AudioMedia.h"
@@ -0,0 +1,377 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "MpmcQueue.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+// What Acquire does when HighWatermark items are already handed out
+enum class PoolExhaustedPolicy
+{
+    // wait up to BlockTimeout for an item to come back, then drop
+    Block,
+
+    // fail right away, the caller skips the frame
+    Drop,
+
+    // hand out the item that has been out the longest again, overwriting it
+    ReuseOldest
+};
+
+struct BoundedPoolOptions
+{
+    // Items created up front
+    size_t LowWatermark = 2;
+
+    // Items never outnumber this
+    size_t HighWatermark = 8;
+
+    PoolExhaustedPolicy Policy = PoolExhaustedPolicy::Drop;
+
+    std::chrono::milliseconds BlockTimeout{ 100 };
+};
+
+struct BoundedPoolStats
+{
+    size_t Outstanding;
+    size_t Free;
+
+    // Most items handed out at once
+    size_t PeakDepth;
+
+    uint64_t Allocations;
+    uint64_t Drops;
+    uint64_t Reuses;
+
+    // Acquires that blocked, and how long they blocked in total
+    uint64_t Waits;
+    std::chrono::nanoseconds WaitTime;
+};
+
+/*
+    Recycles expensive items, such as full desktop textures, between a producer and a
+    consumer that returns them asynchronously, without growing when the consumer falls
+    behind. Items are created by the factory up to the high watermark and after that
+    the policy decides between waiting, dropping and reusing.
+
+    Items live in a fixed table and the free list is a lock-free queue of their indices,
+    so recycling takes no lock and allocates nothing. Only creating items and blocking
+    take a mutex. Acquire and Release may be called from any thread.
+*/
+template<typename Item>
+class BoundedPool
+{
+public:
+    using Factory = std::function<Item()>;
+
+    BoundedPool(Factory factory, BoundedPoolOptions options = {})
+        : mFactory{ std::move(factory) }
+        , mOptions{ options }
+        , mFree{ (std::max)(options.HighWatermark, static_cast<size_t>(1)) }
+        , mCreated{ 0 }
+        , mHandouts{ 0 }
+        , mOutstanding{ 0 }
+        , mPeakDepth{ 0 }
+        , mDrops{ 0 }
+        , mReuses{ 0 }
+        , mWaits{ 0 }
+        , mWaitTime{ 0 }
+        , mWaiters{ 0 }
+    {
+        if (!mFactory)
+        {
+            throw std::invalid_argument("null pool factory");
+        }
+
+        if (mOptions.HighWatermark == 0 || mOptions.LowWatermark > mOptions.HighWatermark)
+        {
+            throw std::invalid_argument("pool watermarks must satisfy 0 <= low <= high, 0 < high");
+        }
+
+        mSlots.reset(new Slot[mOptions.HighWatermark]);
+        for (size_t i = 0; i < mOptions.HighWatermark; ++i)
+        {
+            mSlots[i].Holders.store(0, std::memory_order_relaxed);
+            mSlots[i].HandedOutAt.store(0, std::memory_order_relaxed);
+        }
+
+        Prewarm(mOptions.LowWatermark);
+    }
+
+    BoundedPool(const BoundedPool&) = delete;
+    BoundedPool& operator=(const BoundedPool&) = delete;
+
+    // Creates items until depth exist, up to the high watermark
+    void Prewarm(size_t depth)
+    {
+        uint32_t index;
+        while (mCreated.load(std::memory_order_acquire) < (std::min)(depth, mOptions.HighWatermark) && TryCreate(index))
+        {
+            Recycle(index);
+        }
+    }
+
+    // False when no item could be had under the policy
+    bool Acquire(Item& item)
+    {
+        uint32_t index;
+        if (mFree.TryPop(index) || TryCreate(index))
+        {
+            HandOut(index, item);
+            return true;
+        }
+
+        switch (mOptions.Policy)
+        {
+        case PoolExhaustedPolicy::Block:
+            if (WaitForFree(index))
+            {
+                HandOut(index, item);
+                return true;
+            }
+            break;
+        case PoolExhaustedPolicy::ReuseOldest:
+            if (TryReuseOldest(item))
+            {
+                return true;
+            }
+
+            // everything came back while looking
+            if (mFree.TryPop(index))
+            {
+                HandOut(index, item);
+                return true;
+            }
+            break;
+        case PoolExhaustedPolicy::Drop:
+        default:
+            break;
+        }
+
+        mDrops.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // Gives an acquired item back. An item that was reused is free once every holder released it.
+    void Release(const Item& item)
+    {
+        ReleaseMatching([&item](const Item& held) { return held == item; });
+    }
+
+    // Releases the handed out item the predicate matches, for callers that only get part of it back
+    template<typename Predicate>
+    void ReleaseMatching(Predicate matches)
+    {
+        const uint32_t index = IndexOf(matches);
+        Slot& slot = mSlots[index];
+        uint32_t holders = slot.Holders.load(std::memory_order_relaxed);
+        do
+        {
+            if (holders == 0)
+            {
+                throw std::invalid_argument("released an item that is not handed out");
+            }
+        } while (!slot.Holders.compare_exchange_weak(holders, holders - 1, std::memory_order_acq_rel));
+
+        if (holders == 1)
+        {
+            mOutstanding.fetch_sub(1, std::memory_order_relaxed);
+            Recycle(index);
+        }
+    }
+
+    BoundedPoolStats Stats() const
+    {
+        BoundedPoolStats stats{};
+        stats.Allocations = mCreated.load(std::memory_order_acquire);
+        stats.Outstanding = mOutstanding.load(std::memory_order_relaxed);
+        stats.Free = static_cast<size_t>(stats.Allocations) > stats.Outstanding ? static_cast<size_t>(stats.Allocations) - stats.Outstanding : 0;
+        stats.PeakDepth = mPeakDepth.load(std::memory_order_relaxed);
+        stats.Drops = mDrops.load(std::memory_order_relaxed);
+        stats.Reuses = mReuses.load(std::memory_order_relaxed);
+        stats.Waits = mWaits.load(std::memory_order_relaxed);
+        stats.WaitTime = std::chrono::nanoseconds{ mWaitTime.load(std::memory_order_relaxed) };
+        return stats;
+    }
+
+    const BoundedPoolOptions& Options() const
+    {
+        return mOptions;
+    }
+
+private:
+    struct Slot
+    {
+        // Written once, before the slot is counted in mCreated
+        Item Held;
+        std::atomic<uint32_t> Holders;
+        std::atomic<uint64_t> HandedOutAt;
+    };
+
+    bool TryCreate(uint32_t& index)
+    {
+        std::lock_guard<std::mutex> lock{ mCreateMutex };
+        const size_t created = mCreated.load(std::memory_order_relaxed);
+        if (created == mOptions.HighWatermark)
+        {
+            return false;
+        }
+
+        // a throwing factory leaves the pool as it was
+        mSlots[created].Held = mFactory();
+        mCreated.store(created + 1, std::memory_order_release);
+        index = static_cast<uint32_t>(created);
+        return true;
+    }
+
+    void HandOut(uint32_t index, Item& item)
+    {
+        Slot& slot = mSlots[index];
+        slot.HandedOutAt.store(++mHandouts, std::memory_order_relaxed);
+        slot.Holders.store(1, std::memory_order_release);
+        item = slot.Held;
+
+        const size_t outstanding = mOutstanding.fetch_add(1, std::memory_order_relaxed) + 1;
+        size_t peak = mPeakDepth.load(std::memory_order_relaxed);
+        while (outstanding > peak && !mPeakDepth.compare_exchange_weak(peak, outstanding, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    void Recycle(uint32_t index)
+    {
+        // the queue has room for every item, it only looks full while a consumer that
+        // was preempted between claiming and emptying a cell a lap behind finishes
+        while (!mFree.TryPush(index))
+        {
+            std::this_thread::yield();
+        }
+
+        // pairs with the fence in WaitForFree so a waiter either sees the item or gets notified
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (mWaiters.load(std::memory_order_relaxed) != 0)
+        {
+            {
+                std::lock_guard<std::mutex> lock{ mWaitMutex };
+            }
+            mReleased.notify_all();
+        }
+    }
+
+    bool WaitForFree(uint32_t& index)
+    {
+        mWaits.fetch_add(1, std::memory_order_relaxed);
+        const auto start = std::chrono::steady_clock::now();
+
+        bool found;
+        {
+            std::unique_lock<std::mutex> lock{ mWaitMutex };
+            mWaiters.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            found = mReleased.wait_for(lock, mOptions.BlockTimeout, [this, &index]() { return mFree.TryPop(index); });
+            mWaiters.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        const auto waited = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+        mWaitTime.fetch_add(waited.count(), std::memory_order_relaxed);
+        return found;
+    }
+
+    bool TryReuseOldest(Item& item)
+    {
+        const size_t created = mCreated.load(std::memory_order_acquire);
+        for (;;)
+        {
+            size_t oldest = created;
+            uint64_t oldestHandout = UINT64_MAX;
+            for (size_t i = 0; i < created; ++i)
+            {
+                const uint64_t handout = mSlots[i].HandedOutAt.load(std::memory_order_relaxed);
+                if (mSlots[i].Holders.load(std::memory_order_relaxed) != 0 && handout < oldestHandout)
+                {
+                    oldest = i;
+                    oldestHandout = handout;
+                }
+            }
+
+            if (oldest == created)
+            {
+                return false;
+            }
+
+            // only while it is still out, an item that just came back is taken from the free list instead
+            Slot& slot = mSlots[oldest];
+            uint32_t holders = slot.Holders.load(std::memory_order_relaxed);
+            while (holders != 0 && !slot.Holders.compare_exchange_weak(holders, holders + 1, std::memory_order_acq_rel))
+            {
+            }
+
+            if (holders != 0)
+            {
+                slot.HandedOutAt.store(++mHandouts, std::memory_order_relaxed);
+                item = slot.Held;
+                mReuses.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+    }
+
+    template<typename Predicate>
+    uint32_t IndexOf(Predicate& matches) const
+    {
+        const size_t created = mCreated.load(std::memory_order_acquire);
+        for (size_t i = 0; i < created; ++i)
+        {
+            if (matches(static_cast<const Item&>(mSlots[i].Held)))
+            {
+                return static_cast<uint32_t>(i);
+            }
+        }
+        throw std::invalid_argument("released an item the pool did not hand out");
+    }
+
+    Factory mFactory;
+    BoundedPoolOptions mOptions;
+    std::unique_ptr<Slot[]> mSlots;
+    MpmcQueue<uint32_t> mFree;
+    std::mutex mCreateMutex;
+    std::atomic<size_t> mCreated;
+    std::atomic<uint64_t> mHandouts;
+    std::atomic<size_t> mOutstanding;
+    std::atomic<size_t> mPeakDepth;
+    std::atomic<uint64_t> mDrops;
+    std::atomic<uint64_t> mReuses;
+    std::atomic<uint64_t> mWaits;
+    std::atomic<int64_t> mWaitTime;
+
+    // Blocking acquires wait here for a release
+    std::mutex mWaitMutex;
+    std::condition_variable mReleased;
+    std::atomic<uint32_t> mWaiters;
+};
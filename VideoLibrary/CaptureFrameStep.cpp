@@ -20,8 +20,8 @@
 #include "pch.h"
 #include "CaptureFrameStep.h"
 
-CaptureFrameStep::CaptureFrameStep(ScreenDuplicator& duplicator)
-    : mDupl{ duplicator }
+CaptureFrameStep::CaptureFrameStep(DuplicationFrameSource& source)
+    : mSource{ source }
 {
 }
 
@@ -31,7 +31,7 @@ CaptureFrameStep::~CaptureFrameStep()
 
 void CaptureFrameStep::Perform()
 {
-    mFrame = std::make_shared<Frame>(mDupl);
+    mFrame = mSource.AcquireDuplicationFrame();
 }
 
 std::shared_ptr<Frame> CaptureFrameStep::Result()
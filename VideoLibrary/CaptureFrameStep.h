@@ -21,14 +21,14 @@
 
 #include "RecordingStep.h"
 #include "DesktopMonitor.h"
-#include "ScreenDuplicator.h"
+#include "DuplicationFrameSource.h"
 #include "Frame.h"
 
 class CaptureFrameStep :
     public RecordingStep
 {
 public:
-    CaptureFrameStep(ScreenDuplicator& duplicator);
+    CaptureFrameStep(DuplicationFrameSource& source);
     virtual ~CaptureFrameStep();
 
     virtual void Perform() override;
@@ -36,6 +36,6 @@ public:
     std::shared_ptr<Frame> Result();
 
 private:
-    ScreenDuplicator& mDupl;
+    DuplicationFrameSource& mSource;
     std::shared_ptr<Frame> mFrame;
 };
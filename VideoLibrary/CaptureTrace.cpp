@@ -0,0 +1,34 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "CaptureTrace.h"
+
+size_t CaptureTraceDirtyPixelsSize(const RECT* dirtyRects, size_t dirtyRectsCount)
+{
+    size_t size = 0;
+    for (size_t i = 0; i < dirtyRectsCount; ++i)
+    {
+        const RECT& rect = dirtyRects[i];
+        if (rect.right > rect.left && rect.bottom > rect.top)
+        {
+            size += static_cast<size_t>(rect.right - rect.left) * static_cast<size_t>(rect.bottom - rect.top) * CaptureTraceBytesPerPixel;
+        }
+    }
+    return size;
+}
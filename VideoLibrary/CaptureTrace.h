@@ -0,0 +1,112 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+//
+// CaptureTrace.h
+// On-disk layout of a capture trace and the frame view shared by the writer, reader and replay.
+//
+// A trace is a CaptureTraceHeader followed by one record per captured frame.
+// Each record is a CaptureTraceRecordHeader followed by, in order:
+//   move rects, dirty rects, the pointer shape buffer (if it changed on that frame)
+//   and the dirty pixels (if the trace records pixels).
+// Dirty pixels are the 32 bit BGRA rows of every dirty rect, back to back, without padding.
+// Records are padded to 8 bytes so every field can be read in place from a mapped file.
+// All values are little-endian.
+//
+
+#pragma once
+
+#include "PlatformTypes.h"
+#include <cstdint>
+
+constexpr char CaptureTraceMagic[8] = { 'D', 'R', 'T', 'R', 'A', 'C', 'E', '\0' };
+constexpr uint32_t CaptureTraceVersion = 1;
+constexpr uint32_t CaptureTraceBytesPerPixel = 4;
+
+// CaptureTraceHeader::Flags
+constexpr uint32_t CaptureTraceHasPixels = 0x1;
+
+// CaptureTraceRecordHeader::Flags
+constexpr uint32_t CaptureTraceRecordHasPointerShape = 0x1;
+constexpr uint32_t CaptureTraceRecordHasPixels = 0x2;
+
+#pragma pack(push, 8)
+
+struct CaptureTraceHeader
+{
+    char Magic[8];
+    uint32_t Version;
+    uint32_t Flags;
+
+    // Units of the present and pointer update times, QueryPerformanceFrequency on Windows
+    int64_t TicksPerSecond;
+};
+
+struct CaptureTraceRecordHeader
+{
+    // Size of the record including this header and padding
+    uint32_t Size;
+    uint32_t Flags;
+    int64_t PresentTime;
+    int64_t PointerUpdateTime;
+    RECT MonitorBounds;
+    int32_t Rotation;
+    int32_t PointerVisible;
+    POINT PointerPosition;
+    uint32_t MoveRectsCount;
+    uint32_t DirtyRectsCount;
+    DXGI_OUTDUPL_POINTER_SHAPE_INFO PointerShapeInfo;
+    uint32_t PointerShapeSize;
+    uint32_t PixelsSize;
+};
+
+#pragma pack(pop)
+
+static_assert(sizeof(CaptureTraceHeader) == 24, "capture trace header layout changed");
+static_assert(sizeof(CaptureTraceRecordHeader) % 8 == 0, "capture trace records must stay 8 byte aligned");
+
+// Everything one captured frame delivered. The pointers are only valid as long as their source.
+struct CaptureTraceFrame
+{
+    int64_t PresentTime = 0;
+    int64_t PointerUpdateTime = 0;
+    RECT MonitorBounds{};
+    DXGI_MODE_ROTATION Rotation = DXGI_MODE_ROTATION_UNSPECIFIED;
+
+    // Relative to the monitor, as reported by the duplication API
+    DXGI_OUTDUPL_POINTER_POSITION PointerPosition{};
+
+    const DXGI_OUTDUPL_MOVE_RECT* MoveRects = nullptr;
+    size_t MoveRectsCount = 0;
+
+    const RECT* DirtyRects = nullptr;
+    size_t DirtyRectsCount = 0;
+
+    // Only set on frames where the pointer shape changed
+    bool HasPointerShape = false;
+    DXGI_OUTDUPL_POINTER_SHAPE_INFO PointerShapeInfo{};
+    const byte* PointerShape = nullptr;
+    size_t PointerShapeSize = 0;
+
+    // BGRA rows of each dirty rect, back to back. Null when pixels were not recorded.
+    const byte* Pixels = nullptr;
+    size_t PixelsSize = 0;
+};
+
+// Bytes needed to hold the pixels of the given dirty rects
+size_t CaptureTraceDirtyPixelsSize(const RECT* dirtyRects, size_t dirtyRectsCount);
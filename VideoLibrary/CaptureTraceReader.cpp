@@ -0,0 +1,272 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "CaptureTraceReader.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+class CaptureTraceReader::MappedFile
+{
+public:
+    explicit MappedFile(const std::filesystem::path& path)
+        : mData{ nullptr }
+        , mSize{ 0 }
+    {
+#ifdef _WIN32
+        mFile = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (mFile == INVALID_HANDLE_VALUE)
+        {
+            throw std::runtime_error("could not open capture trace");
+        }
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(mFile, &size))
+        {
+            Close();
+            throw std::runtime_error("could not read capture trace size");
+        }
+        mSize = static_cast<size_t>(size.QuadPart);
+        if (mSize == 0)
+        {
+            return;
+        }
+
+        mMapping = CreateFileMappingW(mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mMapping == nullptr)
+        {
+            Close();
+            throw std::runtime_error("could not map capture trace");
+        }
+
+        mData = static_cast<const byte*>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+        if (mData == nullptr)
+        {
+            Close();
+            throw std::runtime_error("could not map capture trace");
+        }
+#else
+        mFile = open(path.c_str(), O_RDONLY);
+        if (mFile < 0)
+        {
+            throw std::runtime_error("could not open capture trace");
+        }
+
+        struct stat status;
+        if (fstat(mFile, &status) != 0)
+        {
+            Close();
+            throw std::runtime_error("could not read capture trace size");
+        }
+        mSize = static_cast<size_t>(status.st_size);
+        if (mSize == 0)
+        {
+            return;
+        }
+
+        void* data = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, mFile, 0);
+        if (data == MAP_FAILED)
+        {
+            Close();
+            throw std::runtime_error("could not map capture trace");
+        }
+        mData = static_cast<const byte*>(data);
+        (void)madvise(data, mSize, MADV_SEQUENTIAL);
+#endif
+    }
+
+    ~MappedFile()
+    {
+        Close();
+    }
+
+    const byte* Data() const { return mData; }
+    size_t Size() const { return mSize; }
+
+private:
+    void Close()
+    {
+#ifdef _WIN32
+        if (mData)
+        {
+            UnmapViewOfFile(mData);
+        }
+        if (mMapping)
+        {
+            CloseHandle(mMapping);
+        }
+        if (mFile != INVALID_HANDLE_VALUE)
+        {
+            CloseHandle(mFile);
+        }
+        mMapping = nullptr;
+        mFile = INVALID_HANDLE_VALUE;
+#else
+        if (mData)
+        {
+            munmap(const_cast<byte*>(mData), mSize);
+        }
+        if (mFile >= 0)
+        {
+            close(mFile);
+        }
+        mFile = -1;
+#endif
+        mData = nullptr;
+    }
+
+#ifdef _WIN32
+    HANDLE mFile = INVALID_HANDLE_VALUE;
+    HANDLE mMapping = nullptr;
+#else
+    int mFile = -1;
+#endif
+    const byte* mData;
+    size_t mSize;
+};
+
+CaptureTraceReader::CaptureTraceReader(const std::filesystem::path& path)
+    : mFile{ std::make_unique<MappedFile>(path) }
+    , mData{ mFile->Data() }
+    , mSize{ mFile->Size() }
+    , mHeader{}
+{
+    if (mSize < sizeof(CaptureTraceHeader))
+    {
+        throw std::runtime_error("capture trace is truncated");
+    }
+
+    std::memcpy(&mHeader, mData, sizeof(mHeader));
+    if (std::memcmp(mHeader.Magic, CaptureTraceMagic, sizeof(mHeader.Magic)) != 0)
+    {
+        throw std::runtime_error("not a capture trace");
+    }
+
+    if (mHeader.Version != CaptureTraceVersion)
+    {
+        throw std::runtime_error("unsupported capture trace version");
+    }
+
+    Index();
+}
+
+CaptureTraceReader::~CaptureTraceReader()
+{
+}
+
+bool CaptureTraceReader::HasPixels() const
+{
+    return (mHeader.Flags & CaptureTraceHasPixels) != 0;
+}
+
+int64_t CaptureTraceReader::TicksPerSecond() const
+{
+    return mHeader.TicksPerSecond;
+}
+
+size_t CaptureTraceReader::FrameCount() const
+{
+    return mRecordOffsets.size();
+}
+
+CaptureTraceFrame CaptureTraceReader::Frame(size_t index) const
+{
+    if (index >= mRecordOffsets.size())
+    {
+        throw std::out_of_range("capture trace frame index");
+    }
+
+    const byte* record = mData + mRecordOffsets[index];
+    const auto& header = *reinterpret_cast<const CaptureTraceRecordHeader*>(record);
+    const byte* payload = record + sizeof(CaptureTraceRecordHeader);
+
+    CaptureTraceFrame frame;
+    frame.PresentTime = header.PresentTime;
+    frame.PointerUpdateTime = header.PointerUpdateTime;
+    frame.MonitorBounds = header.MonitorBounds;
+    frame.Rotation = static_cast<DXGI_MODE_ROTATION>(header.Rotation);
+    frame.PointerPosition.Position = header.PointerPosition;
+    frame.PointerPosition.Visible = header.PointerVisible;
+
+    frame.MoveRects = reinterpret_cast<const DXGI_OUTDUPL_MOVE_RECT*>(payload);
+    frame.MoveRectsCount = header.MoveRectsCount;
+    payload += header.MoveRectsCount * sizeof(DXGI_OUTDUPL_MOVE_RECT);
+
+    frame.DirtyRects = reinterpret_cast<const RECT*>(payload);
+    frame.DirtyRectsCount = header.DirtyRectsCount;
+    payload += header.DirtyRectsCount * sizeof(RECT);
+
+    if (header.Flags & CaptureTraceRecordHasPointerShape)
+    {
+        frame.HasPointerShape = true;
+        frame.PointerShapeInfo = header.PointerShapeInfo;
+        frame.PointerShape = payload;
+        frame.PointerShapeSize = header.PointerShapeSize;
+        payload += header.PointerShapeSize;
+    }
+
+    if (header.Flags & CaptureTraceRecordHasPixels)
+    {
+        frame.Pixels = payload;
+        frame.PixelsSize = header.PixelsSize;
+    }
+
+    return frame;
+}
+
+void CaptureTraceReader::Index()
+{
+    size_t offset = sizeof(CaptureTraceHeader);
+    while (offset + sizeof(CaptureTraceRecordHeader) <= mSize)
+    {
+        const auto& header = *reinterpret_cast<const CaptureTraceRecordHeader*>(mData + offset);
+
+        const uint64_t payloadSize =
+            static_cast<uint64_t>(header.MoveRectsCount) * sizeof(DXGI_OUTDUPL_MOVE_RECT) +
+            static_cast<uint64_t>(header.DirtyRectsCount) * sizeof(RECT) +
+            header.PointerShapeSize +
+            header.PixelsSize;
+
+        if (header.Size % 8 != 0 ||
+            header.Size < sizeof(CaptureTraceRecordHeader) + payloadSize ||
+            header.Size > mSize - offset)
+        {
+            // a session that was killed mid-write leaves a partial record at the end
+            break;
+        }
+
+        if ((header.Flags & CaptureTraceRecordHasPixels) &&
+            header.PixelsSize != CaptureTraceDirtyPixelsSize(
+                reinterpret_cast<const RECT*>(mData + offset + sizeof(CaptureTraceRecordHeader) + header.MoveRectsCount * sizeof(DXGI_OUTDUPL_MOVE_RECT)),
+                header.DirtyRectsCount))
+        {
+            throw std::runtime_error("capture trace pixels do not match the dirty rects");
+        }
+
+        mRecordOffsets.push_back(offset);
+        offset += header.Size;
+    }
+}
@@ -0,0 +1,60 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "CaptureTrace.h"
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+/*
+    Read-only view of a capture trace.
+
+    The file is memory mapped and indexed once when opened. Frames returned by Frame()
+    point straight into the mapping, so replaying a trace copies nothing.
+*/
+class CaptureTraceReader
+{
+public:
+    explicit CaptureTraceReader(const std::filesystem::path& path);
+    ~CaptureTraceReader();
+
+    CaptureTraceReader(const CaptureTraceReader&) = delete;
+    CaptureTraceReader& operator=(const CaptureTraceReader&) = delete;
+
+    bool HasPixels() const;
+
+    int64_t TicksPerSecond() const;
+
+    size_t FrameCount() const;
+
+    // The returned frame is valid as long as the reader
+    CaptureTraceFrame Frame(size_t index) const;
+
+private:
+    class MappedFile;
+
+    void Index();
+
+    std::unique_ptr<MappedFile> mFile;
+    const byte* mData;
+    size_t mSize;
+    CaptureTraceHeader mHeader;
+    std::vector<size_t> mRecordOffsets;
+};
@@ -0,0 +1,90 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "CaptureTraceReplay.h"
+
+#include <stdexcept>
+#include <thread>
+
+CaptureTraceReplay::CaptureTraceReplay(std::shared_ptr<CaptureTraceReader> reader, ReplayPacing pacing)
+    : mReader{ reader }
+    , mPacing{ pacing }
+    , mPosition{ 0 }
+    , mFirstPresentTime{ 0 }
+{
+    if (mReader == nullptr)
+    {
+        throw std::invalid_argument("null capture trace reader");
+    }
+}
+
+bool CaptureTraceReplay::Next(CaptureTraceFrame& frame)
+{
+    if (mPosition >= mReader->FrameCount())
+    {
+        return false;
+    }
+
+    frame = mReader->Frame(mPosition++);
+
+    if (mPacing == ReplayPacing::RealTime)
+    {
+        WaitForPresentTime(frame.PresentTime);
+    }
+
+    return true;
+}
+
+void CaptureTraceReplay::Rewind()
+{
+    mPosition = 0;
+    mFirstPresentTime = 0;
+}
+
+size_t CaptureTraceReplay::Position() const
+{
+    return mPosition;
+}
+
+ReplayPacing CaptureTraceReplay::Pacing() const
+{
+    return mPacing;
+}
+
+void CaptureTraceReplay::WaitForPresentTime(int64_t presentTime)
+{
+    // pointer-only updates have no present time
+    const int64_t ticksPerSecond = mReader->TicksPerSecond();
+    if (presentTime == 0 || ticksPerSecond <= 0)
+    {
+        return;
+    }
+
+    if (mFirstPresentTime == 0)
+    {
+        mFirstPresentTime = presentTime;
+        mStart = std::chrono::steady_clock::now();
+        return;
+    }
+
+    // microsecond precision, ticks * 1e6 does not overflow for sessions of many hours
+    const int64_t ticks = presentTime - mFirstPresentTime;
+    const auto offset = std::chrono::nanoseconds{ ticks * 1'000'000 / ticksPerSecond * 1'000 };
+    std::this_thread::sleep_until(mStart + offset);
+}
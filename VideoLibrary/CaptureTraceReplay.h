@@ -0,0 +1,57 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "CaptureTraceReader.h"
+#include <chrono>
+#include <memory>
+
+enum class ReplayPacing
+{
+    // Hand out frames as fast as they are asked for, for benchmarks
+    FullSpeed,
+
+    // Wait until each frame's present time, relative to the first frame, has passed
+    RealTime
+};
+
+// Feeds the frames of a capture trace back in order
+class CaptureTraceReplay
+{
+public:
+    CaptureTraceReplay(std::shared_ptr<CaptureTraceReader> reader, ReplayPacing pacing = ReplayPacing::FullSpeed);
+
+    // Returns false once every frame was replayed
+    bool Next(CaptureTraceFrame& frame);
+
+    void Rewind();
+
+    size_t Position() const;
+
+    ReplayPacing Pacing() const;
+
+private:
+    void WaitForPresentTime(int64_t presentTime);
+
+    std::shared_ptr<CaptureTraceReader> mReader;
+    ReplayPacing mPacing;
+    size_t mPosition;
+    int64_t mFirstPresentTime;
+    std::chrono::steady_clock::time_point mStart;
+};
@@ -0,0 +1,140 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "CaptureTraceWriter.h"
+
+#include <cstring>
+#include <stdexcept>
+
+CaptureTraceWriter::CaptureTraceWriter(const std::filesystem::path& path, bool recordPixels, int64_t ticksPerSecond)
+    : mFile{ path, std::ios::binary | std::ios::trunc }
+    , mRecordPixels{ recordPixels }
+    , mFramesWritten{ 0 }
+    , mBytesWritten{ 0 }
+{
+    if (!mFile)
+    {
+        throw std::runtime_error("could not create capture trace");
+    }
+
+    CaptureTraceHeader header{};
+    std::memcpy(header.Magic, CaptureTraceMagic, sizeof(header.Magic));
+    header.Version = CaptureTraceVersion;
+    header.Flags = mRecordPixels ? CaptureTraceHasPixels : 0;
+    header.TicksPerSecond = ticksPerSecond;
+    WriteBytes(&header, sizeof(header));
+}
+
+CaptureTraceWriter::~CaptureTraceWriter()
+{
+    mFile.flush();
+}
+
+bool CaptureTraceWriter::RecordsPixels() const
+{
+    return mRecordPixels;
+}
+
+void CaptureTraceWriter::Write(const CaptureTraceFrame& frame)
+{
+    const bool writePixels = mRecordPixels && frame.Pixels != nullptr;
+    if (writePixels && frame.PixelsSize != CaptureTraceDirtyPixelsSize(frame.DirtyRects, frame.DirtyRectsCount))
+    {
+        throw std::invalid_argument("dirty pixels do not match the dirty rects");
+    }
+
+    const bool writeShape = frame.HasPointerShape && frame.PointerShape != nullptr;
+
+    CaptureTraceRecordHeader record{};
+    record.Flags =
+        (writeShape ? CaptureTraceRecordHasPointerShape : 0) |
+        (writePixels ? CaptureTraceRecordHasPixels : 0);
+    record.PresentTime = frame.PresentTime;
+    record.PointerUpdateTime = frame.PointerUpdateTime;
+    record.MonitorBounds = frame.MonitorBounds;
+    record.Rotation = static_cast<int32_t>(frame.Rotation);
+    record.PointerVisible = frame.PointerPosition.Visible ? 1 : 0;
+    record.PointerPosition = frame.PointerPosition.Position;
+    record.MoveRectsCount = static_cast<uint32_t>(frame.MoveRectsCount);
+    record.DirtyRectsCount = static_cast<uint32_t>(frame.DirtyRectsCount);
+    record.PointerShapeInfo = writeShape ? frame.PointerShapeInfo : DXGI_OUTDUPL_POINTER_SHAPE_INFO{};
+    record.PointerShapeSize = writeShape ? static_cast<uint32_t>(frame.PointerShapeSize) : 0;
+    record.PixelsSize = writePixels ? static_cast<uint32_t>(frame.PixelsSize) : 0;
+
+    const size_t payloadSize =
+        frame.MoveRectsCount * sizeof(DXGI_OUTDUPL_MOVE_RECT) +
+        frame.DirtyRectsCount * sizeof(RECT) +
+        record.PointerShapeSize +
+        record.PixelsSize;
+    const size_t unpaddedSize = sizeof(record) + payloadSize;
+    const size_t paddedSize = (unpaddedSize + 7) & ~static_cast<size_t>(7);
+    if (paddedSize > UINT32_MAX)
+    {
+        throw std::invalid_argument("capture trace record too large");
+    }
+    record.Size = static_cast<uint32_t>(paddedSize);
+
+    WriteBytes(&record, sizeof(record));
+    WriteBytes(frame.MoveRects, frame.MoveRectsCount * sizeof(DXGI_OUTDUPL_MOVE_RECT));
+    WriteBytes(frame.DirtyRects, frame.DirtyRectsCount * sizeof(RECT));
+    if (writeShape)
+    {
+        WriteBytes(frame.PointerShape, record.PointerShapeSize);
+    }
+    if (writePixels)
+    {
+        WriteBytes(frame.Pixels, record.PixelsSize);
+    }
+
+    const char padding[8] = {};
+    WriteBytes(padding, paddedSize - unpaddedSize);
+
+    if (!mFile)
+    {
+        throw std::runtime_error("could not write capture trace");
+    }
+
+    ++mFramesWritten;
+}
+
+void CaptureTraceWriter::Flush()
+{
+    mFile.flush();
+}
+
+uint64_t CaptureTraceWriter::FramesWritten() const
+{
+    return mFramesWritten;
+}
+
+uint64_t CaptureTraceWriter::BytesWritten() const
+{
+    return mBytesWritten;
+}
+
+void CaptureTraceWriter::WriteBytes(const void* data, size_t size)
+{
+    if (size == 0)
+    {
+        return;
+    }
+
+    mFile.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+    mBytesWritten += size;
+}
@@ -0,0 +1,57 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "CaptureTrace.h"
+#include <filesystem>
+#include <fstream>
+
+/*
+    Appends captured frames to a trace file.
+
+    Metadata is always recorded. Pixels are recorded only when the writer was created
+    with recordPixels and the frame carries them, and only for the dirty rects,
+    which keeps traces of long sessions small enough to check in as test data.
+*/
+class CaptureTraceWriter
+{
+public:
+    CaptureTraceWriter(const std::filesystem::path& path, bool recordPixels, int64_t ticksPerSecond);
+    ~CaptureTraceWriter();
+
+    CaptureTraceWriter(const CaptureTraceWriter&) = delete;
+    CaptureTraceWriter& operator=(const CaptureTraceWriter&) = delete;
+
+    bool RecordsPixels() const;
+
+    void Write(const CaptureTraceFrame& frame);
+
+    void Flush();
+
+    uint64_t FramesWritten() const;
+    uint64_t BytesWritten() const;
+
+private:
+    void WriteBytes(const void* data, size_t size);
+
+    std::ofstream mFile;
+    bool mRecordPixels;
+    uint64_t mFramesWritten;
+    uint64_t mBytesWritten;
+};
@@ -0,0 +1,149 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "pch.h"
+#include "ChangeDetector.h"
+
+#include <stdexcept>
+
+ChangeDetector::ChangeDetector()
+    : mChanged{ true }
+    , mPointerDrawn{ true }
+    , mPointerVisible{ false }
+    , mPointerPosition{ 0, 0 }
+    , mStats{}
+{
+}
+
+void ChangeDetector::ObservePointer(const SourceFrame& frame)
+{
+    // the position is only reported with an update time
+    if (!frame.Captured() || frame.PointerUpdateTime() == 0)
+    {
+        return;
+    }
+
+    ObservePointer(frame.PointerPosition(), frame.PointerShapeUpdated());
+}
+
+void ChangeDetector::ObservePointer(const DXGI_OUTDUPL_POINTER_POSITION& position, bool shapeUpdated)
+{
+    const bool visible = position.Visible != 0;
+    const bool moved = position.Position.x != mPointerPosition.x || position.Position.y != mPointerPosition.y;
+
+    // a hidden pointer can move without anything to see
+    if (mPointerDrawn && (shapeUpdated || visible != mPointerVisible || (visible && moved)))
+    {
+        mChanged = true;
+        ++mStats.PointerChanges;
+    }
+
+    mPointerVisible = visible;
+    mPointerPosition = position.Position;
+}
+
+void ChangeDetector::PointerDrawn(bool drawn)
+{
+    if (drawn && !mPointerDrawn)
+    {
+        mChanged = true;
+    }
+
+    mPointerDrawn = drawn;
+}
+
+void ChangeDetector::MarkChanged()
+{
+    mChanged = true;
+}
+
+bool ChangeDetector::Pending() const
+{
+    return mChanged;
+}
+
+bool ChangeDetector::TakeChange()
+{
+    if (!mChanged)
+    {
+        ++mStats.Unchanged;
+        return false;
+    }
+
+    mChanged = false;
+    ++mStats.Changed;
+    return true;
+}
+
+ChangeDetectorStats ChangeDetector::Stats() const
+{
+    return mStats;
+}
+
+KeepAliveTimer::KeepAliveTimer(std::chrono::nanoseconds maxInterval)
+    : mMaxInterval{ maxInterval }
+    , mLastWritten{ 0 }
+    , mWritten{ false }
+    , mGapSignaled{ false }
+    , mStats{}
+{
+    if (mMaxInterval.count() <= 0)
+    {
+        throw std::invalid_argument("the keep-alive interval must be positive");
+    }
+}
+
+void KeepAliveTimer::Written(std::chrono::nanoseconds now)
+{
+    mLastWritten = now;
+    mWritten = true;
+    mGapSignaled = false;
+    ++mStats.Written;
+}
+
+IdleTick KeepAliveTimer::Idle(std::chrono::nanoseconds now)
+{
+    ++mStats.Idle;
+
+    // nothing to keep alive yet, the first frame is written as soon as it can be made
+    if (!mWritten || now - mLastWritten >= mMaxInterval)
+    {
+        ++mStats.KeptAlive;
+        return IdleTick::KeepAlive;
+    }
+
+    if (!mGapSignaled)
+    {
+        mGapSignaled = true;
+        ++mStats.Gaps;
+        return IdleTick::SignalGap;
+    }
+
+    return IdleTick::Nothing;
+}
+
+std::chrono::nanoseconds KeepAliveTimer::MaxInterval() const
+{
+    return mMaxInterval;
+}
+
+KeepAliveStats KeepAliveTimer::Stats() const
+{
+    return mStats;
+}
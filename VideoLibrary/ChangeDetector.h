@@ -0,0 +1,124 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+//
+// ChangeDetector.h
+// Tells static frames from changed ones so the recording loop only composes and
+// encodes when the desktop or the pointer changed. Drawn damage and pointer
+// updates mark a change, composing takes it. While nothing changes the writer
+// signals a gap in the stream instead of encoding copies of the same frame, and
+// writes a keep-alive frame at most every so often.
+//
+
+#pragma once
+
+#include "FrameSource.h"
+#include <chrono>
+#include <cstdint>
+
+struct ChangeDetectorStats
+{
+    // Frames composed because something changed, and frames skipped because nothing did
+    uint64_t Changed;
+    uint64_t Unchanged;
+
+    // Pointer moves, shows, hides and shape changes
+    uint64_t PointerChanges;
+};
+
+class ChangeDetector
+{
+public:
+    // The first frame is always a change
+    ChangeDetector();
+
+    // A pointer update of a captured frame, relative to the frame's monitor
+    void ObservePointer(const SourceFrame& frame);
+
+    // The pointer as it is drawn now
+    void ObservePointer(const DXGI_OUTDUPL_POINTER_POSITION& position, bool shapeUpdated);
+
+    // Whether the pointer is drawn into the frames. A pointer that is recorded apart
+    // changes nothing in them, drawing it again is a change
+    void PointerDrawn(bool drawn);
+
+    // Pixels of the surface changed, like dirty and move rects that were drawn
+    void MarkChanged();
+
+    // Whether something changed since the last TakeChange
+    bool Pending() const;
+
+    // True once for every stretch of changes, false while the desktop is static
+    bool TakeChange();
+
+    ChangeDetectorStats Stats() const;
+
+private:
+    bool mChanged;
+    bool mPointerDrawn;
+    bool mPointerVisible;
+    POINT mPointerPosition;
+    ChangeDetectorStats mStats;
+};
+
+// What to write at a tick that found no changed frame
+enum class IdleTick
+{
+    // nothing, the gap was already signaled
+    Nothing,
+
+    // tell the writer the stream has a gap, so it does not wait for samples
+    SignalGap,
+
+    // write the unchanged desktop again
+    KeepAlive
+};
+
+struct KeepAliveStats
+{
+    uint64_t Written;
+    uint64_t Idle;
+    uint64_t Gaps;
+    uint64_t KeptAlive;
+};
+
+class KeepAliveTimer
+{
+public:
+    // Frames are written at least every maxInterval, so players seeking
+    // into a static stretch find a frame nearby
+    explicit KeepAliveTimer(std::chrono::nanoseconds maxInterval = std::chrono::seconds{ 1 });
+
+    // A frame was written at now
+    void Written(std::chrono::nanoseconds now);
+
+    // A tick at now found no changed frame. KeepAlive is returned until Written is called.
+    IdleTick Idle(std::chrono::nanoseconds now);
+
+    std::chrono::nanoseconds MaxInterval() const;
+
+    KeepAliveStats Stats() const;
+
+private:
+    std::chrono::nanoseconds mMaxInterval;
+    std::chrono::nanoseconds mLastWritten;
+    bool mWritten;
+    bool mGapSignaled;
+    KeepAliveStats mStats;
+};
@@ -0,0 +1,116 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "pch.h"
+#include "CopyDamageStep.h"
+
+namespace
+{
+    // {6C1E5F2A-93D4-4B8E-A157-2F0C8D6419E3}
+    const GUID ContentsGuid = { 0x6c1e5f2a, 0x93d4, 0x4b8e, { 0xa1, 0x57, 0x2f, 0x0c, 0x8d, 0x64, 0x19, 0xe3 } };
+}
+
+CopyDamageStep::CopyDamageStep(
+    ID3D11Texture2D* sharedSurfacePtr,
+    winrt::com_ptr<ID3D11Texture2D> destination,
+    std::shared_ptr<DamageHistory> history)
+    : mSharedSurfacePtr{ sharedSurfacePtr }
+    , mDestination{ destination }
+    , mHistory{ history }
+{
+    if (mHistory == nullptr)
+    {
+        throw std::exception("null damage history");
+    }
+
+    winrt::check_pointer(mSharedSurfacePtr);
+    winrt::check_pointer(mDestination.get());
+}
+
+CopyDamageStep::~CopyDamageStep()
+{
+}
+
+void CopyDamageStep::Perform()
+{
+    winrt::com_ptr<ID3D11Device> device;
+    mSharedSurfacePtr->GetDevice(device.put());
+
+    winrt::com_ptr<ID3D11DeviceContext> context;
+    device->GetImmediateContext(context.put());
+
+    const Contents contents = ReadContents(mDestination.get());
+
+    Region damage;
+    if (contents.Overlay.right > contents.Overlay.left && contents.Overlay.bottom > contents.Overlay.top)
+    {
+        damage.Reset(contents.Overlay);
+    }
+
+    if (mHistory->DamageSince(contents.Generation, damage))
+    {
+        const RECT* rects = damage.Rects();
+        for (size_t i = 0; i < damage.RectsCount(); ++i)
+        {
+            D3D11_BOX box;
+            box.left = rects[i].left;
+            box.right = rects[i].right;
+            box.top = rects[i].top;
+            box.bottom = rects[i].bottom;
+            box.front = 0;
+            box.back = 1;
+
+            context->CopySubresourceRegion(
+                mDestination.get(), 0,
+                rects[i].left, rects[i].top, 0,
+                mSharedSurfacePtr, 0,
+                &box);
+        }
+    }
+    else
+    {
+        context->CopyResource(mDestination.get(), mSharedSurfacePtr);
+    }
+
+    WriteContents(mDestination.get(), Contents{ mHistory->Generation(), RECT{} });
+}
+
+void CopyDamageStep::MarkOverlay(ID3D11Texture2D* texture, const RECT& overlay)
+{
+    Contents contents = ReadContents(texture);
+    contents.Overlay = overlay;
+    WriteContents(texture, contents);
+}
+
+CopyDamageStep::Contents CopyDamageStep::ReadContents(ID3D11Texture2D* texture)
+{
+    Contents contents{ DamageHistory::UnknownGeneration, RECT{} };
+    UINT size = sizeof(contents);
+    if (FAILED(texture->GetPrivateData(ContentsGuid, &size, &contents)) || size != sizeof(contents))
+    {
+        // a new texture
+        return Contents{ DamageHistory::UnknownGeneration, RECT{} };
+    }
+    return contents;
+}
+
+void CopyDamageStep::WriteContents(ID3D11Texture2D* texture, const Contents& contents)
+{
+    winrt::check_hresult(texture->SetPrivateData(ContentsGuid, sizeof(contents), &contents));
+}
@@ -0,0 +1,58 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "RecordingStep.h"
+#include "DamageHistory.h"
+
+// Brings a pooled texture up to date with the shared surface. Only the damage since
+// the texture was last filled and the overlay drawn on it then are copied, while the
+// history still covers it.
+class CopyDamageStep : public RecordingStep
+{
+public:
+    CopyDamageStep(
+        ID3D11Texture2D* sharedSurfacePtr,
+        winrt::com_ptr<ID3D11Texture2D> destination,
+        std::shared_ptr<DamageHistory> history);
+
+    ~CopyDamageStep();
+
+    // Inherited via RecordingStep
+    virtual void Perform() override;
+
+    // Remembers an area drawn over the copy, such as the pointer, to restore it next time
+    static void MarkOverlay(ID3D11Texture2D* texture, const RECT& overlay);
+
+private:
+    // What a pooled texture holds, kept with the texture as private data
+    struct Contents
+    {
+        uint64_t Generation;
+        RECT Overlay;
+    };
+
+    static Contents ReadContents(ID3D11Texture2D* texture);
+    static void WriteContents(ID3D11Texture2D* texture, const Contents& contents);
+
+    ID3D11Texture2D* mSharedSurfacePtr;
+    winrt::com_ptr<ID3D11Texture2D> mDestination;
+    std::shared_ptr<DamageHistory> mHistory;
+};
@@ -0,0 +1,95 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "D3D11DynamicBufferDevice.h"
+
+namespace
+{
+    class D3D11DynamicBuffer : public DynamicBuffer
+    {
+    public:
+        D3D11DynamicBuffer(winrt::com_ptr<ID3D11Buffer> buffer, size_t size)
+            : mBuffer{ buffer }
+            , mSize{ size }
+        {
+        }
+
+        virtual size_t Size() const override
+        {
+            return mSize;
+        }
+
+        ID3D11Buffer* Get() const
+        {
+            return mBuffer.get();
+        }
+
+    private:
+        winrt::com_ptr<ID3D11Buffer> mBuffer;
+        size_t mSize;
+    };
+}
+
+D3D11DynamicBufferDevice::D3D11DynamicBufferDevice(winrt::com_ptr<ID3D11Device> device)
+    : mDevice{ device }
+{
+    winrt::check_pointer(mDevice.get());
+    mDevice->GetImmediateContext(mContext.put());
+}
+
+D3D11DynamicBufferDevice::~D3D11DynamicBufferDevice()
+{
+}
+
+std::shared_ptr<DynamicBuffer> D3D11DynamicBufferDevice::CreateBuffer(DynamicBufferBinding binding, size_t size)
+{
+    D3D11_BUFFER_DESC bufferDesc;
+    bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+    bufferDesc.ByteWidth = static_cast<UINT>(size);
+    bufferDesc.BindFlags = binding == DynamicBufferBinding::Constant ? D3D11_BIND_CONSTANT_BUFFER : D3D11_BIND_VERTEX_BUFFER;
+    bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    bufferDesc.MiscFlags = 0;
+    bufferDesc.StructureByteStride = 0;
+
+    winrt::com_ptr<ID3D11Buffer> buffer;
+    winrt::check_hresult(mDevice->CreateBuffer(&bufferDesc, nullptr, buffer.put()));
+    return std::make_shared<D3D11DynamicBuffer>(buffer, size);
+}
+
+void* D3D11DynamicBufferDevice::Map(DynamicBuffer& buffer, BufferMapMode mode)
+{
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    winrt::check_hresult(mContext->Map(
+        Buffer(buffer),
+        0,
+        mode == BufferMapMode::Discard ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE,
+        0,
+        &mapped));
+    return mapped.pData;
+}
+
+void D3D11DynamicBufferDevice::Unmap(DynamicBuffer& buffer)
+{
+    mContext->Unmap(Buffer(buffer), 0);
+}
+
+ID3D11Buffer* D3D11DynamicBufferDevice::Buffer(const DynamicBuffer& buffer)
+{
+    return static_cast<const D3D11DynamicBuffer&>(buffer).Get();
+}
@@ -0,0 +1,41 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+#include "DynamicBufferDevice.h"
+
+// Dynamic buffers on a D3D11 device's immediate context
+class D3D11DynamicBufferDevice : public DynamicBufferDevice
+{
+public:
+    D3D11DynamicBufferDevice(winrt::com_ptr<ID3D11Device> device);
+
+    virtual ~D3D11DynamicBufferDevice();
+
+    // Inherited via DynamicBufferDevice
+    virtual std::shared_ptr<DynamicBuffer> CreateBuffer(DynamicBufferBinding binding, size_t size) override;
+    virtual void* Map(DynamicBuffer& buffer, BufferMapMode mode) override;
+    virtual void Unmap(DynamicBuffer& buffer) override;
+
+    // The D3D11 buffer behind a buffer created by this device
+    static ID3D11Buffer* Buffer(const DynamicBuffer& buffer);
+
+private:
+    winrt::com_ptr<ID3D11Device> mDevice;
+    winrt::com_ptr<ID3D11DeviceContext> mContext;
+};
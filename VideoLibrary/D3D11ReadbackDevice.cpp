@@ -0,0 +1,145 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "pch.h"
+#include "D3D11ReadbackDevice.h"
+
+namespace
+{
+    class D3D11ReadbackBuffer : public ReadbackBuffer
+    {
+    public:
+        D3D11ReadbackBuffer(winrt::com_ptr<ID3D11Texture2D> texture, UINT width, UINT height)
+            : mTexture{ texture }
+            , mWidth{ width }
+            , mHeight{ height }
+        {
+        }
+
+        virtual UINT Width() const override
+        {
+            return mWidth;
+        }
+
+        virtual UINT Height() const override
+        {
+            return mHeight;
+        }
+
+        ID3D11Texture2D* Get() const
+        {
+            return mTexture.get();
+        }
+
+    private:
+        winrt::com_ptr<ID3D11Texture2D> mTexture;
+        UINT mWidth;
+        UINT mHeight;
+    };
+}
+
+D3D11ReadbackDevice::D3D11ReadbackDevice(winrt::com_ptr<ID3D11Device> device, DXGI_FORMAT format)
+    : mDevice{ device }
+    , mFormat{ format }
+    , mSource{ nullptr }
+{
+    winrt::check_pointer(mDevice.get());
+    mDevice->GetImmediateContext(mContext.put());
+}
+
+D3D11ReadbackDevice::~D3D11ReadbackDevice()
+{
+}
+
+void D3D11ReadbackDevice::Source(ID3D11Texture2D* source)
+{
+    mSource = source;
+}
+
+std::shared_ptr<ReadbackBuffer> D3D11ReadbackDevice::CreateBuffer(UINT width, UINT height)
+{
+    D3D11_TEXTURE2D_DESC desc;
+    desc.Format = mFormat;
+    desc.Width = width;
+    desc.Height = height;
+    desc.BindFlags = 0;
+    desc.Usage = D3D11_USAGE_STAGING;
+    desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+    desc.MiscFlags = 0;
+    desc.ArraySize = 1;
+    desc.SampleDesc.Count = 1;
+    desc.SampleDesc.Quality = 0;
+    desc.MipLevels = 1;
+
+    winrt::com_ptr<ID3D11Texture2D> texture;
+    winrt::check_hresult(mDevice->CreateTexture2D(&desc, nullptr, texture.put()));
+    return std::make_shared<D3D11ReadbackBuffer>(texture, width, height);
+}
+
+void D3D11ReadbackDevice::Copy(ReadbackBuffer& buffer, const RECT& region)
+{
+    if (mSource == nullptr)
+    {
+        throw std::exception("readback source is null");
+    }
+
+    D3D11_BOX box;
+    box.left = region.left;
+    box.right = region.right;
+    box.top = region.top;
+    box.bottom = region.bottom;
+    box.front = 0;
+    box.back = 1;
+
+    mContext->CopySubresourceRegion(
+        Texture(buffer),
+        0, 0, 0, 0,
+        mSource, 0, &box);
+}
+
+bool D3D11ReadbackDevice::Map(ReadbackBuffer& buffer, bool wait, MappedReadback& mapped)
+{
+    D3D11_MAPPED_SUBRESOURCE subresource;
+    const HRESULT hr = mContext->Map(
+        Texture(buffer),
+        0,
+        D3D11_MAP_READ,
+        wait ? 0 : D3D11_MAP_FLAG_DO_NOT_WAIT,
+        &subresource);
+
+    if (hr == DXGI_ERROR_WAS_STILL_DRAWING)
+    {
+        return false;
+    }
+    winrt::check_hresult(hr);
+
+    mapped.Data = static_cast<const byte*>(subresource.pData);
+    mapped.Pitch = subresource.RowPitch;
+    return true;
+}
+
+void D3D11ReadbackDevice::Unmap(ReadbackBuffer& buffer)
+{
+    mContext->Unmap(Texture(buffer), 0);
+}
+
+ID3D11Texture2D* D3D11ReadbackDevice::Texture(const ReadbackBuffer& buffer)
+{
+    return static_cast<const D3D11ReadbackBuffer&>(buffer).Get();
+}
@@ -0,0 +1,48 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include "ReadbackDevice.h"
+
+// Staging texture readbacks on a D3D11 device's immediate context
+class D3D11ReadbackDevice : public ReadbackDevice
+{
+public:
+    D3D11ReadbackDevice(winrt::com_ptr<ID3D11Device> device, DXGI_FORMAT format);
+
+    virtual ~D3D11ReadbackDevice();
+
+    // The surface copies read from, it has to be locked while copying
+    void Source(ID3D11Texture2D* source);
+
+    // Inherited via ReadbackDevice
+    virtual std::shared_ptr<ReadbackBuffer> CreateBuffer(UINT width, UINT height) override;
+    virtual void Copy(ReadbackBuffer& buffer, const RECT& region) override;
+    virtual bool Map(ReadbackBuffer& buffer, bool wait, MappedReadback& mapped) override;
+    virtual void Unmap(ReadbackBuffer& buffer) override;
+
+    // The staging texture behind a buffer created by this device
+    static ID3D11Texture2D* Texture(const ReadbackBuffer& buffer);
+
+private:
+    winrt::com_ptr<ID3D11Device> mDevice;
+    winrt::com_ptr<ID3D11DeviceContext> mContext;
+    DXGI_FORMAT mFormat;
+    ID3D11Texture2D* mSource;
+};
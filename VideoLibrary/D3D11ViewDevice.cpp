@@ -0,0 +1,94 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "pch.h"
+#include "D3D11ViewDevice.h"
+
+namespace
+{
+    class D3D11TextureView : public TextureView
+    {
+    public:
+        D3D11TextureView(winrt::com_ptr<ID3D11View> view)
+            : mView{ view }
+        {
+        }
+
+        ID3D11View* Get() const
+        {
+            return mView.get();
+        }
+
+    private:
+        winrt::com_ptr<ID3D11View> mView;
+    };
+}
+
+D3D11ViewDevice::D3D11ViewDevice(winrt::com_ptr<ID3D11Device> device)
+    : mDevice{ device }
+{
+    winrt::check_pointer(mDevice.get());
+}
+
+D3D11ViewDevice::~D3D11ViewDevice()
+{
+}
+
+std::shared_ptr<TextureView> D3D11ViewDevice::CreateView(void* texture, ViewKind kind)
+{
+    auto texturePtr = static_cast<ID3D11Texture2D*>(texture);
+    winrt::check_pointer(texturePtr);
+
+    if (kind == ViewKind::RenderTarget)
+    {
+        winrt::com_ptr<ID3D11RenderTargetView> rtv;
+        winrt::check_hresult(mDevice->CreateRenderTargetView(
+            texturePtr,
+            nullptr,
+            rtv.put()
+        ));
+        return std::make_shared<D3D11TextureView>(rtv.as<ID3D11View>());
+    }
+
+    D3D11_TEXTURE2D_DESC desc;
+    texturePtr->GetDesc(&desc);
+
+    D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc;
+    srvDesc.Format = desc.Format;
+    srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+    srvDesc.Texture2D.MostDetailedMip = desc.MipLevels - 1;
+    srvDesc.Texture2D.MipLevels = desc.MipLevels;
+    winrt::com_ptr<ID3D11ShaderResourceView> srv;
+    winrt::check_hresult(mDevice->CreateShaderResourceView(
+        texturePtr,
+        &srvDesc,
+        srv.put()
+    ));
+    return std::make_shared<D3D11TextureView>(srv.as<ID3D11View>());
+}
+
+ID3D11RenderTargetView* D3D11ViewDevice::RenderTargetView(const TextureView& view)
+{
+    return static_cast<ID3D11RenderTargetView*>(static_cast<const D3D11TextureView&>(view).Get());
+}
+
+ID3D11ShaderResourceView* D3D11ViewDevice::ShaderResourceView(const TextureView& view)
+{
+    return static_cast<ID3D11ShaderResourceView*>(static_cast<const D3D11TextureView&>(view).Get());
+}
@@ -0,0 +1,40 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include "ViewDevice.h"
+
+// Views of D3D11 textures, covering the whole texture in its own format
+class D3D11ViewDevice : public ViewDevice
+{
+public:
+    D3D11ViewDevice(winrt::com_ptr<ID3D11Device> device);
+
+    virtual ~D3D11ViewDevice();
+
+    // Inherited via ViewDevice, the texture is an ID3D11Texture2D
+    virtual std::shared_ptr<TextureView> CreateView(void* texture, ViewKind kind) override;
+
+    // The D3D11 views behind views created by this device
+    static ID3D11RenderTargetView* RenderTargetView(const TextureView& view);
+    static ID3D11ShaderResourceView* ShaderResourceView(const TextureView& view);
+
+private:
+    winrt::com_ptr<ID3D11Device> mDevice;
+};
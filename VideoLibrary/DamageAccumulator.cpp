@@ -0,0 +1,116 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "DamageAccumulator.h"
+
+DamageAccumulator::DamageAccumulator()
+    : mAccumulatedArea{ 0 }
+    , mAppliedArea{ 0 }
+    , mSkippedFrames{ 0 }
+    , mRecoveredFrames{ 0 }
+{
+}
+
+void DamageAccumulator::Accumulate(
+    const RECT* dirtyRects,
+    size_t dirtyRectsCount,
+    const DXGI_OUTDUPL_MOVE_RECT* moveRects,
+    size_t moveRectsCount)
+{
+    const int64_t areaBefore = mPending.Area();
+
+    mPending.Union(dirtyRects, dirtyRectsCount);
+    AddMoveDestinations(moveRects, moveRectsCount, mPending);
+
+    mAccumulatedArea += mPending.Area() - areaBefore;
+    ++mSkippedFrames;
+}
+
+bool DamageAccumulator::Apply(
+    const RECT* dirtyRects,
+    size_t dirtyRectsCount,
+    const DXGI_OUTDUPL_MOVE_RECT* moveRects,
+    size_t moveRectsCount,
+    Region& damage)
+{
+    damage.Reset(dirtyRects, dirtyRectsCount);
+
+    if (mPending.IsEmpty())
+    {
+        return true;
+    }
+
+    mAppliedArea += mPending.Area();
+    ++mRecoveredFrames;
+
+    AddMoveDestinations(moveRects, moveRectsCount, damage);
+    damage.Union(mPending);
+    mPending.Clear();
+    return false;
+}
+
+bool DamageAccumulator::HasPendingDamage() const
+{
+    return !mPending.IsEmpty();
+}
+
+const Region& DamageAccumulator::PendingDamage() const
+{
+    return mPending;
+}
+
+void DamageAccumulator::Reset()
+{
+    mPending.Clear();
+}
+
+int64_t DamageAccumulator::AccumulatedArea() const
+{
+    return mAccumulatedArea;
+}
+
+int64_t DamageAccumulator::AppliedArea() const
+{
+    return mAppliedArea;
+}
+
+uint64_t DamageAccumulator::SkippedFrames() const
+{
+    return mSkippedFrames;
+}
+
+uint64_t DamageAccumulator::RecoveredFrames() const
+{
+    return mRecoveredFrames;
+}
+
+void DamageAccumulator::AddMoveDestinations(const DXGI_OUTDUPL_MOVE_RECT* moveRects, size_t moveRectsCount, Region& region)
+{
+    if (moveRectsCount == 0)
+    {
+        return;
+    }
+
+    mMoveDestinations.clear();
+    for (size_t i = 0; i < moveRectsCount; ++i)
+    {
+        mMoveDestinations.push_back(moveRects[i].DestinationRect);
+    }
+    region.Union(mMoveDestinations.data(), mMoveDestinations.size());
+}
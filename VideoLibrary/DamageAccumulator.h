@@ -0,0 +1,81 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "PlatformTypes.h"
+#include "Region.h"
+#include <cstdint>
+#include <vector>
+
+/*
+    Carries damage forward across frames that were captured but could not be drawn,
+    for example when the shared surface's keyed mutex timed out.
+
+    The duplication API always hands out a complete desktop image, so the pixels
+    that changed during skipped frames can be redrawn from the next frame's image.
+    Only the changed areas matter: the dirty rects and the destinations of the
+    move rects. Move rects of the next frame are also turned into damage while
+    damage is pending, because their sources may be stale on the shared surface.
+*/
+class DamageAccumulator
+{
+public:
+    DamageAccumulator();
+
+    // Records the damage of a frame that was captured but not drawn
+    void Accumulate(
+        const RECT* dirtyRects,
+        size_t dirtyRectsCount,
+        const DXGI_OUTDUPL_MOVE_RECT* moveRects,
+        size_t moveRectsCount);
+
+    // Builds the damage to draw for a frame that is about to be drawn and clears the pending damage.
+    // Returns false when the frame's move rects were folded into damage and must not be drawn as moves.
+    bool Apply(
+        const RECT* dirtyRects,
+        size_t dirtyRectsCount,
+        const DXGI_OUTDUPL_MOVE_RECT* moveRects,
+        size_t moveRectsCount,
+        Region& damage);
+
+    bool HasPendingDamage() const;
+    const Region& PendingDamage() const;
+
+    // Drops pending damage, e.g. after the whole surface was redrawn
+    void Reset();
+
+    // Pixels added to the pending damage, counted once even when several skipped frames touch them
+    int64_t AccumulatedArea() const;
+
+    // Pixels of pending damage that were drawn by a later frame
+    int64_t AppliedArea() const;
+
+    uint64_t SkippedFrames() const;
+    uint64_t RecoveredFrames() const;
+
+private:
+    void AddMoveDestinations(const DXGI_OUTDUPL_MOVE_RECT* moveRects, size_t moveRectsCount, Region& region);
+
+    Region mPending;
+    std::vector<RECT> mMoveDestinations;
+    int64_t mAccumulatedArea;
+    int64_t mAppliedArea;
+    uint64_t mSkippedFrames;
+    uint64_t mRecoveredFrames;
+};
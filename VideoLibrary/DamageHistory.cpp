@@ -0,0 +1,105 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "pch.h"
+#include "DamageHistory.h"
+
+#include <stdexcept>
+
+DamageHistory::DamageHistory(const RECT& bounds, size_t depth)
+    : mBounds{ bounds }
+    , mBoundsArea{ static_cast<int64_t>(bounds.right - bounds.left) * (bounds.bottom - bounds.top) }
+    , mFrames(depth)
+    , mGeneration{ UnknownGeneration + 1 }
+    , mPartialCopies{ 0 }
+    , mFullCopies{ 0 }
+    , mAreaSaved{ 0 }
+{
+    if (depth == 0)
+    {
+        throw std::invalid_argument("damage history depth must not be zero");
+    }
+
+    if (bounds.right <= bounds.left || bounds.bottom <= bounds.top)
+    {
+        throw std::invalid_argument("damage history bounds are empty");
+    }
+}
+
+uint64_t DamageHistory::Add(const Region& damage)
+{
+    ++mGeneration;
+    Region& frame = mFrames[mGeneration % mFrames.size()];
+    frame = damage;
+    frame.Clip(mBounds);
+    return mGeneration;
+}
+
+uint64_t DamageHistory::Generation() const
+{
+    return mGeneration;
+}
+
+bool DamageHistory::DamageSince(uint64_t generation, Region& damage)
+{
+    const bool known =
+        generation != UnknownGeneration &&
+        generation <= mGeneration &&
+        mGeneration - generation <= mFrames.size();
+
+    if (known)
+    {
+        for (uint64_t frame = generation + 1; frame <= mGeneration; ++frame)
+        {
+            damage.Union(mFrames[frame % mFrames.size()]);
+        }
+        damage.Clip(mBounds);
+    }
+
+    // past half the surface, or in many small pieces, one copy of everything is cheaper
+    if (!known || damage.RectsCount() > MaxRects || damage.Area() * 2 > mBoundsArea)
+    {
+        ++mFullCopies;
+        return false;
+    }
+
+    ++mPartialCopies;
+    mAreaSaved += mBoundsArea - damage.Area();
+    return true;
+}
+
+const RECT& DamageHistory::Bounds() const
+{
+    return mBounds;
+}
+
+uint64_t DamageHistory::PartialCopies() const
+{
+    return mPartialCopies;
+}
+
+uint64_t DamageHistory::FullCopies() const
+{
+    return mFullCopies;
+}
+
+int64_t DamageHistory::AreaSaved() const
+{
+    return mAreaSaved;
+}
@@ -0,0 +1,78 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "PlatformTypes.h"
+#include "Region.h"
+#include <cstdint>
+#include <vector>
+
+/*
+    Damage of the last few frames drawn to a surface, so copies of the surface
+    can be brought up to date by copying only what changed since they were taken,
+    like buffer age in EGL.
+
+    Every frame adds its damage and advances the generation. A copy remembers the
+    generation it matches and asks for the damage since then. Copies older than the
+    history, or whose damage is so large or fragmented that one full copy is cheaper,
+    are told to copy everything.
+*/
+class DamageHistory
+{
+public:
+    // Frames kept, more than the texture pool normally cycles through
+    static constexpr size_t DefaultDepth = 8;
+
+    // Damage made of more rects than this is copied in one go
+    static constexpr size_t MaxRects = 64;
+
+    // The generation of copies whose contents are unknown, such as new textures
+    static constexpr uint64_t UnknownGeneration = 0;
+
+    DamageHistory(const RECT& bounds, size_t depth = DefaultDepth);
+
+    // Records the damage of a frame drawn to the surface and returns the new generation
+    uint64_t Add(const Region& damage);
+
+    // The generation of the surface as it is now
+    uint64_t Generation() const;
+
+    // Adds the damage since the given generation to damage, clipped to the bounds.
+    // Returns false when the whole surface has to be copied instead.
+    bool DamageSince(uint64_t generation, Region& damage);
+
+    const RECT& Bounds() const;
+
+    // Requests answered with damage, and with a full copy
+    uint64_t PartialCopies() const;
+    uint64_t FullCopies() const;
+
+    // Pixels partial copies did not have to copy
+    int64_t AreaSaved() const;
+
+private:
+    RECT mBounds;
+    int64_t mBoundsArea;
+    std::vector<Region> mFrames;
+    uint64_t mGeneration;
+    uint64_t mPartialCopies;
+    uint64_t mFullCopies;
+    int64_t mAreaSaved;
+};
@@ -23,10 +23,12 @@
 
 DesktopPointer::DesktopPointer(RECT virtualDesktopBounds)
     : mIsPointerTextureStale { true }
+    , mShapeVersion{ 0 }
     , mPointerOwnerIndex { UINT_MAX }
     , mLastUpdateTime { 0 }
     , mPosition{}
     , mShapeInfo{}
+    , mPointerTextureBounds{}
     , mVisible{ false }
     , mVirtualDesktopBounds{ virtualDesktopBounds }
 {
@@ -44,6 +46,7 @@ std::size_t DesktopPointer::BufferSize() const
 byte* DesktopPointer::PutBuffer(std::size_t requiredSize)
 {
     mIsPointerTextureStale = true;
+    ++mShapeVersion;
 
     if (requiredSize > mBuffer.size()) {
         mBuffer.resize(requiredSize);
@@ -52,6 +55,11 @@ byte* DesktopPointer::PutBuffer(std::size_t requiredSize)
     return mBuffer.data();
 }
 
+const byte* DesktopPointer::Buffer() const
+{
+    return mBuffer.data();
+}
+
 DXGI_OUTDUPL_POINTER_POSITION DesktopPointer::Position() const
 {
     return mPosition;
@@ -104,12 +112,13 @@ void DesktopPointer::ShapeInfo(DXGI_OUTDUPL_POINTER_SHAPE_INFO newShapeInfo)
     mShapeInfo = newShapeInfo;
 }
 
-void DesktopPointer::UpdateTexture(winrt::com_ptr<ID3D11Texture2D> const& newImage)
+void DesktopPointer::UpdateTexture(winrt::com_ptr<ID3D11Texture2D> const& newImage, RECT textureBounds)
 {
     if (mPointerTexture) {
         mPointerTexture = nullptr;
     }
     mPointerTexture = newImage;
+    mPointerTextureBounds = textureBounds;
     mIsPointerTextureStale = false;
 }
 
@@ -118,7 +127,49 @@ winrt::com_ptr<ID3D11Texture2D> DesktopPointer::Texture() const
     return mPointerTexture;
 }
 
+RECT DesktopPointer::TextureBounds() const
+{
+    return mPointerTextureBounds;
+}
+
+bool DesktopPointer::TextureStale() const
+{
+    return mIsPointerTextureStale;
+}
+
 bool DesktopPointer::Visible() const
 {
     return mVisible;
 }
+
+void DesktopPointer::CopyState(const DesktopPointer& other)
+{
+    if (other.mShapeVersion != mShapeVersion)
+    {
+        mBuffer = other.mBuffer;
+        mShapeVersion = other.mShapeVersion;
+        mIsPointerTextureStale = true;
+    }
+
+    mShapeInfo = other.mShapeInfo;
+    mPosition = other.mPosition;
+    mLastUpdateTime = other.mLastUpdateTime;
+    mPointerOwnerIndex = other.mPointerOwnerIndex;
+    mVisible = other.mVisible;
+}
+
+RECT DesktopPointer::Bounds() const
+{
+    LONG height = static_cast<LONG>(mShapeInfo.Height);
+    if (mShapeInfo.Type == DXGI_OUTDUPL_POINTER_SHAPE_TYPE_MONOCHROME)
+    {
+        // monochrome shapes hold the AND mask followed by the XOR mask
+        height /= 2;
+    }
+
+    return RECT{
+        mPosition.Position.x,
+        mPosition.Position.y,
+        mPosition.Position.x + static_cast<LONG>(mShapeInfo.Width),
+        mPosition.Position.y + height };
+}
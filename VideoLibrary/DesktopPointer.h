@@ -29,6 +29,9 @@ public:
 
     byte* PutBuffer(std::size_t requiredSize = 0);
 
+    // The shape buffer for reading, unlike PutBuffer it keeps the texture current
+    const byte* Buffer() const;
+
     /*
         TODO in a multi monitor recording scenario, need to offset the Position based on entire virtual desktop
         The returned position will work when recording a single monitor because it is
@@ -40,16 +43,31 @@ public:
     DXGI_OUTDUPL_POINTER_SHAPE_INFO ShapeInfo() const;
     void ShapeInfo(DXGI_OUTDUPL_POINTER_SHAPE_INFO newShapeInfo);
 
-    void UpdateTexture(winrt::com_ptr<ID3D11Texture2D> const& newImage);
+    void UpdateTexture(winrt::com_ptr<ID3D11Texture2D> const& newImage, RECT textureBounds = {});
     winrt::com_ptr<ID3D11Texture2D> Texture() const;
 
+    // Where a texture composed with the desktop belongs, which can lag Bounds()
+    RECT TextureBounds() const;
+
+    // True when the shape changed since the last UpdateTexture
+    bool TextureStale() const;
+
     bool Visible() const;
 
+    // Takes the shape and position of another pointer. The texture is kept
+    // unless the other pointer's shape changed since the last copy
+    void CopyState(const DesktopPointer& other);
+
+    // The area covered by the pointer shape, in the same coordinates as Position()
+    RECT Bounds() const;
+
 private:
     std::vector<byte> mBuffer;
+    uint64_t mShapeVersion;
     DXGI_OUTDUPL_POINTER_SHAPE_INFO mShapeInfo;
     bool mIsPointerTextureStale;
     winrt::com_ptr<ID3D11Texture2D> mPointerTexture;
+    RECT mPointerTextureBounds;
     DXGI_OUTDUPL_POINTER_POSITION mPosition;
     LARGE_INTEGER mLastUpdateTime;
     UINT mPointerOwnerIndex;
@@ -0,0 +1,168 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "pch.h"
+#include "DirtyRectCoalescer.h"
+
+namespace
+{
+    // Number of most recently emitted rects a new rect is compared against.
+    // Rects are sorted by top edge, so anything further back is usually far above.
+    constexpr size_t MergeWindow = 16;
+
+    // Merging changes the sort order, so a couple of passes catch merges
+    // that only become possible after a box has grown
+    constexpr int MaxMergePasses = 4;
+
+    RECT BoundingBox(const RECT& a, const RECT& b)
+    {
+        return RECT{
+            std::min(a.left, b.left),
+            std::min(a.top, b.top),
+            std::max(a.right, b.right),
+            std::max(a.bottom, b.bottom) };
+    }
+}
+
+DirtyRectCoalescer::DirtyRectCoalescer(LONG pixelsPerRectCost)
+    : mPixelsPerRectCost{ pixelsPerRectCost }
+    , mInputArea{ 0 }
+    , mOutputArea{ 0 }
+{
+}
+
+LONG DirtyRectCoalescer::PixelsPerRectCost() const
+{
+    return mPixelsPerRectCost;
+}
+
+void DirtyRectCoalescer::PixelsPerRectCost(LONG pixelsPerRectCost)
+{
+    mPixelsPerRectCost = pixelsPerRectCost;
+}
+
+void DirtyRectCoalescer::Coalesce(const RECT* rects, size_t count)
+{
+    mRects.clear();
+    mInputArea = 0;
+    mOutputArea = 0;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const RECT& rect = rects[i];
+        if (rect.right <= rect.left || rect.bottom <= rect.top)
+        {
+            continue;
+        }
+
+        mInputArea += Area(rect);
+        mRects.push_back(rect);
+    }
+
+    for (int pass = 0; pass < MaxMergePasses; ++pass)
+    {
+        if (MergePass() == 0)
+        {
+            break;
+        }
+    }
+
+    for (const RECT& rect : mRects)
+    {
+        mOutputArea += Area(rect);
+    }
+}
+
+const RECT* DirtyRectCoalescer::Rects() const
+{
+    return mRects.data();
+}
+
+size_t DirtyRectCoalescer::RectsCount() const
+{
+    return mRects.size();
+}
+
+int64_t DirtyRectCoalescer::InputArea() const
+{
+    return mInputArea;
+}
+
+int64_t DirtyRectCoalescer::OutputArea() const
+{
+    return mOutputArea;
+}
+
+int64_t DirtyRectCoalescer::Area(const RECT& rect)
+{
+    return static_cast<int64_t>(rect.right - rect.left) * static_cast<int64_t>(rect.bottom - rect.top);
+}
+
+bool DirtyRectCoalescer::ShouldMerge(const RECT& a, const RECT& b) const
+{
+    // cheap rejection: the gap alone already costs more than a rect
+    const int64_t gapX = static_cast<int64_t>(std::max(a.left, b.left)) - std::min(a.right, b.right);
+    const int64_t gapY = static_cast<int64_t>(std::max(a.top, b.top)) - std::min(a.bottom, b.bottom);
+    if (gapX > mPixelsPerRectCost || gapY > mPixelsPerRectCost)
+    {
+        return false;
+    }
+
+    const int64_t extraPixels = Area(BoundingBox(a, b)) - Area(a) - Area(b);
+    return extraPixels <= mPixelsPerRectCost;
+}
+
+size_t DirtyRectCoalescer::MergePass()
+{
+    std::sort(mRects.begin(), mRects.end(), [](const RECT& a, const RECT& b) {
+        return a.top != b.top ? a.top < b.top : a.left < b.left;
+    });
+
+    // mRects[0, emitted) holds the coalesced output, which never overtakes the input index
+    size_t merges = 0;
+    size_t emitted = 0;
+    for (size_t i = 0; i < mRects.size(); ++i)
+    {
+        RECT current = mRects[i];
+
+        bool merged = true;
+        while (merged)
+        {
+            merged = false;
+            const size_t windowStart = emitted > MergeWindow ? emitted - MergeWindow : 0;
+            for (size_t j = emitted; j-- > windowStart;)
+            {
+                if (ShouldMerge(mRects[j], current))
+                {
+                    current = BoundingBox(mRects[j], current);
+                    mRects[j] = mRects[emitted - 1];
+                    --emitted;
+                    ++merges;
+                    merged = true;
+                    break;
+                }
+            }
+        }
+
+        mRects[emitted++] = current;
+    }
+
+    mRects.resize(emitted);
+    return merges;
+}
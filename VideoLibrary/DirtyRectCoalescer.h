@@ -0,0 +1,70 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "PlatformTypes.h"
+#include <cstdint>
+#include <vector>
+
+/*
+    Merges overlapping, adjacent and nearly-adjacent dirty rects before they are
+    turned into vertices.
+
+    Drawing a rect costs its area in pixel writes plus a fixed per-rect cost
+    (vertex generation, upload and draw setup). Two rects are replaced by their
+    bounding box when the box writes no more than PixelsPerRectCost() pixels
+    more than the two rects do separately. Overlapping rects usually get cheaper
+    when merged because the overlap is no longer drawn twice.
+*/
+class DirtyRectCoalescer
+{
+public:
+    static constexpr LONG DefaultPixelsPerRectCost = 64 * 64;
+
+    DirtyRectCoalescer(LONG pixelsPerRectCost = DefaultPixelsPerRectCost);
+
+    LONG PixelsPerRectCost() const;
+    void PixelsPerRectCost(LONG pixelsPerRectCost);
+
+    // Coalesces the given rects. The result is valid until the next call.
+    void Coalesce(const RECT* rects, size_t count);
+
+    const RECT* Rects() const;
+    size_t RectsCount() const;
+
+    // Sum of the input rect areas of the last Coalesce call, overlaps included
+    int64_t InputArea() const;
+
+    // Sum of the output rect areas of the last Coalesce call
+    int64_t OutputArea() const;
+
+    static int64_t Area(const RECT& rect);
+
+private:
+
+    bool ShouldMerge(const RECT& a, const RECT& b) const;
+
+    size_t MergePass();
+
+    std::vector<RECT> mRects;
+    LONG mPixelsPerRectCost;
+    int64_t mInputArea;
+    int64_t mOutputArea;
+};
@@ -0,0 +1,61 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "DuplicationFrameSource.h"
+
+DuplicationFrameSource::DuplicationFrameSource(std::shared_ptr<ScreenDuplicator> duplicator)
+    : mDuplicator{ duplicator }
+    , mTicksPerSecond{ 0 }
+    , mAcquireTimeoutMs{ 1 }
+{
+    if (mDuplicator == nullptr)
+    {
+        throw std::exception("Null duplicator");
+    }
+
+    // present times are QueryPerformanceCounter values
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    mTicksPerSecond = frequency.QuadPart;
+}
+
+std::shared_ptr<SourceFrame> DuplicationFrameSource::AcquireFrame()
+{
+    return AcquireDuplicationFrame();
+}
+
+int64_t DuplicationFrameSource::TicksPerSecond() const
+{
+    return mTicksPerSecond;
+}
+
+std::shared_ptr<Frame> DuplicationFrameSource::AcquireDuplicationFrame()
+{
+    return std::make_shared<Frame>(*mDuplicator, mAcquireTimeoutMs);
+}
+
+std::shared_ptr<ScreenDuplicator> DuplicationFrameSource::Duplicator() const
+{
+    return mDuplicator;
+}
+
+void DuplicationFrameSource::AcquireTimeout(std::chrono::milliseconds timeout)
+{
+    mAcquireTimeoutMs = static_cast<UINT>((std::max)(timeout.count(), static_cast<std::chrono::milliseconds::rep>(0)));
+}
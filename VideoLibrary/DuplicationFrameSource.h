@@ -0,0 +1,48 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "FrameSource.h"
+#include "ScreenDuplicator.h"
+#include "Frame.h"
+#include <chrono>
+
+// Frames from the Desktop Duplication API
+class DuplicationFrameSource : public FrameSource
+{
+public:
+    DuplicationFrameSource(std::shared_ptr<ScreenDuplicator> duplicator);
+
+    // Inherited via FrameSource
+    std::shared_ptr<SourceFrame> AcquireFrame() override;
+    int64_t TicksPerSecond() const override;
+
+    // Same as AcquireFrame, keeping access to the desktop image texture
+    std::shared_ptr<Frame> AcquireDuplicationFrame();
+
+    std::shared_ptr<ScreenDuplicator> Duplicator() const;
+
+    // How long acquiring waits for the desktop to change, 1 ms by default
+    void AcquireTimeout(std::chrono::milliseconds timeout);
+
+private:
+    std::shared_ptr<ScreenDuplicator> mDuplicator;
+    int64_t mTicksPerSecond;
+    UINT mAcquireTimeoutMs;
+};
@@ -0,0 +1,66 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+//
+// DynamicBufferDevice.h
+// Creates, maps and unmaps the vertex and constant buffers the renderers
+// upload to every frame.
+//
+
+#pragma once
+#include <cstddef>
+#include <memory>
+
+enum class DynamicBufferBinding
+{
+    Vertex,
+    Constant
+};
+
+enum class BufferMapMode
+{
+    // the previous contents may still be in use by the GPU, give me fresh memory
+    Discard,
+
+    // I will only write to ranges the GPU is not using
+    NoOverwrite
+};
+
+// A CPU writable buffer created by a DynamicBufferDevice
+class DynamicBuffer
+{
+public:
+    virtual ~DynamicBuffer() = default;
+
+    virtual size_t Size() const = 0;
+};
+
+class DynamicBufferDevice
+{
+public:
+    virtual ~DynamicBufferDevice() = default;
+
+    virtual std::shared_ptr<DynamicBuffer> CreateBuffer(DynamicBufferBinding binding, size_t size) = 0;
+
+    virtual void* Map(DynamicBuffer& buffer, BufferMapMode mode) = 0;
+
+    virtual void Unmap(DynamicBuffer& buffer) = 0;
+
+    // Replaces the whole contents of a small buffer such as a constant buffer
+    void Update(DynamicBuffer& buffer, const void* data, size_t size);
+};
@@ -0,0 +1,147 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "DynamicBufferRing.h"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+    size_t AlignUp(size_t value, size_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    size_t NextPowerOfTwo(size_t value)
+    {
+        size_t result = 1;
+        while (result < value)
+        {
+            result <<= 1;
+        }
+        return result;
+    }
+}
+
+void DynamicBufferDevice::Update(DynamicBuffer& buffer, const void* data, size_t size)
+{
+    if (size > buffer.Size())
+    {
+        throw std::invalid_argument("update is larger than the buffer");
+    }
+
+    void* mapped = Map(buffer, BufferMapMode::Discard);
+    std::memcpy(mapped, data, size);
+    Unmap(buffer);
+}
+
+DynamicBufferRing::DynamicBufferRing(std::shared_ptr<DynamicBufferDevice> device, size_t capacity)
+    : mDevice{ device }
+    , mCapacity{ 0 }
+    , mCursor{ 0 }
+    , mHighWaterMark{ 0 }
+    , mDiscards{ 0 }
+    , mGrows{ 0 }
+{
+    if (mDevice == nullptr)
+    {
+        throw std::invalid_argument("null dynamic buffer device");
+    }
+
+    if (capacity == 0)
+    {
+        throw std::invalid_argument("dynamic buffer ring capacity must not be zero");
+    }
+
+    // created on first write so an unused ring costs nothing
+    mCapacity = capacity;
+}
+
+BufferSpan DynamicBufferRing::Write(const void* data, size_t size, size_t alignment)
+{
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0)
+    {
+        throw std::invalid_argument("alignment must be a power of two");
+    }
+
+    if (size == 0)
+    {
+        return BufferSpan{ mBuffer.get(), 0, 0 };
+    }
+
+    mHighWaterMark = (std::max)(mHighWaterMark, size);
+    const size_t wanted = NextPowerOfTwo(mHighWaterMark * WritesPerRing);
+    if (mBuffer == nullptr || mCapacity < wanted)
+    {
+        Grow((std::max)(mCapacity, wanted));
+    }
+
+    size_t offset = AlignUp(mCursor, alignment);
+    BufferMapMode mode = BufferMapMode::NoOverwrite;
+    if (offset == 0 || offset + size > mCapacity)
+    {
+        // wrapped, everything written before may still be in flight
+        offset = 0;
+        mode = BufferMapMode::Discard;
+        ++mDiscards;
+    }
+
+    uint8_t* mapped = static_cast<uint8_t*>(mDevice->Map(*mBuffer, mode));
+    std::memcpy(mapped + offset, data, size);
+    mDevice->Unmap(*mBuffer);
+
+    mCursor = offset + size;
+    return BufferSpan{ mBuffer.get(), offset, size };
+}
+
+DynamicBufferDevice& DynamicBufferRing::Device() const
+{
+    return *mDevice;
+}
+
+size_t DynamicBufferRing::Capacity() const
+{
+    return mCapacity;
+}
+
+size_t DynamicBufferRing::HighWaterMark() const
+{
+    return mHighWaterMark;
+}
+
+uint64_t DynamicBufferRing::Discards() const
+{
+    return mDiscards;
+}
+
+uint64_t DynamicBufferRing::Grows() const
+{
+    return mGrows;
+}
+
+void DynamicBufferRing::Grow(size_t capacity)
+{
+    mBuffer = mDevice->CreateBuffer(DynamicBufferBinding::Vertex, capacity);
+    mCapacity = capacity;
+
+    // a new buffer starts with a discard
+    mCursor = 0;
+    ++mGrows;
+}
@@ -0,0 +1,75 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+//
+// DynamicBufferRing.h
+// Suballocates per frame vertex data from one persistent dynamic buffer.
+// Writes are appended with no-overwrite maps and the buffer is only discarded
+// when the ring wraps, so steady state recording creates no buffers.
+// The buffer grows from the largest write seen, it never shrinks.
+//
+
+#pragma once
+#include "DynamicBufferDevice.h"
+#include <cstdint>
+
+// Where a write landed in the ring
+struct BufferSpan
+{
+    DynamicBuffer* Buffer;
+    size_t Offset;
+    size_t Size;
+};
+
+class DynamicBufferRing
+{
+public:
+    static constexpr size_t DefaultCapacity = 64 * 1024;
+
+    // The ring holds at least this many of the largest writes before wrapping,
+    // leaving the GPU time to finish with the data before it is discarded
+    static constexpr size_t WritesPerRing = 8;
+
+    DynamicBufferRing(std::shared_ptr<DynamicBufferDevice> device, size_t capacity = DefaultCapacity);
+
+    // Copies size bytes into the ring at an offset that is a multiple of alignment
+    BufferSpan Write(const void* data, size_t size, size_t alignment);
+
+    DynamicBufferDevice& Device() const;
+
+    size_t Capacity() const;
+
+    // Largest single write so far
+    size_t HighWaterMark() const;
+
+    uint64_t Discards() const;
+
+    // Buffers created so far, including the first
+    uint64_t Grows() const;
+
+private:
+    void Grow(size_t capacity);
+
+    std::shared_ptr<DynamicBufferDevice> mDevice;
+    std::shared_ptr<DynamicBuffer> mBuffer;
+    size_t mCapacity;
+    size_t mCursor;
+    size_t mHighWaterMark;
+    uint64_t mDiscards;
+    uint64_t mGrows;
+};
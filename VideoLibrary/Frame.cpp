@@ -21,21 +21,20 @@
 #include "Errors.h"
 #include "Frame.h"
 
-Frame::Frame(ScreenDuplicator& duplicator)
+Frame::Frame(ScreenDuplicator& duplicator, UINT timeoutMs)
     : mDupl{ duplicator.Duplication()}
     , mCaptured{ false }
-    , mRectBuffer{ duplicator.Buffer()}
+    , mAcquired{ false }
     , mNumMoveRects{ 0 }
     , mNumDirtyRects{ 0 }
-    , mMoveRects{ nullptr }
-    , mDirtyRects{ nullptr }
     , mDesktopMonitorBounds{ }
+    , mFrameInfo{ }
     , mRotation{ DXGI_MODE_ROTATION_UNSPECIFIED }
 {
     try
     {
         winrt::com_ptr<IDXGIResource> desktopImageResource;
-        HRESULT hr = mDupl->AcquireNextFrame(1, &mFrameInfo, desktopImageResource.put());
+        HRESULT hr = mDupl->AcquireNextFrame(timeoutMs, &mFrameInfo, desktopImageResource.put());
 
         if (hr == DXGI_ERROR_WAIT_TIMEOUT || hr == DXGI_STATUS_OCCLUDED)
         {
@@ -45,6 +44,7 @@ Frame::Frame(ScreenDuplicator& duplicator)
         winrt::check_hresult(hr);
 
         mCaptured = true;
+        mAcquired = true;
         mFrameTexture = desktopImageResource.as<ID3D11Texture2D>();
 
         // Don't care about move or dirty rects, just get the pointer data and update the pointer cache
@@ -75,21 +75,20 @@ Frame::Frame(ScreenDuplicator& duplicator)
         if (mFrameInfo.TotalMetadataBufferSize != 0) {
 
             UINT totalBufferSize = mFrameInfo.TotalMetadataBufferSize;
-            if (totalBufferSize > mRectBuffer->size()) {
-                mRectBuffer->resize(totalBufferSize);
-            }
+            mMetadata = duplicator.MetadataPool()->Acquire();
+            mMetadata.Resize(totalBufferSize);
 
             UINT moveRectsBufferSize = 0;
             winrt::check_hresult(mDupl->GetFrameMoveRects(
                 totalBufferSize,
-                reinterpret_cast<DXGI_OUTDUPL_MOVE_RECT*>(mRectBuffer->data()),
+                reinterpret_cast<DXGI_OUTDUPL_MOVE_RECT*>(mMetadata.Data()),
                 &moveRectsBufferSize));
 
             UINT dirtyRectsBufferSize = totalBufferSize - moveRectsBufferSize;
 
             winrt::check_hresult(mDupl->GetFrameDirtyRects(
                 dirtyRectsBufferSize,
-                reinterpret_cast<RECT*>(mRectBuffer->data() + moveRectsBufferSize),
+                reinterpret_cast<RECT*>(mMetadata.Data() + moveRectsBufferSize),
                 &dirtyRectsBufferSize));
 
             mNumMoveRects = moveRectsBufferSize / sizeof(DXGI_OUTDUPL_MOVE_RECT);
@@ -105,15 +104,22 @@ Frame::Frame(ScreenDuplicator& duplicator)
 
 Frame::~Frame()
 {
-    if (mDupl)
+    try
     {
-        try
-        {
-            (void)mDupl->ReleaseFrame();
-        }
-        catch (...)
-        {
-        }
+        ReleaseFrame();
+    }
+    catch (...)
+    {
+    }
+}
+
+void Frame::ReleaseFrame()
+{
+    if (mDupl && mAcquired)
+    {
+        mAcquired = false;
+        mFrameTexture = nullptr;
+        (void)mDupl->ReleaseFrame();
     }
 }
 
@@ -151,16 +157,61 @@ bool Frame::Captured() const
 
 DXGI_MODE_ROTATION Frame::Rotation() const { return mRotation; }
 
-DXGI_OUTDUPL_MOVE_RECT* Frame::MoveRects() const
+const DXGI_OUTDUPL_MOVE_RECT* Frame::MoveRects() const
 {
-    return reinterpret_cast<DXGI_OUTDUPL_MOVE_RECT*>(mRectBuffer->data());
+    return reinterpret_cast<DXGI_OUTDUPL_MOVE_RECT*>(mMetadata.Data());
 }
 
-RECT* Frame::DirtyRects() const
+const RECT* Frame::DirtyRects() const
 {
-    return reinterpret_cast<RECT*>(mRectBuffer->data() + (mNumMoveRects * sizeof(DXGI_OUTDUPL_MOVE_RECT)));
+    return reinterpret_cast<RECT*>(mMetadata.Data() + (mNumMoveRects * sizeof(DXGI_OUTDUPL_MOVE_RECT)));
 }
 
 size_t Frame::MoveRectsCount() const { return mNumMoveRects; }
 
 size_t Frame::DirtyRectsCount() const { return mNumDirtyRects; }
+
+DXGI_OUTDUPL_POINTER_POSITION Frame::PointerPosition() const
+{
+    return mFrameInfo.PointerPosition;
+}
+
+int64_t Frame::PointerUpdateTime() const
+{
+    return mFrameInfo.LastMouseUpdateTime.QuadPart;
+}
+
+bool Frame::PointerShapeUpdated() const
+{
+    return mCaptured && mFrameInfo.LastMouseUpdateTime.QuadPart != 0 && mFrameInfo.PointerShapeBufferSize != 0;
+}
+
+void Frame::DirtyRegion(Region& region) const
+{
+    region.Reset(DirtyRects(), mNumDirtyRects);
+}
+
+void Frame::MoveSourceRegion(Region& region) const
+{
+    region.Clear();
+    const DXGI_OUTDUPL_MOVE_RECT* moveRects = MoveRects();
+    for (size_t i = 0; i < mNumMoveRects; ++i)
+    {
+        const RECT& destination = moveRects[i].DestinationRect;
+        region.Union(RECT{
+            moveRects[i].SourcePoint.x,
+            moveRects[i].SourcePoint.y,
+            moveRects[i].SourcePoint.x + destination.right - destination.left,
+            moveRects[i].SourcePoint.y + destination.bottom - destination.top });
+    }
+}
+
+void Frame::MoveDestinationRegion(Region& region) const
+{
+    region.Clear();
+    const DXGI_OUTDUPL_MOVE_RECT* moveRects = MoveRects();
+    for (size_t i = 0; i < mNumMoveRects; ++i)
+    {
+        region.Union(moveRects[i].DestinationRect);
+    }
+}
@@ -20,45 +20,60 @@
 #pragma once
 
 #include "ScreenDuplicator.h"
+#include "Region.h"
+#include "FrameSource.h"
 
-class Frame
+class Frame : public SourceFrame
 {
 public:
-    Frame(ScreenDuplicator& duplicator);
+    // Waits up to timeoutMs for the desktop to change before giving up on a frame
+    Frame(ScreenDuplicator& duplicator, UINT timeoutMs = 1);
     ~Frame();
 
+    // Returns the desktop image to the duplication API. Move and dirty rects stay valid
+    // because they live in a pooled metadata block owned by this frame.
+    void ReleaseFrame();
+
     winrt::com_ptr<ID3D11Texture2D> DesktopImage() const;
 
-    RECT DesktopMonitorBounds() const;
+    // Inherited via SourceFrame
+    RECT DesktopMonitorBounds() const override;
+
+    int64_t PresentationTime() const override;
 
-    int64_t PresentationTime() const;
+    bool Captured() const override;
 
-    bool Captured() const;
+    DXGI_MODE_ROTATION Rotation() const override;
 
-    DXGI_MODE_ROTATION Rotation() const;
+    const DXGI_OUTDUPL_MOVE_RECT* MoveRects() const override;
 
-    DXGI_OUTDUPL_MOVE_RECT* MoveRects() const;
+    const RECT* DirtyRects() const override;
 
-    RECT* DirtyRects() const;
+    size_t MoveRectsCount() const override;
 
-    size_t MoveRectsCount() const;
+    size_t DirtyRectsCount() const override;
 
-    size_t DirtyRectsCount() const;
+    DXGI_OUTDUPL_POINTER_POSITION PointerPosition() const override;
+    int64_t PointerUpdateTime() const override;
+    bool PointerShapeUpdated() const override;
+
+    // The frame's damage as regions, in desktop image coordinates
+    void DirtyRegion(Region& region) const;
+    void MoveSourceRegion(Region& region) const;
+    void MoveDestinationRegion(Region& region) const;
 
 private:
     RECT mDesktopMonitorBounds;
     winrt::com_ptr<ID3D11Texture2D> mFrameTexture;
     DXGI_OUTDUPL_FRAME_INFO mFrameInfo;
     winrt::com_ptr<IDXGIOutputDuplication> mDupl;
-    std::shared_ptr<std::vector<byte>> mRectBuffer;
+    FrameMetadata mMetadata;
 
     bool mCaptured;
+    bool mAcquired;
 
     // move/dirty rects data
-    DXGI_OUTDUPL_MOVE_RECT* mMoveRects;
     size_t mNumMoveRects;
-
-    RECT* mDirtyRects;
     size_t mNumDirtyRects;
 
     DXGI_MODE_ROTATION mRotation;
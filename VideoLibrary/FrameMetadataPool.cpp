@@ -0,0 +1,173 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "FrameMetadataPool.h"
+
+FrameMetadataBlock::FrameMetadataBlock(size_t capacity)
+    : mData(capacity)
+    , mSize{ 0 }
+    , mReferences{ 0 }
+{
+}
+
+byte* FrameMetadataBlock::Data() { return mData.data(); }
+
+const byte* FrameMetadataBlock::Data() const { return mData.data(); }
+
+size_t FrameMetadataBlock::Size() const { return mSize; }
+
+size_t FrameMetadataBlock::Capacity() const { return mData.size(); }
+
+FrameMetadata::FrameMetadata()
+    : mBlock{ nullptr }
+{
+}
+
+FrameMetadata::FrameMetadata(FrameMetadataBlock* block)
+    : mBlock{ block }
+{
+    if (mBlock)
+    {
+        mBlock->mReferences.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+FrameMetadata::FrameMetadata(const FrameMetadata& other)
+    : FrameMetadata(other.mBlock)
+{
+}
+
+FrameMetadata::FrameMetadata(FrameMetadata&& other) noexcept
+    : mBlock{ other.mBlock }
+{
+    other.mBlock = nullptr;
+}
+
+FrameMetadata& FrameMetadata::operator=(FrameMetadata other) noexcept
+{
+    std::swap(mBlock, other.mBlock);
+    return *this;
+}
+
+FrameMetadata::~FrameMetadata()
+{
+    if (mBlock == nullptr || mBlock->mReferences.fetch_sub(1, std::memory_order_acq_rel) != 1)
+    {
+        return;
+    }
+
+    // the pool may be destroyed when owner goes out of scope, after the block is returned
+    std::shared_ptr<FrameMetadataPool> owner = std::move(mBlock->mOwner);
+    owner->Release(mBlock);
+}
+
+FrameMetadata::operator bool() const { return mBlock != nullptr; }
+
+byte* FrameMetadata::Data() const { return mBlock ? mBlock->Data() : nullptr; }
+
+size_t FrameMetadata::Size() const { return mBlock ? mBlock->Size() : 0; }
+
+size_t FrameMetadata::Capacity() const { return mBlock ? mBlock->Capacity() : 0; }
+
+void FrameMetadata::Resize(size_t size)
+{
+    if (mBlock == nullptr)
+    {
+        throw std::logic_error("resize of empty frame metadata");
+    }
+
+    if (size > mBlock->Capacity())
+    {
+        mBlock->mData.resize(size);
+        mBlock->mOwner->CountAllocation();
+    }
+
+    mBlock->mSize = size;
+}
+
+uint32_t FrameMetadata::UseCount() const
+{
+    return mBlock ? mBlock->mReferences.load(std::memory_order_relaxed) : 0;
+}
+
+FrameMetadataPool::FrameMetadataPool(size_t blockCount, size_t blockCapacity)
+    : mBlockCapacity{ blockCapacity }
+    , mAllocations{ 0 }
+{
+    mBlocks.reserve(blockCount);
+    mFree.reserve(blockCount);
+    for (size_t i = 0; i < blockCount; ++i)
+    {
+        mBlocks.push_back(std::make_unique<FrameMetadataBlock>(blockCapacity));
+        mFree.push_back(mBlocks.back().get());
+    }
+}
+
+FrameMetadata FrameMetadataPool::Acquire()
+{
+    FrameMetadataBlock* block = nullptr;
+    {
+        std::lock_guard<std::mutex> lock{ mMutex };
+        if (mFree.empty())
+        {
+            // more frames in flight than expected, grow the pool
+            mBlocks.push_back(std::make_unique<FrameMetadataBlock>(mBlockCapacity));
+            mFree.reserve(mBlocks.size());
+            block = mBlocks.back().get();
+            CountAllocation();
+        }
+        else
+        {
+            block = mFree.back();
+            mFree.pop_back();
+        }
+    }
+
+    block->mSize = 0;
+    block->mOwner = shared_from_this();
+    return FrameMetadata{ block };
+}
+
+size_t FrameMetadataPool::BlockCount() const
+{
+    std::lock_guard<std::mutex> lock{ mMutex };
+    return mBlocks.size();
+}
+
+size_t FrameMetadataPool::FreeCount() const
+{
+    std::lock_guard<std::mutex> lock{ mMutex };
+    return mFree.size();
+}
+
+size_t FrameMetadataPool::Allocations() const
+{
+    return mAllocations.load(std::memory_order_relaxed);
+}
+
+void FrameMetadataPool::Release(FrameMetadataBlock* block)
+{
+    std::lock_guard<std::mutex> lock{ mMutex };
+    mFree.push_back(block);
+}
+
+void FrameMetadataPool::CountAllocation()
+{
+    mAllocations.fetch_add(1, std::memory_order_relaxed);
+}
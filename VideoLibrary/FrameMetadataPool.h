@@ -0,0 +1,131 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "PlatformTypes.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class FrameMetadataPool;
+
+// One frame's move and dirty rects. Owned by a FrameMetadataPool and shared through FrameMetadata handles.
+class FrameMetadataBlock
+{
+public:
+    explicit FrameMetadataBlock(size_t capacity);
+
+    FrameMetadataBlock(const FrameMetadataBlock&) = delete;
+    FrameMetadataBlock& operator=(const FrameMetadataBlock&) = delete;
+
+    byte* Data();
+    const byte* Data() const;
+    size_t Size() const;
+    size_t Capacity() const;
+
+private:
+    friend class FrameMetadata;
+    friend class FrameMetadataPool;
+
+    std::vector<byte> mData;
+    size_t mSize;
+    std::atomic<uint32_t> mReferences;
+
+    // Keeps the pool alive while the block is handed out
+    std::shared_ptr<FrameMetadataPool> mOwner;
+};
+
+/*
+    Intrusively refcounted handle to a FrameMetadataBlock.
+    The block goes back to its pool when the last handle is destroyed.
+*/
+class FrameMetadata
+{
+public:
+    FrameMetadata();
+    FrameMetadata(const FrameMetadata& other);
+    FrameMetadata(FrameMetadata&& other) noexcept;
+    FrameMetadata& operator=(FrameMetadata other) noexcept;
+    ~FrameMetadata();
+
+    explicit operator bool() const;
+
+    byte* Data() const;
+    size_t Size() const;
+    size_t Capacity() const;
+
+    // Sets the used size, growing the block if the frame reports more metadata than it holds
+    void Resize(size_t size);
+
+    // Number of handles sharing the block
+    uint32_t UseCount() const;
+
+private:
+    friend class FrameMetadataPool;
+
+    explicit FrameMetadata(FrameMetadataBlock* block);
+
+    FrameMetadataBlock* mBlock;
+};
+
+/*
+    Fixed set of metadata blocks, one per frame in flight.
+
+    Capture no longer writes into a single shared buffer, so a frame's rects stay
+    valid while the next frame is acquired. Blocks are recycled through a free list
+    and only allocate when more frames are in flight than the pool was sized for,
+    or when a frame reports more metadata than a block's capacity.
+*/
+class FrameMetadataPool : public std::enable_shared_from_this<FrameMetadataPool>
+{
+public:
+    static constexpr size_t DefaultBlockCount = 3;
+
+    // Enough for a few thousand rects
+    static constexpr size_t DefaultBlockCapacity = 64 * 1024;
+
+    FrameMetadataPool(size_t blockCount = DefaultBlockCount, size_t blockCapacity = DefaultBlockCapacity);
+
+    FrameMetadataPool(const FrameMetadataPool&) = delete;
+    FrameMetadataPool& operator=(const FrameMetadataPool&) = delete;
+
+    // The pool must be owned by a shared_ptr
+    FrameMetadata Acquire();
+
+    size_t BlockCount() const;
+    size_t FreeCount() const;
+
+    // Heap allocations made after construction, by growing blocks or adding blocks
+    size_t Allocations() const;
+
+private:
+    friend class FrameMetadata;
+
+    void Release(FrameMetadataBlock* block);
+
+    void CountAllocation();
+
+    mutable std::mutex mMutex;
+    std::vector<std::unique_ptr<FrameMetadataBlock>> mBlocks;
+    std::vector<FrameMetadataBlock*> mFree;
+    size_t mBlockCapacity;
+    std::atomic<size_t> mAllocations;
+};
@@ -0,0 +1,204 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "pch.h"
+#include "FramePacer.h"
+
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+
+namespace
+{
+    constexpr uint64_t NanosecondsPerSecond = 1000000000;
+}
+
+std::chrono::nanoseconds SteadyPacerClock::Now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch());
+}
+
+void SteadyPacerClock::Sleep(std::chrono::nanoseconds duration)
+{
+    std::this_thread::sleep_for(duration);
+}
+
+void SteadyPacerClock::Pause()
+{
+    std::this_thread::yield();
+}
+
+FramePacer::FramePacer(std::shared_ptr<PacerClock> clock, FramePacerOptions options)
+    : mClock{ clock }
+    , mOptions{ options }
+    , mInterval{ 0 }
+    , mStart{ 0 }
+    , mNext{ 0 }
+    , mCaughtUp{ 0 }
+    , mTicks{ 0 }
+    , mDropped{ 0 }
+    , mLate{ 0 }
+    , mWaited{ 0 }
+    , mJitterSum{ 0 }
+    , mJitterSquares{ 0 }
+    , mMaxJitter{ 0 }
+    , mSlept{ 0 }
+    , mSpun{ 0 }
+{
+    if (mClock == nullptr)
+    {
+        throw std::invalid_argument("null pacer clock");
+    }
+
+    if (mOptions.FrameRate == 0)
+    {
+        throw std::invalid_argument("frame rate must not be zero");
+    }
+
+    mInterval = std::chrono::nanoseconds{ NanosecondsPerSecond / mOptions.FrameRate };
+    Start();
+}
+
+void FramePacer::Start()
+{
+    mStart = mClock->Now();
+    mNext = 0;
+    mCaughtUp = 0;
+}
+
+FrameTick FramePacer::WaitForTick()
+{
+    FrameTick tick{};
+    const std::chrono::nanoseconds now = mClock->Now();
+    if (now > DeadlineOf(mNext))
+    {
+        ++mLate;
+        if (mOptions.LatePolicy == LateTickPolicy::CatchUp && mCaughtUp < mOptions.MaxCatchUp)
+        {
+            ++mCaughtUp;
+        }
+        else
+        {
+            // the newest tick whose deadline passed
+            const uint64_t newest = static_cast<uint64_t>((now - mStart).count()) * mOptions.FrameRate / NanosecondsPerSecond;
+            tick.Dropped = newest - mNext;
+            mNext = newest;
+            mCaughtUp = 0;
+        }
+        tick.Lateness = now - DeadlineOf(mNext);
+    }
+    else
+    {
+        mCaughtUp = 0;
+        WaitUntil(DeadlineOf(mNext));
+        tick.Lateness = mClock->Now() - DeadlineOf(mNext);
+        RecordJitter(tick.Lateness);
+    }
+
+    tick.Index = mNext;
+    tick.Deadline = DeadlineOf(mNext);
+    ++mNext;
+    ++mTicks;
+    mDropped += tick.Dropped;
+    return tick;
+}
+
+std::chrono::nanoseconds FramePacer::Interval() const
+{
+    return mInterval;
+}
+
+std::chrono::nanoseconds FramePacer::NextDeadline() const
+{
+    return DeadlineOf(mNext);
+}
+
+std::chrono::nanoseconds FramePacer::UntilNextTick() const
+{
+    const std::chrono::nanoseconds remaining = NextDeadline() - mClock->Now();
+    return remaining > std::chrono::nanoseconds::zero() ? remaining : std::chrono::nanoseconds::zero();
+}
+
+PacerClock& FramePacer::Clock() const
+{
+    return *mClock;
+}
+
+const FramePacerOptions& FramePacer::Options() const
+{
+    return mOptions;
+}
+
+FramePacerStats FramePacer::Stats() const
+{
+    FramePacerStats stats{};
+    stats.Ticks = mTicks;
+    stats.Dropped = mDropped;
+    stats.Late = mLate;
+    stats.MaxJitter = mMaxJitter;
+    stats.Slept = mSlept;
+    stats.Spun = mSpun;
+    if (mWaited != 0)
+    {
+        const double mean = mJitterSum / mWaited;
+        const double variance = mJitterSquares / mWaited - mean * mean;
+        stats.MeanJitter = std::chrono::nanoseconds{ static_cast<int64_t>(mean) };
+        stats.JitterDeviation = std::chrono::nanoseconds{ static_cast<int64_t>(std::sqrt(variance > 0 ? variance : 0)) };
+    }
+    return stats;
+}
+
+std::chrono::nanoseconds FramePacer::DeadlineOf(uint64_t index) const
+{
+    // exact, so rounding of the interval does not add up over a long recording
+    return mStart + std::chrono::nanoseconds{ static_cast<int64_t>(index * NanosecondsPerSecond / mOptions.FrameRate) };
+}
+
+void FramePacer::WaitUntil(std::chrono::nanoseconds deadline)
+{
+    std::chrono::nanoseconds now = mClock->Now();
+    const std::chrono::nanoseconds sleepUntil = deadline - mOptions.SpinThreshold;
+    if (now < sleepUntil)
+    {
+        mClock->Sleep(sleepUntil - now);
+        const std::chrono::nanoseconds woke = mClock->Now();
+        mSlept += woke - now;
+        now = woke;
+    }
+
+    const std::chrono::nanoseconds spinStart = now;
+    while (now < deadline)
+    {
+        mClock->Pause();
+        now = mClock->Now();
+    }
+    mSpun += now - spinStart;
+}
+
+void FramePacer::RecordJitter(std::chrono::nanoseconds lateness)
+{
+    const double jitter = static_cast<double>(lateness.count());
+    ++mWaited;
+    mJitterSum += jitter;
+    mJitterSquares += jitter * jitter;
+    if (lateness > mMaxJitter)
+    {
+        mMaxJitter = lateness;
+    }
+}
@@ -0,0 +1,221 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+//
+// FramePacer.h
+// Paces the recording loop to absolute deadlines on a monotonic clock, so the
+// frame rate does not drift by the time spent capturing or by timer granularity.
+// Tick n is due at start + n * interval. Waiting sleeps until shortly before the
+// deadline and busy waits the rest, a tick that is already late runs right away
+// or is dropped, depending on the policy.
+//
+
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+// Time source of a FramePacer, replaced with a virtual clock in tests
+class PacerClock
+{
+public:
+    virtual ~PacerClock() = default;
+
+    // Monotonic time since an arbitrary epoch
+    virtual std::chrono::nanoseconds Now() = 0;
+
+    // Sleeps at least the duration, timer granularity may make it longer
+    virtual void Sleep(std::chrono::nanoseconds duration) = 0;
+
+    // Called between reads of Now() while busy waiting
+    virtual void Pause() = 0;
+};
+
+// std::chrono::steady_clock with the thread sleeping and yielding
+class SteadyPacerClock : public PacerClock
+{
+public:
+    virtual std::chrono::nanoseconds Now() override;
+    virtual void Sleep(std::chrono::nanoseconds duration) override;
+    virtual void Pause() override;
+};
+
+// What to do with ticks whose deadline passed before they were waited for
+enum class LateTickPolicy
+{
+    // run them back to back, up to MaxCatchUp in a row, then drop the rest
+    CatchUp,
+
+    // skip to the newest tick that is due
+    Drop
+};
+
+struct FramePacerOptions
+{
+    uint32_t FrameRate = 30;
+
+    LateTickPolicy LatePolicy = LateTickPolicy::Drop;
+
+    // Late ticks run in a row before CatchUp drops the rest
+    uint32_t MaxCatchUp = 2;
+
+    // Sleeping stops this long before the deadline and the rest is busy waited.
+    // Zero only sleeps, a value of at least the frame interval only busy waits.
+    std::chrono::nanoseconds SpinThreshold{ std::chrono::milliseconds{ 2 } };
+};
+
+struct FrameTick
+{
+    // Ticks since Start, including dropped ones
+    uint64_t Index;
+    std::chrono::nanoseconds Deadline;
+
+    // How long after the deadline the wait returned
+    std::chrono::nanoseconds Lateness;
+
+    // Ticks dropped right before this one
+    uint64_t Dropped;
+};
+
+struct FramePacerStats
+{
+    uint64_t Ticks;
+    uint64_t Dropped;
+
+    // Ticks that were already late when waited for
+    uint64_t Late;
+
+    // Lateness of the ticks that were waited for, late ones are left out
+    std::chrono::nanoseconds MeanJitter;
+    std::chrono::nanoseconds MaxJitter;
+    std::chrono::nanoseconds JitterDeviation;
+
+    // Time spent sleeping and busy waiting
+    std::chrono::nanoseconds Slept;
+    std::chrono::nanoseconds Spun;
+};
+
+class FramePacer
+{
+public:
+    FramePacer(std::shared_ptr<PacerClock> clock, FramePacerOptions options = {});
+
+    // The first tick is due now
+    void Start();
+
+    // Waits for the next tick, or returns a late one right away
+    FrameTick WaitForTick();
+
+    std::chrono::nanoseconds Interval() const;
+
+    std::chrono::nanoseconds NextDeadline() const;
+
+    // Zero when the next tick is due
+    std::chrono::nanoseconds UntilNextTick() const;
+
+    PacerClock& Clock() const;
+
+    const FramePacerOptions& Options() const;
+
+    FramePacerStats Stats() const;
+
+private:
+    std::chrono::nanoseconds DeadlineOf(uint64_t index) const;
+    void WaitUntil(std::chrono::nanoseconds deadline);
+    void RecordJitter(std::chrono::nanoseconds lateness);
+
+    std::shared_ptr<PacerClock> mClock;
+    FramePacerOptions mOptions;
+    std::chrono::nanoseconds mInterval;
+    std::chrono::nanoseconds mStart;
+    uint64_t mNext;
+    uint32_t mCaughtUp;
+
+    uint64_t mTicks;
+    uint64_t mDropped;
+    uint64_t mLate;
+    uint64_t mWaited;
+    double mJitterSum;
+    double mJitterSquares;
+    std::chrono::nanoseconds mMaxJitter;
+    std::chrono::nanoseconds mSlept;
+    std::chrono::nanoseconds mSpun;
+};
+
+// Keeps the candidate whose time is closest to a target, such as the captured
+// frame to encode for an output tick
+template<typename Candidate>
+class ClosestFrame
+{
+public:
+    ClosestFrame()
+        : mTarget{ 0 }
+        , mDistance{ 0 }
+        , mHas{ false }
+    {
+    }
+
+    // Forgets the kept candidate and aims at a new target
+    void Reset(std::chrono::nanoseconds target)
+    {
+        mTarget = target;
+        mCandidate = Candidate{};
+        mHas = false;
+    }
+
+    // True when the candidate is kept. Of two equally close ones the later offered wins.
+    bool Offer(std::chrono::nanoseconds time, Candidate candidate)
+    {
+        const std::chrono::nanoseconds distance = time < mTarget ? mTarget - time : time - mTarget;
+        if (mHas && distance > mDistance)
+        {
+            return false;
+        }
+
+        mCandidate = std::move(candidate);
+        mDistance = distance;
+        mHas = true;
+        return true;
+    }
+
+    // False when nothing was offered since the last reset
+    bool Take(Candidate& candidate)
+    {
+        if (!mHas)
+        {
+            return false;
+        }
+
+        candidate = std::move(mCandidate);
+        mCandidate = Candidate{};
+        mHas = false;
+        return true;
+    }
+
+    std::chrono::nanoseconds Target() const
+    {
+        return mTarget;
+    }
+
+private:
+    std::chrono::nanoseconds mTarget;
+    std::chrono::nanoseconds mDistance;
+    Candidate mCandidate;
+    bool mHas;
+};
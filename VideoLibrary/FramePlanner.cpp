@@ -0,0 +1,87 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "FramePlanner.h"
+
+FramePlanner::FramePlanner()
+    : mMoveRects{ nullptr }
+    , mMoveRectsCount{ 0 }
+{
+}
+
+void FramePlanner::Skip(const SourceFrame& frame)
+{
+    mAccumulator.Accumulate(
+        frame.DirtyRects(),
+        frame.DirtyRectsCount(),
+        frame.MoveRects(),
+        frame.MoveRectsCount());
+}
+
+void FramePlanner::Plan(const SourceFrame& frame)
+{
+    const bool replayMoves = mAccumulator.Apply(
+        frame.DirtyRects(),
+        frame.DirtyRectsCount(),
+        frame.MoveRects(),
+        frame.MoveRectsCount(),
+        mDamage);
+
+    mMoveRects = replayMoves ? frame.MoveRects() : nullptr;
+    mMoveRectsCount = replayMoves ? frame.MoveRectsCount() : 0;
+
+    // the region has no overlaps between the reported rects,
+    // nearby rects are merged so fewer, larger quads are drawn
+    mCoalescer.Coalesce(mDamage.Rects(), mDamage.RectsCount());
+}
+
+const DXGI_OUTDUPL_MOVE_RECT* FramePlanner::MoveRects() const
+{
+    return mMoveRects;
+}
+
+size_t FramePlanner::MoveRectsCount() const
+{
+    return mMoveRectsCount;
+}
+
+const Region& FramePlanner::Damage() const
+{
+    return mDamage;
+}
+
+const RECT* FramePlanner::DirtyRects() const
+{
+    return mCoalescer.Rects();
+}
+
+size_t FramePlanner::DirtyRectsCount() const
+{
+    return mCoalescer.RectsCount();
+}
+
+const DamageAccumulator& FramePlanner::Accumulator() const
+{
+    return mAccumulator;
+}
+
+DirtyRectCoalescer& FramePlanner::Coalescer()
+{
+    return mCoalescer;
+}
@@ -0,0 +1,66 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "FrameSource.h"
+#include "DamageAccumulator.h"
+#include "DirtyRectCoalescer.h"
+#include "Region.h"
+
+/*
+    The CPU side of composing a frame onto the shared surface: which move rects to
+    replay and which rects to redraw from the desktop image.
+
+    Pipeline feeds it duplication frames and turns the plan into draw calls.
+    It only needs the SourceFrame interface, so the same planning can be driven by
+    synthetic or recorded sources on machines without a GPU.
+*/
+class FramePlanner
+{
+public:
+    FramePlanner();
+
+    // The frame was captured but could not be drawn, carry its damage forward
+    void Skip(const SourceFrame& frame);
+
+    // Plans the frame. The results are valid until the next call and while the frame is alive.
+    void Plan(const SourceFrame& frame);
+
+    // Move rects to replay before drawing dirty rects, empty when the moves were turned into damage
+    const DXGI_OUTDUPL_MOVE_RECT* MoveRects() const;
+    size_t MoveRectsCount() const;
+
+    // Every pixel that has to be redrawn from the desktop image
+    const Region& Damage() const;
+
+    // Damage merged into rects that are cheap to draw
+    const RECT* DirtyRects() const;
+    size_t DirtyRectsCount() const;
+
+    const DamageAccumulator& Accumulator() const;
+
+    DirtyRectCoalescer& Coalescer();
+
+private:
+    DamageAccumulator mAccumulator;
+    DirtyRectCoalescer mCoalescer;
+    Region mDamage;
+    const DXGI_OUTDUPL_MOVE_RECT* mMoveRects;
+    size_t mMoveRectsCount;
+};
@@ -0,0 +1,74 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "PlatformTypes.h"
+#include <cstdint>
+#include <memory>
+
+/*
+    One captured desktop frame, independent of where it came from.
+
+    Frame implements this for the Desktop Duplication API. Synthetic and recorded
+    sources implement it too, so everything that only looks at a frame's metadata
+    can run without a GPU or a Windows desktop.
+
+    Rects are in desktop image coordinates, like the duplication API reports them.
+*/
+class SourceFrame
+{
+public:
+    virtual ~SourceFrame() = default;
+
+    // False when no new frame was available, the other values are then meaningless
+    virtual bool Captured() const = 0;
+
+    virtual int64_t PresentationTime() const = 0;
+
+    virtual RECT DesktopMonitorBounds() const = 0;
+
+    virtual DXGI_MODE_ROTATION Rotation() const = 0;
+
+    virtual const DXGI_OUTDUPL_MOVE_RECT* MoveRects() const = 0;
+    virtual size_t MoveRectsCount() const = 0;
+
+    virtual const RECT* DirtyRects() const = 0;
+    virtual size_t DirtyRectsCount() const = 0;
+
+    // Pointer data as reported with this frame, relative to the monitor
+    virtual DXGI_OUTDUPL_POINTER_POSITION PointerPosition() const = 0;
+    virtual int64_t PointerUpdateTime() const = 0;
+    virtual bool PointerShapeUpdated() const = 0;
+
+    // CPU copy of the 32 bit BGRA desktop image, null when the image only lives on the GPU
+    virtual const byte* Pixels() const { return nullptr; }
+    virtual size_t Pitch() const { return 0; }
+};
+
+class FrameSource
+{
+public:
+    virtual ~FrameSource() = default;
+
+    // Returns the next frame. Check Captured() on the result, sources may time out.
+    virtual std::shared_ptr<SourceFrame> AcquireFrame() = 0;
+
+    // Units of PresentationTime and PointerUpdateTime
+    virtual int64_t TicksPerSecond() const = 0;
+};
@@ -0,0 +1,72 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Layout must match PackedRectConstants in PackedRect.h
+cbuffer RectConstants : register(b0)
+{
+    float2 InverseImageSize;
+    float2 Center;
+    float2 PositionScale;
+    uint Rotation;
+    uint Padding;
+};
+
+// Layout must match PackedRect in PackedRect.h
+struct INSTANCE_INPUT
+{
+    uint4 Source : SOURCE;
+    uint4 Destination : DESTINATION;
+    uint VertexId : SV_VertexID;
+};
+
+struct VS_OUTPUT
+{
+    float4 Pos : SV_POSITION;
+    float2 Tex : TEXCOORD;
+};
+
+// Corners are numbered bottom left, top left, bottom right, top right,
+// which is also the order of the four vertex triangle strip.
+// Each row is the source corner drawn at each corner for one rotation,
+// the same table is in PackedRect.cpp
+static const uint SourceCorners[4][4] =
+{
+    { 0, 1, 2, 3 },
+    { 2, 0, 3, 1 },
+    { 3, 2, 1, 0 },
+    { 1, 3, 0, 2 }
+};
+
+float2 Corner(uint4 rect, uint corner)
+{
+    return float2(corner >= 2 ? rect.z : rect.x, (corner & 1) ? rect.y : rect.w);
+}
+
+//--------------------------------------------------------------------------------------
+// Vertex Shader
+//--------------------------------------------------------------------------------------
+VS_OUTPUT main(INSTANCE_INPUT input)
+{
+    const uint corner = input.VertexId & 3;
+
+    VS_OUTPUT output;
+    output.Pos = float4((Corner(input.Destination, corner) - Center) * PositionScale, 0.0f, 1.0f);
+    output.Tex = Corner(input.Source, SourceCorners[Rotation & 3][corner]) * InverseImageSize;
+    return output;
+}
@@ -19,6 +19,13 @@
 
 #pragma once
 
+#include <atomic>
+
+/*
+    The keys the next lock acquires and releases the keyed mutex with.
+    Rotating 0 and 1 makes two devices take turns. Equal keys never rotate,
+    so any number of writers take the surface in whatever order they lock it.
+*/
 class RotatingKeys
 {
 public:
@@ -36,24 +43,25 @@ public:
 
     int AcquireKey() const
     {
-        return mAcquireKey;
+        return mAcquireKey.load(std::memory_order_relaxed);
     }
 
     int ReleaseKey() const
     {
-        return mReleaseKey;
+        return mReleaseKey.load(std::memory_order_relaxed);
     }
 
+    // Called by the holder of the lock, threads waiting for it may read the keys meanwhile
     void Rotate()
     {
-        auto previousRelease = mReleaseKey;
-        mReleaseKey = mAcquireKey;
-        mAcquireKey = previousRelease;
+        auto previousRelease = mReleaseKey.load(std::memory_order_relaxed);
+        mReleaseKey.store(mAcquireKey.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        mAcquireKey.store(previousRelease, std::memory_order_relaxed);
     }
 
 private:
-    int mAcquireKey;
-    int mReleaseKey;
+    std::atomic<int> mAcquireKey;
+    std::atomic<int> mReleaseKey;
 };
 
 class KeyedMutexLock
@@ -90,7 +98,12 @@ public:
 
     ~KeyedMutexLock()
     {
-        // only release and rotate if mLocked is true?
+        // a timed out acquire does not own the mutex, so there is nothing to release
+        if (!mLocked)
+        {
+            return;
+        }
+
         auto releaseKey = mRotatingKeys->ReleaseKey();
         mRotatingKeys->Rotate();
         winrt::check_hresult(mMutex->ReleaseSync(releaseKey));
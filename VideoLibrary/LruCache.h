@@ -0,0 +1,119 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+/*
+    Fixed capacity map that evicts the least recently used entry when it is full.
+
+    Find moves the entry it returns to the front. Pointers returned by Find and
+    Insert stay valid until the entry is evicted or erased.
+*/
+template<typename Key, typename Value, typename Hash = std::hash<Key>>
+class LruCache
+{
+public:
+    explicit LruCache(size_t capacity)
+        : mCapacity{ capacity }
+        , mHits{ 0 }
+        , mMisses{ 0 }
+        , mEvictions{ 0 }
+    {
+        if (mCapacity == 0)
+        {
+            throw std::invalid_argument("cache capacity must not be zero");
+        }
+    }
+
+    // Null and counted as a miss when the key is not cached
+    Value* Find(const Key& key)
+    {
+        auto found = mIndex.find(key);
+        if (found == mIndex.end())
+        {
+            ++mMisses;
+            return nullptr;
+        }
+
+        ++mHits;
+        mEntries.splice(mEntries.begin(), mEntries, found->second);
+        return &found->second->second;
+    }
+
+    // Replaces an entry with the same key, otherwise evicts the oldest entry when full
+    Value& Insert(const Key& key, Value value)
+    {
+        auto found = mIndex.find(key);
+        if (found != mIndex.end())
+        {
+            found->second->second = std::move(value);
+            mEntries.splice(mEntries.begin(), mEntries, found->second);
+            return found->second->second;
+        }
+
+        if (mEntries.size() == mCapacity)
+        {
+            mIndex.erase(mEntries.back().first);
+            mEntries.pop_back();
+            ++mEvictions;
+        }
+
+        mEntries.emplace_front(key, std::move(value));
+        mIndex.emplace(key, mEntries.begin());
+        return mEntries.front().second;
+    }
+
+    void Erase(const Key& key)
+    {
+        auto found = mIndex.find(key);
+        if (found != mIndex.end())
+        {
+            mEntries.erase(found->second);
+            mIndex.erase(found);
+        }
+    }
+
+    void Clear()
+    {
+        mEntries.clear();
+        mIndex.clear();
+    }
+
+    size_t Size() const { return mEntries.size(); }
+    size_t Capacity() const { return mCapacity; }
+
+    uint64_t Hits() const { return mHits; }
+    uint64_t Misses() const { return mMisses; }
+    uint64_t Evictions() const { return mEvictions; }
+
+private:
+    typedef std::list<std::pair<Key, Value>> EntryList;
+
+    size_t mCapacity;
+    EntryList mEntries;
+    std::unordered_map<Key, typename EntryList::iterator, Hash> mIndex;
+    uint64_t mHits;
+    uint64_t mMisses;
+    uint64_t mEvictions;
+};
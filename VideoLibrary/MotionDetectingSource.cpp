@@ -0,0 +1,84 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "MotionDetectingSource.h"
+
+#include <stdexcept>
+
+class MotionDetectingSource::Frame : public SourceFrame
+{
+public:
+    Frame(std::shared_ptr<SourceFrame> frame, const MotionDetector& detector)
+        : mFrame{ frame }
+        , mMoveRects(detector.MoveRects(), detector.MoveRects() + detector.MoveRectsCount())
+        , mDirtyRects(detector.DirtyRects(), detector.DirtyRects() + detector.DirtyRectsCount())
+    {
+    }
+
+    bool Captured() const override { return mFrame->Captured(); }
+    int64_t PresentationTime() const override { return mFrame->PresentationTime(); }
+    RECT DesktopMonitorBounds() const override { return mFrame->DesktopMonitorBounds(); }
+    DXGI_MODE_ROTATION Rotation() const override { return mFrame->Rotation(); }
+    const DXGI_OUTDUPL_MOVE_RECT* MoveRects() const override { return mMoveRects.data(); }
+    size_t MoveRectsCount() const override { return mMoveRects.size(); }
+    const RECT* DirtyRects() const override { return mDirtyRects.data(); }
+    size_t DirtyRectsCount() const override { return mDirtyRects.size(); }
+    DXGI_OUTDUPL_POINTER_POSITION PointerPosition() const override { return mFrame->PointerPosition(); }
+    int64_t PointerUpdateTime() const override { return mFrame->PointerUpdateTime(); }
+    bool PointerShapeUpdated() const override { return mFrame->PointerShapeUpdated(); }
+    const byte* Pixels() const override { return mFrame->Pixels(); }
+    size_t Pitch() const override { return mFrame->Pitch(); }
+
+private:
+    std::shared_ptr<SourceFrame> mFrame;
+    std::vector<DXGI_OUTDUPL_MOVE_RECT> mMoveRects;
+    std::vector<RECT> mDirtyRects;
+};
+
+MotionDetectingSource::MotionDetectingSource(std::shared_ptr<FrameSource> source, MotionDetectorOptions options)
+    : mSource{ source }
+    , mDetector{ options }
+{
+    if (mSource == nullptr)
+    {
+        throw std::invalid_argument("null frame source");
+    }
+}
+
+std::shared_ptr<SourceFrame> MotionDetectingSource::AcquireFrame()
+{
+    std::shared_ptr<SourceFrame> frame = mSource->AcquireFrame();
+    if (!frame->Captured())
+    {
+        return frame;
+    }
+
+    mDetector.Detect(*frame);
+    return std::make_shared<Frame>(frame, mDetector);
+}
+
+int64_t MotionDetectingSource::TicksPerSecond() const
+{
+    return mSource->TicksPerSecond();
+}
+
+const MotionDetector& MotionDetectingSource::Detector() const
+{
+    return mDetector;
+}
@@ -0,0 +1,41 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "MotionDetector.h"
+#include <memory>
+
+// Adds the moves a MotionDetector finds to the frames of a source that only reports dirty rects
+class MotionDetectingSource : public FrameSource
+{
+public:
+    MotionDetectingSource(std::shared_ptr<FrameSource> source, MotionDetectorOptions options = MotionDetectorOptions{});
+
+    // Inherited via FrameSource
+    std::shared_ptr<SourceFrame> AcquireFrame() override;
+    int64_t TicksPerSecond() const override;
+
+    const MotionDetector& Detector() const;
+
+private:
+    class Frame;
+
+    std::shared_ptr<FrameSource> mSource;
+    MotionDetector mDetector;
+};
@@ -0,0 +1,376 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "MotionDetector.h"
+#include "Simd.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+    constexpr uint32_t HashSeed = 0x9E3779B9;
+
+    // Rotate, xor and multiply by 9. Not a strong hash, matches are always checked pixel by pixel.
+    inline uint32_t Mix(uint32_t hash, uint32_t pixel)
+    {
+        hash = ((hash << 5) | (hash >> 27)) ^ pixel;
+        return hash + (hash << 3);
+    }
+
+    inline const uint32_t* Row(const byte* pixels, size_t pitch, LONG y)
+    {
+        return reinterpret_cast<const uint32_t*>(pixels + static_cast<size_t>(y) * pitch);
+    }
+
+    // One hash per row of the rect. Pixel x goes into lane x % 4, the lanes are combined at the end.
+    void HashRows(const byte* pixels, size_t pitch, const RECT& rect, uint32_t* hashes)
+    {
+        const LONG width = rect.right - rect.left;
+        for (LONG y = rect.top; y < rect.bottom; ++y)
+        {
+            const uint32_t* row = Row(pixels, pitch, y) + rect.left;
+            uint32_t lanes[4] = { HashSeed, HashSeed, HashSeed, HashSeed };
+            LONG x = 0;
+#if SIMD_SSE2
+            __m128i hash = _mm_set1_epi32(static_cast<int>(HashSeed));
+            for (; x + 4 <= width; x += 4)
+            {
+                const __m128i pixel = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x));
+                hash = _mm_xor_si128(_mm_or_si128(_mm_slli_epi32(hash, 5), _mm_srli_epi32(hash, 27)), pixel);
+                hash = _mm_add_epi32(hash, _mm_slli_epi32(hash, 3));
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), hash);
+#elif SIMD_NEON
+            uint32x4_t hash = vdupq_n_u32(HashSeed);
+            for (; x + 4 <= width; x += 4)
+            {
+                const uint32x4_t pixel = vld1q_u32(row + x);
+                hash = veorq_u32(vorrq_u32(vshlq_n_u32(hash, 5), vshrq_n_u32(hash, 27)), pixel);
+                hash = vaddq_u32(hash, vshlq_n_u32(hash, 3));
+            }
+            vst1q_u32(lanes, hash);
+#endif
+            for (; x < width; ++x)
+            {
+                lanes[x & 3] = Mix(lanes[x & 3], row[x]);
+            }
+
+            hashes[y - rect.top] = Mix(Mix(Mix(Mix(HashSeed, lanes[0]), lanes[1]), lanes[2]), lanes[3]);
+        }
+    }
+
+    // One hash per column of the rect, four neighbouring columns are hashed at once
+    void HashColumns(const byte* pixels, size_t pitch, const RECT& rect, uint32_t* hashes)
+    {
+        const LONG width = rect.right - rect.left;
+        std::fill(hashes, hashes + width, HashSeed);
+        for (LONG y = rect.top; y < rect.bottom; ++y)
+        {
+            const uint32_t* row = Row(pixels, pitch, y) + rect.left;
+            LONG x = 0;
+#if SIMD_SSE2
+            for (; x + 4 <= width; x += 4)
+            {
+                const __m128i pixel = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x));
+                __m128i hash = _mm_loadu_si128(reinterpret_cast<const __m128i*>(hashes + x));
+                hash = _mm_xor_si128(_mm_or_si128(_mm_slli_epi32(hash, 5), _mm_srli_epi32(hash, 27)), pixel);
+                hash = _mm_add_epi32(hash, _mm_slli_epi32(hash, 3));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(hashes + x), hash);
+            }
+#elif SIMD_NEON
+            for (; x + 4 <= width; x += 4)
+            {
+                const uint32x4_t pixel = vld1q_u32(row + x);
+                uint32x4_t hash = vld1q_u32(hashes + x);
+                hash = veorq_u32(vorrq_u32(vshlq_n_u32(hash, 5), vshrq_n_u32(hash, 27)), pixel);
+                hash = vaddq_u32(hash, vshlq_n_u32(hash, 3));
+                vst1q_u32(hashes + x, hash);
+            }
+#endif
+            for (; x < width; ++x)
+            {
+                hashes[x] = Mix(hashes[x], row[x]);
+            }
+        }
+    }
+
+    // Finds the shift with the longest run of lines that match the previous frame shifted,
+    // scored by how many lines of the run changed in place. Line i of the current frame came
+    // from line i - shift of the previous frame. The run is [first, last).
+    // Returns false when no run has at least minimumChanged changed lines.
+    bool FindShift(const uint32_t* current, const uint32_t* previous, LONG count, LONG maximumShift, LONG minimumChanged, LONG& shift, LONG& first, LONG& last)
+    {
+        LONG bestChanged = minimumChanged - 1;
+        const LONG limit = (std::min)(maximumShift, count - 1);
+        for (LONG distance = 1; distance <= limit && count - distance > bestChanged; ++distance)
+        {
+            for (const LONG candidate : { -distance, distance })
+            {
+                const LONG begin = (std::max)(candidate, static_cast<LONG>(0));
+                const LONG end = count + (std::min)(candidate, static_cast<LONG>(0));
+                LONG start = begin;
+                LONG changed = 0;
+                for (LONG i = begin; i <= end; ++i)
+                {
+                    if (i < end && current[i] == previous[i - candidate])
+                    {
+                        changed += current[i] != previous[i] ? 1 : 0;
+                        continue;
+                    }
+
+                    if (changed > bestChanged)
+                    {
+                        bestChanged = changed;
+                        shift = candidate;
+                        first = start;
+                        last = i;
+                    }
+                    start = i + 1;
+                    changed = 0;
+                }
+            }
+        }
+        return bestChanged >= minimumChanged;
+    }
+}
+
+MotionDetector::MotionDetector(MotionDetectorOptions options)
+    : mOptions{ options }
+    , mWidth{ 0 }
+    , mHeight{ 0 }
+    , mPixelsMoved{ 0 }
+{
+    if (mOptions.MinimumWidth < 1 || mOptions.MinimumHeight < 1 || mOptions.MaximumShift < 1 || mOptions.MinimumRun < 1)
+    {
+        throw std::invalid_argument("invalid motion detector options");
+    }
+}
+
+void MotionDetector::Detect(const SourceFrame& frame)
+{
+    mMoveRects.clear();
+    mDirtyRects.clear();
+    mPixelsMoved = 0;
+
+    if (!frame.Captured())
+    {
+        return;
+    }
+
+    const RECT* dirtyRects = frame.DirtyRects();
+    const size_t dirtyRectsCount = frame.DirtyRectsCount();
+    mDirtyRects.assign(dirtyRects, dirtyRects + dirtyRectsCount);
+    mMoveRects.assign(frame.MoveRects(), frame.MoveRects() + frame.MoveRectsCount());
+
+    const byte* pixels = frame.Pixels();
+    if (pixels == nullptr)
+    {
+        Reset();
+        return;
+    }
+
+    const RECT bounds = frame.DesktopMonitorBounds();
+    const LONG width = bounds.right - bounds.left;
+    const LONG height = bounds.bottom - bounds.top;
+    const size_t pitch = frame.Pitch();
+    const RECT image{ 0, 0, width, height };
+    if (width != mWidth || height != mHeight)
+    {
+        // nothing to compare against yet
+        mWidth = width;
+        mHeight = height;
+        mPrevious.resize(static_cast<size_t>(width) * height);
+        Remember(pixels, pitch, image);
+        return;
+    }
+
+    if (frame.MoveRectsCount() == 0)
+    {
+        for (size_t i = 0; i < dirtyRectsCount; ++i)
+        {
+            RECT rect = dirtyRects[i];
+            rect.left = (std::max)(rect.left, image.left);
+            rect.top = (std::max)(rect.top, image.top);
+            rect.right = (std::min)(rect.right, image.right);
+            rect.bottom = (std::min)(rect.bottom, image.bottom);
+
+            DXGI_OUTDUPL_MOVE_RECT move;
+            if (rect.right - rect.left < mOptions.MinimumWidth ||
+                rect.bottom - rect.top < mOptions.MinimumHeight ||
+                !DetectMove(pixels, pitch, rect, move))
+            {
+                continue;
+            }
+
+            // moves are applied together, their destinations must not overlap
+            bool overlaps = false;
+            for (const DXGI_OUTDUPL_MOVE_RECT& other : mMoveRects)
+            {
+                overlaps = overlaps ||
+                    (move.DestinationRect.left < other.DestinationRect.right && other.DestinationRect.left < move.DestinationRect.right &&
+                     move.DestinationRect.top < other.DestinationRect.bottom && other.DestinationRect.top < move.DestinationRect.bottom);
+            }
+
+            if (!overlaps)
+            {
+                mMoveRects.push_back(move);
+            }
+        }
+
+        if (!mMoveRects.empty())
+        {
+            mDirty.Reset(dirtyRects, dirtyRectsCount);
+            const int64_t dirtyArea = mDirty.Area();
+            for (const DXGI_OUTDUPL_MOVE_RECT& move : mMoveRects)
+            {
+                mDirty.Subtract(move.DestinationRect);
+            }
+            mPixelsMoved = static_cast<uint64_t>(dirtyArea - mDirty.Area());
+            mDirtyRects.assign(mDirty.Rects(), mDirty.Rects() + mDirty.RectsCount());
+        }
+    }
+
+    // everything that changed this frame, in the frame's original rects
+    for (size_t i = 0; i < dirtyRectsCount; ++i)
+    {
+        Remember(pixels, pitch, dirtyRects[i]);
+    }
+
+    for (size_t i = 0; i < frame.MoveRectsCount(); ++i)
+    {
+        Remember(pixels, pitch, frame.MoveRects()[i].DestinationRect);
+    }
+}
+
+void MotionDetector::Reset()
+{
+    mPrevious.clear();
+    mWidth = 0;
+    mHeight = 0;
+}
+
+const DXGI_OUTDUPL_MOVE_RECT* MotionDetector::MoveRects() const
+{
+    return mMoveRects.data();
+}
+
+size_t MotionDetector::MoveRectsCount() const
+{
+    return mMoveRects.size();
+}
+
+const RECT* MotionDetector::DirtyRects() const
+{
+    return mDirtyRects.data();
+}
+
+size_t MotionDetector::DirtyRectsCount() const
+{
+    return mDirtyRects.size();
+}
+
+uint64_t MotionDetector::PixelsMoved() const
+{
+    return mPixelsMoved;
+}
+
+const MotionDetectorOptions& MotionDetector::Options() const
+{
+    return mOptions;
+}
+
+bool MotionDetector::DetectMove(const byte* pixels, size_t pitch, const RECT& rect, DXGI_OUTDUPL_MOVE_RECT& move)
+{
+    // scrolling is mostly vertical, try that first
+    return DetectShift(pixels, pitch, rect, true, move) || DetectShift(pixels, pitch, rect, false, move);
+}
+
+bool MotionDetector::DetectShift(const byte* pixels, size_t pitch, const RECT& rect, bool vertical, DXGI_OUTDUPL_MOVE_RECT& move)
+{
+    const LONG count = vertical ? rect.bottom - rect.top : rect.right - rect.left;
+    mCurrentHashes.resize(count);
+    mPreviousHashes.resize(count);
+
+    const byte* previous = reinterpret_cast<const byte*>(mPrevious.data());
+    const size_t previousPitch = static_cast<size_t>(mWidth) * sizeof(uint32_t);
+    if (vertical)
+    {
+        HashRows(pixels, pitch, rect, mCurrentHashes.data());
+        HashRows(previous, previousPitch, rect, mPreviousHashes.data());
+    }
+    else
+    {
+        HashColumns(pixels, pitch, rect, mCurrentHashes.data());
+        HashColumns(previous, previousPitch, rect, mPreviousHashes.data());
+    }
+
+    LONG shift = 0;
+    LONG first = 0;
+    LONG last = 0;
+    if (!FindShift(mCurrentHashes.data(), mPreviousHashes.data(), count, mOptions.MaximumShift, mOptions.MinimumRun, shift, first, last))
+    {
+        return false;
+    }
+
+    const RECT destination = vertical ?
+        RECT{ rect.left, rect.top + first, rect.right, rect.top + last } :
+        RECT{ rect.left + first, rect.top, rect.left + last, rect.bottom };
+    const POINT source = vertical ?
+        POINT{ destination.left, destination.top - shift } :
+        POINT{ destination.left - shift, destination.top };
+
+    // hashes only narrow the search down, the move has to reproduce the frame exactly
+    const size_t rowSize = static_cast<size_t>(destination.right - destination.left) * sizeof(uint32_t);
+    for (LONG y = 0; y < destination.bottom - destination.top; ++y)
+    {
+        if (std::memcmp(
+            Row(pixels, pitch, destination.top + y) + destination.left,
+            Row(previous, previousPitch, source.y + y) + source.x,
+            rowSize) != 0)
+        {
+            return false;
+        }
+    }
+
+    move.SourcePoint = source;
+    move.DestinationRect = destination;
+    return true;
+}
+
+void MotionDetector::Remember(const byte* pixels, size_t pitch, const RECT& rect)
+{
+    const LONG left = (std::max)(rect.left, static_cast<LONG>(0));
+    const LONG top = (std::max)(rect.top, static_cast<LONG>(0));
+    const LONG right = (std::min)(rect.right, mWidth);
+    const LONG bottom = (std::min)(rect.bottom, mHeight);
+    if (right <= left)
+    {
+        return;
+    }
+
+    for (LONG y = top; y < bottom; ++y)
+    {
+        std::memcpy(
+            &mPrevious[static_cast<size_t>(y) * mWidth + left],
+            Row(pixels, pitch, y) + left,
+            static_cast<size_t>(right - left) * sizeof(uint32_t));
+    }
+}
@@ -0,0 +1,87 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "FrameSource.h"
+#include "Region.h"
+#include <vector>
+
+struct MotionDetectorOptions
+{
+    // Dirty rects smaller than this in either direction are not searched
+    LONG MinimumWidth = 64;
+    LONG MinimumHeight = 64;
+
+    // Largest shift searched, in pixels
+    LONG MaximumShift = 256;
+
+    // Fewest changed rows or columns a detected move has to cover
+    LONG MinimumRun = 16;
+};
+
+/*
+    Finds scrolled and moved content in frames that only report dirty rects.
+
+    The detector keeps a copy of the previous frame. Inside every large dirty rect
+    it hashes the rows and columns of both frames, looks for the vertical or
+    horizontal shift under which the most lines match, and checks the longest
+    matching run pixel by pixel. Each run that checks out becomes a move rect in
+    the format the duplication API reports, and its destination is removed from
+    the dirty rects.
+
+    Frames that already carry move rects are passed through unchanged.
+*/
+class MotionDetector
+{
+public:
+    explicit MotionDetector(MotionDetectorOptions options = MotionDetectorOptions{});
+
+    // Compares the frame with the previous one. The results are valid until the next call.
+    void Detect(const SourceFrame& frame);
+
+    // Forgets the previous frame, the next frame is passed through
+    void Reset();
+
+    const DXGI_OUTDUPL_MOVE_RECT* MoveRects() const;
+    size_t MoveRectsCount() const;
+
+    const RECT* DirtyRects() const;
+    size_t DirtyRectsCount() const;
+
+    // Dirty pixels of the last frame that are covered by detected moves instead
+    uint64_t PixelsMoved() const;
+
+    const MotionDetectorOptions& Options() const;
+
+private:
+    bool DetectMove(const byte* pixels, size_t pitch, const RECT& rect, DXGI_OUTDUPL_MOVE_RECT& move);
+    bool DetectShift(const byte* pixels, size_t pitch, const RECT& rect, bool vertical, DXGI_OUTDUPL_MOVE_RECT& move);
+    void Remember(const byte* pixels, size_t pitch, const RECT& rect);
+
+    MotionDetectorOptions mOptions;
+    std::vector<uint32_t> mPrevious;
+    LONG mWidth;
+    LONG mHeight;
+    std::vector<uint32_t> mCurrentHashes;
+    std::vector<uint32_t> mPreviousHashes;
+    std::vector<DXGI_OUTDUPL_MOVE_RECT> mMoveRects;
+    std::vector<RECT> mDirtyRects;
+    Region mDirty;
+    uint64_t mPixelsMoved;
+};
@@ -0,0 +1,268 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "MoveRectPlanner.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+    int64_t Area(const RECT& rect)
+    {
+        return static_cast<int64_t>(rect.right - rect.left) * (rect.bottom - rect.top);
+    }
+
+    bool Overlaps(const RECT& a, const RECT& b)
+    {
+        return a.left < b.right && b.left < a.right && a.top < b.bottom && b.top < a.bottom;
+    }
+
+    // True when a and b together cover exactly their bounding box
+    bool FormRect(const RECT& a, const RECT& b)
+    {
+        if (a.top == b.top && a.bottom == b.bottom)
+        {
+            return a.left <= b.right && b.left <= a.right;
+        }
+
+        if (a.left == b.left && a.right == b.right)
+        {
+            return a.top <= b.bottom && b.top <= a.bottom;
+        }
+
+        return false;
+    }
+}
+
+MoveRectPlanner::MoveRectPlanner(size_t bytesPerPixel)
+    : mBytesPerPixel{ bytesPerPixel }
+    , mDroppedMoves{ 0 }
+    , mMergedMoves{ 0 }
+    , mStagedMoves{ 0 }
+    , mBytesCopied{ 0 }
+    , mBytesSaved{ 0 }
+{
+    if (mBytesPerPixel == 0)
+    {
+        throw std::invalid_argument("bytes per pixel must not be zero");
+    }
+}
+
+void MoveRectPlanner::Plan(const RECT* sources, const RECT* destinations, size_t count)
+{
+    mMoves.clear();
+    mCopies.clear();
+    mDroppedMoves = 0;
+    mMergedMoves = 0;
+    mStagedMoves = 0;
+
+    // what staging every move costs, a copy into the staging texture and one back
+    uint64_t stagedBytes = 0;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const RECT& source = sources[i];
+        const LONG deltaX = destinations[i].left - source.left;
+        const LONG deltaY = destinations[i].top - source.top;
+        const int64_t area = Area(source);
+        if (area <= 0)
+        {
+            ++mDroppedMoves;
+            continue;
+        }
+
+        stagedBytes += 2 * static_cast<uint64_t>(area) * mBytesPerPixel;
+        if (deltaX == 0 && deltaY == 0)
+        {
+            ++mDroppedMoves;
+            continue;
+        }
+
+        mMoves.push_back(Move{ source, deltaX, deltaY, false });
+    }
+
+    Merge();
+    Order();
+
+    mBytesCopied = 0;
+    for (const MoveCopy& copy : mCopies)
+    {
+        mBytesCopied += static_cast<uint64_t>(Area(copy.Source)) * mBytesPerPixel;
+    }
+    mBytesSaved = stagedBytes - mBytesCopied;
+}
+
+const MoveCopy* MoveRectPlanner::Copies() const
+{
+    return mCopies.data();
+}
+
+size_t MoveRectPlanner::CopiesCount() const
+{
+    return mCopies.size();
+}
+
+size_t MoveRectPlanner::DroppedMoves() const
+{
+    return mDroppedMoves;
+}
+
+size_t MoveRectPlanner::MergedMoves() const
+{
+    return mMergedMoves;
+}
+
+size_t MoveRectPlanner::StagedMoves() const
+{
+    return mStagedMoves;
+}
+
+uint64_t MoveRectPlanner::BytesCopied() const
+{
+    return mBytesCopied;
+}
+
+uint64_t MoveRectPlanner::BytesSaved() const
+{
+    return mBytesSaved;
+}
+
+RECT MoveRectPlanner::Destination(const Move& move)
+{
+    return RECT{
+        move.Source.left + move.DeltaX,
+        move.Source.top + move.DeltaY,
+        move.Source.right + move.DeltaX,
+        move.Source.bottom + move.DeltaY };
+}
+
+void MoveRectPlanner::Merge()
+{
+    // frames rarely have more than a handful of moves, a quadratic pass is fine
+    bool merged = true;
+    while (merged)
+    {
+        merged = false;
+        for (size_t i = 0; i < mMoves.size() && !merged; ++i)
+        {
+            for (size_t j = i + 1; j < mMoves.size(); ++j)
+            {
+                Move& a = mMoves[i];
+                const Move& b = mMoves[j];
+                if (a.DeltaX != b.DeltaX || a.DeltaY != b.DeltaY || !FormRect(a.Source, b.Source))
+                {
+                    continue;
+                }
+
+                a.Source.left = (std::min)(a.Source.left, b.Source.left);
+                a.Source.top = (std::min)(a.Source.top, b.Source.top);
+                a.Source.right = (std::max)(a.Source.right, b.Source.right);
+                a.Source.bottom = (std::max)(a.Source.bottom, b.Source.bottom);
+                mMoves.erase(mMoves.begin() + j);
+                ++mMergedMoves;
+                merged = true;
+                break;
+            }
+        }
+    }
+}
+
+void MoveRectPlanner::Order()
+{
+    mOrdered.clear();
+
+    // a move that overlaps itself cannot be a single copy within one resource
+    for (Move& move : mMoves)
+    {
+        move.Staged = Overlaps(move.Source, Destination(move));
+    }
+
+    // Repeatedly emit a direct move whose destination no other pending direct move
+    // still has to read. When none is left the pending moves read each other in
+    // a cycle, stage the smallest to break it. Staged moves read their sources
+    // before any direct copy and write their destinations after all of them.
+    std::vector<size_t> pending;
+    for (size_t i = 0; i < mMoves.size(); ++i)
+    {
+        if (!mMoves[i].Staged)
+        {
+            pending.push_back(i);
+        }
+    }
+
+    while (!pending.empty())
+    {
+        size_t ready = pending.size();
+        for (size_t p = 0; p < pending.size() && ready == pending.size(); ++p)
+        {
+            const RECT destination = Destination(mMoves[pending[p]]);
+            bool read = false;
+            for (size_t q = 0; q < pending.size() && !read; ++q)
+            {
+                read = q != p && Overlaps(mMoves[pending[q]].Source, destination);
+            }
+
+            if (!read)
+            {
+                ready = p;
+            }
+        }
+
+        if (ready == pending.size())
+        {
+            size_t smallest = 0;
+            for (size_t p = 1; p < pending.size(); ++p)
+            {
+                if (Area(mMoves[pending[p]].Source) < Area(mMoves[pending[smallest]].Source))
+                {
+                    smallest = p;
+                }
+            }
+            mMoves[pending[smallest]].Staged = true;
+            pending.erase(pending.begin() + smallest);
+            continue;
+        }
+
+        mOrdered.push_back(mMoves[pending[ready]]);
+        pending.erase(pending.begin() + ready);
+    }
+
+    for (const Move& move : mMoves)
+    {
+        if (move.Staged)
+        {
+            ++mStagedMoves;
+            mCopies.push_back(MoveCopy{ MoveCopyKind::SurfaceToStaging, move.Source, POINT{ move.Source.left, move.Source.top } });
+        }
+    }
+
+    for (const Move& move : mOrdered)
+    {
+        mCopies.push_back(MoveCopy{ MoveCopyKind::SurfaceToSurface, move.Source, POINT{ move.Source.left + move.DeltaX, move.Source.top + move.DeltaY } });
+    }
+
+    for (const Move& move : mMoves)
+    {
+        if (move.Staged)
+        {
+            mCopies.push_back(MoveCopy{ MoveCopyKind::StagingToSurface, move.Source, POINT{ move.Source.left + move.DeltaX, move.Source.top + move.DeltaY } });
+        }
+    }
+}
@@ -0,0 +1,101 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "PlatformTypes.h"
+#include <cstdint>
+#include <vector>
+
+enum class MoveCopyKind
+{
+    // surface to the staging texture at the same position
+    SurfaceToStaging,
+
+    // surface to surface, source and destination do not overlap
+    SurfaceToSurface,
+
+    // staging texture back to the surface
+    StagingToSurface
+};
+
+struct MoveCopy
+{
+    MoveCopyKind Kind;
+    RECT Source;
+    POINT Destination;
+};
+
+/*
+    Turns a frame's move rects into the copies that apply them to the shared surface.
+
+    Every move reads the surface as it was before the frame, so a copy has to run
+    before any copy that writes over its source. Moves are first cleaned up: moves
+    that go nowhere are dropped and moves with the same displacement whose sources
+    form one rect are merged. The remaining moves are ordered so that each reads its
+    source before it is overwritten and are copied directly. Only moves that overlap
+    themselves, or that read each other's destinations in a cycle, go through the
+    staging texture, which takes two copies instead of one.
+
+    Rects are in the surface's coordinates after rotation.
+*/
+class MoveRectPlanner
+{
+public:
+    MoveRectPlanner(size_t bytesPerPixel = 4);
+
+    // Plans the moves of one frame. The copies are valid until the next call.
+    void Plan(const RECT* sources, const RECT* destinations, size_t count);
+
+    // Copies to run in order
+    const MoveCopy* Copies() const;
+    size_t CopiesCount() const;
+
+    // Of the last Plan call
+    size_t DroppedMoves() const;
+    size_t MergedMoves() const;
+    size_t StagedMoves() const;
+
+    // Bytes the copies move, and how many fewer that is than staging every move
+    uint64_t BytesCopied() const;
+    uint64_t BytesSaved() const;
+
+private:
+    struct Move
+    {
+        RECT Source;
+        LONG DeltaX;
+        LONG DeltaY;
+        bool Staged;
+    };
+
+    static RECT Destination(const Move& move);
+
+    void Merge();
+    void Order();
+
+    size_t mBytesPerPixel;
+    std::vector<Move> mMoves;
+    std::vector<Move> mOrdered;
+    std::vector<MoveCopy> mCopies;
+    size_t mDroppedMoves;
+    size_t mMergedMoves;
+    size_t mStagedMoves;
+    uint64_t mBytesCopied;
+    uint64_t mBytesSaved;
+};
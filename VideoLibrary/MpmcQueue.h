@@ -0,0 +1,168 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+/*
+    Bounded multi-producer multi-consumer queue without locks, after Dmitry Vyukov's design.
+
+    Every cell carries a sequence number that says whose turn it is: a producer may fill
+    the cell when the sequence equals its position and a consumer may empty it when it is
+    one past. A stale position never matches a reused cell, so there is no ABA problem,
+    and the cells are allocated once, so there is nothing to reclaim.
+
+    Push and pop never allocate and fail instead of waiting when the queue is full or empty.
+*/
+template<typename T>
+class MpmcQueue
+{
+public:
+    // Rounded up to a power of two
+    explicit MpmcQueue(size_t capacity)
+        : mEnqueue{ 0 }
+        , mDequeue{ 0 }
+    {
+        if (capacity == 0)
+        {
+            throw std::invalid_argument("queue capacity must not be zero");
+        }
+
+        size_t rounded = 1;
+        while (rounded < capacity)
+        {
+            rounded <<= 1;
+        }
+
+        mCells.reset(new Cell[rounded]);
+        mMask = rounded - 1;
+        for (size_t i = 0; i < rounded; ++i)
+        {
+            mCells[i].Sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpmcQueue(const MpmcQueue&) = delete;
+    MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+    // False when the queue is full
+    bool TryPush(const T& value)
+    {
+        return Push(value);
+    }
+
+    // Only moves from the value when it was pushed
+    bool TryPush(T&& value)
+    {
+        return Push(std::move(value));
+    }
+
+    // False when the queue is empty
+    bool TryPop(T& value)
+    {
+        size_t position = mDequeue.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;)
+        {
+            cell = &mCells[position & mMask];
+            const size_t sequence = cell->Sequence.load(std::memory_order_acquire);
+            const intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1);
+            if (difference == 0)
+            {
+                if (mDequeue.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (difference < 0)
+            {
+                // no producer has filled the cell yet
+                return false;
+            }
+            else
+            {
+                position = mDequeue.load(std::memory_order_relaxed);
+            }
+        }
+
+        value = std::move(cell->Value);
+        cell->Sequence.store(position + mMask + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t Capacity() const
+    {
+        return mMask + 1;
+    }
+
+private:
+    static constexpr size_t CacheLineSize = 64;
+
+    struct Cell
+    {
+        std::atomic<size_t> Sequence;
+        T Value;
+    };
+
+    template<typename U>
+    bool Push(U&& value)
+    {
+        size_t position = mEnqueue.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;)
+        {
+            cell = &mCells[position & mMask];
+            const size_t sequence = cell->Sequence.load(std::memory_order_acquire);
+            const intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+            if (difference == 0)
+            {
+                if (mEnqueue.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (difference < 0)
+            {
+                // the consumer of the previous lap has not emptied the cell
+                return false;
+            }
+            else
+            {
+                position = mEnqueue.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->Value = std::forward<U>(value);
+        cell->Sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    std::unique_ptr<Cell[]> mCells;
+    size_t mMask;
+
+    // producers and consumers each get their own cache line
+    alignas(CacheLineSize) std::atomic<size_t> mEnqueue;
+    alignas(CacheLineSize) std::atomic<size_t> mDequeue;
+};
@@ -0,0 +1,472 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "pch.h"
+#include "DxMultithread.h"
+#include "DuplicationFrameSource.h"
+#include "FramePlanner.h"
+#include "MoveRectPlanner.h"
+#include "PackedRect.h"
+#include "RenderMoveRectsStep.h"
+#include "RenderDirtyRectsStep.h"
+#include "TextureToMediaSampleStep.h"
+#include "RotationTransform.h"
+#include "MultiMonitorCapture.h"
+
+namespace
+{
+    // How long a capture thread waits for its monitor to change before checking for Stop
+    constexpr std::chrono::milliseconds CaptureTimeout{ 50 };
+
+    // The shared surface opened on a monitor's device. The device stays entered
+    // while the surface is locked, like Pipeline keeps it during a frame.
+    class KeyedMutexSurfaceLock : public SurfaceLock
+    {
+    public:
+        KeyedMutexSurfaceLock(std::shared_ptr<SharedSurface> surface)
+            : mSurface{ surface }
+        {
+        }
+
+        virtual bool Lock() override
+        {
+            mMultithread = std::make_unique<DxMultithread>(mSurface->Device().as<ID3D10Multithread>());
+            mLock = mSurface->Lock();
+            if (!mLock->Locked())
+            {
+                Unlock();
+                return false;
+            }
+            return true;
+        }
+
+        virtual void Unlock() override
+        {
+            mLock.reset();
+            mMultithread.reset();
+        }
+
+        // Valid while locked
+        ID3D11Texture2D* TexturePtr() const
+        {
+            return mLock->TexturePtr();
+        }
+
+    private:
+        std::shared_ptr<SharedSurface> mSurface;
+        std::unique_ptr<DxMultithread> mMultithread;
+        std::unique_ptr<KeyedMutexLock> mLock;
+    };
+
+    // One monitor drawn into its region of the shared surface, the capture half of Pipeline
+    class MonitorCaptureSource : public CaptureSource
+    {
+    public:
+        MonitorCaptureSource(
+            const DesktopMonitor& monitor,
+            std::shared_ptr<KeyedMutexSurfaceLock> lock,
+            std::shared_ptr<DesktopPointer> desktopPointer,
+            std::shared_ptr<ChangeDetector> changes,
+            std::shared_ptr<std::mutex> pointerMutex,
+            RECT virtualDesktopBounds)
+            : mLock{ lock }
+            , mDesktopPointer{ desktopPointer }
+            , mChanges{ changes }
+            , mPointerMutex{ pointerMutex }
+            , mVirtualDesktopBounds{ virtualDesktopBounds }
+        {
+            // the monitor's own pointer holds the shapes it reports, they are merged after every frame
+            mDuplicator = std::make_shared<ScreenDuplicator>(monitor, std::make_shared<DesktopPointer>(virtualDesktopBounds));
+            mFrameSource = std::make_shared<DuplicationFrameSource>(mDuplicator);
+            mFrameSource->AcquireTimeout(CaptureTimeout);
+
+            auto device = mDuplicator->Device();
+            mShaderCache = std::make_shared<ShaderCache>(device);
+            mDirtyRectInstances = std::make_shared<std::vector<PackedRect>>();
+            mBufferDevice = std::make_shared<D3D11DynamicBufferDevice>(device);
+            mVertexRing = std::make_shared<DynamicBufferRing>(mBufferDevice);
+            mViewDevice = std::make_shared<D3D11ViewDevice>(device);
+            mDesktopViews = std::make_shared<ViewCache>(mViewDevice);
+            mDirtyRectConstants = mBufferDevice->CreateBuffer(DynamicBufferBinding::Constant, sizeof(PackedRectConstants));
+            mPlanner = std::make_shared<FramePlanner>();
+            mMovePlanner = std::make_shared<MoveRectPlanner>();
+        }
+
+        winrt::com_ptr<ID3D11Device> Device() const
+        {
+            return mDuplicator->Device();
+        }
+
+        virtual bool Capture() override
+        {
+            mFrame = mFrameSource->AcquireDuplicationFrame();
+            if (!mFrame->Captured())
+            {
+                mFrame = nullptr;
+                return false;
+            }
+
+            MergePointer();
+            return true;
+        }
+
+        virtual void Write(Region& damage) override
+        {
+            auto device = mDuplicator->Device();
+            if (mStagingTexture == nullptr)
+            {
+                D3D11_TEXTURE2D_DESC stagingDesc;
+                mFrame->DesktopImage()->GetDesc(&stagingDesc);
+                stagingDesc.BindFlags = D3D11_BIND_RENDER_TARGET;
+                stagingDesc.MiscFlags = 0;
+                winrt::check_hresult(device->CreateTexture2D(&stagingDesc, nullptr, mStagingTexture.put()));
+            }
+
+            if (mRenderTargetView == nullptr)
+            {
+                winrt::check_hresult(device->CreateRenderTargetView(
+                    mLock->TexturePtr(),
+                    nullptr,
+                    mRenderTargetView.put()
+                ));
+            }
+
+            mPlanner->Plan(*mFrame);
+
+            if (mPlanner->MoveRectsCount() != 0)
+            {
+                RenderMoveRectsStep renderMoves{
+                    mFrame,
+                    mVirtualDesktopBounds,
+                    mMovePlanner,
+                    mStagingTexture,
+                    mLock->TexturePtr()
+                };
+                renderMoves.Perform();
+            }
+
+            RenderDirtyRectsStep renderDirty{
+                mFrame,
+                mVirtualDesktopBounds,
+                mDirtyRectInstances,
+                mPlanner,
+                mShaderCache,
+                mDesktopViews,
+                mVertexRing,
+                mDirtyRectConstants,
+                mLock->TexturePtr(),
+                mRenderTargetView
+            };
+            renderDirty.Perform();
+            AddDamage(damage);
+
+            mFrame->ReleaseFrame();
+            mFrame = nullptr;
+        }
+
+        virtual void Skip() override
+        {
+            mPlanner->Skip(*mFrame);
+            mFrame = nullptr;
+        }
+
+    private:
+        // Only the monitor that shows the pointer, or showed it most recently, moves it
+        void MergePointer()
+        {
+            auto monitorPointer = mDuplicator->DesktopPointerPtr();
+            LARGE_INTEGER updateTime;
+            updateTime.QuadPart = mFrame->PointerUpdateTime();
+
+            std::lock_guard<std::mutex> lock{ *mPointerMutex };
+            if (mFrame->PointerShapeUpdated())
+            {
+                const size_t size = monitorPointer->BufferSize();
+                std::memcpy(mDesktopPointer->PutBuffer(size), monitorPointer->Buffer(), size);
+                mDesktopPointer->ShapeInfo(monitorPointer->ShapeInfo());
+            }
+
+            mDesktopPointer->UpdatePosition(
+                mFrame->PointerPosition(),
+                updateTime,
+                mDuplicator->OutputIndex(),
+                mFrame->DesktopMonitorBounds());
+
+            // the merged pointer, a pointer hidden on this monitor may be shown on another
+            mChanges->ObservePointer(mDesktopPointer->Position(), mFrame->PointerShapeUpdated());
+        }
+
+        // The dirty rects that were drawn and the destinations of the moves, on the shared surface
+        void AddDamage(Region& damage)
+        {
+            D3D11_TEXTURE2D_DESC imageDesc;
+            mFrame->DesktopImage()->GetDesc(&imageDesc);
+            const LONG imageWidth = static_cast<LONG>(imageDesc.Width);
+            const LONG imageHeight = static_cast<LONG>(imageDesc.Height);
+
+            const size_t dirtyCount = mPlanner->DirtyRectsCount();
+            const size_t moveCount = mPlanner->MoveRectsCount();
+            mDamageRects.resize(dirtyCount + moveCount);
+            mMoveSources.resize(moveCount);
+            RotateRects(mFrame->Rotation(), mPlanner->DirtyRects(), dirtyCount, imageWidth, imageHeight, mDamageRects.data());
+            RotateMoveRects(mFrame->Rotation(), mPlanner->MoveRects(), moveCount, imageWidth, imageHeight, mMoveSources.data(), mDamageRects.data() + dirtyCount);
+
+            const RECT monitorBounds = mFrame->DesktopMonitorBounds();
+            mFrameDamage.Reset(mDamageRects.data(), mDamageRects.size());
+            mFrameDamage.Translate(monitorBounds.left - mVirtualDesktopBounds.left, monitorBounds.top - mVirtualDesktopBounds.top);
+            damage.Union(mFrameDamage);
+        }
+
+        std::shared_ptr<ScreenDuplicator> mDuplicator;
+        std::shared_ptr<DuplicationFrameSource> mFrameSource;
+        std::shared_ptr<KeyedMutexSurfaceLock> mLock;
+        std::shared_ptr<DesktopPointer> mDesktopPointer;
+        std::shared_ptr<ChangeDetector> mChanges;
+        std::shared_ptr<std::mutex> mPointerMutex;
+        std::shared_ptr<ShaderCache> mShaderCache;
+        std::shared_ptr<std::vector<PackedRect>> mDirtyRectInstances;
+        std::shared_ptr<D3D11DynamicBufferDevice> mBufferDevice;
+        std::shared_ptr<DynamicBufferRing> mVertexRing;
+        std::shared_ptr<D3D11ViewDevice> mViewDevice;
+        std::shared_ptr<ViewCache> mDesktopViews;
+        std::shared_ptr<DynamicBuffer> mDirtyRectConstants;
+        std::shared_ptr<FramePlanner> mPlanner;
+        std::shared_ptr<MoveRectPlanner> mMovePlanner;
+        winrt::com_ptr<ID3D11Texture2D> mStagingTexture;
+        winrt::com_ptr<ID3D11RenderTargetView> mRenderTargetView;
+        std::shared_ptr<Frame> mFrame;
+        std::vector<RECT> mDamageRects;
+        std::vector<RECT> mMoveSources;
+        Region mFrameDamage;
+        RECT mVirtualDesktopBounds;
+    };
+}
+
+MultiMonitorCapture::MultiMonitorCapture(
+    const std::vector<DesktopMonitor>& monitors,
+    winrt::com_ptr<ID3D11Device> device,
+    RECT virtualDesktopBounds,
+    BoundedPoolOptions texturePoolOptions
+)
+    : mDevice{ device }
+    , mComposeMisses{ 0 }
+    , mVirtualDesktopBounds{ virtualDesktopBounds }
+    , mTexturePoolOptions{ texturePoolOptions }
+{
+    winrt::check_pointer(mDevice.get());
+    if (monitors.empty())
+    {
+        throw std::exception("No monitors to capture");
+    }
+
+    const LONG width = virtualDesktopBounds.right - virtualDesktopBounds.left;
+    const LONG height = virtualDesktopBounds.bottom - virtualDesktopBounds.top;
+    mSharedSurface = std::make_shared<SharedSurface>(mDevice, width, height, std::make_shared<RotatingKeys>(0, 0));
+
+    mDesktopPointer = std::make_shared<DesktopPointer>(virtualDesktopBounds);
+    mChanges = std::make_shared<ChangeDetector>();
+    mPointerMutex = std::make_shared<std::mutex>();
+    mComposePointer = std::make_shared<DesktopPointer>(virtualDesktopBounds);
+    mShaderCache = std::make_shared<ShaderCache>(mDevice);
+    mBufferDevice = std::make_shared<D3D11DynamicBufferDevice>(mDevice);
+    mVertexRing = std::make_shared<DynamicBufferRing>(mBufferDevice);
+    mPointerTextures = std::make_shared<PointerTextureCache>();
+    mPointerMasks = std::make_shared<PointerMaskCache>();
+    mViewDevice = std::make_shared<D3D11ViewDevice>(mDevice);
+    mPointerViews = std::make_shared<ViewCache>(mViewDevice);
+    mReadbackDevice = std::make_shared<D3D11ReadbackDevice>(mDevice, mSharedSurface->Desc().Format);
+    mPointerReadbacks = std::make_shared<ReadbackRing>(mReadbackDevice);
+    mDamageHistory = std::make_shared<DamageHistory>(RECT{ 0, 0, width, height });
+
+    for (const DesktopMonitor& monitor : monitors)
+    {
+        // every monitor writes through the surface opened on its own adapter's device
+        auto surface = mSharedSurface->OpenSharedSurfaceWithDevice(monitor.Adapter().Device());
+        auto lock = std::make_shared<KeyedMutexSurfaceLock>(surface);
+        auto source = std::make_shared<MonitorCaptureSource>(
+            monitor,
+            lock,
+            mDesktopPointer,
+            mChanges,
+            mPointerMutex,
+            virtualDesktopBounds);
+
+        mCapture.AddSource(winrt::to_string(monitor.OutputName()), source, lock);
+    }
+}
+
+MultiMonitorCapture::~MultiMonitorCapture()
+{
+    mCapture.Stop();
+}
+
+void MultiMonitorCapture::Start()
+{
+    mCapture.Start();
+}
+
+void MultiMonitorCapture::Stop()
+{
+    mCapture.Stop();
+}
+
+void MultiMonitorCapture::Perform()
+{
+    mSample = nullptr;
+
+    // need to use multithread protect because of Media Foundation api
+    DxMultithread multithread{ mDevice.as<ID3D10Multithread>() };
+    const bool damaged = mCapture.TakeDamage(mFrameDamage);
+    if (damaged)
+    {
+        mDamageHistory->Add(mFrameDamage);
+    }
+
+    // the surface is blank until a monitor drew into it
+    if (mCapture.Written() == 0)
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> pointerLock{ *mPointerMutex };
+        if (damaged)
+        {
+            mChanges->MarkChanged();
+        }
+
+        // a static desktop is neither composed nor encoded
+        if (!mChanges->TakeChange())
+        {
+            return;
+        }
+    }
+
+    Compose();
+    if (mSample == nullptr)
+    {
+        // try again at the next tick
+        std::lock_guard<std::mutex> pointerLock{ *mPointerMutex };
+        mChanges->MarkChanged();
+    }
+}
+
+void MultiMonitorCapture::KeepAlive()
+{
+    mSample = nullptr;
+    DxMultithread multithread{ mDevice.as<ID3D10Multithread>() };
+    if (mCapture.Written() == 0)
+    {
+        return;
+    }
+
+    Compose();
+}
+
+void MultiMonitorCapture::Compose()
+{
+    if (mTexturePool == nullptr)
+    {
+        AllocateTexturePool();
+    }
+
+    // the monitors keep merging the pointer while it is drawn
+    {
+        std::lock_guard<std::mutex> pointerLock{ *mPointerMutex };
+        mComposePointer->CopyState(*mDesktopPointer);
+    }
+
+    winrt::com_ptr<ID3D11Texture2D> desktopTexture;
+    {
+        RenderPointerTextureStep renderPointer{
+            mComposePointer,
+            mSharedSurface,
+            mDevice,
+            mShaderCache,
+            mVertexRing,
+            mPointerTextures,
+            mPointerMasks,
+            mPointerViews,
+            mReadbackDevice,
+            mPointerReadbacks,
+            mDamageHistory,
+            mTexturePool,
+            mVirtualDesktopBounds,
+            mVirtualDesktopBounds
+        };
+        renderPointer.Perform();
+        desktopTexture = renderPointer.Result();
+    }
+
+    if (desktopTexture == nullptr)
+    {
+        ++mComposeMisses;
+        return;
+    }
+
+    TextureToMediaSampleStep convertTexture{
+        desktopTexture,
+        mTexturePool
+    };
+    convertTexture.Perform();
+
+    mSample = convertTexture.Result();
+}
+
+winrt::com_ptr<IMFSample> MultiMonitorCapture::Sample() const
+{
+    return mSample;
+}
+
+winrt::com_ptr<ID3D11Device> MultiMonitorCapture::Device() const
+{
+    return mDevice;
+}
+
+ChangeDetectorStats MultiMonitorCapture::Changes() const
+{
+    std::lock_guard<std::mutex> pointerLock{ *mPointerMutex };
+    return mChanges->Stats();
+}
+
+std::vector<CaptureSourceStats> MultiMonitorCapture::MonitorStats() const
+{
+    return mCapture.Stats();
+}
+
+uint64_t MultiMonitorCapture::ComposeMisses() const
+{
+    return mComposeMisses;
+}
+
+const DamageHistory& MultiMonitorCapture::History() const
+{
+    return *mDamageHistory;
+}
+
+BoundedPoolStats MultiMonitorCapture::TexturePoolStats() const
+{
+    return mTexturePool != nullptr ? mTexturePool->Stats() : BoundedPoolStats{};
+}
+
+void MultiMonitorCapture::AllocateTexturePool()
+{
+    mTexturePool.attach(new TexturePool(mDevice, mSharedSurface->Desc(), mTexturePoolOptions));
+    winrt::check_pointer(mTexturePool.get());
+}
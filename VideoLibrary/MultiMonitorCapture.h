@@ -0,0 +1,129 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include "RecordingStep.h"
+#include "ParallelCapture.h"
+#include "TexturePool.h"
+#include "DesktopMonitor.h"
+#include "DesktopPointer.h"
+#include "D3D11DynamicBufferDevice.h"
+#include "DynamicBufferRing.h"
+#include "D3D11ReadbackDevice.h"
+#include "ReadbackRing.h"
+#include "DamageHistory.h"
+#include "D3D11ViewDevice.h"
+#include "ViewCache.h"
+#include "ShaderCache.h"
+#include "SharedSurface.h"
+#include "RenderPointerTextureStep.h"
+#include "ChangeDetector.h"
+
+/*
+    Records every monitor of the virtual desktop into one video.
+
+    Each monitor has its own ScreenDuplicator on the device of the adapter it is
+    attached to, and its own thread that waits for the monitor's frames and draws
+    them into its region of the shared surface. The threads only meet on the
+    surface's keyed mutex, which they take with equal keys so no turn order is
+    forced on them.
+
+    Perform is the single compositor: it draws the pointer onto a pooled copy of
+    the surface and turns it into a sample, like Pipeline does for one monitor.
+    It skips both while no monitor drew anything and the pointer stayed put.
+*/
+class MultiMonitorCapture : public RecordingStep
+{
+public:
+    // device composes and encodes, the shared surface covering virtualDesktopBounds is created on it
+    MultiMonitorCapture(
+        const std::vector<DesktopMonitor>& monitors,
+        winrt::com_ptr<ID3D11Device> device,
+        RECT virtualDesktopBounds,
+        BoundedPoolOptions texturePoolOptions = {}
+    );
+
+    virtual ~MultiMonitorCapture();
+
+    // Starts capturing every monitor on its own thread
+    void Start();
+
+    // Joins the capture threads
+    void Stop();
+
+    // Inherited via RecordingStep
+    virtual void Perform() override;
+
+    // Composes a sample of the unchanged desktop, for writing a frame while it is static
+    void KeepAlive();
+
+    // Null when nothing changed or the compositor missed the frame
+    winrt::com_ptr<IMFSample> Sample() const;
+
+    // Samples composed for changes and ticks that found the desktop static
+    ChangeDetectorStats Changes() const;
+
+    winrt::com_ptr<ID3D11Device> Device() const;
+
+    // Frame rate and time waiting for the shared surface, per monitor
+    std::vector<CaptureSourceStats> MonitorStats() const;
+
+    // Frames the compositor could not make because the surface stayed busy or the pool was empty
+    uint64_t ComposeMisses() const;
+
+    const DamageHistory& History() const;
+
+    BoundedPoolStats TexturePoolStats() const;
+
+private:
+
+    void AllocateTexturePool();
+    void Compose();
+
+    winrt::com_ptr<ID3D11Device> mDevice;
+    std::shared_ptr<SharedSurface> mSharedSurface;
+
+    // Merged from the monitors' pointers, both guarded by mPointerMutex
+    std::shared_ptr<DesktopPointer> mDesktopPointer;
+    std::shared_ptr<ChangeDetector> mChanges;
+    std::shared_ptr<std::mutex> mPointerMutex;
+
+    // Copied from mDesktopPointer to compose from, owns the pointer texture
+    std::shared_ptr<DesktopPointer> mComposePointer;
+
+    std::shared_ptr<ShaderCache> mShaderCache;
+    std::shared_ptr<D3D11DynamicBufferDevice> mBufferDevice;
+    std::shared_ptr<DynamicBufferRing> mVertexRing;
+    std::shared_ptr<PointerTextureCache> mPointerTextures;
+    std::shared_ptr<PointerMaskCache> mPointerMasks;
+    std::shared_ptr<D3D11ViewDevice> mViewDevice;
+    std::shared_ptr<ViewCache> mPointerViews;
+    std::shared_ptr<D3D11ReadbackDevice> mReadbackDevice;
+    std::shared_ptr<ReadbackRing> mPointerReadbacks;
+    std::shared_ptr<DamageHistory> mDamageHistory;
+    Region mFrameDamage;
+    winrt::com_ptr<TexturePool> mTexturePool;
+    winrt::com_ptr<IMFSample> mSample;
+    uint64_t mComposeMisses;
+    RECT mVirtualDesktopBounds;
+    BoundedPoolOptions mTexturePoolOptions;
+
+    // Declared last so the capture threads stop before anything they use goes away
+    ParallelCapture mCapture;
+};
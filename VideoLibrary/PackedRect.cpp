@@ -0,0 +1,170 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "PackedRect.h"
+#include "RotationTransform.h"
+
+#include <stdexcept>
+
+namespace
+{
+    constexpr LONG MaxPackedCoordinate = 0xFFFF;
+
+    // Rows are indexed by PackedRectConstants::Rotation, the same table is in the shader
+    constexpr RectCorner SourceCornerTable[4][4] = {
+        {
+            RotationTransform<DXGI_MODE_ROTATION_IDENTITY>::SourceCorners[0],
+            RotationTransform<DXGI_MODE_ROTATION_IDENTITY>::SourceCorners[1],
+            RotationTransform<DXGI_MODE_ROTATION_IDENTITY>::SourceCorners[2],
+            RotationTransform<DXGI_MODE_ROTATION_IDENTITY>::SourceCorners[3]
+        },
+        {
+            RotationTransform<DXGI_MODE_ROTATION_ROTATE90>::SourceCorners[0],
+            RotationTransform<DXGI_MODE_ROTATION_ROTATE90>::SourceCorners[1],
+            RotationTransform<DXGI_MODE_ROTATION_ROTATE90>::SourceCorners[2],
+            RotationTransform<DXGI_MODE_ROTATION_ROTATE90>::SourceCorners[3]
+        },
+        {
+            RotationTransform<DXGI_MODE_ROTATION_ROTATE180>::SourceCorners[0],
+            RotationTransform<DXGI_MODE_ROTATION_ROTATE180>::SourceCorners[1],
+            RotationTransform<DXGI_MODE_ROTATION_ROTATE180>::SourceCorners[2],
+            RotationTransform<DXGI_MODE_ROTATION_ROTATE180>::SourceCorners[3]
+        },
+        {
+            RotationTransform<DXGI_MODE_ROTATION_ROTATE270>::SourceCorners[0],
+            RotationTransform<DXGI_MODE_ROTATION_ROTATE270>::SourceCorners[1],
+            RotationTransform<DXGI_MODE_ROTATION_ROTATE270>::SourceCorners[2],
+            RotationTransform<DXGI_MODE_ROTATION_ROTATE270>::SourceCorners[3]
+        }
+    };
+
+    uint32_t RotationIndex(DXGI_MODE_ROTATION rotation)
+    {
+        switch (rotation)
+        {
+        case DXGI_MODE_ROTATION_ROTATE90:
+            return 1;
+        case DXGI_MODE_ROTATION_ROTATE180:
+            return 2;
+        case DXGI_MODE_ROTATION_ROTATE270:
+            return 3;
+        default:
+            return 0;
+        }
+    }
+
+    // Corner of a left, top, right, bottom quadruple
+    void CornerOf(const uint16_t rect[4], RectCorner corner, uint16_t& x, uint16_t& y)
+    {
+        const bool right = corner == BottomRightCorner || corner == TopRightCorner;
+        const bool bottom = corner == BottomLeftCorner || corner == BottomRightCorner;
+        x = rect[right ? 2 : 0];
+        y = rect[bottom ? 3 : 1];
+    }
+}
+
+PackedRectConstants MakePackedRectConstants(DXGI_MODE_ROTATION rotation, const DirtyRectVertexLayout& layout)
+{
+    if (layout.ImageWidth <= 0 || layout.ImageHeight <= 0 || layout.TargetWidth < 2 || layout.TargetHeight < 2)
+    {
+        throw std::invalid_argument("invalid dirty rect layout");
+    }
+
+    if (layout.ImageWidth > MaxPackedCoordinate || layout.ImageHeight > MaxPackedCoordinate ||
+        layout.TargetWidth > MaxPackedCoordinate || layout.TargetHeight > MaxPackedCoordinate)
+    {
+        throw std::invalid_argument("dirty rect layout exceeds 16 bit coordinates");
+    }
+
+    // same integer center as the triangle list path
+    const LONG centerX = layout.TargetWidth / 2;
+    const LONG centerY = layout.TargetHeight / 2;
+
+    PackedRectConstants constants;
+    constants.InverseImageWidth = 1.0f / static_cast<float>(layout.ImageWidth);
+    constants.InverseImageHeight = 1.0f / static_cast<float>(layout.ImageHeight);
+    constants.CenterX = static_cast<float>(centerX);
+    constants.CenterY = static_cast<float>(centerY);
+    constants.PositionScaleX = 1.0f / static_cast<float>(centerX);
+    constants.PositionScaleY = -1.0f / static_cast<float>(centerY);
+    constants.Rotation = RotationIndex(rotation);
+    constants.Padding = 0;
+    return constants;
+}
+
+void PackDirtyRects(
+    DXGI_MODE_ROTATION rotation,
+    const RECT* rects,
+    size_t count,
+    const DirtyRectVertexLayout& layout,
+    PackedRect* packed)
+{
+    VisitRotation(rotation, [&](auto transform) {
+        using Transform = decltype(transform);
+        for (size_t i = 0; i < count; ++i)
+        {
+            const RECT& rect = rects[i];
+            const RECT rotated = Transform::Rect(rect, layout.ImageWidth, layout.ImageHeight);
+
+            // dirty rects are within the image and monitors within the target,
+            // so every coordinate fits once the layout has been validated
+            PackedRect& out = packed[i];
+            out.Source[0] = static_cast<uint16_t>(rect.left);
+            out.Source[1] = static_cast<uint16_t>(rect.top);
+            out.Source[2] = static_cast<uint16_t>(rect.right);
+            out.Source[3] = static_cast<uint16_t>(rect.bottom);
+            out.Destination[0] = static_cast<uint16_t>(rotated.left + layout.OriginX);
+            out.Destination[1] = static_cast<uint16_t>(rotated.top + layout.OriginY);
+            out.Destination[2] = static_cast<uint16_t>(rotated.right + layout.OriginX);
+            out.Destination[3] = static_cast<uint16_t>(rotated.bottom + layout.OriginY);
+        }
+    });
+}
+
+void ExpandPackedRects(
+    const PackedRect* packed,
+    size_t count,
+    const PackedRectConstants& constants,
+    Vertex* vertices)
+{
+    const RectCorner* sourceCorners = SourceCornerTable[constants.Rotation & 3];
+
+    // the shader draws a four vertex strip, the triangle list repeats two of them
+    constexpr RectCorner listCorners[g_VerticesPerRect] = {
+        BottomLeftCorner, TopLeftCorner, BottomRightCorner,
+        BottomRightCorner, TopLeftCorner, TopRightCorner
+    };
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        for (int v = 0; v < g_VerticesPerRect; ++v)
+        {
+            uint16_t x, y, u, w;
+            CornerOf(packed[i].Destination, listCorners[v], x, y);
+            CornerOf(packed[i].Source, sourceCorners[listCorners[v]], u, w);
+
+            Vertex& vertex = vertices[i * g_VerticesPerRect + v];
+            vertex.pos.x = (static_cast<float>(x) - constants.CenterX) * constants.PositionScaleX;
+            vertex.pos.y = (static_cast<float>(y) - constants.CenterY) * constants.PositionScaleY;
+            vertex.pos.z = 0.0f;
+            vertex.texCoord.u = static_cast<float>(u) * constants.InverseImageWidth;
+            vertex.texCoord.v = static_cast<float>(w) * constants.InverseImageHeight;
+        }
+    }
+}
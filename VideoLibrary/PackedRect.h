@@ -0,0 +1,92 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+//
+// PackedRect.h
+// Compact per instance record for drawing dirty rects. The instanced vertex
+// shader expands each record into a quad, so a rect costs 16 bytes of upload
+// instead of six 20 byte vertices.
+//
+
+#pragma once
+#include "PlatformTypes.h"
+#include "Vertex.h"
+#include <cstdint>
+
+// Where the desktop image is drawn on the render target
+struct DirtyRectVertexLayout
+{
+    // dimensions of the desktop image the dirty rects are in
+    LONG ImageWidth;
+    LONG ImageHeight;
+
+    // top left of the monitor on the render target
+    LONG OriginX;
+    LONG OriginY;
+
+    // dimensions of the render target
+    LONG TargetWidth;
+    LONG TargetHeight;
+};
+
+// Layout must match INSTANCE_INPUT in InstancedRectVertexShader.hlsl
+struct PackedRect
+{
+    // left, top, right, bottom in the desktop image
+    uint16_t Source[4];
+
+    // left, top, right, bottom on the render target
+    uint16_t Destination[4];
+};
+
+static_assert(sizeof(PackedRect) == 16, "PackedRect is uploaded as two R16G16B16A16 elements");
+
+// Per draw values, layout must match the RectConstants cbuffer
+struct PackedRectConstants
+{
+    float InverseImageWidth;
+    float InverseImageHeight;
+    float CenterX;
+    float CenterY;
+    float PositionScaleX;
+    float PositionScaleY;
+
+    // 0 to 3 for identity, 90, 180 and 270 degrees
+    uint32_t Rotation;
+    uint32_t Padding;
+};
+
+static_assert(sizeof(PackedRectConstants) % 16 == 0, "constant buffers are a multiple of 16 bytes");
+
+// Throws std::invalid_argument when the image or target cannot be addressed with 16 bit coordinates
+PackedRectConstants MakePackedRectConstants(DXGI_MODE_ROTATION rotation, const DirtyRectVertexLayout& layout);
+
+// Rotates each rect and places it on the render target
+void PackDirtyRects(
+    DXGI_MODE_ROTATION rotation,
+    const RECT* rects,
+    size_t count,
+    const DirtyRectVertexLayout& layout,
+    PackedRect* packed);
+
+// Does on the CPU what the instanced vertex shader does, g_VerticesPerRect vertices per rect
+void ExpandPackedRects(
+    const PackedRect* packed,
+    size_t count,
+    const PackedRectConstants& constants,
+    Vertex* vertices);
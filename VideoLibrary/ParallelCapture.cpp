@@ -0,0 +1,207 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "pch.h"
+#include "ParallelCapture.h"
+
+#include <stdexcept>
+
+ParallelCapture::ParallelCapture()
+    : mRunning{ false }
+    , mStopped{ false }
+{
+}
+
+ParallelCapture::~ParallelCapture()
+{
+    Stop();
+}
+
+void ParallelCapture::AddSource(std::string name, std::shared_ptr<CaptureSource> source, std::shared_ptr<SurfaceLock> lock)
+{
+    if (mRunning || mStopped)
+    {
+        throw std::logic_error("sources are added before capturing starts");
+    }
+
+    if (source == nullptr || lock == nullptr)
+    {
+        throw std::invalid_argument("null capture source or surface lock");
+    }
+
+    mSources.emplace_back(std::make_unique<SourceState>(std::move(name), std::move(source), std::move(lock)));
+}
+
+void ParallelCapture::Start()
+{
+    if (mRunning || mStopped)
+    {
+        throw std::logic_error("capturing starts once");
+    }
+
+    if (mSources.empty())
+    {
+        throw std::logic_error("there is nothing to capture");
+    }
+
+    mStartTime = std::chrono::steady_clock::now();
+    mRunning = true;
+    for (auto& source : mSources)
+    {
+        SourceState& state = *source;
+        state.Thread = std::thread{ [this, &state]() { Run(state); } };
+    }
+}
+
+void ParallelCapture::Stop()
+{
+    if (!mRunning)
+    {
+        return;
+    }
+
+    mRunning = false;
+    mStopped = true;
+    for (auto& source : mSources)
+    {
+        source->Thread.join();
+    }
+    mStopTime = std::chrono::steady_clock::now();
+}
+
+bool ParallelCapture::Running() const
+{
+    return mRunning;
+}
+
+bool ParallelCapture::TakeDamage(Region& damage)
+{
+    {
+        std::lock_guard<std::mutex> lock{ mFailureMutex };
+        if (mFailure)
+        {
+            std::rethrow_exception(mFailure);
+        }
+    }
+
+    damage.Clear();
+    for (auto& source : mSources)
+    {
+        std::lock_guard<std::mutex> lock{ source->DamageMutex };
+        damage.Union(source->Pending);
+        source->Pending.Clear();
+    }
+    return !damage.IsEmpty();
+}
+
+uint64_t ParallelCapture::Written() const
+{
+    uint64_t written = 0;
+    for (const auto& source : mSources)
+    {
+        written += source->WrittenFrames.load(std::memory_order_relaxed);
+    }
+    return written;
+}
+
+std::vector<CaptureSourceStats> ParallelCapture::Stats() const
+{
+    const auto end = mStopped ? mStopTime : std::chrono::steady_clock::now();
+    const double seconds = mRunning || mStopped ? std::chrono::duration<double>(end - mStartTime).count() : 0.0;
+
+    std::vector<CaptureSourceStats> stats;
+    for (const auto& source : mSources)
+    {
+        CaptureSourceStats sourceStats{};
+        sourceStats.Name = source->Name;
+        sourceStats.Captured = source->Captured.load(std::memory_order_relaxed);
+        sourceStats.Written = source->WrittenFrames.load(std::memory_order_relaxed);
+        sourceStats.Skipped = source->Skipped.load(std::memory_order_relaxed);
+        sourceStats.Idle = source->Idle.load(std::memory_order_relaxed);
+        sourceStats.FrameRate = seconds > 0.0 ? sourceStats.Written / seconds : 0.0;
+        sourceStats.LockWait = std::chrono::nanoseconds{ source->LockWait.load(std::memory_order_relaxed) };
+        sourceStats.MaxLockWait = std::chrono::nanoseconds{ source->MaxLockWait.load(std::memory_order_relaxed) };
+        stats.push_back(sourceStats);
+    }
+    return stats;
+}
+
+void ParallelCapture::Run(SourceState& state)
+{
+    try
+    {
+        while (mRunning.load(std::memory_order_relaxed))
+        {
+            CaptureOnce(state);
+        }
+    }
+    catch (...)
+    {
+        // the compositor rethrows it, the other monitors keep going until then
+        std::lock_guard<std::mutex> lock{ mFailureMutex };
+        if (!mFailure)
+        {
+            mFailure = std::current_exception();
+        }
+    }
+}
+
+void ParallelCapture::CaptureOnce(SourceState& state)
+{
+    if (!state.Source->Capture())
+    {
+        state.Idle.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    state.Captured.fetch_add(1, std::memory_order_relaxed);
+
+    const auto start = std::chrono::steady_clock::now();
+    const bool locked = state.Lock->Lock();
+    const int64_t wait = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    state.LockWait.fetch_add(wait, std::memory_order_relaxed);
+    int64_t longest = state.MaxLockWait.load(std::memory_order_relaxed);
+    while (wait > longest && !state.MaxLockWait.compare_exchange_weak(longest, wait, std::memory_order_relaxed))
+    {
+    }
+
+    if (!locked)
+    {
+        state.Source->Skip();
+        state.Skipped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    try
+    {
+        state.Written.Clear();
+        state.Source->Write(state.Written);
+
+        // published before unlocking, a compositor that locks next finds it
+        std::lock_guard<std::mutex> lock{ state.DamageMutex };
+        state.Pending.Union(state.Written);
+    }
+    catch (...)
+    {
+        state.Lock->Unlock();
+        throw;
+    }
+
+    state.Lock->Unlock();
+    state.WrittenFrames.fetch_add(1, std::memory_order_relaxed);
+}
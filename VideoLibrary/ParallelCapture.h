@@ -0,0 +1,164 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+//
+// ParallelCapture.h
+// Captures several monitors at once into their regions of one shared virtual
+// desktop surface. Every monitor is waited on by its own thread, so a monitor
+// that refreshes slowly or not at all does not hold up the others. The threads
+// take turns on the surface's lock and a single compositor picks up what they
+// drew since it last looked.
+//
+
+#pragma once
+
+#include "Region.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// The shared surface's lock as one capture thread sees it
+class SurfaceLock
+{
+public:
+    virtual ~SurfaceLock() = default;
+
+    // False when the surface stayed busy until the lock gave up
+    virtual bool Lock() = 0;
+
+    virtual void Unlock() = 0;
+};
+
+// One monitor, captured on its own thread
+class CaptureSource
+{
+public:
+    virtual ~CaptureSource() = default;
+
+    // Waits for the monitor's next frame, false when none arrived.
+    // Returns in bounded time so the thread notices Stop.
+    virtual bool Capture() = 0;
+
+    // Draws the captured frame into the monitor's region of the locked surface
+    // and adds the pixels it changed, in surface coordinates, to damage
+    virtual void Write(Region& damage) = 0;
+
+    // The surface stayed busy, the captured frame's damage goes with the next write
+    virtual void Skip() = 0;
+};
+
+struct CaptureSourceStats
+{
+    std::string Name;
+
+    uint64_t Captured;
+    uint64_t Written;
+
+    // Frames the surface was too busy for
+    uint64_t Skipped;
+
+    // Waits that ended without a frame
+    uint64_t Idle;
+
+    // Written frames per second between Start and now, or Stop
+    double FrameRate;
+
+    // Time waiting for the surface's lock, in total and at most once
+    std::chrono::nanoseconds LockWait;
+    std::chrono::nanoseconds MaxLockWait;
+};
+
+class ParallelCapture
+{
+public:
+    ParallelCapture();
+
+    ParallelCapture(const ParallelCapture&) = delete;
+    ParallelCapture& operator=(const ParallelCapture&) = delete;
+
+    ~ParallelCapture();
+
+    // Sources are added before Start, each with its own lock on the same surface
+    void AddSource(std::string name, std::shared_ptr<CaptureSource> source, std::shared_ptr<SurfaceLock> lock);
+
+    void Start();
+
+    // Joins the capture threads, damage they wrote can still be taken
+    void Stop();
+
+    bool Running() const;
+
+    // Moves the damage written since the last call into damage, false when there was none.
+    // Rethrows what stopped a capture thread.
+    bool TakeDamage(Region& damage);
+
+    // Frames written by all sources, zero until the surface has content
+    uint64_t Written() const;
+
+    std::vector<CaptureSourceStats> Stats() const;
+
+private:
+    struct SourceState
+    {
+        SourceState(std::string name, std::shared_ptr<CaptureSource> source, std::shared_ptr<SurfaceLock> lock)
+            : Name{ std::move(name) }
+            , Source{ std::move(source) }
+            , Lock{ std::move(lock) }
+        {
+        }
+
+        std::string Name;
+        std::shared_ptr<CaptureSource> Source;
+        std::shared_ptr<SurfaceLock> Lock;
+
+        // Damage of one write, only touched by the source's thread
+        Region Written;
+
+        // Damage written and not yet taken by the compositor
+        std::mutex DamageMutex;
+        Region Pending;
+
+        std::atomic<uint64_t> Captured{ 0 };
+        std::atomic<uint64_t> WrittenFrames{ 0 };
+        std::atomic<uint64_t> Skipped{ 0 };
+        std::atomic<uint64_t> Idle{ 0 };
+        std::atomic<int64_t> LockWait{ 0 };
+        std::atomic<int64_t> MaxLockWait{ 0 };
+
+        std::thread Thread;
+    };
+
+    void Run(SourceState& state);
+    void CaptureOnce(SourceState& state);
+
+    std::vector<std::unique_ptr<SourceState>> mSources;
+    std::atomic<bool> mRunning;
+    bool mStopped;
+    std::chrono::steady_clock::time_point mStartTime;
+    std::chrono::steady_clock::time_point mStopTime;
+
+    std::mutex mFailureMutex;
+    std::exception_ptr mFailure;
+};
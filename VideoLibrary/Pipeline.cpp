@@ -24,16 +24,22 @@
 #include "RenderDirtyRectsStep.h"
 #include "RenderPointerTextureStep.h"
 #include "TextureToMediaSampleStep.h"
+#include "RecordTraceStep.h"
+#include "RecordPointerTrackStep.h"
+#include "CopyDamageStep.h"
+#include "RotationTransform.h"
 #include "Pipeline.h"
 
 Pipeline::Pipeline(
     std::shared_ptr<ScreenDuplicator> duplicator,
     std::shared_ptr<SharedSurface> sharedSurface,
-    RECT virtualDesktopBounds
+    RECT virtualDesktopBounds,
+    BoundedPoolOptions texturePoolOptions
 )
     : mDuplicator{ duplicator }
     , mSharedSurface{ sharedSurface }
     , mVirtualDesktopBounds{ virtualDesktopBounds }
+    , mTexturePoolOptions{ texturePoolOptions }
 {
     if (mDuplicator == nullptr)
     {
@@ -42,8 +48,25 @@ Pipeline::Pipeline(
 
     winrt::check_pointer(mSharedSurface.get());
     mShaderCache = std::make_shared<ShaderCache>(mDuplicator->Device());
-    mVertexBuffer = std::make_shared<std::vector<Vertex>>();
-
+    mDirtyRectInstances = std::make_shared<std::vector<PackedRect>>();
+    mBufferDevice = std::make_shared<D3D11DynamicBufferDevice>(mDuplicator->Device());
+    mVertexRing = std::make_shared<DynamicBufferRing>(mBufferDevice);
+    mPointerTextures = std::make_shared<PointerTextureCache>();
+    mPointerMasks = std::make_shared<PointerMaskCache>();
+    mViewDevice = std::make_shared<D3D11ViewDevice>(mDuplicator->Device());
+    mDesktopViews = std::make_shared<ViewCache>(mViewDevice);
+    mPointerViews = std::make_shared<ViewCache>(mViewDevice);
+    mReadbackDevice = std::make_shared<D3D11ReadbackDevice>(mDuplicator->Device(), mSharedSurface->Desc().Format);
+    mPointerReadbacks = std::make_shared<ReadbackRing>(mReadbackDevice);
+    const D3D11_TEXTURE2D_DESC surfaceDesc = mSharedSurface->Desc();
+    mDamageHistory = std::make_shared<DamageHistory>(
+        RECT{ 0, 0, static_cast<LONG>(surfaceDesc.Width), static_cast<LONG>(surfaceDesc.Height) });
+    mDirtyRectConstants = mBufferDevice->CreateBuffer(DynamicBufferBinding::Constant, sizeof(PackedRectConstants));
+    mFrameSource = std::make_shared<DuplicationFrameSource>(mDuplicator);
+    mPlanner = std::make_shared<FramePlanner>();
+    mMovePlanner = std::make_shared<MoveRectPlanner>();
+    mTracePixels = std::make_shared<std::vector<byte>>();
+    BuildGraph();
 }
 
 Pipeline::~Pipeline()
@@ -52,100 +75,404 @@ Pipeline::~Pipeline()
 
 void Pipeline::Perform()
 {
-    mSample == nullptr;
-    auto device = mDuplicator->Device();
-    // need to use multithread protect because of Media Foundation api
+    mGraph.Set(mSamplePort, winrt::com_ptr<IMFSample>{});
+    mGraph.Run();
+}
+
+void Pipeline::KeepAlive()
+{
+    mGraph.Set(mSamplePort, winrt::com_ptr<IMFSample>{});
+    DxMultithread multithread{ mDuplicator->Device().as<ID3D10Multithread>() };
+
+    // composes the unchanged desktop as if it changed
+    mGraph.Set(mChangePort, mGraph.Value(mChangePort) + 1);
+    mGraph.RunFrom("draw pointer");
+}
+
+void Pipeline::BuildGraph()
+{
+    // the device lock, the frame and the lock on the surface only live while the frame
+    // is drawn. Ports are reset in reverse, so the device lock is released last.
+    mDevicePort = mGraph.Port<std::shared_ptr<DxMultithread>>("device lock", PortLifetime::Run);
+    mFramePort = mGraph.Port<std::shared_ptr<Frame>>("frame", PortLifetime::Run);
+    mSurfacePort = mGraph.Port<std::shared_ptr<KeyedMutexLock>>("surface", PortLifetime::Run);
+    mChangePort = mGraph.Port<uint64_t>("change");
+    mDesktopTexturePort = mGraph.Port<winrt::com_ptr<ID3D11Texture2D>>("desktop texture", PortLifetime::Run);
+    mSamplePort = mGraph.Port<winrt::com_ptr<IMFSample>>("sample");
+
+    auto step = [this](bool (Pipeline::*function)(StepContext&))
+    {
+        return [this, function](StepContext& context) { return (this->*function)(context); };
+    };
+
+    mGraph.AddStep("capture", {}, { mFramePort }, step(&Pipeline::CaptureFrame));
+    mGraph.AddStep("lock device", {}, { mDevicePort }, step(&Pipeline::LockDevice));
+    mGraph.AddStep("trace", { mFramePort }, {}, step(&Pipeline::RecordTrace));
+    mGraph.AddStep("pointer track", { mFramePort }, {}, step(&Pipeline::RecordPointerTrack));
+    mGraph.AddStep("lock surface", { mFramePort }, { mSurfacePort }, step(&Pipeline::LockSurface));
+    mGraph.AddStep("plan", { mFramePort, mSurfacePort }, {}, step(&Pipeline::PlanFrame));
+    mGraph.AddStep("move rects", { mFramePort, mSurfacePort }, {}, step(&Pipeline::RenderMoveRects));
+    mGraph.AddStep("dirty rects", { mFramePort, mSurfacePort }, {}, step(&Pipeline::RenderDirtyRects));
+    mGraph.AddStep("finish frame", { mFramePort }, { mSurfacePort }, step(&Pipeline::FinishFrame));
+    mGraph.AddStep("detect changes", {}, { mChangePort }, step(&Pipeline::DetectChanges));
+
+    // a static desktop is neither composed nor encoded
+    mGraph.AddStep("draw pointer", { mChangePort }, { mDesktopTexturePort }, step(&Pipeline::DrawPointer), StepOptions{ true });
+    mGraph.AddStep("make sample", { mDesktopTexturePort }, { mSamplePort }, step(&Pipeline::MakeSample));
+}
+
+bool Pipeline::CaptureFrame(StepContext& context)
+{
+    // capture before locking so the frame's damage is known even if the lock times out
+    CaptureFrameStep captureFrame{ *mFrameSource };
+    captureFrame.Perform();
+
+    std::shared_ptr<Frame> frame = captureFrame.Result();
+
+    // the pointer is drawn from its own state, it changes whether or not the frame is drawn
+    mChanges.ObservePointer(*frame);
+    context.Write(mFramePort, frame);
+    return true;
+}
+
+bool Pipeline::LockDevice(StepContext& context)
+{
+    // Capture waits for the next frame without the lock, so the encoder and Media Foundation
+    // can use the device meanwhile. Everything after it needs multithread protect because
+    // of the Media Foundation api
     // https://docs.microsoft.com/en-us/windows/win32/api/mfobjects/nf-mfobjects-imfdxgidevicemanager-resetdevice#remarks
-    DxMultithread multithread{ device.as<ID3D10Multithread>() };
+    context.Write(mDevicePort, std::make_shared<DxMultithread>(mDuplicator->Device().as<ID3D10Multithread>()));
+    return true;
+}
+
+bool Pipeline::RecordTrace(StepContext& context)
+{
+    const std::shared_ptr<Frame>& frame = context.Read(mFramePort);
+    if (mTraceWriter == nullptr || !frame->Captured())
+    {
+        return true;
+    }
+
+    if (mTraceWriter->RecordsPixels())
     {
-        auto lock = mSharedSurface->Lock();
+        D3D11_TEXTURE2D_DESC imageDesc;
+        frame->DesktopImage()->GetDesc(&imageDesc);
 
-        if (!lock->Locked())
+        // a mode change, new resolution or rotation hands out images of another size
+        D3D11_TEXTURE2D_DESC readbackDesc{};
+        if (mTraceReadbackTexture != nullptr)
         {
-            return;
+            mTraceReadbackTexture->GetDesc(&readbackDesc);
         }
 
-        CaptureFrameStep captureFrame{ *mDuplicator };
-        captureFrame.Perform();
+        if (mTraceReadbackTexture == nullptr ||
+            readbackDesc.Width != imageDesc.Width ||
+            readbackDesc.Height != imageDesc.Height ||
+            readbackDesc.Format != imageDesc.Format)
+        {
+            readbackDesc = imageDesc;
+            readbackDesc.Usage = D3D11_USAGE_STAGING;
+            readbackDesc.BindFlags = 0;
+            readbackDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+            readbackDesc.MiscFlags = 0;
+            mTraceReadbackTexture = nullptr;
+            winrt::check_hresult(mDuplicator->Device()->CreateTexture2D(
+                &readbackDesc,
+                nullptr,
+                mTraceReadbackTexture.put()));
+        }
+    }
+
+    RecordTraceStep recordTrace{
+        frame,
+        mDuplicator->DesktopPointerPtr(),
+        mTraceWriter,
+        mTraceReadbackTexture,
+        mTracePixels
+    };
+    recordTrace.Perform();
+    return true;
+}
+
+bool Pipeline::RecordPointerTrack(StepContext& context)
+{
+    if (mPointerTrack == nullptr)
+    {
+        return true;
+    }
+
+    RecordPointerTrackStep recordPointer{
+        context.Read(mFramePort),
+        mDuplicator->DesktopPointerPtr(),
+        mPointerTrack
+    };
+    recordPointer.Perform();
+    return true;
+}
+
+bool Pipeline::LockSurface(StepContext& context)
+{
+    const std::shared_ptr<Frame>& frame = context.Read(mFramePort);
+    std::shared_ptr<KeyedMutexLock> lock{ mSharedSurface->Lock() };
 
-        std::shared_ptr<Frame> frame = captureFrame.Result();
-        mDesktopMonitorBounds = frame->DesktopMonitorBounds();
+    if (!lock->Locked())
+    {
         if (frame->Captured())
         {
-            if (mTexturePool == nullptr)
-            {
-                AllocateTexturePool();
-            }
-
-            if (mStagingTexture == nullptr)
-            {
-                D3D11_TEXTURE2D_DESC stagingDesc;
-                frame->DesktopImage()->GetDesc(&stagingDesc);
-                stagingDesc.BindFlags = D3D11_BIND_RENDER_TARGET;
-                stagingDesc.MiscFlags = 0;
-                AllocateStagingTexture(device, stagingDesc);
-            }
-
-            if (mRenderTargetView == nullptr)
-            {
-                winrt::check_hresult(mDuplicator->Device()->CreateRenderTargetView(
-                    lock->TexturePtr(),
-                    nullptr,
-                    mRenderTargetView.put()
-                ));
-            }
-
-            RenderMoveRectsStep renderMoves{
-                frame,
-                mVirtualDesktopBounds,
-                mStagingTexture,
-                lock->TexturePtr()
-            };
-
-            renderMoves.Perform();
-
-            RenderDirtyRectsStep renderDirty{
-                frame,
-                mVirtualDesktopBounds,
-                mVertexBuffer,
-                mShaderCache,
-                lock->TexturePtr(),
-                mRenderTargetView
-            };
-            renderDirty.Perform();
+            mPlanner->Skip(*frame);
         }
+        return false;
     }
 
-    RenderPointerTextureStep renderPointer{
-        mDuplicator->DesktopPointerPtr(),
-        mSharedSurface,
-        mDuplicator->Device(),
-        mShaderCache,
-        mTexturePool,
+    mDesktopMonitorBounds = frame->DesktopMonitorBounds();
+    context.Write(mSurfacePort, lock);
+    return true;
+}
+
+bool Pipeline::PlanFrame(StepContext& context)
+{
+    const std::shared_ptr<Frame>& frame = context.Read(mFramePort);
+    if (!frame->Captured())
+    {
+        return true;
+    }
+
+    if (mTexturePool == nullptr)
+    {
+        AllocateTexturePool();
+    }
+
+    if (mStagingTexture == nullptr)
+    {
+        D3D11_TEXTURE2D_DESC stagingDesc;
+        frame->DesktopImage()->GetDesc(&stagingDesc);
+        stagingDesc.BindFlags = D3D11_BIND_RENDER_TARGET;
+        stagingDesc.MiscFlags = 0;
+        AllocateStagingTexture(mDuplicator->Device(), stagingDesc);
+    }
+
+    if (mRenderTargetView == nullptr)
+    {
+        winrt::check_hresult(mDuplicator->Device()->CreateRenderTargetView(
+            context.Read(mSurfacePort)->TexturePtr(),
+            nullptr,
+            mRenderTargetView.put()
+        ));
+    }
+
+    mPlanner->Plan(*frame);
+    return true;
+}
+
+bool Pipeline::RenderMoveRects(StepContext& context)
+{
+    const std::shared_ptr<Frame>& frame = context.Read(mFramePort);
+    if (!frame->Captured() || mPlanner->MoveRectsCount() == 0)
+    {
+        return true;
+    }
+
+    RenderMoveRectsStep renderMoves{
+        frame,
+        mVirtualDesktopBounds,
+        mMovePlanner,
+        mStagingTexture,
+        context.Read(mSurfacePort)->TexturePtr()
+    };
+    renderMoves.Perform();
+    return true;
+}
+
+bool Pipeline::RenderDirtyRects(StepContext& context)
+{
+    const std::shared_ptr<Frame>& frame = context.Read(mFramePort);
+    if (!frame->Captured())
+    {
+        return true;
+    }
+
+    RenderDirtyRectsStep renderDirty{
+        frame,
         mVirtualDesktopBounds,
-        mDesktopMonitorBounds
+        mDirtyRectInstances,
+        mPlanner,
+        mShaderCache,
+        mDesktopViews,
+        mVertexRing,
+        mDirtyRectConstants,
+        context.Read(mSurfacePort)->TexturePtr(),
+        mRenderTargetView
     };
-    renderPointer.Perform();
+    renderDirty.Perform();
+    return true;
+}
+
+bool Pipeline::FinishFrame(StepContext& context)
+{
+    const std::shared_ptr<Frame>& frame = context.Read(mFramePort);
+    if (frame->Captured())
+    {
+        RecordDamage(*frame);
+
+        // includes damage carried over from frames the surface was too busy for
+        if (!mPlanner->Damage().IsEmpty() || mPlanner->MoveRectsCount() != 0)
+        {
+            mChanges.MarkChanged();
+        }
+
+        // done with the desktop image, let the next frame be acquired
+        // while the pooled move and dirty rects are still in use
+        frame->ReleaseFrame();
+    }
+
+    // composing locks the surface again
+    context.Write(mSurfacePort).reset();
+    return true;
+}
 
-    if (renderPointer.Result() == nullptr)
+bool Pipeline::DetectChanges(StepContext& context)
+{
+    if (mChanges.TakeChange())
     {
-        return;
+        ++context.Write(mChangePort);
     }
+    return true;
+}
+
+bool Pipeline::DrawPointer(StepContext& context)
+{
+    winrt::com_ptr<ID3D11Texture2D> desktopTexture;
+    if (mTexturePool == nullptr)
+    {
+        // nothing was captured yet
+    }
+    else if (mPointerTrack)
+    {
+        desktopTexture = CopySharedSurface();
+    }
+    else
+    {
+        RenderPointerTextureStep renderPointer{
+            mDuplicator->DesktopPointerPtr(),
+            mSharedSurface,
+            mDuplicator->Device(),
+            mShaderCache,
+            mVertexRing,
+            mPointerTextures,
+            mPointerMasks,
+            mPointerViews,
+            mReadbackDevice,
+            mPointerReadbacks,
+            mDamageHistory,
+            mTexturePool,
+            mVirtualDesktopBounds,
+            mDesktopMonitorBounds
+        };
+        renderPointer.Perform();
+        desktopTexture = renderPointer.Result();
+    }
+
+    if (desktopTexture == nullptr)
+    {
+        // the surface was busy or the encoder behind, try again with the next frame
+        mChanges.MarkChanged();
+        return false;
+    }
+
+    context.Write(mDesktopTexturePort, desktopTexture);
+    return true;
+}
 
-    winrt::com_ptr<ID3D11Texture2D> desktopTexture = renderPointer.Result();
-    
+bool Pipeline::MakeSample(StepContext& context)
+{
     TextureToMediaSampleStep convertTexture{
-        desktopTexture,
+        context.Read(mDesktopTexturePort),
         mTexturePool
     };
     convertTexture.Perform();
 
-    mSample = convertTexture.Result();
+    winrt::com_ptr<IMFSample> sample = convertTexture.Result();
+    if (sample == nullptr)
+    {
+        mChanges.MarkChanged();
+        return false;
+    }
+
+    context.Write(mSamplePort, sample);
+    return true;
 }
 
 winrt::com_ptr<IMFSample> Pipeline::Sample() const
 {
-    return mSample;
+    return mGraph.Value(mSamplePort);
+}
+
+ChangeDetectorStats Pipeline::Changes() const
+{
+    return mChanges.Stats();
+}
+
+const DamageAccumulator& Pipeline::Damage() const
+{
+    return mPlanner->Accumulator();
+}
+
+uint64_t Pipeline::PointerCacheHits() const
+{
+    return mPointerTextures->Hits() + mPointerMasks->Hits();
+}
+
+uint64_t Pipeline::PointerCacheMisses() const
+{
+    return mPointerTextures->Misses() + mPointerMasks->Misses();
+}
+
+const ReadbackRing& Pipeline::PointerReadbacks() const
+{
+    return *mPointerReadbacks;
+}
+
+const DamageHistory& Pipeline::History() const
+{
+    return *mDamageHistory;
+}
+
+uint64_t Pipeline::ViewsCreated() const
+{
+    return mDesktopViews->Created() + mPointerViews->Created();
+}
+
+BoundedPoolStats Pipeline::TexturePoolStats() const
+{
+    return mTexturePool != nullptr ? mTexturePool->Stats() : BoundedPoolStats{};
+}
+
+void Pipeline::AcquireTimeout(std::chrono::milliseconds timeout)
+{
+    mFrameSource->AcquireTimeout(timeout);
+}
+
+void Pipeline::Trace(std::shared_ptr<CaptureTraceWriter> writer)
+{
+    mTraceWriter = writer;
+}
+
+void Pipeline::PointerTrack(std::shared_ptr<PointerTrackWriter> writer)
+{
+    mPointerTrack = writer;
+
+    // a recorded pointer moves without changing the frames
+    mChanges.PointerDrawn(writer == nullptr);
+}
+
+StepGraph& Pipeline::Graph()
+{
+    return mGraph;
+}
+
+std::vector<StepTiming> Pipeline::StepTimings() const
+{
+    return mGraph.Timings();
 }
 
 void Pipeline::AllocateTexturePool()
@@ -153,7 +480,7 @@ void Pipeline::AllocateTexturePool()
     D3D11_TEXTURE2D_DESC desc = mSharedSurface->Desc();
     // Use the same device that was used to open the shared surface
     // instead of the device used by Desktop Duplication API's desktop image.
-    mTexturePool.attach(new TexturePool(mDuplicator->Device(), desc));
+    mTexturePool.attach(new TexturePool(mDuplicator->Device(), desc, mTexturePoolOptions));
     winrt::check_pointer(mTexturePool.get());
 }
 
@@ -164,3 +491,49 @@ void Pipeline::AllocateStagingTexture(winrt::com_ptr<ID3D11Device> device, const
         nullptr,
         mStagingTexture.put()));
 }
+
+winrt::com_ptr<ID3D11Texture2D> Pipeline::CopySharedSurface()
+{
+    if (mTexturePool == nullptr)
+    {
+        return nullptr;
+    }
+
+    auto lock = mSharedSurface->Lock();
+    if (!lock->Locked())
+    {
+        return nullptr;
+    }
+
+    // the encoder still reads the sample after the next frame is drawn to the shared surface
+    std::shared_ptr<TexturePoolEntry> desktopCopy = mTexturePool->Acquire();
+    if (desktopCopy == nullptr)
+    {
+        return nullptr;
+    }
+
+    CopyDamageStep copyDamage{ lock->TexturePtr(), desktopCopy->Texture(), mDamageHistory };
+    copyDamage.Perform();
+    return desktopCopy->Texture();
+}
+
+void Pipeline::RecordDamage(const Frame& frame)
+{
+    D3D11_TEXTURE2D_DESC imageDesc;
+    frame.DesktopImage()->GetDesc(&imageDesc);
+    const LONG imageWidth = static_cast<LONG>(imageDesc.Width);
+    const LONG imageHeight = static_cast<LONG>(imageDesc.Height);
+
+    // the dirty rects that were drawn and the destinations of the moves, on the shared surface
+    const size_t dirtyCount = mPlanner->DirtyRectsCount();
+    const size_t moveCount = mPlanner->MoveRectsCount();
+    mDamageRects.resize(dirtyCount + moveCount);
+    mMoveSources.resize(moveCount);
+    RotateRects(frame.Rotation(), mPlanner->DirtyRects(), dirtyCount, imageWidth, imageHeight, mDamageRects.data());
+    RotateMoveRects(frame.Rotation(), mPlanner->MoveRects(), moveCount, imageWidth, imageHeight, mMoveSources.data(), mDamageRects.data() + dirtyCount);
+
+    const RECT monitorBounds = frame.DesktopMonitorBounds();
+    mFrameDamage.Reset(mDamageRects.data(), mDamageRects.size());
+    mFrameDamage.Translate(monitorBounds.left - mVirtualDesktopBounds.left, monitorBounds.top - mVirtualDesktopBounds.top);
+    mDamageHistory->Add(mFrameDamage);
+}
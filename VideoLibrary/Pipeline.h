@@ -23,9 +23,25 @@
 #include "DesktopMonitor.h"
 #include "DesktopPointer.h"
 #include "ScreenDuplicator.h"
-#include "Vertex.h"
+#include "PackedRect.h"
+#include "D3D11DynamicBufferDevice.h"
+#include "DynamicBufferRing.h"
+#include "D3D11ReadbackDevice.h"
+#include "ReadbackRing.h"
+#include "DamageHistory.h"
+#include "D3D11ViewDevice.h"
+#include "ViewCache.h"
 #include "ShaderCache.h"
 #include "SharedSurface.h"
+#include "FramePlanner.h"
+#include "MoveRectPlanner.h"
+#include "DuplicationFrameSource.h"
+#include "CaptureTraceWriter.h"
+#include "PointerTrackWriter.h"
+#include "RenderPointerTextureStep.h"
+#include "ChangeDetector.h"
+#include "StepGraph.h"
+#include "DxMultithread.h"
 
 class Pipeline : public RecordingStep
 {
@@ -33,29 +49,123 @@ public:
     Pipeline(
         std::shared_ptr<ScreenDuplicator> duplicator,
         std::shared_ptr<SharedSurface> sharedSurface,
-        RECT virtualDesktopBounds
+        RECT virtualDesktopBounds,
+        BoundedPoolOptions texturePoolOptions = {}
     );
 
     virtual ~Pipeline();
 
-    // Inherited via RecordingStep
+    // Inherited via RecordingStep. Captures a frame, and composes a sample only
+    // when the desktop or the pointer changed since the last one.
     virtual void Perform() override;
 
+    // Composes a sample of the unchanged desktop, for writing a frame while it is static
+    void KeepAlive();
+
+    // Null when nothing changed or the sample could not be made
     winrt::com_ptr<IMFSample> Sample() const;
 
+    // Samples composed for changes and captures that found the desktop static
+    ChangeDetectorStats Changes() const;
+
+    // Damage carried over from frames that were captured while the shared surface was busy
+    const DamageAccumulator& Damage() const;
+
+    // Pointer shapes found in the cache, summed over color textures and decoded masks
+    uint64_t PointerCacheHits() const;
+    uint64_t PointerCacheMisses() const;
+
+    // Readbacks of the desktop under masked pointers, with their stall counts
+    const ReadbackRing& PointerReadbacks() const;
+
+    // Damage of recent frames, with how often pooled textures were only partly copied
+    const DamageHistory& History() const;
+
+    // Views created for desktop images and pointer textures, flat once they are all cached
+    uint64_t ViewsCreated() const;
+
+    // Output textures handed to the encoder, empty until the first frame is captured
+    BoundedPoolStats TexturePoolStats() const;
+
+    // How long capturing waits for the desktop to change, lets the recording loop
+    // wait for new frames instead of sleeping until the next tick
+    void AcquireTimeout(std::chrono::milliseconds timeout);
+
+    // Records every captured frame to the trace, pass null to stop recording
+    void Trace(std::shared_ptr<CaptureTraceWriter> writer);
+
+    // Records the pointer to a track instead of drawing it into the frames, pass null to draw it again
+    void PointerTrack(std::shared_ptr<PointerTrackWriter> writer);
+
+    // The steps of a frame, in order: capture, lock device, trace, pointer track,
+    // lock surface, plan, move rects, dirty rects, finish frame, detect changes,
+    // draw pointer and make sample. Optional steps are inserted between them and use
+    // the ports frame, surface, change, desktop texture and sample. Steps run on the
+    // thread calling Perform, the ones after lock device with the device's
+    // multithread lock held.
+    StepGraph& Graph();
+
+    // How long every step of the frame took, and how often it was skipped
+    std::vector<StepTiming> StepTimings() const;
+
 private:
 
+    void BuildGraph();
+    bool CaptureFrame(StepContext& context);
+    bool LockDevice(StepContext& context);
+    bool RecordTrace(StepContext& context);
+    bool RecordPointerTrack(StepContext& context);
+    bool LockSurface(StepContext& context);
+    bool PlanFrame(StepContext& context);
+    bool RenderMoveRects(StepContext& context);
+    bool RenderDirtyRects(StepContext& context);
+    bool FinishFrame(StepContext& context);
+    bool DetectChanges(StepContext& context);
+    bool DrawPointer(StepContext& context);
+    bool MakeSample(StepContext& context);
+
     void AllocateTexturePool();
     void AllocateStagingTexture(winrt::com_ptr<ID3D11Device> device, const D3D11_TEXTURE2D_DESC& desc);
+    winrt::com_ptr<ID3D11Texture2D> CopySharedSurface();
+    void RecordDamage(const Frame& frame);
 
     std::shared_ptr<ScreenDuplicator> mDuplicator;
     std::shared_ptr<SharedSurface> mSharedSurface;
     std::shared_ptr<ShaderCache> mShaderCache;
-    std::shared_ptr<std::vector<Vertex>> mVertexBuffer;
+    std::shared_ptr<std::vector<PackedRect>> mDirtyRectInstances;
+    std::shared_ptr<D3D11DynamicBufferDevice> mBufferDevice;
+    std::shared_ptr<DynamicBufferRing> mVertexRing;
+    std::shared_ptr<PointerTextureCache> mPointerTextures;
+    std::shared_ptr<PointerMaskCache> mPointerMasks;
+    std::shared_ptr<D3D11ViewDevice> mViewDevice;
+    std::shared_ptr<ViewCache> mDesktopViews;
+    std::shared_ptr<ViewCache> mPointerViews;
+    std::shared_ptr<D3D11ReadbackDevice> mReadbackDevice;
+    std::shared_ptr<ReadbackRing> mPointerReadbacks;
+    std::shared_ptr<DamageHistory> mDamageHistory;
+    std::vector<RECT> mDamageRects;
+    std::vector<RECT> mMoveSources;
+    Region mFrameDamage;
+    std::shared_ptr<DynamicBuffer> mDirtyRectConstants;
+    std::shared_ptr<DuplicationFrameSource> mFrameSource;
+    std::shared_ptr<FramePlanner> mPlanner;
+    std::shared_ptr<MoveRectPlanner> mMovePlanner;
+    ChangeDetector mChanges;
+    std::shared_ptr<CaptureTraceWriter> mTraceWriter;
+    std::shared_ptr<PointerTrackWriter> mPointerTrack;
+    winrt::com_ptr<ID3D11Texture2D> mTraceReadbackTexture;
+    std::shared_ptr<std::vector<byte>> mTracePixels;
     winrt::com_ptr<TexturePool> mTexturePool;
     winrt::com_ptr<ID3D11Texture2D> mStagingTexture;
-    winrt::com_ptr<IMFSample> mSample;
     winrt::com_ptr<ID3D11RenderTargetView> mRenderTargetView;
     RECT mVirtualDesktopBounds;
     RECT mDesktopMonitorBounds;
+    BoundedPoolOptions mTexturePoolOptions;
+    StepGraph mGraph;
+    StepPort<std::shared_ptr<DxMultithread>> mDevicePort;
+    StepPort<std::shared_ptr<Frame>> mFramePort;
+    StepPort<std::shared_ptr<KeyedMutexLock>> mSurfacePort;
+    StepPort<uint64_t> mChangePort;
+    StepPort<winrt::com_ptr<ID3D11Texture2D>> mDesktopTexturePort;
+    StepPort<winrt::com_ptr<IMFSample>> mSamplePort;
 };
@@ -0,0 +1,585 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "PointerKernels.h"
+#include "Simd.h"
+
+#include <stdexcept>
+
+namespace
+{
+    constexpr UINT AlphaMask = 0xFF000000;
+    constexpr UINT ColorMask = 0x00FFFFFF;
+
+#if SIMD_SSE2 || SIMD_NEON
+    // For every byte of a 1 bpp mask, one all ones or all zeros lane per bit, most significant bit first
+    struct MaskLanes
+    {
+        alignas(32) UINT Lanes[256][8];
+
+        MaskLanes()
+        {
+            for (UINT bits = 0; bits < 256; ++bits)
+            {
+                for (UINT lane = 0; lane < 8; ++lane)
+                {
+                    Lanes[bits][lane] = (bits & (0x80 >> lane)) ? 0xFFFFFFFF : 0;
+                }
+            }
+        }
+    };
+
+    const MaskLanes& Lanes()
+    {
+        static const MaskLanes lanes;
+        return lanes;
+    }
+#endif
+
+    // The eight mask bits starting at bit, the first one in the most significant bit
+    inline UINT MaskBits(const byte* row, UINT bit)
+    {
+        const UINT offset = bit % 8;
+        const byte* bytes = row + bit / 8;
+
+        // the second byte is only read when the bits straddle it, it may be past the end of the mask
+        const UINT bits = offset == 0 ? bytes[0] : ((static_cast<UINT>(bytes[0]) << 8) | bytes[1]) >> (8 - offset);
+        return bits & 0xFF;
+    }
+
+    inline UINT MonochromePixel(UINT color, const byte* andRow, const byte* xorRow, UINT bit)
+    {
+        const byte maskBit = static_cast<byte>(0x80 >> (bit % 8));
+        const UINT andMask = (andRow[bit / 8] & maskBit) ? 0xFFFFFFFF : AlphaMask;
+        const UINT xorMask = (xorRow[bit / 8] & maskBit) ? ColorMask : 0;
+        return (color & andMask) ^ xorMask;
+    }
+
+    inline UINT MaskedColorPixel(UINT color, UINT mask)
+    {
+        return (mask & AlphaMask) ? AlphaMask | (color ^ mask) : AlphaMask | mask;
+    }
+
+    inline const UINT* DesktopRow(const UINT* desktop, UINT desktopPitch, UINT j)
+    {
+        return desktop + j * desktopPitch / sizeof(UINT);
+    }
+
+    void MonochromeScalar(UINT* dest, const UINT* colorData, UINT colorPitch, const byte* maskData, UINT maskPitch, UINT width, UINT height, UINT maskX, UINT maskY, UINT maskHeight)
+    {
+        /*
+        The pointer type is a monochrome mouse pointer, which is a monochrome bitmap.
+        The bitmap's size is specified by width and height in a
+        1 bits per pixel (bpp) device independent bitmap (DIB) format AND maskBit that is
+        followed by another 1 bpp DIB format XOR maskBit of the same size.
+
+        if is mono must divide height by 2 to get to the xor maskBit
+        */
+        for (UINT j = 0; j < height; ++j) {
+
+            BYTE maskBit = 0x80 >> (maskX % 8);
+            for (UINT i = 0; i < width; ++i) {
+                // maskData contains two 1bpp images
+                auto dstIndex = j * width + i;
+                auto colorIndex = j * colorPitch / sizeof(UINT) + i;
+
+                auto maskAndIndex = ((maskY + j) * maskPitch) + ((maskX + i) / 8);
+                auto maskXorIndex = ((maskY + j + maskHeight) * maskPitch) + ((maskX + i) / 8);
+
+                auto andMaskBit = maskData[maskAndIndex] & maskBit;
+                auto xorMaskBit = maskData[maskXorIndex] & maskBit;
+
+                auto andMask = andMaskBit ? 0xFFFFFFFF : 0xFF000000;
+                auto xorMask = xorMaskBit ? 0x00FFFFFF : 0x00000000;
+
+                auto color = colorData[colorIndex];
+
+                dest[dstIndex] = (color & andMask) ^ xorMask;
+
+                if (maskBit == 1) {
+                    maskBit = 0x80;
+                }
+                else {
+                    maskBit = maskBit >> 1;
+                }
+            }
+        }
+    }
+
+    void MaskedColorScalar(UINT* dest, const UINT* colorData, UINT colorPitch, const UINT* maskData, UINT maskPitch, UINT width, UINT height, UINT maskX, UINT maskY)
+    {
+        /*
+        The pointer type is a masked color mouse pointer.
+        A masked color mouse pointer is a 32 bpp ARGB format bitmap with the maskBit value in the alpha bits.
+        The only allowed maskBit values are 0 and 0xFF. When the maskBit value is 0,
+        the RGB value should replace the screen pixel. When the maskBit value is 0xFF,
+        an XOR operation is performed on the RGB value and the screen pixel;
+        the result replaces the screen pixel.
+        */
+        for (UINT j = 0; j < height; ++j) {
+            for (UINT i = 0; i < width; ++i) {
+
+                auto destIndex = (j*width) + i;
+                auto colorIndex = (j*colorPitch / sizeof(UINT)) + i;
+                auto maskIndex = ((j + maskY)*maskPitch / sizeof(UINT)) + (i + maskX);
+
+                dest[destIndex] = MaskedColorPixel(colorData[colorIndex], maskData[maskIndex]);
+            }
+        }
+    }
+
+#if SIMD_SSE2
+    void MonochromeSse2(UINT* dest, const UINT* desktop, UINT desktopPitch, const byte* mask, UINT maskPitch, UINT width, UINT height, UINT maskX, UINT maskY, UINT maskHeight)
+    {
+        const MaskLanes& lanes = Lanes();
+        const __m128i alpha = _mm_set1_epi32(static_cast<int>(AlphaMask));
+        const __m128i color = _mm_set1_epi32(static_cast<int>(ColorMask));
+        for (UINT j = 0; j < height; ++j)
+        {
+            const UINT* desktopRow = DesktopRow(desktop, desktopPitch, j);
+            const byte* andRow = mask + (maskY + j) * maskPitch;
+            const byte* xorRow = mask + (maskY + j + maskHeight) * maskPitch;
+            UINT* destRow = dest + j * width;
+
+            UINT i = 0;
+            for (; i + 8 <= width; i += 8)
+            {
+                const UINT* andLanes = lanes.Lanes[MaskBits(andRow, maskX + i)];
+                const UINT* xorLanes = lanes.Lanes[MaskBits(xorRow, maskX + i)];
+                for (UINT half = 0; half < 8; half += 4)
+                {
+                    const __m128i andMask = _mm_or_si128(_mm_load_si128(reinterpret_cast<const __m128i*>(andLanes + half)), alpha);
+                    const __m128i xorMask = _mm_and_si128(_mm_load_si128(reinterpret_cast<const __m128i*>(xorLanes + half)), color);
+                    const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(desktopRow + i + half));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(destRow + i + half), _mm_xor_si128(_mm_and_si128(pixels, andMask), xorMask));
+                }
+            }
+
+            for (; i < width; ++i)
+            {
+                destRow[i] = MonochromePixel(desktopRow[i], andRow, xorRow, maskX + i);
+            }
+        }
+    }
+
+    void MaskedColorSse2(UINT* dest, const UINT* desktop, UINT desktopPitch, const UINT* mask, UINT maskPitch, UINT width, UINT height, UINT maskX, UINT maskY)
+    {
+        const __m128i alpha = _mm_set1_epi32(static_cast<int>(AlphaMask));
+        const __m128i zero = _mm_setzero_si128();
+        for (UINT j = 0; j < height; ++j)
+        {
+            const UINT* desktopRow = DesktopRow(desktop, desktopPitch, j);
+            const UINT* maskRow = mask + (j + maskY) * maskPitch / sizeof(UINT) + maskX;
+            UINT* destRow = dest + j * width;
+
+            UINT i = 0;
+            for (; i + 4 <= width; i += 4)
+            {
+                const __m128i shape = _mm_loadu_si128(reinterpret_cast<const __m128i*>(maskRow + i));
+                const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(desktopRow + i));
+
+                // replace selects the shape color, otherwise it is XORed with the desktop
+                const __m128i replace = _mm_cmpeq_epi32(_mm_and_si128(shape, alpha), zero);
+                const __m128i blended = _mm_xor_si128(shape, _mm_andnot_si128(replace, pixels));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(destRow + i), _mm_or_si128(blended, alpha));
+            }
+
+            for (; i < width; ++i)
+            {
+                destRow[i] = MaskedColorPixel(desktopRow[i], maskRow[i]);
+            }
+        }
+    }
+#endif
+
+#if SIMD_AVX2
+    SIMD_TARGET_AVX2
+    void MonochromeAvx2(UINT* dest, const UINT* desktop, UINT desktopPitch, const byte* mask, UINT maskPitch, UINT width, UINT height, UINT maskX, UINT maskY, UINT maskHeight)
+    {
+        const MaskLanes& lanes = Lanes();
+        const __m256i alpha = _mm256_set1_epi32(static_cast<int>(AlphaMask));
+        const __m256i color = _mm256_set1_epi32(static_cast<int>(ColorMask));
+        for (UINT j = 0; j < height; ++j)
+        {
+            const UINT* desktopRow = DesktopRow(desktop, desktopPitch, j);
+            const byte* andRow = mask + (maskY + j) * maskPitch;
+            const byte* xorRow = mask + (maskY + j + maskHeight) * maskPitch;
+            UINT* destRow = dest + j * width;
+
+            UINT i = 0;
+            for (; i + 8 <= width; i += 8)
+            {
+                const __m256i andMask = _mm256_or_si256(
+                    _mm256_load_si256(reinterpret_cast<const __m256i*>(lanes.Lanes[MaskBits(andRow, maskX + i)])), alpha);
+                const __m256i xorMask = _mm256_and_si256(
+                    _mm256_load_si256(reinterpret_cast<const __m256i*>(lanes.Lanes[MaskBits(xorRow, maskX + i)])), color);
+                const __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(desktopRow + i));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(destRow + i), _mm256_xor_si256(_mm256_and_si256(pixels, andMask), xorMask));
+            }
+
+            for (; i < width; ++i)
+            {
+                destRow[i] = MonochromePixel(desktopRow[i], andRow, xorRow, maskX + i);
+            }
+        }
+    }
+
+    SIMD_TARGET_AVX2
+    void MaskedColorAvx2(UINT* dest, const UINT* desktop, UINT desktopPitch, const UINT* mask, UINT maskPitch, UINT width, UINT height, UINT maskX, UINT maskY)
+    {
+        const __m256i alpha = _mm256_set1_epi32(static_cast<int>(AlphaMask));
+        const __m256i zero = _mm256_setzero_si256();
+        for (UINT j = 0; j < height; ++j)
+        {
+            const UINT* desktopRow = DesktopRow(desktop, desktopPitch, j);
+            const UINT* maskRow = mask + (j + maskY) * maskPitch / sizeof(UINT) + maskX;
+            UINT* destRow = dest + j * width;
+
+            UINT i = 0;
+            for (; i + 8 <= width; i += 8)
+            {
+                const __m256i shape = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(maskRow + i));
+                const __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(desktopRow + i));
+                const __m256i replace = _mm256_cmpeq_epi32(_mm256_and_si256(shape, alpha), zero);
+                const __m256i blended = _mm256_xor_si256(shape, _mm256_andnot_si256(replace, pixels));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(destRow + i), _mm256_or_si256(blended, alpha));
+            }
+
+            for (; i < width; ++i)
+            {
+                destRow[i] = MaskedColorPixel(desktopRow[i], maskRow[i]);
+            }
+        }
+    }
+#endif
+
+#if SIMD_NEON
+    void MonochromeNeon(UINT* dest, const UINT* desktop, UINT desktopPitch, const byte* mask, UINT maskPitch, UINT width, UINT height, UINT maskX, UINT maskY, UINT maskHeight)
+    {
+        const MaskLanes& lanes = Lanes();
+        const uint32x4_t alpha = vdupq_n_u32(AlphaMask);
+        const uint32x4_t color = vdupq_n_u32(ColorMask);
+        for (UINT j = 0; j < height; ++j)
+        {
+            const UINT* desktopRow = DesktopRow(desktop, desktopPitch, j);
+            const byte* andRow = mask + (maskY + j) * maskPitch;
+            const byte* xorRow = mask + (maskY + j + maskHeight) * maskPitch;
+            UINT* destRow = dest + j * width;
+
+            UINT i = 0;
+            for (; i + 8 <= width; i += 8)
+            {
+                const UINT* andLanes = lanes.Lanes[MaskBits(andRow, maskX + i)];
+                const UINT* xorLanes = lanes.Lanes[MaskBits(xorRow, maskX + i)];
+                for (UINT half = 0; half < 8; half += 4)
+                {
+                    const uint32x4_t andMask = vorrq_u32(vld1q_u32(andLanes + half), alpha);
+                    const uint32x4_t xorMask = vandq_u32(vld1q_u32(xorLanes + half), color);
+                    const uint32x4_t pixels = vld1q_u32(desktopRow + i + half);
+                    vst1q_u32(destRow + i + half, veorq_u32(vandq_u32(pixels, andMask), xorMask));
+                }
+            }
+
+            for (; i < width; ++i)
+            {
+                destRow[i] = MonochromePixel(desktopRow[i], andRow, xorRow, maskX + i);
+            }
+        }
+    }
+
+    void MaskedColorNeon(UINT* dest, const UINT* desktop, UINT desktopPitch, const UINT* mask, UINT maskPitch, UINT width, UINT height, UINT maskX, UINT maskY)
+    {
+        const uint32x4_t alpha = vdupq_n_u32(AlphaMask);
+        for (UINT j = 0; j < height; ++j)
+        {
+            const UINT* desktopRow = DesktopRow(desktop, desktopPitch, j);
+            const UINT* maskRow = mask + (j + maskY) * maskPitch / sizeof(UINT) + maskX;
+            UINT* destRow = dest + j * width;
+
+            UINT i = 0;
+            for (; i + 4 <= width; i += 4)
+            {
+                const uint32x4_t shape = vld1q_u32(maskRow + i);
+                const uint32x4_t pixels = vld1q_u32(desktopRow + i);
+                const uint32x4_t replace = vceqq_u32(vandq_u32(shape, alpha), vdupq_n_u32(0));
+                const uint32x4_t blended = veorq_u32(shape, vbicq_u32(pixels, replace));
+                vst1q_u32(destRow + i, vorrq_u32(blended, alpha));
+            }
+
+            for (; i < width; ++i)
+            {
+                destRow[i] = MaskedColorPixel(desktopRow[i], maskRow[i]);
+            }
+        }
+    }
+#endif
+
+    void DecodedScalar(UINT* dest, const UINT* desktop, UINT desktopPitch, const UINT* andPlane, const UINT* xorPlane, UINT planeWidth, UINT width, UINT height, UINT maskX, UINT maskY)
+    {
+        for (UINT j = 0; j < height; ++j)
+        {
+            const UINT* desktopRow = DesktopRow(desktop, desktopPitch, j);
+            const UINT* andRow = andPlane + (maskY + j) * planeWidth + maskX;
+            const UINT* xorRow = xorPlane + (maskY + j) * planeWidth + maskX;
+            UINT* destRow = dest + j * width;
+            for (UINT i = 0; i < width; ++i)
+            {
+                destRow[i] = (desktopRow[i] & andRow[i]) ^ xorRow[i];
+            }
+        }
+    }
+
+#if SIMD_SSE2
+    void DecodedSse2(UINT* dest, const UINT* desktop, UINT desktopPitch, const UINT* andPlane, const UINT* xorPlane, UINT planeWidth, UINT width, UINT height, UINT maskX, UINT maskY)
+    {
+        for (UINT j = 0; j < height; ++j)
+        {
+            const UINT* desktopRow = DesktopRow(desktop, desktopPitch, j);
+            const UINT* andRow = andPlane + (maskY + j) * planeWidth + maskX;
+            const UINT* xorRow = xorPlane + (maskY + j) * planeWidth + maskX;
+            UINT* destRow = dest + j * width;
+
+            UINT i = 0;
+            for (; i + 4 <= width; i += 4)
+            {
+                const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(desktopRow + i));
+                const __m128i andMask = _mm_loadu_si128(reinterpret_cast<const __m128i*>(andRow + i));
+                const __m128i xorMask = _mm_loadu_si128(reinterpret_cast<const __m128i*>(xorRow + i));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(destRow + i), _mm_xor_si128(_mm_and_si128(pixels, andMask), xorMask));
+            }
+
+            for (; i < width; ++i)
+            {
+                destRow[i] = (desktopRow[i] & andRow[i]) ^ xorRow[i];
+            }
+        }
+    }
+#endif
+
+#if SIMD_AVX2
+    SIMD_TARGET_AVX2
+    void DecodedAvx2(UINT* dest, const UINT* desktop, UINT desktopPitch, const UINT* andPlane, const UINT* xorPlane, UINT planeWidth, UINT width, UINT height, UINT maskX, UINT maskY)
+    {
+        for (UINT j = 0; j < height; ++j)
+        {
+            const UINT* desktopRow = DesktopRow(desktop, desktopPitch, j);
+            const UINT* andRow = andPlane + (maskY + j) * planeWidth + maskX;
+            const UINT* xorRow = xorPlane + (maskY + j) * planeWidth + maskX;
+            UINT* destRow = dest + j * width;
+
+            UINT i = 0;
+            for (; i + 8 <= width; i += 8)
+            {
+                const __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(desktopRow + i));
+                const __m256i andMask = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(andRow + i));
+                const __m256i xorMask = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(xorRow + i));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(destRow + i), _mm256_xor_si256(_mm256_and_si256(pixels, andMask), xorMask));
+            }
+
+            for (; i < width; ++i)
+            {
+                destRow[i] = (desktopRow[i] & andRow[i]) ^ xorRow[i];
+            }
+        }
+    }
+#endif
+
+#if SIMD_NEON
+    void DecodedNeon(UINT* dest, const UINT* desktop, UINT desktopPitch, const UINT* andPlane, const UINT* xorPlane, UINT planeWidth, UINT width, UINT height, UINT maskX, UINT maskY)
+    {
+        for (UINT j = 0; j < height; ++j)
+        {
+            const UINT* desktopRow = DesktopRow(desktop, desktopPitch, j);
+            const UINT* andRow = andPlane + (maskY + j) * planeWidth + maskX;
+            const UINT* xorRow = xorPlane + (maskY + j) * planeWidth + maskX;
+            UINT* destRow = dest + j * width;
+
+            UINT i = 0;
+            for (; i + 4 <= width; i += 4)
+            {
+                vst1q_u32(destRow + i, veorq_u32(vandq_u32(vld1q_u32(desktopRow + i), vld1q_u32(andRow + i)), vld1q_u32(xorRow + i)));
+            }
+
+            for (; i < width; ++i)
+            {
+                destRow[i] = (desktopRow[i] & andRow[i]) ^ xorRow[i];
+            }
+        }
+    }
+#endif
+}
+
+PointerKernel BestPointerKernel()
+{
+    static const PointerKernel best = PointerKernelSupported(PointerKernel::Avx2) ? PointerKernel::Avx2 :
+        PointerKernelSupported(PointerKernel::Sse2) ? PointerKernel::Sse2 :
+        PointerKernelSupported(PointerKernel::Neon) ? PointerKernel::Neon :
+        PointerKernel::Scalar;
+    return best;
+}
+
+bool PointerKernelSupported(PointerKernel kernel)
+{
+    switch (kernel)
+    {
+    case PointerKernel::Scalar:
+        return true;
+#if SIMD_SSE2
+    case PointerKernel::Sse2:
+        return true;
+#endif
+#if SIMD_AVX2
+    case PointerKernel::Avx2:
+        return SimdHasAvx2();
+#endif
+#if SIMD_NEON
+    case PointerKernel::Neon:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+void ComposeMonochromePointer(UINT* destination, const UINT* desktop, UINT desktopPitch, const byte* mask, UINT maskPitch, UINT width, UINT height, UINT maskX, UINT maskY, UINT maskHeight, PointerKernel kernel)
+{
+    if (!PointerKernelSupported(kernel))
+    {
+        throw std::invalid_argument("pointer kernel not supported on this CPU");
+    }
+
+    switch (kernel)
+    {
+#if SIMD_SSE2
+    case PointerKernel::Sse2:
+        MonochromeSse2(destination, desktop, desktopPitch, mask, maskPitch, width, height, maskX, maskY, maskHeight);
+        break;
+#endif
+#if SIMD_AVX2
+    case PointerKernel::Avx2:
+        MonochromeAvx2(destination, desktop, desktopPitch, mask, maskPitch, width, height, maskX, maskY, maskHeight);
+        break;
+#endif
+#if SIMD_NEON
+    case PointerKernel::Neon:
+        MonochromeNeon(destination, desktop, desktopPitch, mask, maskPitch, width, height, maskX, maskY, maskHeight);
+        break;
+#endif
+    default:
+        MonochromeScalar(destination, desktop, desktopPitch, mask, maskPitch, width, height, maskX, maskY, maskHeight);
+        break;
+    }
+}
+
+void ComposeMaskedColorPointer(UINT* destination, const UINT* desktop, UINT desktopPitch, const UINT* mask, UINT maskPitch, UINT width, UINT height, UINT maskX, UINT maskY, PointerKernel kernel)
+{
+    if (!PointerKernelSupported(kernel))
+    {
+        throw std::invalid_argument("pointer kernel not supported on this CPU");
+    }
+
+    switch (kernel)
+    {
+#if SIMD_SSE2
+    case PointerKernel::Sse2:
+        MaskedColorSse2(destination, desktop, desktopPitch, mask, maskPitch, width, height, maskX, maskY);
+        break;
+#endif
+#if SIMD_AVX2
+    case PointerKernel::Avx2:
+        MaskedColorAvx2(destination, desktop, desktopPitch, mask, maskPitch, width, height, maskX, maskY);
+        break;
+#endif
+#if SIMD_NEON
+    case PointerKernel::Neon:
+        MaskedColorNeon(destination, desktop, desktopPitch, mask, maskPitch, width, height, maskX, maskY);
+        break;
+#endif
+    default:
+        MaskedColorScalar(destination, desktop, desktopPitch, mask, maskPitch, width, height, maskX, maskY);
+        break;
+    }
+}
+
+void DecodePointerShape(const DXGI_OUTDUPL_POINTER_SHAPE_INFO& info, const byte* shape, DecodedPointerShape& decoded, PointerKernel kernel)
+{
+    decoded.Width = info.Width;
+    decoded.Height = info.Type == DXGI_OUTDUPL_POINTER_SHAPE_TYPE_MONOCHROME ? info.Height / 2 : info.Height;
+    decoded.And.resize(static_cast<size_t>(decoded.Width) * decoded.Height);
+    decoded.Xor.resize(decoded.And.size());
+
+    // a desktop pitch of zero repeats the same row for every row of the shape
+    const std::vector<UINT> zeros(decoded.Width, 0);
+    const std::vector<UINT> ones(decoded.Width, 0xFFFFFFFF);
+    switch (info.Type)
+    {
+    case DXGI_OUTDUPL_POINTER_SHAPE_TYPE_MONOCHROME:
+        ComposeMonochromePointer(decoded.Xor.data(), zeros.data(), 0, shape, info.Pitch, decoded.Width, decoded.Height, 0, 0, decoded.Height, kernel);
+        ComposeMonochromePointer(decoded.And.data(), ones.data(), 0, shape, info.Pitch, decoded.Width, decoded.Height, 0, 0, decoded.Height, kernel);
+        break;
+    case DXGI_OUTDUPL_POINTER_SHAPE_TYPE_MASKED_COLOR:
+        ComposeMaskedColorPointer(decoded.Xor.data(), zeros.data(), 0, reinterpret_cast<const UINT*>(shape), info.Pitch, decoded.Width, decoded.Height, 0, 0, kernel);
+        ComposeMaskedColorPointer(decoded.And.data(), ones.data(), 0, reinterpret_cast<const UINT*>(shape), info.Pitch, decoded.Width, decoded.Height, 0, 0, kernel);
+        break;
+    default:
+        throw std::invalid_argument("only monochrome and masked color pointer shapes are decoded");
+    }
+
+    for (size_t i = 0; i < decoded.And.size(); ++i)
+    {
+        decoded.And[i] ^= decoded.Xor[i];
+    }
+}
+
+void ComposeDecodedPointer(UINT* destination, const UINT* desktop, UINT desktopPitch, const DecodedPointerShape& shape, UINT width, UINT height, UINT maskX, UINT maskY, PointerKernel kernel)
+{
+    if (!PointerKernelSupported(kernel))
+    {
+        throw std::invalid_argument("pointer kernel not supported on this CPU");
+    }
+
+    if (maskX + width > shape.Width || maskY + height > shape.Height)
+    {
+        throw std::invalid_argument("pointer area outside of the decoded shape");
+    }
+
+    const UINT* andPlane = shape.And.data();
+    const UINT* xorPlane = shape.Xor.data();
+    switch (kernel)
+    {
+#if SIMD_SSE2
+    case PointerKernel::Sse2:
+        DecodedSse2(destination, desktop, desktopPitch, andPlane, xorPlane, shape.Width, width, height, maskX, maskY);
+        break;
+#endif
+#if SIMD_AVX2
+    case PointerKernel::Avx2:
+        DecodedAvx2(destination, desktop, desktopPitch, andPlane, xorPlane, shape.Width, width, height, maskX, maskY);
+        break;
+#endif
+#if SIMD_NEON
+    case PointerKernel::Neon:
+        DecodedNeon(destination, desktop, desktopPitch, andPlane, xorPlane, shape.Width, width, height, maskX, maskY);
+        break;
+#endif
+    default:
+        DecodedScalar(destination, desktop, desktopPitch, andPlane, xorPlane, shape.Width, width, height, maskX, maskY);
+        break;
+    }
+}
@@ -0,0 +1,107 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+//
+// PointerKernels.h
+// Blends monochrome and masked color pointer shapes with the desktop pixels under them.
+// The result is a 32 bpp BGRA image that is drawn over the desktop like a color pointer.
+//
+
+#pragma once
+#include "PlatformTypes.h"
+#include <vector>
+
+enum class PointerKernel
+{
+    Scalar,
+    Sse2,
+    Avx2,
+    Neon
+};
+
+// The fastest kernel the CPU running the process supports, checked once
+PointerKernel BestPointerKernel();
+
+bool PointerKernelSupported(PointerKernel kernel);
+
+/*
+    The shape is a 1 bpp AND mask followed by a 1 bpp XOR mask of maskHeight rows each.
+    The desktop color is kept where the AND bit is set and cleared where it is not,
+    then inverted where the XOR bit is set. The desktop alpha is always kept. maskX and maskY are the first column and
+    row of the shape that is visible when the pointer is clipped at the top left.
+
+    Pitches are in bytes. The vector kernels expand eight mask bits at a time through
+    a lookup table.
+*/
+void ComposeMonochromePointer(
+    UINT* destination,
+    const UINT* desktop,
+    UINT desktopPitch,
+    const byte* mask,
+    UINT maskPitch,
+    UINT width,
+    UINT height,
+    UINT maskX,
+    UINT maskY,
+    UINT maskHeight,
+    PointerKernel kernel = BestPointerKernel());
+
+/*
+    The shape is 32 bpp with the mask in the alpha channel. Where the alpha is clear
+    the shape's color replaces the desktop, otherwise it is XORed with the desktop.
+*/
+void ComposeMaskedColorPointer(
+    UINT* destination,
+    const UINT* desktop,
+    UINT desktopPitch,
+    const UINT* mask,
+    UINT maskPitch,
+    UINT width,
+    UINT height,
+    UINT maskX,
+    UINT maskY,
+    PointerKernel kernel = BestPointerKernel());
+
+/*
+    A monochrome or masked color shape as two planes with one value per pixel.
+    Both kernels above compute (desktop & And) ^ Xor for every pixel, so once a shape is
+    decoded it is composed the same way whatever its type.
+*/
+struct DecodedPointerShape
+{
+    UINT Width = 0;
+    UINT Height = 0;
+    std::vector<UINT> And;
+    std::vector<UINT> Xor;
+};
+
+// Runs the shape's kernel over an all zero and an all ones desktop, which yields Xor and And ^ Xor.
+// Throws for color shapes, they are drawn as they are.
+void DecodePointerShape(const DXGI_OUTDUPL_POINTER_SHAPE_INFO& info, const byte* shape, DecodedPointerShape& decoded, PointerKernel kernel = BestPointerKernel());
+
+// Bit-exact with composing the shape with its own kernel. maskX and maskY index the planes.
+void ComposeDecodedPointer(
+    UINT* destination,
+    const UINT* desktop,
+    UINT desktopPitch,
+    const DecodedPointerShape& shape,
+    UINT width,
+    UINT height,
+    UINT maskX,
+    UINT maskY,
+    PointerKernel kernel = BestPointerKernel());
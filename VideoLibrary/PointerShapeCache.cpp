@@ -0,0 +1,71 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "PointerShapeCache.h"
+
+namespace
+{
+    inline uint64_t RotateLeft(uint64_t value, int bits)
+    {
+        return (value << bits) | (value >> (64 - bits));
+    }
+
+    // The block mix of MurmurHash3, eight bytes at a time
+    inline uint64_t Mix(uint64_t hash, uint64_t word)
+    {
+        word *= 0x87C37B91114253D5ull;
+        word = RotateLeft(word, 31);
+        word *= 0x4CF5AD432745937Full;
+        hash ^= word;
+        return RotateLeft(hash, 27) * 5 + 0x52DCE729;
+    }
+}
+
+size_t PointerShapeSize(const DXGI_OUTDUPL_POINTER_SHAPE_INFO& info)
+{
+    // monochrome heights already count both masks
+    return static_cast<size_t>(info.Pitch) * info.Height;
+}
+
+uint64_t HashPointerShape(const DXGI_OUTDUPL_POINTER_SHAPE_INFO& info, const byte* shape)
+{
+    uint64_t hash = Mix(0x9E3779B97F4A7C15ull, info.Type | (static_cast<uint64_t>(info.Width) << 32));
+    hash = Mix(hash, info.Height | (static_cast<uint64_t>(info.Pitch) << 32));
+
+    const size_t size = PointerShapeSize(info);
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8)
+    {
+        uint64_t word;
+        std::memcpy(&word, shape + i, sizeof(word));
+        hash = Mix(hash, word);
+    }
+
+    if (i < size)
+    {
+        uint64_t word = 0;
+        std::memcpy(&word, shape + i, size - i);
+        hash = Mix(hash, word);
+    }
+
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDull;
+    hash ^= hash >> 33;
+    return hash;
+}
@@ -0,0 +1,121 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "PlatformTypes.h"
+#include "LruCache.h"
+#include <cstring>
+#include <vector>
+
+// Bytes of the shape buffer the info describes
+size_t PointerShapeSize(const DXGI_OUTDUPL_POINTER_SHAPE_INFO& info);
+
+// Hash of everything that changes how the shape looks. The hot spot is left out.
+uint64_t HashPointerShape(const DXGI_OUTDUPL_POINTER_SHAPE_INFO& info, const byte* shape);
+
+/*
+    Values derived from pointer shapes, such as textures or decoded masks, keyed by
+    the shape's content. Applications switch between a small set of cursors, so
+    rebuilding the value every time the shape changes is mostly wasted work.
+
+    Entries keep a copy of the shape, a hash collision is a miss and not a wrong cursor.
+*/
+template<typename Value>
+class PointerShapeCache
+{
+public:
+    // Arrow, I-beam, hand, wait, the resize cursors and a few application cursors
+    static constexpr size_t DefaultCapacity = 16;
+
+    explicit PointerShapeCache(size_t capacity = DefaultCapacity)
+        : mEntries{ capacity }
+        , mHits{ 0 }
+        , mMisses{ 0 }
+        , mLast{ nullptr }
+    {
+    }
+
+    // The value cached for the shape, null on a miss
+    Value* Find(const DXGI_OUTDUPL_POINTER_SHAPE_INFO& info, const byte* shape)
+    {
+        Entry* entry = mEntries.Find(HashPointerShape(info, shape));
+        if (entry == nullptr || !entry->Matches(info, shape))
+        {
+            ++mMisses;
+            mLast = nullptr;
+            return nullptr;
+        }
+
+        ++mHits;
+        mLast = &entry->CachedValue;
+        return mLast;
+    }
+
+    Value& Insert(const DXGI_OUTDUPL_POINTER_SHAPE_INFO& info, const byte* shape, Value value)
+    {
+        Entry entry;
+        entry.Info = info;
+        entry.Shape.assign(shape, shape + PointerShapeSize(info));
+        entry.CachedValue = std::move(value);
+        mLast = &mEntries.Insert(HashPointerShape(info, shape), std::move(entry)).CachedValue;
+        return *mLast;
+    }
+
+    // The value the last Find or Insert returned, so a shape that did not change
+    // is not hashed again. Null after a miss.
+    Value* Last()
+    {
+        return mLast;
+    }
+
+    void Clear()
+    {
+        mEntries.Clear();
+        mLast = nullptr;
+    }
+
+    size_t Size() const { return mEntries.Size(); }
+    size_t Capacity() const { return mEntries.Capacity(); }
+
+    uint64_t Hits() const { return mHits; }
+    uint64_t Misses() const { return mMisses; }
+    uint64_t Evictions() const { return mEntries.Evictions(); }
+
+private:
+    struct Entry
+    {
+        DXGI_OUTDUPL_POINTER_SHAPE_INFO Info;
+        std::vector<byte> Shape;
+        Value CachedValue;
+
+        bool Matches(const DXGI_OUTDUPL_POINTER_SHAPE_INFO& info, const byte* shape) const
+        {
+            return Info.Type == info.Type &&
+                Info.Width == info.Width &&
+                Info.Height == info.Height &&
+                Info.Pitch == info.Pitch &&
+                (Shape.empty() || std::memcmp(Shape.data(), shape, Shape.size()) == 0);
+        }
+    };
+
+    LruCache<uint64_t, Entry> mEntries;
+    uint64_t mHits;
+    uint64_t mMisses;
+    Value* mLast;
+};
@@ -0,0 +1,88 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+//
+// PointerTrack.h
+// On-disk layout of a pointer track, the cursor recorded next to a video instead of drawn into it.
+//
+// A track is a PointerTrackHeader followed by records, each a PointerTrackRecordHeader and
+// its payload padded to 8 bytes:
+//   Shape records hold a PointerTrackShape and the shape buffer. Every distinct shape is
+//   written once, the first time it is seen, and given the next id.
+//   Sample records hold a PointerTrackSample, written whenever the position, visibility
+//   or shape changed.
+// Times are in ticks of the header's TicksPerSecond, StartTime is when the video started.
+// All values are little-endian.
+//
+
+#pragma once
+
+#include "PlatformTypes.h"
+#include <cstdint>
+
+constexpr char PointerTrackMagic[8] = { 'D', 'R', 'P', 'O', 'I', 'N', 'T', '\0' };
+constexpr uint32_t PointerTrackVersion = 1;
+
+// PointerTrackRecordHeader::Type
+constexpr uint32_t PointerTrackShapeRecord = 1;
+constexpr uint32_t PointerTrackSampleRecord = 2;
+
+// PointerTrackSample::ShapeId before the first shape arrived
+constexpr uint32_t PointerTrackNoShape = UINT32_MAX;
+
+#pragma pack(push, 8)
+
+struct PointerTrackHeader
+{
+    char Magic[8];
+    uint32_t Version;
+    uint32_t Reserved;
+    int64_t TicksPerSecond;
+    int64_t StartTime;
+};
+
+struct PointerTrackRecordHeader
+{
+    // Size of the record including this header and padding
+    uint32_t Size;
+    uint32_t Type;
+};
+
+struct PointerTrackShape
+{
+    uint32_t Id;
+    uint32_t ShapeSize;
+    DXGI_OUTDUPL_POINTER_SHAPE_INFO Info;
+};
+
+struct PointerTrackSample
+{
+    int64_t Time;
+
+    // Top left of the shape in the recorded frame's pixels
+    POINT Position;
+    int32_t Visible;
+    uint32_t ShapeId;
+};
+
+#pragma pack(pop)
+
+static_assert(sizeof(PointerTrackHeader) == 32, "pointer track header layout changed");
+static_assert(sizeof(PointerTrackShape) % 8 == 0, "pointer track records must stay 8 byte aligned");
+static_assert(sizeof(PointerTrackSample) % 8 == 0, "pointer track records must stay 8 byte aligned");
@@ -0,0 +1,147 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "pch.h"
+#include "PointerTrackReader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+PointerTrackReader::PointerTrackReader(const std::filesystem::path& path)
+    : mHeader{}
+{
+    std::ifstream file{ path, std::ios::binary };
+    if (!file)
+    {
+        throw std::runtime_error("could not open pointer track");
+    }
+
+    const std::vector<char> data{ std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} };
+    if (data.size() < sizeof(mHeader))
+    {
+        throw std::runtime_error("pointer track is truncated");
+    }
+
+    std::memcpy(&mHeader, data.data(), sizeof(mHeader));
+    if (std::memcmp(mHeader.Magic, PointerTrackMagic, sizeof(mHeader.Magic)) != 0)
+    {
+        throw std::runtime_error("not a pointer track");
+    }
+
+    if (mHeader.Version != PointerTrackVersion)
+    {
+        throw std::runtime_error("unsupported pointer track version");
+    }
+
+    size_t offset = sizeof(mHeader);
+    while (offset < data.size())
+    {
+        PointerTrackRecordHeader record;
+        if (data.size() - offset < sizeof(record))
+        {
+            throw std::runtime_error("pointer track is truncated");
+        }
+        std::memcpy(&record, data.data() + offset, sizeof(record));
+        if (record.Size < sizeof(record) || record.Size > data.size() - offset)
+        {
+            throw std::runtime_error("pointer track record is truncated");
+        }
+
+        const char* payload = data.data() + offset + sizeof(record);
+        const size_t payloadSize = record.Size - sizeof(record);
+        if (record.Type == PointerTrackShapeRecord)
+        {
+            PointerTrackShape shape;
+            if (payloadSize < sizeof(shape))
+            {
+                throw std::runtime_error("pointer track shape is truncated");
+            }
+            std::memcpy(&shape, payload, sizeof(shape));
+            if (shape.Id != mShapes.size() || shape.ShapeSize > payloadSize - sizeof(shape))
+            {
+                throw std::runtime_error("pointer track shape is corrupt");
+            }
+
+            const byte* buffer = reinterpret_cast<const byte*>(payload + sizeof(shape));
+            mShapes.push_back(StoredShape{ shape.Info, std::vector<byte>(buffer, buffer + shape.ShapeSize) });
+        }
+        else if (record.Type == PointerTrackSampleRecord)
+        {
+            PointerTrackSample sample;
+            if (payloadSize < sizeof(sample))
+            {
+                throw std::runtime_error("pointer track sample is truncated");
+            }
+            std::memcpy(&sample, payload, sizeof(sample));
+            if (sample.ShapeId != PointerTrackNoShape && sample.ShapeId >= mShapes.size())
+            {
+                throw std::runtime_error("pointer track sample refers to an unknown shape");
+            }
+            mSamples.push_back(sample);
+        }
+
+        // unknown records are skipped so newer writers stay readable
+        offset += record.Size;
+    }
+}
+
+int64_t PointerTrackReader::TicksPerSecond() const
+{
+    return mHeader.TicksPerSecond;
+}
+
+int64_t PointerTrackReader::StartTime() const
+{
+    return mHeader.StartTime;
+}
+
+size_t PointerTrackReader::ShapeCount() const
+{
+    return mShapes.size();
+}
+
+const DXGI_OUTDUPL_POINTER_SHAPE_INFO& PointerTrackReader::ShapeInfo(uint32_t id) const
+{
+    return mShapes.at(id).Info;
+}
+
+const std::vector<byte>& PointerTrackReader::Shape(uint32_t id) const
+{
+    return mShapes.at(id).Buffer;
+}
+
+const std::vector<PointerTrackSample>& PointerTrackReader::Samples() const
+{
+    return mSamples;
+}
+
+const PointerTrackSample* PointerTrackReader::At(int64_t time) const
+{
+    // samples are written in capture order
+    auto after = std::upper_bound(
+        mSamples.begin(),
+        mSamples.end(),
+        time,
+        [](int64_t value, const PointerTrackSample& sample) { return value < sample.Time; });
+
+    return after == mSamples.begin() ? nullptr : &*(after - 1);
+}
@@ -0,0 +1,58 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "PointerTrack.h"
+#include <filesystem>
+#include <vector>
+
+/*
+    Reads a whole pointer track into memory, for players and post-processors
+    that overlay the cursor on a video recorded without it.
+*/
+class PointerTrackReader
+{
+public:
+    explicit PointerTrackReader(const std::filesystem::path& path);
+
+    int64_t TicksPerSecond() const;
+
+    int64_t StartTime() const;
+
+    size_t ShapeCount() const;
+    const DXGI_OUTDUPL_POINTER_SHAPE_INFO& ShapeInfo(uint32_t id) const;
+    const std::vector<byte>& Shape(uint32_t id) const;
+
+    const std::vector<PointerTrackSample>& Samples() const;
+
+    // The sample in effect at the given time, null before the first one
+    const PointerTrackSample* At(int64_t time) const;
+
+private:
+    struct StoredShape
+    {
+        DXGI_OUTDUPL_POINTER_SHAPE_INFO Info;
+        std::vector<byte> Buffer;
+    };
+
+    PointerTrackHeader mHeader;
+    std::vector<StoredShape> mShapes;
+    std::vector<PointerTrackSample> mSamples;
+};
@@ -0,0 +1,188 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "pch.h"
+#include "PointerTrackWriter.h"
+#include "PointerShapeCache.h"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+    bool SameInfo(const DXGI_OUTDUPL_POINTER_SHAPE_INFO& a, const DXGI_OUTDUPL_POINTER_SHAPE_INFO& b)
+    {
+        return a.Type == b.Type &&
+            a.Width == b.Width &&
+            a.Height == b.Height &&
+            a.Pitch == b.Pitch &&
+            a.HotSpot.x == b.HotSpot.x &&
+            a.HotSpot.y == b.HotSpot.y;
+    }
+}
+
+PointerTrackWriter::PointerTrackWriter(const std::filesystem::path& path, int64_t ticksPerSecond, int64_t startTime)
+    : mFile{ path, std::ios::binary | std::ios::trunc }
+    , mShapeId{ PointerTrackNoShape }
+    , mLastSample{}
+    , mHasSample{ false }
+    , mShapesWritten{ 0 }
+    , mSamplesWritten{ 0 }
+    , mBytesWritten{ 0 }
+{
+    if (!mFile)
+    {
+        throw std::runtime_error("could not create pointer track");
+    }
+
+    if (ticksPerSecond <= 0)
+    {
+        throw std::invalid_argument("pointer track ticks per second must be positive");
+    }
+
+    PointerTrackHeader header{};
+    std::memcpy(header.Magic, PointerTrackMagic, sizeof(header.Magic));
+    header.Version = PointerTrackVersion;
+    header.TicksPerSecond = ticksPerSecond;
+    header.StartTime = startTime;
+    WriteBytes(&header, sizeof(header));
+}
+
+PointerTrackWriter::~PointerTrackWriter()
+{
+    mFile.flush();
+}
+
+void PointerTrackWriter::WriteShape(const DXGI_OUTDUPL_POINTER_SHAPE_INFO& info, const byte* shape)
+{
+    if (shape == nullptr)
+    {
+        throw std::invalid_argument("null pointer shape");
+    }
+
+    // the hot spot is not part of the hash but players need it, so it is compared here
+    const size_t size = PointerShapeSize(info);
+    const uint64_t hash = HashPointerShape(info, shape);
+    auto range = mShapes.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        const KnownShape& known = it->second;
+        if (SameInfo(known.Info, info) && std::memcmp(known.Shape.data(), shape, size) == 0)
+        {
+            mShapeId = known.Id;
+            return;
+        }
+    }
+
+    if (size > UINT32_MAX - sizeof(PointerTrackShape))
+    {
+        throw std::invalid_argument("pointer shape too large");
+    }
+
+    KnownShape known;
+    known.Info = info;
+    known.Shape.assign(shape, shape + size);
+    known.Id = static_cast<uint32_t>(mShapesWritten);
+
+    PointerTrackShape record{};
+    record.Id = known.Id;
+    record.ShapeSize = static_cast<uint32_t>(size);
+    record.Info = info;
+    WriteRecord(PointerTrackShapeRecord, &record, sizeof(record), shape, size);
+
+    mShapeId = known.Id;
+    mShapes.emplace(hash, std::move(known));
+    ++mShapesWritten;
+}
+
+void PointerTrackWriter::WriteSample(int64_t time, bool visible, POINT position)
+{
+    PointerTrackSample sample{};
+    sample.Time = time;
+    sample.Position = position;
+    sample.Visible = visible ? 1 : 0;
+    sample.ShapeId = mShapeId;
+
+    if (mHasSample &&
+        mLastSample.Visible == sample.Visible &&
+        mLastSample.ShapeId == sample.ShapeId &&
+        mLastSample.Position.x == sample.Position.x &&
+        mLastSample.Position.y == sample.Position.y)
+    {
+        return;
+    }
+
+    WriteRecord(PointerTrackSampleRecord, &sample, sizeof(sample), nullptr, 0);
+    mLastSample = sample;
+    mHasSample = true;
+    ++mSamplesWritten;
+}
+
+void PointerTrackWriter::Flush()
+{
+    mFile.flush();
+}
+
+uint64_t PointerTrackWriter::ShapesWritten() const
+{
+    return mShapesWritten;
+}
+
+uint64_t PointerTrackWriter::SamplesWritten() const
+{
+    return mSamplesWritten;
+}
+
+uint64_t PointerTrackWriter::BytesWritten() const
+{
+    return mBytesWritten;
+}
+
+void PointerTrackWriter::WriteRecord(uint32_t type, const void* payload, size_t payloadSize, const void* data, size_t dataSize)
+{
+    const size_t unpaddedSize = sizeof(PointerTrackRecordHeader) + payloadSize + dataSize;
+    const size_t paddedSize = (unpaddedSize + 7) & ~static_cast<size_t>(7);
+
+    PointerTrackRecordHeader header{};
+    header.Size = static_cast<uint32_t>(paddedSize);
+    header.Type = type;
+
+    WriteBytes(&header, sizeof(header));
+    WriteBytes(payload, payloadSize);
+    WriteBytes(data, dataSize);
+
+    const char padding[8] = {};
+    WriteBytes(padding, paddedSize - unpaddedSize);
+
+    if (!mFile)
+    {
+        throw std::runtime_error("could not write pointer track");
+    }
+}
+
+void PointerTrackWriter::WriteBytes(const void* data, size_t size)
+{
+    if (size == 0)
+    {
+        return;
+    }
+
+    mFile.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+    mBytesWritten += size;
+}
@@ -0,0 +1,74 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "PointerTrack.h"
+#include <filesystem>
+#include <fstream>
+#include <unordered_map>
+#include <vector>
+
+/*
+    Writes the pointer to a track file next to the video, so the recorder does not
+    have to draw it into every frame and players can overlay it later.
+
+    Shapes are deduplicated by content, switching back to a cursor seen before only
+    writes a sample. Samples that would repeat the previous one are skipped.
+*/
+class PointerTrackWriter
+{
+public:
+    PointerTrackWriter(const std::filesystem::path& path, int64_t ticksPerSecond, int64_t startTime);
+    ~PointerTrackWriter();
+
+    PointerTrackWriter(const PointerTrackWriter&) = delete;
+    PointerTrackWriter& operator=(const PointerTrackWriter&) = delete;
+
+    // Makes the shape current, the next sample refers to it
+    void WriteShape(const DXGI_OUTDUPL_POINTER_SHAPE_INFO& info, const byte* shape);
+
+    void WriteSample(int64_t time, bool visible, POINT position);
+
+    void Flush();
+
+    uint64_t ShapesWritten() const;
+    uint64_t SamplesWritten() const;
+    uint64_t BytesWritten() const;
+
+private:
+    struct KnownShape
+    {
+        DXGI_OUTDUPL_POINTER_SHAPE_INFO Info;
+        std::vector<byte> Shape;
+        uint32_t Id;
+    };
+
+    void WriteRecord(uint32_t type, const void* payload, size_t payloadSize, const void* data, size_t dataSize);
+    void WriteBytes(const void* data, size_t size);
+
+    std::ofstream mFile;
+    std::unordered_multimap<uint64_t, KnownShape> mShapes;
+    uint32_t mShapeId;
+    PointerTrackSample mLastSample;
+    bool mHasSample;
+    uint64_t mShapesWritten;
+    uint64_t mSamplesWritten;
+    uint64_t mBytesWritten;
+};
@@ -0,0 +1,63 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+//
+// ReadbackDevice.h
+// Copies parts of the shared surface into CPU readable buffers and maps them
+// once the copy has finished.
+//
+
+#pragma once
+#include "PlatformTypes.h"
+#include <cstddef>
+#include <memory>
+
+// A CPU readable copy of part of a surface, created by a ReadbackDevice
+class ReadbackBuffer
+{
+public:
+    virtual ~ReadbackBuffer() = default;
+
+    virtual UINT Width() const = 0;
+    virtual UINT Height() const = 0;
+};
+
+// Pixels of a mapped readback buffer, 32 bits each
+struct MappedReadback
+{
+    const byte* Data;
+    size_t Pitch;
+};
+
+class ReadbackDevice
+{
+public:
+    virtual ~ReadbackDevice() = default;
+
+    virtual std::shared_ptr<ReadbackBuffer> CreateBuffer(UINT width, UINT height) = 0;
+
+    // Queues a copy of the region of the source surface to the top left of the buffer
+    virtual void Copy(ReadbackBuffer& buffer, const RECT& region) = 0;
+
+    // Maps the buffer for reading. Without wait it returns false instead of
+    // blocking when the GPU has not finished the copy yet.
+    virtual bool Map(ReadbackBuffer& buffer, bool wait, MappedReadback& mapped) = 0;
+
+    virtual void Unmap(ReadbackBuffer& buffer) = 0;
+};
@@ -0,0 +1,240 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "pch.h"
+#include "ReadbackRing.h"
+
+#include <stdexcept>
+
+namespace
+{
+    constexpr size_t NotMapped = static_cast<size_t>(-1);
+}
+
+ReadbackRing::ReadbackRing(std::shared_ptr<ReadbackDevice> device, size_t latency)
+    : mDevice{ device }
+    , mLatency{ latency }
+    , mNext{ 0 }
+    , mMapped{ NotMapped }
+    , mSubmits{ 0 }
+    , mHits{ 0 }
+    , mMisses{ 0 }
+    , mDropped{ 0 }
+    , mStalls{ 0 }
+    , mStallTime{ 0 }
+    , mGrows{ 0 }
+{
+    if (mDevice == nullptr)
+    {
+        throw std::invalid_argument("null readback device");
+    }
+
+    if (mLatency == 0)
+    {
+        throw std::invalid_argument("readback latency must not be zero");
+    }
+
+    // one more than the latency so the oldest readback can still be waited on
+    // while the newest is being copied
+    mSlots.resize(mLatency + 1, Slot{ nullptr, ReadbackRequest{}, false });
+}
+
+ReadbackRing::~ReadbackRing()
+{
+    Release();
+}
+
+void ReadbackRing::Submit(const ReadbackRequest& request)
+{
+    const RECT& region = request.Region;
+    if (region.right <= region.left || region.bottom <= region.top)
+    {
+        throw std::invalid_argument("readback region is empty");
+    }
+
+    Release();
+
+    Slot& slot = mSlots[mNext];
+    if (slot.Pending)
+    {
+        // never acquired, the caller did not keep up
+        ++mDropped;
+    }
+
+    const UINT width = static_cast<UINT>(region.right - region.left);
+    const UINT height = static_cast<UINT>(region.bottom - region.top);
+    if (slot.Buffer == nullptr || slot.Buffer->Width() < width || slot.Buffer->Height() < height)
+    {
+        const UINT bufferWidth = slot.Buffer == nullptr ? width : (std::max)(width, slot.Buffer->Width());
+        const UINT bufferHeight = slot.Buffer == nullptr ? height : (std::max)(height, slot.Buffer->Height());
+        slot.Buffer = mDevice->CreateBuffer(bufferWidth, bufferHeight);
+        ++mGrows;
+    }
+
+    mDevice->Copy(*slot.Buffer, region);
+    slot.Request = request;
+    slot.Pending = true;
+
+    mNext = (mNext + 1) % mSlots.size();
+    ++mSubmits;
+}
+
+bool ReadbackRing::Acquire(ReadbackResult& result, bool wait)
+{
+    Release();
+
+    // newest first, the GPU finishes copies in order so the first finished one is the one to use
+    size_t newestPending = NotMapped;
+    size_t oldestPending = NotMapped;
+    MappedReadback pixels{};
+    for (size_t age = 0; age < mSlots.size(); ++age)
+    {
+        Slot& slot = mSlots[SlotAt(age)];
+        if (!slot.Pending)
+        {
+            continue;
+        }
+
+        if (newestPending == NotMapped)
+        {
+            newestPending = age;
+        }
+        else if (wait)
+        {
+            break;
+        }
+
+        if (mDevice->Map(*slot.Buffer, false, pixels))
+        {
+            ++mHits;
+            Acquired(age, pixels, result);
+            return true;
+        }
+
+        oldestPending = age;
+    }
+
+    if (newestPending == NotMapped || (!wait && oldestPending < mLatency))
+    {
+        ++mMisses;
+        return false;
+    }
+
+    const size_t age = wait ? newestPending : oldestPending;
+    const auto start = std::chrono::steady_clock::now();
+    if (!mDevice->Map(*mSlots[SlotAt(age)].Buffer, true, pixels))
+    {
+        throw std::runtime_error("readback device did not wait for the copy");
+    }
+    mStallTime += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    ++mStalls;
+
+    Acquired(age, pixels, result);
+    return true;
+}
+
+void ReadbackRing::Release()
+{
+    if (mMapped != NotMapped)
+    {
+        mDevice->Unmap(*mSlots[mMapped].Buffer);
+        mMapped = NotMapped;
+    }
+}
+
+ReadbackDevice& ReadbackRing::Device() const
+{
+    return *mDevice;
+}
+
+size_t ReadbackRing::Latency() const
+{
+    return mLatency;
+}
+
+size_t ReadbackRing::Pending() const
+{
+    size_t pending = 0;
+    for (const Slot& slot : mSlots)
+    {
+        pending += slot.Pending ? 1 : 0;
+    }
+    return pending;
+}
+
+uint64_t ReadbackRing::Submits() const
+{
+    return mSubmits;
+}
+
+uint64_t ReadbackRing::Hits() const
+{
+    return mHits;
+}
+
+uint64_t ReadbackRing::Misses() const
+{
+    return mMisses;
+}
+
+uint64_t ReadbackRing::Dropped() const
+{
+    return mDropped;
+}
+
+uint64_t ReadbackRing::Stalls() const
+{
+    return mStalls;
+}
+
+std::chrono::nanoseconds ReadbackRing::StallTime() const
+{
+    return mStallTime;
+}
+
+uint64_t ReadbackRing::Grows() const
+{
+    return mGrows;
+}
+
+size_t ReadbackRing::SlotAt(size_t age) const
+{
+    return (mNext + 2 * mSlots.size() - 1 - age) % mSlots.size();
+}
+
+void ReadbackRing::Acquired(size_t age, const MappedReadback& pixels, ReadbackResult& result)
+{
+    const size_t index = SlotAt(age);
+    mSlots[index].Pending = false;
+    mMapped = index;
+
+    for (size_t older = age + 1; older < mSlots.size(); ++older)
+    {
+        Slot& slot = mSlots[SlotAt(older)];
+        if (slot.Pending)
+        {
+            slot.Pending = false;
+            ++mDropped;
+        }
+    }
+
+    result.Request = mSlots[index].Request;
+    result.Pixels = pixels;
+    result.Age = age;
+}
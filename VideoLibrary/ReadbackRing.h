@@ -0,0 +1,128 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+//
+// ReadbackRing.h
+// Reads regions of a surface back to the CPU a few frames after they were copied,
+// so the CPU does not wait on the GPU for the copy it just queued.
+// Each submit copies into the next buffer of a small reusable ring and acquire
+// maps the newest copy the GPU has finished. Only a copy that reached the latency
+// without finishing is waited on, which is counted as a stall.
+//
+
+#pragma once
+#include "ReadbackDevice.h"
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// What to read back
+struct ReadbackRequest
+{
+    RECT Region;
+
+    // Not used by the ring, handed back with the result for the caller to
+    // remember where the region came from
+    POINT Origin;
+};
+
+struct ReadbackResult
+{
+    ReadbackRequest Request;
+    MappedReadback Pixels;
+
+    // Submits since this readback was requested, 0 when it is the latest
+    size_t Age;
+};
+
+class ReadbackRing
+{
+public:
+    // Frames a readback may stay in flight before acquiring it waits for the GPU
+    static constexpr size_t DefaultLatency = 2;
+
+    ReadbackRing(std::shared_ptr<ReadbackDevice> device, size_t latency = DefaultLatency);
+
+    ~ReadbackRing();
+
+    // Queues a copy of the region, reusing the ring's buffers once they are large enough.
+    // Releases the acquired result.
+    void Submit(const ReadbackRequest& request);
+
+    // Maps the newest finished readback without waiting and drops the older ones.
+    // When none has finished it waits on the oldest once it reached the latency.
+    // With wait set only the newest readback will do, for callers whose older
+    // requests are out of date, and it is waited on when it has not finished.
+    // Returns false when nothing was finished and waiting was not needed.
+    // The result is valid until Release or the next Submit.
+    bool Acquire(ReadbackResult& result, bool wait = false);
+
+    void Release();
+
+    ReadbackDevice& Device() const;
+
+    size_t Latency() const;
+
+    // Readbacks submitted and not acquired or dropped yet
+    size_t Pending() const;
+
+    uint64_t Submits() const;
+
+    // Acquires that found a finished readback without waiting
+    uint64_t Hits() const;
+
+    // Acquires that found nothing and returned false
+    uint64_t Misses() const;
+
+    // Readbacks skipped because a newer one finished first or the ring wrapped
+    uint64_t Dropped() const;
+
+    // Acquires that had to wait for the GPU, and how long they waited in total
+    uint64_t Stalls() const;
+    std::chrono::nanoseconds StallTime() const;
+
+    // Buffers created so far
+    uint64_t Grows() const;
+
+private:
+    struct Slot
+    {
+        std::shared_ptr<ReadbackBuffer> Buffer;
+        ReadbackRequest Request;
+        bool Pending;
+    };
+
+    // Slot index of the readback submitted age submits ago
+    size_t SlotAt(size_t age) const;
+    // Hands out a mapped slot and drops the readbacks older than it
+    void Acquired(size_t age, const MappedReadback& pixels, ReadbackResult& result);
+
+    std::shared_ptr<ReadbackDevice> mDevice;
+    std::vector<Slot> mSlots;
+    size_t mLatency;
+    size_t mNext;
+    size_t mMapped;
+    uint64_t mSubmits;
+    uint64_t mHits;
+    uint64_t mMisses;
+    uint64_t mDropped;
+    uint64_t mStalls;
+    std::chrono::nanoseconds mStallTime;
+    uint64_t mGrows;
+};
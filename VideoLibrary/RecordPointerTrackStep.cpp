@@ -0,0 +1,77 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "pch.h"
+#include "RecordPointerTrackStep.h"
+
+RecordPointerTrackStep::RecordPointerTrackStep(
+    std::shared_ptr<Frame> frame,
+    std::shared_ptr<DesktopPointer> desktopPointer,
+    std::shared_ptr<PointerTrackWriter> writer)
+    : mFrame{ frame }
+    , mDesktopPointer{ desktopPointer }
+    , mWriter{ writer }
+{
+    if (mFrame == nullptr)
+    {
+        throw std::exception("Null frame");
+    }
+
+    if (mDesktopPointer == nullptr)
+    {
+        throw std::exception("null desktop pointer");
+    }
+
+    if (mWriter == nullptr)
+    {
+        throw std::exception("null pointer track writer");
+    }
+}
+
+RecordPointerTrackStep::~RecordPointerTrackStep()
+{
+}
+
+void RecordPointerTrackStep::Perform()
+{
+    if (!mFrame->Captured())
+    {
+        return;
+    }
+
+    const bool shapeUpdated = mFrame->PointerShapeUpdated();
+    if (shapeUpdated)
+    {
+        mWriter->WriteShape(mDesktopPointer->ShapeInfo(), mDesktopPointer->Buffer());
+    }
+
+    // a zero update time means the pointer did not change on this frame
+    int64_t time = mFrame->PointerUpdateTime();
+    if (time == 0 && !shapeUpdated)
+    {
+        return;
+    }
+
+    if (time == 0)
+    {
+        time = mFrame->PresentationTime();
+    }
+
+    mWriter->WriteSample(time, mDesktopPointer->Visible(), mDesktopPointer->Position().Position);
+}
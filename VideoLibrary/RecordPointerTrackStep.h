@@ -0,0 +1,45 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "RecordingStep.h"
+#include "Frame.h"
+#include "DesktopPointer.h"
+#include "PointerTrackWriter.h"
+
+// Appends the pointer changes a frame delivered to a pointer track
+class RecordPointerTrackStep : public RecordingStep
+{
+public:
+    RecordPointerTrackStep(
+        std::shared_ptr<Frame> frame,
+        std::shared_ptr<DesktopPointer> desktopPointer,
+        std::shared_ptr<PointerTrackWriter> writer);
+
+    ~RecordPointerTrackStep();
+
+    // Inherited via RecordingStep
+    virtual void Perform() override;
+
+private:
+    std::shared_ptr<Frame> mFrame;
+    std::shared_ptr<DesktopPointer> mDesktopPointer;
+    std::shared_ptr<PointerTrackWriter> mWriter;
+};
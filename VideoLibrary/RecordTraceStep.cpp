@@ -0,0 +1,134 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "RecordTraceStep.h"
+
+#include <cstring>
+
+RecordTraceStep::RecordTraceStep(
+    std::shared_ptr<Frame> frame,
+    std::shared_ptr<DesktopPointer> desktopPointer,
+    std::shared_ptr<CaptureTraceWriter> writer,
+    winrt::com_ptr<ID3D11Texture2D> readbackTexture,
+    std::shared_ptr<std::vector<byte>> pixelBuffer)
+    : mFrame{ frame }
+    , mDesktopPointer{ desktopPointer }
+    , mWriter{ writer }
+    , mReadbackTexture{ readbackTexture }
+    , mPixelBuffer{ pixelBuffer }
+{
+    if (mFrame == nullptr)
+    {
+        throw std::exception("Null frame");
+    }
+
+    if (mDesktopPointer == nullptr)
+    {
+        throw std::exception("null desktop pointer");
+    }
+
+    if (mWriter == nullptr)
+    {
+        throw std::exception("null capture trace writer");
+    }
+
+    if (mPixelBuffer == nullptr)
+    {
+        throw std::exception("null trace pixel buffer");
+    }
+}
+
+RecordTraceStep::~RecordTraceStep()
+{
+}
+
+void RecordTraceStep::Perform()
+{
+    if (!mFrame->Captured())
+    {
+        return;
+    }
+
+    CaptureTraceFrame traceFrame;
+    traceFrame.PresentTime = mFrame->PresentationTime();
+    traceFrame.PointerUpdateTime = mFrame->PointerUpdateTime();
+    traceFrame.MonitorBounds = mFrame->DesktopMonitorBounds();
+    traceFrame.Rotation = mFrame->Rotation();
+    traceFrame.PointerPosition = mFrame->PointerPosition();
+    traceFrame.MoveRects = mFrame->MoveRects();
+    traceFrame.MoveRectsCount = mFrame->MoveRectsCount();
+    traceFrame.DirtyRects = mFrame->DirtyRects();
+    traceFrame.DirtyRectsCount = mFrame->DirtyRectsCount();
+
+    if (mFrame->PointerShapeUpdated())
+    {
+        traceFrame.HasPointerShape = true;
+        traceFrame.PointerShapeInfo = mDesktopPointer->ShapeInfo();
+        traceFrame.PointerShape = mDesktopPointer->Buffer();
+        traceFrame.PointerShapeSize = mDesktopPointer->BufferSize();
+    }
+
+    if (mWriter->RecordsPixels() && mReadbackTexture && mFrame->DirtyRectsCount() != 0)
+    {
+        ReadDirtyPixels();
+        traceFrame.Pixels = mPixelBuffer->data();
+        traceFrame.PixelsSize = mPixelBuffer->size();
+    }
+
+    mWriter->Write(traceFrame);
+}
+
+void RecordTraceStep::ReadDirtyPixels()
+{
+    winrt::com_ptr<ID3D11Device> device;
+    mReadbackTexture->GetDevice(device.put());
+
+    winrt::com_ptr<ID3D11DeviceContext> context;
+    device->GetImmediateContext(context.put());
+
+    const RECT* dirtyRects = mFrame->DirtyRects();
+    const size_t dirtyRectsCount = mFrame->DirtyRectsCount();
+    mPixelBuffer->resize(CaptureTraceDirtyPixelsSize(dirtyRects, dirtyRectsCount));
+
+    // stalls until the copy is done, tracing with pixels is meant for collecting test data
+    context->CopyResource(mReadbackTexture.get(), mFrame->DesktopImage().get());
+
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    winrt::check_hresult(context->Map(mReadbackTexture.get(), 0, D3D11_MAP_READ, 0, &mapped));
+
+    byte* destination = mPixelBuffer->data();
+    for (size_t i = 0; i < dirtyRectsCount; ++i)
+    {
+        const RECT& rect = dirtyRects[i];
+        if (rect.right <= rect.left || rect.bottom <= rect.top)
+        {
+            continue;
+        }
+
+        const size_t rowSize = static_cast<size_t>(rect.right - rect.left) * CaptureTraceBytesPerPixel;
+        for (LONG y = rect.top; y < rect.bottom; ++y)
+        {
+            const byte* source = static_cast<const byte*>(mapped.pData) + y * mapped.RowPitch + rect.left * CaptureTraceBytesPerPixel;
+            std::memcpy(destination, source, rowSize);
+            destination += rowSize;
+        }
+    }
+
+    context->Unmap(mReadbackTexture.get(), 0);
+}
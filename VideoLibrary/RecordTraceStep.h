@@ -0,0 +1,51 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "RecordingStep.h"
+#include "Frame.h"
+#include "DesktopPointer.h"
+#include "CaptureTraceWriter.h"
+
+// Appends the frame to a capture trace, reading back the dirty pixels when the trace records them
+class RecordTraceStep : public RecordingStep
+{
+public:
+    RecordTraceStep(
+        std::shared_ptr<Frame> frame,
+        std::shared_ptr<DesktopPointer> desktopPointer,
+        std::shared_ptr<CaptureTraceWriter> writer,
+        winrt::com_ptr<ID3D11Texture2D> readbackTexture,
+        std::shared_ptr<std::vector<byte>> pixelBuffer);
+
+    ~RecordTraceStep();
+
+    // Inherited via RecordingStep
+    virtual void Perform() override;
+
+private:
+
+    void ReadDirtyPixels();
+
+    std::shared_ptr<Frame> mFrame;
+    std::shared_ptr<DesktopPointer> mDesktopPointer;
+    std::shared_ptr<CaptureTraceWriter> mWriter;
+    winrt::com_ptr<ID3D11Texture2D> mReadbackTexture;
+    std::shared_ptr<std::vector<byte>> mPixelBuffer;
+};
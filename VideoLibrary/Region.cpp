@@ -0,0 +1,636 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "pch.h"
+#include "Simd.h"
+#include "Region.h"
+
+#include <climits>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+    constexpr size_t NoBand = static_cast<size_t>(-1);
+    constexpr LONG MinCoordinate = (std::numeric_limits<LONG>::min)();
+    constexpr LONG MaxCoordinate = (std::numeric_limits<LONG>::max)();
+
+    const RECT EmptyRect{ 0, 0, 0, 0 };
+
+    bool IsEmptyRect(const RECT& rect)
+    {
+        return rect.right <= rect.left || rect.bottom <= rect.top;
+    }
+
+    bool ExtentsOverlap(const RECT& a, const RECT& b)
+    {
+        return a.left < b.right && b.left < a.right && a.top < b.bottom && b.top < a.bottom;
+    }
+
+    size_t BandEnd(const RECT* rects, size_t count, size_t start)
+    {
+        const LONG top = rects[start].top;
+        size_t end = start + 1;
+        while (end < count && rects[end].top == top)
+        {
+            ++end;
+        }
+        return end;
+    }
+
+    // Compares only the left and right edges of two runs of rects
+    bool SpansEqual(const RECT* a, const RECT* b, size_t count)
+    {
+#if SIMD_SSE2
+        for (size_t i = 0; i < count; ++i)
+        {
+            const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+            const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+            // lanes 0 and 2 hold left and right
+            if ((_mm_movemask_epi8(_mm_cmpeq_epi32(va, vb)) & 0x0F0F) != 0x0F0F)
+            {
+                return false;
+            }
+        }
+        return true;
+#else
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (a[i].left != b[i].left || a[i].right != b[i].right)
+            {
+                return false;
+            }
+        }
+        return true;
+#endif
+    }
+
+    // Merges the band starting at bandStart into the previous band when both have the
+    // same spans and touch vertically. Returns the start of the last band in out.
+    size_t CoalesceBand(std::vector<RECT>& out, size_t previousBand, size_t bandStart)
+    {
+        if (previousBand != NoBand)
+        {
+            const size_t previousCount = bandStart - previousBand;
+            const size_t currentCount = out.size() - bandStart;
+
+            if (previousCount == currentCount &&
+                out[previousBand].bottom == out[bandStart].top &&
+                SpansEqual(out.data() + previousBand, out.data() + bandStart, currentCount))
+            {
+                const LONG bottom = out[bandStart].bottom;
+                for (size_t i = previousBand; i < bandStart; ++i)
+                {
+                    out[i].bottom = bottom;
+                }
+                out.resize(bandStart);
+                return previousBand;
+            }
+        }
+
+        return bandStart;
+    }
+
+    void UnionSpans(const RECT* a, size_t countA, const RECT* b, size_t countB, LONG top, LONG bottom, std::vector<RECT>& out)
+    {
+        size_t i = 0, j = 0;
+        bool open = false;
+        RECT current{ 0, top, 0, bottom };
+
+        while (i < countA || j < countB)
+        {
+            const RECT* next;
+            if (j >= countB || (i < countA && a[i].left <= b[j].left))
+            {
+                next = a + i++;
+            }
+            else
+            {
+                next = b + j++;
+            }
+
+            if (open && next->left <= current.right)
+            {
+                current.right = std::max(current.right, next->right);
+                continue;
+            }
+
+            if (open)
+            {
+                out.push_back(current);
+            }
+            current.left = next->left;
+            current.right = next->right;
+            open = true;
+        }
+
+        if (open)
+        {
+            out.push_back(current);
+        }
+    }
+
+    void IntersectSpans(const RECT* a, size_t countA, const RECT* b, size_t countB, LONG top, LONG bottom, std::vector<RECT>& out)
+    {
+        size_t i = 0, j = 0;
+        while (i < countA && j < countB)
+        {
+            const LONG left = std::max(a[i].left, b[j].left);
+            const LONG right = std::min(a[i].right, b[j].right);
+            if (left < right)
+            {
+                out.push_back(RECT{ left, top, right, bottom });
+            }
+
+            if (a[i].right < b[j].right)
+            {
+                ++i;
+            }
+            else
+            {
+                ++j;
+            }
+        }
+    }
+
+    void SubtractSpans(const RECT* a, size_t countA, const RECT* b, size_t countB, LONG top, LONG bottom, std::vector<RECT>& out)
+    {
+        size_t j = 0;
+        for (size_t i = 0; i < countA; ++i)
+        {
+            LONG left = a[i].left;
+            const LONG right = a[i].right;
+
+            while (j < countB && b[j].right <= left)
+            {
+                ++j;
+            }
+
+            for (size_t k = j; k < countB && b[k].left < right && left < right; ++k)
+            {
+                if (b[k].left > left)
+                {
+                    out.push_back(RECT{ left, top, b[k].left, bottom });
+                }
+                left = std::max(left, b[k].right);
+            }
+
+            if (left < right)
+            {
+                out.push_back(RECT{ left, top, right, bottom });
+            }
+        }
+    }
+}
+
+Region::Region()
+    : mExtents{ EmptyRect }
+{
+}
+
+Region::Region(const RECT& rect)
+    : mExtents{ EmptyRect }
+{
+    Reset(rect);
+}
+
+void Region::Clear()
+{
+    mRects.clear();
+    mExtents = EmptyRect;
+}
+
+void Region::Reset(const RECT& rect)
+{
+    Clear();
+    if (!IsEmptyRect(rect))
+    {
+        mRects.push_back(rect);
+        mExtents = rect;
+    }
+}
+
+void Region::Reset(const RECT* rects, size_t count)
+{
+    BuildFromRects(rects, count, mScratch);
+    Commit(mScratch);
+}
+
+bool Region::IsEmpty() const
+{
+    return mRects.empty();
+}
+
+RECT Region::Extents() const
+{
+    return mExtents;
+}
+
+int64_t Region::Area() const
+{
+    int64_t area = 0;
+    for (const RECT& rect : mRects)
+    {
+        area += static_cast<int64_t>(rect.right - rect.left) * (rect.bottom - rect.top);
+    }
+    return area;
+}
+
+const RECT* Region::Rects() const
+{
+    return mRects.data();
+}
+
+size_t Region::RectsCount() const
+{
+    return mRects.size();
+}
+
+bool Region::Contains(POINT point) const
+{
+    return Intersects(RECT{ point.x, point.y, point.x + 1, point.y + 1 });
+}
+
+bool Region::Intersects(const RECT& rect) const
+{
+    if (IsEmptyRect(rect) || !ExtentsOverlap(mExtents, rect))
+    {
+        return false;
+    }
+
+#if SIMD_SSE2
+    // a rect r overlaps when r.left < rect.right, r.top < rect.bottom, r.right > rect.left and r.bottom > rect.top
+    const __m128i lessThan = _mm_setr_epi32(rect.right, rect.bottom, INT_MIN, INT_MIN);
+    const __m128i greaterThan = _mm_setr_epi32(INT_MIN, INT_MIN, rect.left, rect.top);
+#endif
+
+    for (const RECT& r : mRects)
+    {
+        if (r.top >= rect.bottom)
+        {
+            // bands are sorted top to bottom
+            break;
+        }
+
+#if SIMD_SSE2
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&r));
+        const int mask =
+            (_mm_movemask_epi8(_mm_cmplt_epi32(v, lessThan)) & 0x00FF) |
+            (_mm_movemask_epi8(_mm_cmpgt_epi32(v, greaterThan)) & 0xFF00);
+        if (mask == 0xFFFF)
+        {
+            return true;
+        }
+#else
+        if (ExtentsOverlap(r, rect))
+        {
+            return true;
+        }
+#endif
+    }
+
+    return false;
+}
+
+void Region::Union(const Region& other)
+{
+    if (other.IsEmpty())
+    {
+        return;
+    }
+
+    if (IsEmpty())
+    {
+        mScratch.assign(other.mRects.begin(), other.mRects.end());
+        Commit(mScratch);
+        return;
+    }
+
+    Combine(mRects.data(), mRects.size(), other.mRects.data(), other.mRects.size(), Operation::Union, mScratch);
+    Commit(mScratch);
+}
+
+void Region::Union(const RECT& rect)
+{
+    if (IsEmptyRect(rect))
+    {
+        return;
+    }
+
+    if (IsEmpty())
+    {
+        Reset(rect);
+        return;
+    }
+
+    // already covered by a single rect region
+    if (mRects.size() == 1 &&
+        mExtents.left <= rect.left && mExtents.top <= rect.top &&
+        mExtents.right >= rect.right && mExtents.bottom >= rect.bottom)
+    {
+        return;
+    }
+
+    Combine(mRects.data(), mRects.size(), &rect, 1, Operation::Union, mScratch);
+    Commit(mScratch);
+}
+
+void Region::Union(const RECT* rects, size_t count)
+{
+    if (IsEmpty())
+    {
+        Reset(rects, count);
+        return;
+    }
+
+    BuildFromRects(rects, count, mBuilt);
+    Combine(mRects.data(), mRects.size(), mBuilt.data(), mBuilt.size(), Operation::Union, mScratch);
+    Commit(mScratch);
+}
+
+void Region::Intersect(const Region& other)
+{
+    if (IsEmpty() || other.IsEmpty() || !ExtentsOverlap(mExtents, other.mExtents))
+    {
+        Clear();
+        return;
+    }
+
+    Combine(mRects.data(), mRects.size(), other.mRects.data(), other.mRects.size(), Operation::Intersect, mScratch);
+    Commit(mScratch);
+}
+
+void Region::Intersect(const RECT& rect)
+{
+    if (IsEmpty() || IsEmptyRect(rect) || !ExtentsOverlap(mExtents, rect))
+    {
+        Clear();
+        return;
+    }
+
+    // nothing to clip
+    if (rect.left <= mExtents.left && rect.top <= mExtents.top &&
+        rect.right >= mExtents.right && rect.bottom >= mExtents.bottom)
+    {
+        return;
+    }
+
+    Combine(mRects.data(), mRects.size(), &rect, 1, Operation::Intersect, mScratch);
+    Commit(mScratch);
+}
+
+void Region::Subtract(const Region& other)
+{
+    if (IsEmpty() || other.IsEmpty() || !ExtentsOverlap(mExtents, other.mExtents))
+    {
+        return;
+    }
+
+    Combine(mRects.data(), mRects.size(), other.mRects.data(), other.mRects.size(), Operation::Subtract, mScratch);
+    Commit(mScratch);
+}
+
+void Region::Subtract(const RECT& rect)
+{
+    if (IsEmpty() || IsEmptyRect(rect) || !ExtentsOverlap(mExtents, rect))
+    {
+        return;
+    }
+
+    Combine(mRects.data(), mRects.size(), &rect, 1, Operation::Subtract, mScratch);
+    Commit(mScratch);
+}
+
+void Region::Translate(LONG dx, LONG dy)
+{
+    if (IsEmpty() || (dx == 0 && dy == 0))
+    {
+        return;
+    }
+
+    RECT* rects = mRects.data();
+    const size_t count = mRects.size();
+
+#if SIMD_SSE2
+    const __m128i offset = _mm_setr_epi32(dx, dy, dx, dy);
+    for (size_t i = 0; i < count; ++i)
+    {
+        __m128i* r = reinterpret_cast<__m128i*>(rects + i);
+        _mm_storeu_si128(r, _mm_add_epi32(_mm_loadu_si128(r), offset));
+    }
+#elif SIMD_NEON
+    const int32_t offsetValues[4] = { dx, dy, dx, dy };
+    const int32x4_t offset = vld1q_s32(offsetValues);
+    for (size_t i = 0; i < count; ++i)
+    {
+        int32_t* r = reinterpret_cast<int32_t*>(rects + i);
+        vst1q_s32(r, vaddq_s32(vld1q_s32(r), offset));
+    }
+#else
+    for (size_t i = 0; i < count; ++i)
+    {
+        rects[i].left += dx;
+        rects[i].right += dx;
+        rects[i].top += dy;
+        rects[i].bottom += dy;
+    }
+#endif
+
+    mExtents.left += dx;
+    mExtents.right += dx;
+    mExtents.top += dy;
+    mExtents.bottom += dy;
+}
+
+void Region::Clip(const RECT& bounds)
+{
+    Intersect(bounds);
+}
+
+bool Region::operator==(const Region& other) const
+{
+    return mRects.size() == other.mRects.size() &&
+        (mRects.empty() || std::memcmp(mRects.data(), other.mRects.data(), mRects.size() * sizeof(RECT)) == 0);
+}
+
+bool Region::operator!=(const Region& other) const
+{
+    return !(*this == other);
+}
+
+void Region::Combine(const RECT* a, size_t countA, const RECT* b, size_t countB, Operation operation, std::vector<RECT>& out) const
+{
+    out.clear();
+
+    size_t indexA = 0;
+    size_t indexB = 0;
+    size_t previousBand = NoBand;
+    LONG y = MinCoordinate;
+
+    while (indexA < countA || indexB < countB)
+    {
+        if (indexA >= countA && operation != Operation::Union)
+        {
+            break;
+        }
+
+        if (indexB >= countB && operation == Operation::Intersect)
+        {
+            break;
+        }
+
+        const size_t endA = indexA < countA ? BandEnd(a, countA, indexA) : indexA;
+        const size_t endB = indexB < countB ? BandEnd(b, countB, indexB) : indexB;
+        const LONG topA = indexA < countA ? a[indexA].top : MaxCoordinate;
+        const LONG topB = indexB < countB ? b[indexB].top : MaxCoordinate;
+        const LONG bottomA = indexA < countA ? a[indexA].bottom : MaxCoordinate;
+        const LONG bottomB = indexB < countB ? b[indexB].bottom : MaxCoordinate;
+
+        if (y < topA && y < topB)
+        {
+            y = std::min(topA, topB);
+        }
+
+        const bool activeA = indexA < countA && topA <= y;
+        const bool activeB = indexB < countB && topB <= y;
+        const LONG bottom = std::min(activeA ? bottomA : topA, activeB ? bottomB : topB);
+
+        const RECT* spansA = a + indexA;
+        const size_t spansCountA = activeA ? endA - indexA : 0;
+        const RECT* spansB = b + indexB;
+        const size_t spansCountB = activeB ? endB - indexB : 0;
+
+        const size_t bandStart = out.size();
+        switch (operation)
+        {
+        case Operation::Union:
+            UnionSpans(spansA, spansCountA, spansB, spansCountB, y, bottom, out);
+            break;
+        case Operation::Intersect:
+            IntersectSpans(spansA, spansCountA, spansB, spansCountB, y, bottom, out);
+            break;
+        case Operation::Subtract:
+            SubtractSpans(spansA, spansCountA, spansB, spansCountB, y, bottom, out);
+            break;
+        }
+
+        if (out.size() > bandStart)
+        {
+            previousBand = CoalesceBand(out, previousBand, bandStart);
+        }
+
+        y = bottom;
+        if (activeA && bottomA == bottom)
+        {
+            indexA = endA;
+        }
+        if (activeB && bottomB == bottom)
+        {
+            indexB = endB;
+        }
+    }
+}
+
+void Region::BuildFromRects(const RECT* rects, size_t count, std::vector<RECT>& out)
+{
+    out.clear();
+    mBuild.clear();
+    mActive.clear();
+    mEdges.clear();
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (IsEmptyRect(rects[i]))
+        {
+            continue;
+        }
+
+        mBuild.push_back(rects[i]);
+        mEdges.push_back(rects[i].top);
+        mEdges.push_back(rects[i].bottom);
+    }
+
+    if (mBuild.empty())
+    {
+        return;
+    }
+
+    std::sort(mBuild.begin(), mBuild.end(), [](const RECT& a, const RECT& b) { return a.top < b.top; });
+    std::sort(mEdges.begin(), mEdges.end());
+    mEdges.erase(std::unique(mEdges.begin(), mEdges.end()), mEdges.end());
+
+    // sweep down through every distinct edge keeping the rects that cover the current band
+    size_t next = 0;
+    size_t previousBand = NoBand;
+    for (size_t e = 0; e + 1 < mEdges.size(); ++e)
+    {
+        const LONG top = mEdges[e];
+        const LONG bottom = mEdges[e + 1];
+
+        for (size_t i = 0; i < mActive.size();)
+        {
+            if (mActive[i].bottom <= top)
+            {
+                mActive[i] = mActive.back();
+                mActive.pop_back();
+            }
+            else
+            {
+                ++i;
+            }
+        }
+
+        while (next < mBuild.size() && mBuild[next].top <= top)
+        {
+            mActive.push_back(mBuild[next++]);
+        }
+
+        if (mActive.empty())
+        {
+            continue;
+        }
+
+        std::sort(mActive.begin(), mActive.end(), [](const RECT& a, const RECT& b) { return a.left < b.left; });
+
+        const size_t bandStart = out.size();
+        UnionSpans(mActive.data(), mActive.size(), nullptr, 0, top, bottom, out);
+        previousBand = CoalesceBand(out, previousBand, bandStart);
+    }
+}
+
+void Region::Commit(std::vector<RECT>& rects)
+{
+    std::swap(mRects, rects);
+
+    if (mRects.empty())
+    {
+        mExtents = EmptyRect;
+        return;
+    }
+
+    mExtents.top = mRects.front().top;
+    mExtents.bottom = mRects.back().bottom;
+    mExtents.left = MaxCoordinate;
+    mExtents.right = MinCoordinate;
+    for (const RECT& rect : mRects)
+    {
+        mExtents.left = std::min(mExtents.left, rect.left);
+        mExtents.right = std::max(mExtents.right, rect.right);
+    }
+}
@@ -0,0 +1,97 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "PlatformTypes.h"
+#include <cstdint>
+#include <vector>
+
+/*
+    A set of pixels stored as Y-X banded rects, like X11 and pixman regions.
+
+    The rects are sorted top to bottom into bands that share the same top and bottom.
+    Within a band rects are sorted left to right and never overlap or touch,
+    and vertically adjacent bands with identical spans are merged.
+
+    Every operation writes into scratch storage owned by the region and swaps it in,
+    so once the buffers have grown to the working set size no allocations are made.
+*/
+class Region
+{
+public:
+    Region();
+    explicit Region(const RECT& rect);
+
+    void Clear();
+    void Reset(const RECT& rect);
+
+    // Replaces the region with the union of arbitrary, possibly overlapping rects
+    void Reset(const RECT* rects, size_t count);
+
+    bool IsEmpty() const;
+    RECT Extents() const;
+    int64_t Area() const;
+
+    const RECT* Rects() const;
+    size_t RectsCount() const;
+
+    bool Contains(POINT point) const;
+    bool Intersects(const RECT& rect) const;
+
+    void Union(const Region& other);
+    void Union(const RECT& rect);
+    void Union(const RECT* rects, size_t count);
+
+    void Intersect(const Region& other);
+    void Intersect(const RECT& rect);
+
+    void Subtract(const Region& other);
+    void Subtract(const RECT& rect);
+
+    void Translate(LONG dx, LONG dy);
+
+    // Same as Intersect, named for the common case of clipping to a surface
+    void Clip(const RECT& bounds);
+
+    bool operator==(const Region& other) const;
+    bool operator!=(const Region& other) const;
+
+private:
+    enum class Operation
+    {
+        Union,
+        Intersect,
+        Subtract
+    };
+
+    void Combine(const RECT* a, size_t countA, const RECT* b, size_t countB, Operation operation, std::vector<RECT>& out) const;
+
+    void BuildFromRects(const RECT* rects, size_t count, std::vector<RECT>& out);
+
+    void Commit(std::vector<RECT>& rects);
+
+    std::vector<RECT> mRects;
+    std::vector<RECT> mScratch;
+    std::vector<RECT> mBuild;
+    std::vector<RECT> mBuilt;
+    std::vector<RECT> mActive;
+    std::vector<LONG> mEdges;
+    RECT mExtents;
+};
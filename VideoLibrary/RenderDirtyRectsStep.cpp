@@ -20,19 +20,30 @@
 #include "pch.h"
 #include "VirtualDesktop.h"
 #include "RenderPointerTextureStep.h"
+#include "D3D11DynamicBufferDevice.h"
+#include "D3D11ViewDevice.h"
 #include "RenderDirtyRectsStep.h"
 
 RenderDirtyRectsStep::RenderDirtyRectsStep(
     std::shared_ptr<Frame> frame,
     RECT virtualDesktopBounds,
-    std::shared_ptr<std::vector<Vertex>> vertexBuffer,
+    std::shared_ptr<std::vector<PackedRect>> instanceBuffer,
+    std::shared_ptr<FramePlanner> planner,
     std::shared_ptr<ShaderCache> shaderCache,
+    std::shared_ptr<ViewCache> desktopViews,
+    std::shared_ptr<DynamicBufferRing> vertexRing,
+    std::shared_ptr<DynamicBuffer> constantBuffer,
     ID3D11Texture2D* sharedSurfacePtr,
     winrt::com_ptr<ID3D11RenderTargetView> renderTargetView)
     : mFrame{ frame }
     , mVirtualDesktopBounds{ virtualDesktopBounds }
-    , mVertexBuffer{ vertexBuffer }
+    , mInstanceBuffer{ instanceBuffer }
+    , mConstants{}
+    , mPlanner{ planner }
     , mShaderCache{ shaderCache }
+    , mDesktopViews{ desktopViews }
+    , mVertexRing{ vertexRing }
+    , mConstantBuffer{ constantBuffer }
     , mSharedSurfacePtr{ sharedSurfacePtr }
     , mRenderTargetView{ renderTargetView }
 {
@@ -41,9 +52,14 @@ RenderDirtyRectsStep::RenderDirtyRectsStep(
         throw std::exception("Null frame");
     }
 
-    if (mVertexBuffer == nullptr)
+    if (mInstanceBuffer == nullptr)
     {
-        throw std::exception("null vertex buffer");
+        throw std::exception("null instance buffer");
+    }
+
+    if (mPlanner == nullptr)
+    {
+        throw std::exception("null frame planner");
     }
 
     if (mShaderCache == nullptr)
@@ -51,6 +67,16 @@ RenderDirtyRectsStep::RenderDirtyRectsStep(
         throw std::exception("null shader cache");
     }
 
+    if (mDesktopViews == nullptr)
+    {
+        throw std::exception("null desktop view cache");
+    }
+
+    if (mVertexRing == nullptr || mConstantBuffer == nullptr)
+    {
+        throw std::exception("null dirty rect buffers");
+    }
+
     winrt::check_pointer(mSharedSurfacePtr);
     winrt::check_pointer(mRenderTargetView.get());
 }
@@ -61,7 +87,7 @@ RenderDirtyRectsStep::~RenderDirtyRectsStep()
 
 void RenderDirtyRectsStep::Perform()
 {
-    if (mFrame->DirtyRectsCount() == 0) {
+    if (mPlanner->DirtyRectsCount() == 0) {
         return;
     }
 
@@ -72,8 +98,8 @@ void RenderDirtyRectsStep::Perform()
 
 void RenderDirtyRectsStep::UpdateDirtyRects()
 {
-    // create dirty vertex buffer
-    mVertexBuffer->resize(mFrame->DirtyRectsCount() * g_VerticesPerRect);
+    // one instance per dirty rect, the vertex shader expands it to a quad
+    mInstanceBuffer->resize(mPlanner->DirtyRectsCount());
 
     D3D11_TEXTURE2D_DESC sharedSurfaceDesc;
     mSharedSurfacePtr->GetDesc(&sharedSurfaceDesc);
@@ -81,164 +107,23 @@ void RenderDirtyRectsStep::UpdateDirtyRects()
     D3D11_TEXTURE2D_DESC desktopImageDesc;
     mFrame->DesktopImage()->GetDesc(&desktopImageDesc);
 
-    // be careful with the types of these integers - they should be signed ints
-    // or else the below vertices position calculations will overflow
-    const LONG centerX = (LONG)sharedSurfaceDesc.Width / 2;
-    const LONG centerY = (LONG)sharedSurfaceDesc.Height / 2;
-    const LONG offsetX = mVirtualDesktopBounds.left;
-    const LONG offsetY = mVirtualDesktopBounds.top;
-
     const RECT desktopBounds = mFrame->DesktopMonitorBounds();
-    const LONG desktopWidth = desktopBounds.right - desktopBounds.left;
-    const LONG desktopHeight = desktopBounds.bottom - desktopBounds.top;
-
-    RECT* dirtyRects = mFrame->DirtyRects();
-
-    for (size_t i = 0; i < mFrame->DirtyRectsCount(); ++i) {
-    /*
-        Identity and unspecified:
-        2                4
-        +---------------+
-        |               |
-        |               |
-        +---------------+
-        1               3
-
-        90 CCW:
-        2        4
-        +--------+
-        |        |
-        |        |
-        |        |
-        |        |
-        +--------+
-        1        3
-
-
-        180 CCW:
-        4               1
-        +---------------+
-        |               |
-        |               |
-        +---------------+
-        2               3
-
-        270 CCW:
-        1        3
-        +--------+
-        |        |
-        |        |
-        |        |
-        |        |
-        +--------+
-        4        2
-
-    */
-        RECT dirtyRect = dirtyRects[i];
-        RECT rotatedRect = dirtyRects[i];
-
-        switch (mFrame->Rotation())
-        {
-        case DXGI_MODE_ROTATION_ROTATE90:
-            rotatedRect.left = desktopWidth - dirtyRect.bottom;
-            rotatedRect.top = dirtyRect.left;
-            rotatedRect.right = desktopWidth - dirtyRect.top;
-            rotatedRect.bottom = dirtyRect.right;
-            break;
-
-        case DXGI_MODE_ROTATION_ROTATE180:
-            rotatedRect.left = desktopWidth - dirtyRect.right;
-            rotatedRect.top = desktopHeight - dirtyRect.bottom;
-            rotatedRect.right = desktopWidth - dirtyRect.left;
-            rotatedRect.bottom = desktopHeight - dirtyRect.top;
-            break;
-
-        case DXGI_MODE_ROTATION_ROTATE270:
-            rotatedRect.left = dirtyRect.top;
-            rotatedRect.top = desktopHeight - dirtyRect.right;
-            rotatedRect.right = dirtyRect.bottom;
-            rotatedRect.bottom = desktopHeight - dirtyRect.left;
-            break;
-
-        case DXGI_MODE_ROTATION_IDENTITY:
-        case DXGI_MODE_ROTATION_UNSPECIFIED:
-        default:
-            break;
-        }
-
-        TexCoord bottomLeft = { dirtyRect.left / static_cast<FLOAT>(desktopImageDesc.Width), dirtyRect.bottom / static_cast<FLOAT>(desktopImageDesc.Height) };
-        TexCoord topLeft = { dirtyRect.left / static_cast<FLOAT>(desktopImageDesc.Width), dirtyRect.top / static_cast<FLOAT>(desktopImageDesc.Height) };
-        TexCoord bottomRight = { dirtyRect.right / static_cast<FLOAT>(desktopImageDesc.Width), dirtyRect.bottom / static_cast<FLOAT>(desktopImageDesc.Height) };
-        TexCoord topRight = { dirtyRect.right / static_cast<FLOAT>(desktopImageDesc.Width), dirtyRect.top / static_cast<FLOAT>(desktopImageDesc.Height) };
-
-        // set vertex buffer at [i]
-        auto vertices = mVertexBuffer->data() + i * g_VerticesPerRect;
-
-        switch (mFrame->Rotation()) {
-        case DXGI_MODE_ROTATION_IDENTITY:
-        case DXGI_MODE_ROTATION_UNSPECIFIED:
-
-            vertices[0].texCoord = bottomLeft;
-            vertices[1].texCoord = topLeft;
-            vertices[2].texCoord = bottomRight;
-            vertices[3].texCoord = vertices[2].texCoord;
-            vertices[4].texCoord = vertices[1].texCoord;
-            vertices[5].texCoord = topRight;
-            break;
-
-        case DXGI_MODE_ROTATION_ROTATE90:
-            vertices[0].texCoord = bottomRight;
-            vertices[1].texCoord = bottomLeft;
-            vertices[2].texCoord = topRight;
-            vertices[3].texCoord = vertices[2].texCoord;
-            vertices[4].texCoord = vertices[1].texCoord;
-            vertices[5].texCoord = topLeft;
-            break;
-
-        case DXGI_MODE_ROTATION_ROTATE180:
-            vertices[0].texCoord = topRight;
-            vertices[1].texCoord = bottomRight;
-            vertices[2].texCoord = topLeft;
-            vertices[3].texCoord = vertices[2].texCoord;
-            vertices[4].texCoord = vertices[1].texCoord;
-            vertices[5].texCoord = bottomLeft;
-            break;
-
-        case DXGI_MODE_ROTATION_ROTATE270:
-            vertices[0].texCoord = topLeft;
-            vertices[1].texCoord = topRight;
-            vertices[2].texCoord = bottomLeft;
-            vertices[3].texCoord = vertices[2].texCoord;
-            vertices[4].texCoord = vertices[1].texCoord;
-            vertices[5].texCoord = bottomRight;
-            break;
-
-        default:
-            throw std::exception("render dirty rects with unimplemented rotation");
-        }
-
-        // Set the vertices of the two triangles that make up the dirty rectangle
-        // The second triangle shares a side with the first triangle
-        // vertices proceed clockwise
-
-        // bottomLeft -> topLeft -> bottomRight
-        vertices[0].pos = { (rotatedRect.left + desktopBounds.left - offsetX - centerX) / static_cast<FLOAT>(centerX),
-            -1 * (rotatedRect.bottom + desktopBounds.top - offsetY - centerY) / static_cast<FLOAT>(centerY),
-            0.0f };
-        vertices[1].pos = { (rotatedRect.left + desktopBounds.left - offsetX - centerX) / static_cast<FLOAT>(centerX),
-            -1 * (rotatedRect.top + desktopBounds.top - offsetY - centerY) / static_cast<FLOAT>(centerY),
-            0.0f };
-        vertices[2].pos = { (rotatedRect.right + desktopBounds.left - offsetX - centerX) / static_cast<FLOAT>(centerX),
-            -1 * (rotatedRect.bottom + desktopBounds.top - offsetY - centerY) / static_cast<FLOAT>(centerY),
-            0.0f };
-
-        // bottomRight -> topLeft -> topRight
-        vertices[3].pos = vertices[2].pos;
-        vertices[4].pos = vertices[1].pos;
-        vertices[5].pos = { (rotatedRect.right + desktopBounds.left - offsetX - centerX) / static_cast<FLOAT>(centerX),
-            -1 * (rotatedRect.top + desktopBounds.top - offsetY - centerY) / static_cast<FLOAT>(centerY),
-            0.0f };
-    }
+
+    DirtyRectVertexLayout layout;
+    layout.ImageWidth = static_cast<LONG>(desktopImageDesc.Width);
+    layout.ImageHeight = static_cast<LONG>(desktopImageDesc.Height);
+    layout.OriginX = desktopBounds.left - mVirtualDesktopBounds.left;
+    layout.OriginY = desktopBounds.top - mVirtualDesktopBounds.top;
+    layout.TargetWidth = static_cast<LONG>(sharedSurfaceDesc.Width);
+    layout.TargetHeight = static_cast<LONG>(sharedSurfaceDesc.Height);
+
+    mConstants = MakePackedRectConstants(mFrame->Rotation(), layout);
+    PackDirtyRects(
+        mFrame->Rotation(),
+        mPlanner->DirtyRects(),
+        mPlanner->DirtyRectsCount(),
+        layout,
+        mInstanceBuffer->data());
 }
 
 void RenderDirtyRectsStep::RenderDirtyRects()
@@ -249,22 +134,9 @@ void RenderDirtyRectsStep::RenderDirtyRects()
     winrt::com_ptr<ID3D11DeviceContext> context;
     device->GetImmediateContext(context.put());
 
-    D3D11_TEXTURE2D_DESC srcTextureDesc;
-    mFrame->DesktopImage()->GetDesc(&srcTextureDesc);
-
-    // setup vertex buffer, vertex shader view, etc
-    D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc;
-    srvDesc.Format = srcTextureDesc.Format;
-    srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-    srvDesc.Texture2D.MostDetailedMip = srcTextureDesc.MipLevels - 1;
-    srvDesc.Texture2D.MipLevels = srcTextureDesc.MipLevels;
-    winrt::com_ptr<ID3D11ShaderResourceView> srView;
-    winrt::check_hresult(device->CreateShaderResourceView(
-        mFrame->DesktopImage().get(),
-        &srvDesc,
-        srView.put()
-    ));
-    auto srTemp = srView.get();
+    // duplication hands out the same few desktop images, their views are created once
+    auto srTemp = D3D11ViewDevice::ShaderResourceView(
+        mDesktopViews->View(mFrame->DesktopImage().get(), ViewKind::ShaderResource));
     ID3D11ShaderResourceView** srvPtr = &srTemp;
 
     auto rtv = mRenderTargetView.get();
@@ -277,34 +149,29 @@ void RenderDirtyRectsStep::RenderDirtyRects()
     const float blendFactor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
     context->OMSetBlendState(nullptr, blendFactor, 0xffffffff);
     context->OMSetRenderTargets(1, rtvPtr, nullptr);
-    context->VSSetShader(mShaderCache->VertexShader().get(), nullptr, 0);
+    context->VSSetShader(mShaderCache->InstancedRectVertexShader().get(), nullptr, 0);
     context->PSSetShader(mShaderCache->PixelShader().get(), nullptr, 0);
     context->PSSetShaderResources(0, 1, srvPtr);
     context->PSSetSamplers(0, 1, samplerPtr);
-    context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-
-    D3D11_BUFFER_DESC bufferDesc;
-    bufferDesc.Usage = D3D11_USAGE_DEFAULT;
-    bufferDesc.ByteWidth = static_cast<UINT>(mVertexBuffer->size() * sizeof(Vertex));
-    bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-    bufferDesc.CPUAccessFlags = 0;
-    bufferDesc.MiscFlags = 0;
-    bufferDesc.StructureByteStride = 0;
-
-    D3D11_SUBRESOURCE_DATA bufferData;
-    bufferData.pSysMem = reinterpret_cast<const void*>(mVertexBuffer->data());
-    bufferData.SysMemPitch = 0;
-    bufferData.SysMemSlicePitch = 0;
-
-    winrt::com_ptr<ID3D11Buffer> buffer;
-    winrt::check_hresult(device->CreateBuffer(&bufferDesc, &bufferData, buffer.put()));
-
-    constexpr UINT stride = sizeof(Vertex);
-    constexpr UINT offset = 0;
-    ID3D11Buffer* buf = buffer.get();
+    context->IASetInputLayout(mShaderCache->InstancedRectInputLayout().get());
+    context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+
+    // instances go into the persistent ring, no buffers are created per frame
+    const BufferSpan instances = mVertexRing->Write(
+        mInstanceBuffer->data(),
+        mInstanceBuffer->size() * sizeof(PackedRect),
+        sizeof(PackedRect));
+
+    const UINT stride = sizeof(PackedRect);
+    const UINT offset = static_cast<UINT>(instances.Offset);
+    ID3D11Buffer* buf = D3D11DynamicBufferDevice::Buffer(*instances.Buffer);
     ID3D11Buffer** bufAddr = &buf;
     context->IASetVertexBuffers(0, 1, bufAddr, &stride, &offset);
 
+    mVertexRing->Device().Update(*mConstantBuffer, &mConstants, sizeof(mConstants));
+    ID3D11Buffer* constantsBuffer = D3D11DynamicBufferDevice::Buffer(*mConstantBuffer);
+    context->VSSetConstantBuffers(0, 1, &constantsBuffer);
+
     D3D11_TEXTURE2D_DESC sharedSurfaceDesc;
     mSharedSurfacePtr->GetDesc(&sharedSurfaceDesc);
 
@@ -317,5 +184,6 @@ void RenderDirtyRectsStep::RenderDirtyRects()
     VP.TopLeftY = 0.0f;
     context->RSSetViewports(1, &VP);
 
-    context->Draw(static_cast<UINT>(mVertexBuffer->size()), 0);
+    // four vertex strip per rect
+    context->DrawInstanced(4, static_cast<UINT>(mInstanceBuffer->size()), 0, 0);
 }
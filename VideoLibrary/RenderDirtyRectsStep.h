@@ -22,16 +22,24 @@
 #include "DesktopMonitor.h"
 #include "ShaderCache.h"
 #include "Frame.h"
-#include "Vertex.h"
+#include "PackedRect.h"
+#include "DynamicBufferRing.h"
+#include "FramePlanner.h"
+#include "ViewCache.h"
 
 class RenderDirtyRectsStep : public RecordingStep
 {
 public:
+    // Draws the planner's dirty rects from the frame's desktop image
     RenderDirtyRectsStep(
         std::shared_ptr<Frame> frame,
         RECT virtualDesktopBounds,
-        std::shared_ptr<std::vector<Vertex>> vertexBuffer,
+        std::shared_ptr<std::vector<PackedRect>> instanceBuffer,
+        std::shared_ptr<FramePlanner> planner,
         std::shared_ptr<ShaderCache> shaderCache,
+        std::shared_ptr<ViewCache> desktopViews,
+        std::shared_ptr<DynamicBufferRing> vertexRing,
+        std::shared_ptr<DynamicBuffer> constantBuffer,
         ID3D11Texture2D* sharedSurfacePtr,
         winrt::com_ptr<ID3D11RenderTargetView> renderTargetView
         );
@@ -48,8 +56,13 @@ private:
 
     std::shared_ptr<Frame> mFrame;
     RECT mVirtualDesktopBounds;
-    std::shared_ptr<std::vector<Vertex>> mVertexBuffer;
+    std::shared_ptr<std::vector<PackedRect>> mInstanceBuffer;
+    PackedRectConstants mConstants;
+    std::shared_ptr<FramePlanner> mPlanner;
     std::shared_ptr<ShaderCache> mShaderCache;
+    std::shared_ptr<ViewCache> mDesktopViews;
+    std::shared_ptr<DynamicBufferRing> mVertexRing;
+    std::shared_ptr<DynamicBuffer> mConstantBuffer;
     ID3D11Texture2D* mSharedSurfacePtr;
     winrt::com_ptr<ID3D11RenderTargetView> mRenderTargetView;
 };
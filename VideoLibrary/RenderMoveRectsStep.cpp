@@ -21,14 +21,17 @@
 #include "DesktopMonitor.h"
 #include "RenderDirtyRectsStep.h"
 #include "RenderMoveRectsStep.h"
+#include "RotationTransform.h"
 
 
 RenderMoveRectsStep::RenderMoveRectsStep(
     std::shared_ptr<Frame> frame,
     RECT virtualDesktopBounds,
+    std::shared_ptr<MoveRectPlanner> planner,
     winrt::com_ptr<ID3D11Texture2D> stagingTexture,
     ID3D11Texture2D* sharedSurfacePtr)
     : mFrame { frame }
+    , mPlanner{ planner }
     , mVirtualDesktopBounds{ virtualDesktopBounds }
     , mStagingTexture{ stagingTexture }
     , mSharedSurfacePtr{ sharedSurfacePtr }
@@ -38,6 +41,11 @@ RenderMoveRectsStep::RenderMoveRectsStep(
         throw std::exception("null frame");
     }
 
+    if (mPlanner == nullptr)
+    {
+        throw std::exception("null move rect planner");
+    }
+
     winrt::check_pointer(mStagingTexture.get());
     winrt::check_pointer(mSharedSurfacePtr);
 }
@@ -53,14 +61,11 @@ void RenderMoveRectsStep::Perform()
         return;
     }
 
-    DXGI_OUTDUPL_MOVE_RECT* moveRects = mFrame->MoveRects();
     const LONG offsetX = mVirtualDesktopBounds.left;
     const LONG offsetY = mVirtualDesktopBounds.top;
 
     D3D11_TEXTURE2D_DESC desktopImageDesc;
     mFrame->DesktopImage()->GetDesc(&desktopImageDesc);
-    const LONG desktopWidth = (LONG)desktopImageDesc.Width;
-    const LONG desktopHeight = (LONG)desktopImageDesc.Height;
 
     winrt::com_ptr<ID3D11Device> device;
     mSharedSurfacePtr->GetDevice(device.put());
@@ -68,95 +73,46 @@ void RenderMoveRectsStep::Perform()
     winrt::com_ptr<ID3D11DeviceContext> context;
     device->GetImmediateContext(context.put());
 
-    for (size_t i = 0; i < mFrame->MoveRectsCount(); ++i) {
-        const DXGI_OUTDUPL_MOVE_RECT& moveRect = moveRects[i];
-
-        RECT srcRect{}, dstRect{};
-
-        // set src and dstRect based on rotation of output device
-        switch (mFrame->Rotation())
-        {
-        case DXGI_MODE_ROTATION_UNSPECIFIED:
-        case DXGI_MODE_ROTATION_IDENTITY:
-            srcRect.left = moveRect.SourcePoint.x;
-            srcRect.top = moveRect.SourcePoint.y;
-            srcRect.bottom = moveRect.SourcePoint.y + moveRect.DestinationRect.bottom - moveRect.DestinationRect.top;
-            srcRect.right = moveRect.SourcePoint.x + moveRect.DestinationRect.right - moveRect.DestinationRect.left;
-            dstRect = moveRect.DestinationRect;
-            break;
-
-        case DXGI_MODE_ROTATION_ROTATE90:
-            srcRect.left = desktopHeight - (moveRect.SourcePoint.y + moveRect.DestinationRect.bottom - moveRect.DestinationRect.top);
-            srcRect.top = moveRect.SourcePoint.x;
-            srcRect.right = desktopHeight - moveRect.SourcePoint.y;
-            srcRect.bottom = moveRect.SourcePoint.x + moveRect.DestinationRect.right - moveRect.DestinationRect.left;
-
-            dstRect.left = desktopHeight - moveRect.DestinationRect.bottom;
-            dstRect.top = moveRect.DestinationRect.left;
-            dstRect.right = desktopHeight - moveRect.DestinationRect.top;
-            dstRect.bottom = moveRect.DestinationRect.right;
-            break;
-
-        case DXGI_MODE_ROTATION_ROTATE180:
-            srcRect.left = desktopWidth - (moveRect.SourcePoint.x + moveRect.DestinationRect.right - moveRect.DestinationRect.left);
-            srcRect.top = desktopHeight - (moveRect.SourcePoint.y + moveRect.DestinationRect.bottom - moveRect.DestinationRect.top);
-            srcRect.right = desktopWidth - moveRect.SourcePoint.x;
-            srcRect.bottom = desktopHeight - moveRect.SourcePoint.y;
-
-            dstRect.left = desktopWidth - moveRect.DestinationRect.right;
-            dstRect.top = desktopHeight - moveRect.DestinationRect.bottom;
-            dstRect.right = desktopWidth - moveRect.DestinationRect.left;
-            dstRect.bottom = desktopHeight - moveRect.DestinationRect.top;
-            break;
-
-        case DXGI_MODE_ROTATION_ROTATE270:
-            srcRect.left = moveRect.SourcePoint.x;
-            srcRect.top = desktopWidth - (moveRect.SourcePoint.x + moveRect.DestinationRect.right - moveRect.DestinationRect.left);
-            srcRect.right = moveRect.SourcePoint.y + moveRect.DestinationRect.bottom - moveRect.DestinationRect.top;
-            srcRect.bottom = desktopWidth - moveRect.SourcePoint.x;
-
-            dstRect.left = moveRect.DestinationRect.top;
-            dstRect.top = desktopWidth - moveRect.DestinationRect.right;
-            dstRect.right = moveRect.DestinationRect.bottom;
-            dstRect.bottom = desktopWidth - moveRect.DestinationRect.left;
-            break;
-
-        default:
-            throw std::exception("Move rect rotation unimplemented");
-        }
-
-        // copy rect from shared surface to move surface, keeping same position
-        const auto desktopCoordinates = mFrame->DesktopMonitorBounds();
+    // set src and dstRect based on rotation of output device
+    const size_t moveRectsCount = mFrame->MoveRectsCount();
+    std::vector<RECT> srcRects(moveRectsCount);
+    std::vector<RECT> dstRects(moveRectsCount);
+    RotateMoveRects(
+        mFrame->Rotation(),
+        mFrame->MoveRects(),
+        moveRectsCount,
+        static_cast<LONG>(desktopImageDesc.Width),
+        static_cast<LONG>(desktopImageDesc.Height),
+        srcRects.data(),
+        dstRects.data());
+
+    mPlanner->Plan(srcRects.data(), dstRects.data(), moveRectsCount);
+
+    // the staging texture has the desktop image's size, staged rects keep their position in it
+    const auto desktopCoordinates = mFrame->DesktopMonitorBounds();
+    const LONG surfaceX = desktopCoordinates.left - offsetX;
+    const LONG surfaceY = desktopCoordinates.top - offsetY;
+    const MoveCopy* copies = mPlanner->Copies();
+    for (size_t i = 0; i < mPlanner->CopiesCount(); ++i)
+    {
+        const MoveCopy& copy = copies[i];
+        const bool fromStaging = copy.Kind == MoveCopyKind::StagingToSurface;
+        const bool toStaging = copy.Kind == MoveCopyKind::SurfaceToStaging;
+
         D3D11_BOX box;
-        box.left = desktopCoordinates.left + srcRect.left - offsetX;
-        box.right = desktopCoordinates.left + srcRect.right - offsetX;
-        box.top = desktopCoordinates.top + srcRect.top - offsetY;
-        box.bottom = desktopCoordinates.top + srcRect.bottom - offsetY;
+        box.left = copy.Source.left + (fromStaging ? 0 : surfaceX);
+        box.right = copy.Source.right + (fromStaging ? 0 : surfaceX);
+        box.top = copy.Source.top + (fromStaging ? 0 : surfaceY);
+        box.bottom = copy.Source.bottom + (fromStaging ? 0 : surfaceY);
         box.front = 0;
         box.back = 1;
 
         context->CopySubresourceRegion(
-            mStagingTexture.get(), 0,
-            srcRect.left,
-            srcRect.top,
-            0,
-            mSharedSurfacePtr, 0,
-            &box
-        );
-
-        // copy from move surface to new relative position in shared surface
-        box.left = srcRect.left;
-        box.right = srcRect.right;
-        box.top = srcRect.top;
-        box.bottom = srcRect.bottom;
-        box.front = 0;
-        box.back = 1;
-        context->CopySubresourceRegion(
-            mSharedSurfacePtr, 0,
-            desktopCoordinates.left + dstRect.left - offsetX,
-            desktopCoordinates.top + dstRect.top - offsetY,
+            toStaging ? mStagingTexture.get() : mSharedSurfacePtr, 0,
+            copy.Destination.x + (toStaging ? 0 : surfaceX),
+            copy.Destination.y + (toStaging ? 0 : surfaceY),
             0,
-            mStagingTexture.get(), 0,
+            fromStaging ? mStagingTexture.get() : mSharedSurfacePtr, 0,
             &box
         );
     }
@@ -20,6 +20,7 @@
 #pragma once
 
 #include "Frame.h"
+#include "MoveRectPlanner.h"
 #include "RecordingStep.h"
 
 class RenderMoveRectsStep : public RecordingStep
@@ -28,6 +29,7 @@ public:
     RenderMoveRectsStep(
         std::shared_ptr<Frame> frame,
         RECT virtualDesktopBounds,
+        std::shared_ptr<MoveRectPlanner> planner,
         winrt::com_ptr<ID3D11Texture2D> stagingTexture,
         ID3D11Texture2D* sharedSurfacePtr);
     
@@ -40,6 +42,7 @@ private:
     winrt::com_ptr<ID3D11Texture2D> mStagingTexture;
     ID3D11Texture2D* mSharedSurfacePtr;
     std::shared_ptr<Frame> mFrame;
+    std::shared_ptr<MoveRectPlanner> mPlanner;
     RECT mVirtualDesktopBounds;
 };
 
@@ -24,12 +24,24 @@
 #include "TextureToMediaSampleStep.h"
 #include "TexturePool.h"
 #include "Vertex.h"
+#include "D3D11DynamicBufferDevice.h"
+#include "PointerKernels.h"
+#include "CopyDamageStep.h"
+
+#include <array>
 
 RenderPointerTextureStep::RenderPointerTextureStep(
     std::shared_ptr<DesktopPointer> desktopPointer,
     std::shared_ptr<SharedSurface> sharedSurface,
     winrt::com_ptr<ID3D11Device> device,
     std::shared_ptr<ShaderCache> shaderCache,
+    std::shared_ptr<DynamicBufferRing> vertexRing,
+    std::shared_ptr<PointerTextureCache> textureCache,
+    std::shared_ptr<PointerMaskCache> maskCache,
+    std::shared_ptr<ViewCache> pointerViews,
+    std::shared_ptr<D3D11ReadbackDevice> readbackDevice,
+    std::shared_ptr<ReadbackRing> backgroundReadbacks,
+    std::shared_ptr<DamageHistory> damageHistory,
     winrt::com_ptr<TexturePool> texturePool,
     RECT virtualDesktopBounds,
     RECT desktopMonitorBounds)
@@ -37,6 +49,13 @@ RenderPointerTextureStep::RenderPointerTextureStep(
     , mSharedSurface{ sharedSurface }
     , mDesktopPointer{ desktopPointer }
     , mShaderCache{ shaderCache }
+    , mVertexRing{ vertexRing }
+    , mTextureCache{ textureCache }
+    , mMaskCache{ maskCache }
+    , mPointerViews{ pointerViews }
+    , mReadbackDevice{ readbackDevice }
+    , mBackgroundReadbacks{ backgroundReadbacks }
+    , mDamageHistory{ damageHistory }
     , mTexturePool{ texturePool }
     , mVirtualDesktopBounds{ virtualDesktopBounds }
     , mDesktopMonitorBounds{ desktopMonitorBounds }
@@ -52,6 +71,31 @@ RenderPointerTextureStep::RenderPointerTextureStep(
         throw std::exception("render pointer shader cache is null");
     }
 
+    if (mVertexRing == nullptr)
+    {
+        throw std::exception("render pointer vertex ring is null");
+    }
+
+    if (mTextureCache == nullptr || mMaskCache == nullptr)
+    {
+        throw std::exception("render pointer shape cache is null");
+    }
+
+    if (mPointerViews == nullptr)
+    {
+        throw std::exception("render pointer view cache is null");
+    }
+
+    if (mReadbackDevice == nullptr || mBackgroundReadbacks == nullptr)
+    {
+        throw std::exception("render pointer readbacks are null");
+    }
+
+    if (mDamageHistory == nullptr)
+    {
+        throw std::exception("render pointer damage history is null");
+    }
+
     winrt::check_pointer(mDevice.get());
     winrt::check_pointer(mTexturePool.get());
     winrt::check_pointer(mSharedSurface.get());
@@ -71,13 +115,21 @@ void RenderPointerTextureStep::Perform()
         return;
     }
     mSharedSurfacePtr = lock->TexturePtr();
-    // copy shared surface
     winrt::com_ptr<ID3D11DeviceContext> context;
     mDevice->GetImmediateContext(context.put());
 
-    winrt::com_ptr<ID3D11Texture2D> virtualDesktopCopy = mTexturePool->Acquire();
+    // copy what changed on the shared surface since the pooled texture was last used,
+    // including where the pointer was drawn on it then
+    std::shared_ptr<TexturePoolEntry> entry = mTexturePool->Acquire();
+    if (entry == nullptr)
+    {
+        // the encoder is behind and the pool dropped the frame
+        return;
+    }
+    winrt::com_ptr<ID3D11Texture2D> virtualDesktopCopy = entry->Texture();
 
-    context->CopyResource(virtualDesktopCopy.get(), lock->TexturePtr());
+    CopyDamageStep copyDamage{ lock->TexturePtr(), virtualDesktopCopy, mDamageHistory };
+    copyDamage.Perform();
 
     if (!mDesktopPointer->Visible())
     {
@@ -109,71 +161,44 @@ void RenderPointerTextureStep::Perform()
     else if (pos.y + shape.Height > desc.Height) {
         shape.Height = desc.Height - pos.y;
     }
+
+    RECT bounds{ pos.x, pos.y, pos.x + static_cast<LONG>(shape.Width), pos.y + static_cast<LONG>(shape.Height) };
+    winrt::com_ptr<ID3D11Texture2D> mouseTexture = this->MakePointerTexture(bounds);
+    if (mouseTexture == nullptr)
+    {
+        mResult = virtualDesktopCopy;
+        return;
+    }
+
     float centerX = (float)desc.Width / 2;
     float centerY = (float)desc.Height / 2;
-    float left = ((float)pos.x - centerX) / centerX;
-    float right = ((float)pos.x + (float)shape.Width - centerX) / centerX;
-    float top = -1.0f*((float)pos.y - centerY) / centerY;
-    float bottom = -1.0f*((float)pos.y + (float)shape.Height - centerY) / centerY;
+    float left = ((float)bounds.left - centerX) / centerX;
+    float right = ((float)bounds.right - centerX) / centerX;
+    float top = -1.0f*((float)bounds.top - centerY) / centerY;
+    float bottom = -1.0f*((float)bounds.bottom - centerY) / centerY;
 
     // Vertices for drawing whole texture
     // vertex coords are clock wise per triangle, texture coords are ccw
-    const std::vector<Vertex> vertices = {
+    const std::array<Vertex, 6> vertices = { {
         { { left, bottom, 0 },{ 0.0f, 1.0f } },
         { { left, top, 0 },{ 0.0f, 0.0f } },
         { { right, bottom, 0 },{ 1.0f, 1.0f } },
         { { right, bottom, 0 },{ 1.0f, 1.0f } },
         { { left, top, 0 },{ 0.0f, 0.0f } },
         { { right, top, 0 },{ 1.0f, 0.0f } },
-    };
-
-    winrt::com_ptr<ID3D11Texture2D> mouseTexture = this->MakePointerTexture();
-
-    // Set shader resource properties
-    D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc;
-    srvDesc.Format = desc.Format;
-    srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-    srvDesc.Texture2D.MostDetailedMip = desc.MipLevels - 1;
-    srvDesc.Texture2D.MipLevels = desc.MipLevels;
-    winrt::com_ptr<ID3D11ShaderResourceView> srView;
-    winrt::check_hresult(mDevice->CreateShaderResourceView(
-        mouseTexture.get(),
-        &srvDesc,
-        srView.put()
-    ));
-    auto srv = srView.get();
+    } };
+
+    // color pointer textures are reused while the shape stays the same, masked
+    // pointers are rewritten into the same texture
+    auto srv = D3D11ViewDevice::ShaderResourceView(mPointerViews->View(mouseTexture.get(), ViewKind::ShaderResource));
     ID3D11ShaderResourceView** srvPtr = &srv;
 
-    D3D11_BUFFER_DESC bufferDesc;
-    bufferDesc.Usage = D3D11_USAGE_DEFAULT;
-    bufferDesc.ByteWidth = sizeof(Vertex) * g_VerticesPerRect;
-    bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-    bufferDesc.CPUAccessFlags = 0;
-    bufferDesc.MiscFlags = 0;
-    bufferDesc.StructureByteStride = 0;
-
-    D3D11_SUBRESOURCE_DATA bufferData;
-    bufferData.pSysMem = reinterpret_cast<const void*>(vertices.data());
-    bufferData.SysMemPitch = 0;
-    bufferData.SysMemSlicePitch = 0;
-    // Create vertex buffer
-    winrt::com_ptr<ID3D11Buffer> mouseVertexBuffer;
-    winrt::check_hresult(mDevice->CreateBuffer(
-        &bufferDesc,
-        &bufferData,
-        mouseVertexBuffer.put()
-    ));
-
-    // TODO why create RTV per texture?? for now just do it but
-    // need to store RTV per texture in TexturePool
-
-    winrt::com_ptr<ID3D11RenderTargetView> rtv;
-    winrt::check_hresult(mDevice->CreateRenderTargetView(
-        virtualDesktopCopy.get(),
-        nullptr,
-        rtv.put()
-    ));
-    auto render = rtv.get();
+    const BufferSpan vertexSpan = mVertexRing->Write(
+        vertices.data(),
+        vertices.size() * sizeof(Vertex),
+        16);
+
+    auto render = entry->RenderTargetView();
     ID3D11RenderTargetView** rtvAddr = &render;
 
     auto sampler = mShaderCache->LinearSampler().get();
@@ -182,8 +207,8 @@ void RenderPointerTextureStep::Perform()
     // Set resources
     FLOAT BlendFactor[4] = { 0.f, 0.f, 0.f, 0.f };
     UINT stride = sizeof(Vertex);
-    UINT offset = 0;
-    auto buf = mouseVertexBuffer.get();
+    UINT offset = static_cast<UINT>(vertexSpan.Offset);
+    auto buf = D3D11DynamicBufferDevice::Buffer(*vertexSpan.Buffer);
     auto bufAddr = &buf;
     context->IASetVertexBuffers(0, 1, bufAddr, &stride, &offset);
     context->OMSetBlendState(mShaderCache->BlendState().get(), BlendFactor, 0xFFFFFFFF);
@@ -192,6 +217,8 @@ void RenderPointerTextureStep::Perform()
     context->PSSetShader(mShaderCache->PixelShader().get(), nullptr, 0);
     context->PSSetShaderResources(0, 1, srvPtr);
     context->PSSetSamplers(0, 1, samplerPtr);
+    // the dirty rect step leaves its instanced layout bound
+    context->IASetInputLayout(mShaderCache->VertexShaderInputLayout().get());
     context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
     D3D11_VIEWPORT VP;
@@ -205,6 +232,7 @@ void RenderPointerTextureStep::Perform()
 
     // Draw
     context->Draw(g_VerticesPerRect, 0);
+    CopyDamageStep::MarkOverlay(virtualDesktopCopy.get(), bounds);
 
     mResult = virtualDesktopCopy;
 }
@@ -214,7 +242,7 @@ winrt::com_ptr<ID3D11Texture2D> RenderPointerTextureStep::Result()
     return mResult;
 }
 
-winrt::com_ptr<ID3D11Texture2D> RenderPointerTextureStep::MakePointerTexture()
+winrt::com_ptr<ID3D11Texture2D> RenderPointerTextureStep::MakePointerTexture(RECT& bounds)
 {
     auto shapeInfo = mDesktopPointer->ShapeInfo();
 
@@ -223,7 +251,7 @@ winrt::com_ptr<ID3D11Texture2D> RenderPointerTextureStep::MakePointerTexture()
         return MakeColorPointerTexture();
     case DXGI_OUTDUPL_POINTER_SHAPE_TYPE_MONOCHROME:
     case DXGI_OUTDUPL_POINTER_SHAPE_TYPE_MASKED_COLOR:
-        return MakeMaskedPointerTexture();
+        return MakeMaskedPointerTexture(bounds);
     default:
         break;
     }
@@ -233,14 +261,26 @@ winrt::com_ptr<ID3D11Texture2D> RenderPointerTextureStep::MakePointerTexture()
 
 winrt::com_ptr<ID3D11Texture2D> RenderPointerTextureStep::MakeColorPointerTexture()
 {
+    // the shape has not changed since the texture was made
+    if (!mDesktopPointer->TextureStale() && mDesktopPointer->Texture() != nullptr)
+    {
+        return mDesktopPointer->Texture();
+    }
+
     auto shapeInfo = mDesktopPointer->ShapeInfo();
-    return MakeColorPointer(mDesktopPointer->PutBuffer(), shapeInfo.Width, shapeInfo.Height);
+    const byte* shape = mDesktopPointer->Buffer();
+
+    winrt::com_ptr<ID3D11Texture2D>* cached = mTextureCache->Find(shapeInfo, shape);
+    winrt::com_ptr<ID3D11Texture2D> texture = cached != nullptr ?
+        *cached :
+        mTextureCache->Insert(shapeInfo, shape, MakeColorPointer(shape, shapeInfo.Width, shapeInfo.Height));
+
+    mDesktopPointer->UpdateTexture(texture);
+    return texture;
 }
 
-winrt::com_ptr<ID3D11Texture2D> RenderPointerTextureStep::MakeMaskedPointerTexture()
+winrt::com_ptr<ID3D11Texture2D> RenderPointerTextureStep::MakeMaskedPointerTexture(RECT& bounds)
 {
-    winrt::com_ptr<ID3D11Device> device = mDevice;
-
     // TODO in multi monitor recording, will need to FIRST merge all desktop images and then draw the mouse
     auto pointerPos = mDesktopPointer->Position().Position;
     auto shapeInfo = mDesktopPointer->ShapeInfo();
@@ -256,9 +296,9 @@ winrt::com_ptr<ID3D11Texture2D> RenderPointerTextureStep::MakeMaskedPointerTextu
     UINT maskX = 0, maskY = 0;
 
     if (left < 0) {
-        left = 0;
         maskX = -left;
         width += left;
+        left = 0;
     }
     else if (left + width >(int)desc.Width) {
         width = desc.Width - left;
@@ -269,144 +309,119 @@ winrt::com_ptr<ID3D11Texture2D> RenderPointerTextureStep::MakeMaskedPointerTextu
     }
 
     if (top < 0) {
-        top = 0;
         maskY = -top;
         height += top;
+        top = 0;
     }
     else if (top + height >(int)desc.Height) {
         height = desc.Height - top;
     }
 
-    // create a new texture to copy the current desktop image under the cursor
-    D3D11_TEXTURE2D_DESC newDesc;
-    newDesc.Format = desc.Format;
-    newDesc.Width = width;
-    newDesc.Height = height;
-    newDesc.BindFlags = 0;
-    newDesc.Usage = D3D11_USAGE_STAGING;
-    newDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
-    newDesc.MiscFlags = 0;
-    newDesc.ArraySize = desc.ArraySize;
-    newDesc.SampleDesc = desc.SampleDesc;
-    newDesc.MipLevels = desc.MipLevels;
-
-    winrt::com_ptr<ID3D11Texture2D> desktopCopy;
-    winrt::check_hresult(device->CreateTexture2D(&newDesc, nullptr, desktopCopy.put()));
-
-    D3D11_BOX box;
-    box.left = left;
-    box.right = left + width;
-    box.top = top;
-    box.bottom = top + height;
-    box.front = 0;
-    box.back = 1;
-
-    winrt::com_ptr<ID3D11DeviceContext> context;
-    device->GetImmediateContext(context.put());
-    context->CopySubresourceRegion(
-        desktopCopy.get(),
-        0, 0, 0, 0,
-        mSharedSurfacePtr, 0, &box);
-
-    auto desktopSurface = desktopCopy.as<IDXGISurface>();
-    std::vector<UINT> dest;
-    dest.assign(width * height, 0);
-
-    DXGI_MAPPED_RECT mapped;
-    winrt::check_hresult(desktopSurface->Map(&mapped, DXGI_MAP_READ));
-
-    auto textureData = reinterpret_cast<UINT*>(mapped.pBits);
-    if (textureData == nullptr) {
+    if (width <= 0 || height <= 0) {
         return nullptr;
     }
 
-    auto maskData = mDesktopPointer->PutBuffer();
+    // Queue a copy of the desktop under the cursor and compose with a copy the GPU
+    // already finished, so the pointer lags by up to the ring's latency instead of
+    // stalling the frame. A new shape has nothing to fall back to and waits.
+    mReadbackDevice->Source(mSharedSurfacePtr);
+    mBackgroundReadbacks->Submit(ReadbackRequest{
+        RECT{ left, top, left + width, top + height },
+        POINT{ static_cast<LONG>(maskX), static_cast<LONG>(maskY) } });
+
+    const bool stale = mDesktopPointer->TextureStale() || mDesktopPointer->Texture() == nullptr;
+    ReadbackResult readback;
+    if (!mBackgroundReadbacks->Acquire(readback, stale)) {
+        // nothing finished yet, draw the last composed pointer where it was
+        bounds = mDesktopPointer->TextureBounds();
+        return mDesktopPointer->Texture();
+    }
+
+    const byte* maskData = mDesktopPointer->Buffer();
 
-    if (shapeInfo.Type == DXGI_OUTDUPL_POINTER_SHAPE_TYPE_MONOCHROME) {
-        MakeMonochromePointerBuffer(dest.data(), textureData, mapped.Pitch, maskData, shapeInfo.Pitch, width, height, maskX, maskY, shapeInfo.Height / 2);
-    } else if (shapeInfo.Type == DXGI_OUTDUPL_POINTER_SHAPE_TYPE_MASKED_COLOR) {
-        MakeMaskedColorPointerBuffer(dest.data(), textureData, mapped.Pitch, (UINT*)maskData, shapeInfo.Pitch, width, height, maskX, maskY);
+    // the desktop under the pointer changes every frame, only the decoded masks are reused.
+    // The shape is only looked up again when it changed since the last composed pointer.
+    const DecodedPointerShape* mask = stale ? nullptr : mMaskCache->Last();
+    if (mask == nullptr) {
+        mask = mMaskCache->Find(shapeInfo, maskData);
+    }
+    if (mask == nullptr) {
+        DecodedPointerShape decoded;
+        DecodePointerShape(shapeInfo, maskData, decoded);
+        mask = &mMaskCache->Insert(shapeInfo, maskData, std::move(decoded));
     }
 
-    winrt::check_hresult(desktopSurface->Unmap());
+    const RECT& region = readback.Request.Region;
+    const UINT readbackWidth = static_cast<UINT>(region.right - region.left);
+    const UINT readbackHeight = static_cast<UINT>(region.bottom - region.top);
 
-    return MakeColorPointer((BYTE*)dest.data(), width, height);
+    std::vector<UINT> dest;
+    dest.assign(readbackWidth * readbackHeight, 0);
+
+    ComposeDecodedPointer(
+        dest.data(),
+        reinterpret_cast<const UINT*>(readback.Pixels.Data),
+        static_cast<UINT>(readback.Pixels.Pitch),
+        *mask,
+        readbackWidth,
+        readbackHeight,
+        static_cast<UINT>(readback.Request.Origin.x),
+        static_cast<UINT>(readback.Request.Origin.y));
+
+    mBackgroundReadbacks->Release();
+
+    winrt::com_ptr<ID3D11Texture2D> texture = UpdateMaskedPointer((BYTE*)dest.data(), readbackWidth, readbackHeight);
+    mDesktopPointer->UpdateTexture(texture, region);
+    bounds = region;
+    return texture;
 }
 
-void RenderPointerTextureStep::MakeMonochromePointerBuffer(UINT * dest, const UINT * colorData, UINT colorPitch, byte * maskData, UINT maskPitch, UINT width, UINT height, UINT maskX, UINT maskY, UINT maskHeight)
+winrt::com_ptr<ID3D11Texture2D> RenderPointerTextureStep::UpdateMaskedPointer(const byte* data, UINT width, UINT height)
 {
-    /*
-    The pointer type is a monochrome mouse pointer, which is a monochrome bitmap.
-    The bitmap's size is specified by width and height in a
-    1 bits per pixel (bpp) device independent bitmap (DIB) format AND maskBit that is
-    followed by another 1 bpp DIB format XOR maskBit of the same size.
-
-    if is mono must divide height by 2 to get to the xor maskBit
-    */
-    for (UINT j = 0; j < height; ++j) {
-
-        BYTE maskBit = 0x80 >> (maskX % 8);
-        for (UINT i = 0; i < width; ++i) {
-            // maskData contains two 1bpp images
-            auto dstIndex = j * width + i;
-            auto colorIndex = j * colorPitch / sizeof(UINT) + i;
-
-            auto maskAndIndex = ((maskY + j) * maskPitch) + ((maskX + i) / 8);
-            auto maskXorIndex = ((maskY + j + maskHeight) * maskPitch) + ((maskX + i) / 8);
-
-            auto andMaskBit = maskData[maskAndIndex] & maskBit;
-            auto xorMaskBit = maskData[maskXorIndex] & maskBit;
-
-            auto andMask = andMaskBit ? 0xFFFFFFFF : 0xFF000000;
-            auto xorMask = xorMaskBit ? 0x00FFFFFF : 0x00000000;
-
-            auto color = colorData[colorIndex];
-
-            dest[dstIndex] = (color & andMask) ^ xorMask;
-
-            if (maskBit == 1) {
-                maskBit = 0x80;
-            }
-            else {
-                maskBit = maskBit >> 1;
-            }
-        }
+    // The composed pointer changes with the desktop under it on every readback. It is
+    // written to the same dynamic texture while the size stays the same, so the view
+    // cached for the texture stays valid.
+    winrt::com_ptr<ID3D11Texture2D> texture = mDesktopPointer->Texture();
+    D3D11_TEXTURE2D_DESC desc{};
+    if (texture != nullptr)
+    {
+        texture->GetDesc(&desc);
     }
-}
 
-void RenderPointerTextureStep::MakeMaskedColorPointerBuffer(UINT * dest, const UINT * colorData, UINT colorPitch, UINT * maskData, UINT maskPitch, UINT width, UINT height, UINT maskX, UINT maskY)
-{
-    /*
-    The pointer type is a masked color mouse pointer.
-    A masked color mouse pointer is a 32 bpp ARGB format bitmap with the maskBit value in the alpha bits.
-    The only allowed maskBit values are 0 and 0xFF. When the maskBit value is 0,
-    the RGB value should replace the screen pixel. When the maskBit value is 0xFF,
-    an XOR operation is performed on the RGB value and the screen pixel;
-    the result replaces the screen pixel.
-
-    */
-    for (UINT j = 0; j < height; ++j) {
-        for (UINT i = 0; i < width; ++i) {
-
-            auto destIndex = (j*width) + i;
-            auto colorIndex = (j*colorPitch / sizeof(UINT)) + i;
-            auto maskIndex = ((j + maskY)*maskPitch / sizeof(UINT)) + (i + maskX);
-
-            auto color = colorData[colorIndex];
-            auto mask = maskData[maskIndex];
-
-            if (mask & 0xFF000000) {
-                auto newColor = 0xFF000000 | (color ^ mask);
-                dest[destIndex] = newColor;
-            }
-            else {
-                dest[destIndex] = 0xFF000000 | mask;
-            }
-        }
+    if (texture == nullptr || desc.Usage != D3D11_USAGE_DYNAMIC || desc.Width != width || desc.Height != height)
+    {
+        desc = D3D11_TEXTURE2D_DESC{};
+        desc.Width = width;
+        desc.Height = height;
+        desc.MipLevels = 1;
+        desc.ArraySize = 1;
+        desc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
+        desc.SampleDesc.Count = 1;
+        desc.Usage = D3D11_USAGE_DYNAMIC;
+        desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+        desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+        texture = nullptr;
+        winrt::check_hresult(mDevice->CreateTexture2D(&desc, nullptr, texture.put()));
     }
+
+    winrt::com_ptr<ID3D11DeviceContext> context;
+    mDevice->GetImmediateContext(context.put());
+
+    // discard hands out fresh memory while earlier draws still read the old contents
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    winrt::check_hresult(context->Map(texture.get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped));
+    const size_t rowSize = static_cast<size_t>(width) * 4;
+    for (UINT y = 0; y < height; ++y)
+    {
+        std::memcpy(static_cast<byte*>(mapped.pData) + y * mapped.RowPitch, data + y * rowSize, rowSize);
+    }
+    context->Unmap(texture.get(), 0);
+
+    return texture;
 }
 
-winrt::com_ptr<ID3D11Texture2D> RenderPointerTextureStep::MakeColorPointer(byte * data, int width, int height)
+winrt::com_ptr<ID3D11Texture2D> RenderPointerTextureStep::MakeColorPointer(const byte * data, int width, int height)
 {
     winrt::com_ptr<ID3D11Device> device = mDevice;
 
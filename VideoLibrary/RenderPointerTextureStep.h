@@ -23,6 +23,18 @@
 #include "ShaderCache.h"
 #include "TexturePool.h"
 #include "SharedSurface.h"
+#include "DynamicBufferRing.h"
+#include "PointerKernels.h"
+#include "PointerShapeCache.h"
+#include "D3D11ReadbackDevice.h"
+#include "ReadbackRing.h"
+#include "DamageHistory.h"
+
+// Textures of color pointers, drawn as they are
+typedef PointerShapeCache<winrt::com_ptr<ID3D11Texture2D>> PointerTextureCache;
+
+// Masks of monochrome and masked color pointers, composed with the desktop every frame
+typedef PointerShapeCache<DecodedPointerShape> PointerMaskCache;
 
 class RenderPointerTextureStep : public RecordingStep
 {
@@ -32,6 +44,13 @@ public:
         std::shared_ptr<SharedSurface> sharedSurface,
         winrt::com_ptr<ID3D11Device> device,
         std::shared_ptr<ShaderCache> shaderCache,
+        std::shared_ptr<DynamicBufferRing> vertexRing,
+        std::shared_ptr<PointerTextureCache> textureCache,
+        std::shared_ptr<PointerMaskCache> maskCache,
+        std::shared_ptr<ViewCache> pointerViews,
+        std::shared_ptr<D3D11ReadbackDevice> readbackDevice,
+        std::shared_ptr<ReadbackRing> backgroundReadbacks,
+        std::shared_ptr<DamageHistory> damageHistory,
         winrt::com_ptr<TexturePool> texturePool,
         RECT virtualDesktopBounds,
         RECT desktopMonitorBounds);
@@ -43,17 +62,24 @@ public:
     winrt::com_ptr<ID3D11Texture2D> Result();
 
 private:
-    winrt::com_ptr<ID3D11Texture2D> MakePointerTexture();
+    // bounds is where the texture is drawn, masked pointers can move it
+    winrt::com_ptr<ID3D11Texture2D> MakePointerTexture(RECT& bounds);
     winrt::com_ptr<ID3D11Texture2D> MakeColorPointerTexture();
-    winrt::com_ptr<ID3D11Texture2D> MakeMaskedPointerTexture();
+    winrt::com_ptr<ID3D11Texture2D> MakeMaskedPointerTexture(RECT& bounds);
 
-    void MakeMonochromePointerBuffer(UINT* dest, const UINT * colorData, UINT colorPitch, byte* maskData, UINT maskPitch, UINT width, UINT height, UINT maskX, UINT maskY, UINT maskHeight);
-    void MakeMaskedColorPointerBuffer(UINT * dest, const UINT * colorData, UINT colorPitch, UINT * maskData, UINT maskPitch, UINT width, UINT height, UINT maskX, UINT maskY);
-    winrt::com_ptr<ID3D11Texture2D> MakeColorPointer(byte* data, int width, int height);
+    winrt::com_ptr<ID3D11Texture2D> MakeColorPointer(const byte* data, int width, int height);
+    winrt::com_ptr<ID3D11Texture2D> UpdateMaskedPointer(const byte* data, UINT width, UINT height);
 
     winrt::com_ptr<ID3D11Device> mDevice;
     std::shared_ptr<DesktopPointer> mDesktopPointer;
     std::shared_ptr<ShaderCache> mShaderCache;
+    std::shared_ptr<DynamicBufferRing> mVertexRing;
+    std::shared_ptr<PointerTextureCache> mTextureCache;
+    std::shared_ptr<PointerMaskCache> mMaskCache;
+    std::shared_ptr<ViewCache> mPointerViews;
+    std::shared_ptr<D3D11ReadbackDevice> mReadbackDevice;
+    std::shared_ptr<ReadbackRing> mBackgroundReadbacks;
+    std::shared_ptr<DamageHistory> mDamageHistory;
     std::shared_ptr<SharedSurface> mSharedSurface;
     winrt::com_ptr<TexturePool> mTexturePool;
 
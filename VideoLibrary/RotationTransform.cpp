@@ -0,0 +1,59 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "RotationTransform.h"
+
+void RotateRects(
+    DXGI_MODE_ROTATION rotation,
+    const RECT* rects,
+    size_t count,
+    LONG imageWidth,
+    LONG imageHeight,
+    RECT* result)
+{
+    VisitRotation(rotation, [&](auto transform) {
+        decltype(transform)::Rects(rects, count, imageWidth, imageHeight, result);
+    });
+}
+
+void RotateMoveRects(
+    DXGI_MODE_ROTATION rotation,
+    const DXGI_OUTDUPL_MOVE_RECT* moveRects,
+    size_t count,
+    LONG imageWidth,
+    LONG imageHeight,
+    RECT* sourceRects,
+    RECT* destinationRects)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        const DXGI_OUTDUPL_MOVE_RECT& moveRect = moveRects[i];
+        sourceRects[i] = RECT{
+            moveRect.SourcePoint.x,
+            moveRect.SourcePoint.y,
+            moveRect.SourcePoint.x + moveRect.DestinationRect.right - moveRect.DestinationRect.left,
+            moveRect.SourcePoint.y + moveRect.DestinationRect.bottom - moveRect.DestinationRect.top };
+        destinationRects[i] = moveRect.DestinationRect;
+    }
+
+    VisitRotation(rotation, [&](auto transform) {
+        decltype(transform)::Rects(sourceRects, count, imageWidth, imageHeight, sourceRects);
+        decltype(transform)::Rects(destinationRects, count, imageWidth, imageHeight, destinationRects);
+    });
+}
@@ -0,0 +1,250 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+//
+// RotationTransform.h
+// Maps rects from the duplicated desktop image into desktop coordinates
+// for each output rotation. The desktop image is always in the monitor's
+// native orientation, so a rotated monitor reports its dirty and move rects
+// rotated relative to the desktop they are composed onto.
+//
+// Each rotation is its own specialization so callers dispatch once per frame
+// and the per rect loops contain no branches.
+//
+
+#pragma once
+#include "PlatformTypes.h"
+#include "Simd.h"
+#include "Vertex.h"
+
+// Image dimension added to a rotated coordinate
+enum RotationExtent
+{
+    NoExtent,
+    WidthExtent,
+    HeightExtent
+};
+
+enum RectCorner
+{
+    BottomLeftCorner = 0,
+    TopLeftCorner = 1,
+    BottomRightCorner = 2,
+    TopRightCorner = 3
+};
+
+// Every rotation shuffles the four coordinates of a rect, negates some of
+// them and adds an image dimension. LaneShift k means out[i] = in[(i + k) % 4].
+template <int LaneShift, bool NegateX, bool NegateY, RotationExtent ExtentX, RotationExtent ExtentY,
+    RectCorner BottomLeft, RectCorner TopLeft, RectCorner BottomRight, RectCorner TopRight>
+struct RotationTransformBase
+{
+    // 90 and 270 degree rotations exchange the width and height of the desktop
+    static constexpr bool SwapsDimensions = LaneShift % 2 != 0;
+
+    // The source corner drawn at each corner of the rotated rect
+    static constexpr RectCorner SourceCorners[4] = { BottomLeft, TopLeft, BottomRight, TopRight };
+
+    // width and height are the dimensions of the desktop image
+    static RECT Rect(const RECT& rect, LONG width, LONG height)
+    {
+        const LONG in[4] = { rect.left, rect.top, rect.right, rect.bottom };
+        const LONG offsetX = Extent<ExtentX>(width, height);
+        const LONG offsetY = Extent<ExtentY>(width, height);
+        LONG out[4];
+        for (int i = 0; i < 4; ++i)
+        {
+            const bool isX = i % 2 == 0;
+            const LONG value = in[(i + LaneShift) % 4];
+            const bool negate = isX ? NegateX : NegateY;
+            out[i] = (negate ? -value : value) + (isX ? offsetX : offsetY);
+        }
+        return RECT{ out[0], out[1], out[2], out[3] };
+    }
+
+    // Texture coordinates of the rotated rect's corners, indexed by RectCorner
+    static void TexCoords(const RECT& rect, float inverseWidth, float inverseHeight, TexCoord corners[4])
+    {
+        const float left = rect.left * inverseWidth;
+        const float top = rect.top * inverseHeight;
+        const float right = rect.right * inverseWidth;
+        const float bottom = rect.bottom * inverseHeight;
+        const TexCoord source[4] = {
+            { left, bottom },
+            { left, top },
+            { right, bottom },
+            { right, top }
+        };
+
+        for (int i = 0; i < 4; ++i)
+        {
+            corners[i] = source[SourceCorners[i]];
+        }
+    }
+
+    static void Rects(const RECT* rects, size_t count, LONG width, LONG height, RECT* result)
+    {
+        size_t i = 0;
+#if defined(SIMD_SSE2) || defined(SIMD_NEON)
+        static_assert(sizeof(RECT) == 4 * sizeof(int32_t), "RECT must be four 32 bit coordinates");
+        const RECT offsetRect = Rect(RECT{ 0, 0, 0, 0 }, width, height);
+        const int32_t offset[4] = { offsetRect.left, offsetRect.top, offsetRect.right, offsetRect.bottom };
+        const int32_t sign[4] = { NegateX ? -1 : 0, NegateY ? -1 : 0, NegateX ? -1 : 0, NegateY ? -1 : 0 };
+#if defined(SIMD_SSE2)
+        const __m128i offsetLanes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(offset));
+        const __m128i signLanes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sign));
+        for (; i < count; ++i)
+        {
+            __m128i lanes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rects + i));
+            lanes = Shuffle(lanes);
+            // (x ^ -1) - (-1) == -x, lanes with a zero sign pass through
+            lanes = _mm_sub_epi32(_mm_xor_si128(lanes, signLanes), signLanes);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(result + i), _mm_add_epi32(lanes, offsetLanes));
+        }
+#else
+        const int32x4_t offsetLanes = vld1q_s32(offset);
+        const int32x4_t signLanes = vld1q_s32(sign);
+        for (; i < count; ++i)
+        {
+            int32x4_t lanes = vld1q_s32(reinterpret_cast<const int32_t*>(rects + i));
+            lanes = Shuffle(lanes);
+            lanes = vsubq_s32(veorq_s32(lanes, signLanes), signLanes);
+            vst1q_s32(reinterpret_cast<int32_t*>(result + i), vaddq_s32(lanes, offsetLanes));
+        }
+#endif
+#endif
+        for (; i < count; ++i)
+        {
+            result[i] = Rect(rects[i], width, height);
+        }
+    }
+
+private:
+    template <RotationExtent Which>
+    static LONG Extent(LONG width, LONG height)
+    {
+        return Which == WidthExtent ? width : (Which == HeightExtent ? height : 0);
+    }
+
+#if defined(SIMD_SSE2)
+    static __m128i Shuffle(__m128i lanes)
+    {
+        if constexpr (LaneShift == 1)
+        {
+            return _mm_shuffle_epi32(lanes, _MM_SHUFFLE(0, 3, 2, 1));
+        }
+        else if constexpr (LaneShift == 2)
+        {
+            return _mm_shuffle_epi32(lanes, _MM_SHUFFLE(1, 0, 3, 2));
+        }
+        else if constexpr (LaneShift == 3)
+        {
+            return _mm_shuffle_epi32(lanes, _MM_SHUFFLE(2, 1, 0, 3));
+        }
+        else
+        {
+            return lanes;
+        }
+    }
+#elif defined(SIMD_NEON)
+    static int32x4_t Shuffle(int32x4_t lanes)
+    {
+        if constexpr (LaneShift == 0)
+        {
+            return lanes;
+        }
+        else
+        {
+            return vextq_s32(lanes, lanes, LaneShift);
+        }
+    }
+#endif
+};
+
+template <DXGI_MODE_ROTATION Rotation>
+struct RotationTransform;
+
+// {left, top, right, bottom}
+template <>
+struct RotationTransform<DXGI_MODE_ROTATION_IDENTITY>
+    : RotationTransformBase<0, false, false, NoExtent, NoExtent,
+        BottomLeftCorner, TopLeftCorner, BottomRightCorner, TopRightCorner>
+{
+};
+
+// {height - bottom, left, height - top, right}
+template <>
+struct RotationTransform<DXGI_MODE_ROTATION_ROTATE90>
+    : RotationTransformBase<3, true, false, HeightExtent, NoExtent,
+        BottomRightCorner, BottomLeftCorner, TopRightCorner, TopLeftCorner>
+{
+};
+
+// {width - right, height - bottom, width - left, height - top}
+template <>
+struct RotationTransform<DXGI_MODE_ROTATION_ROTATE180>
+    : RotationTransformBase<2, true, true, WidthExtent, HeightExtent,
+        TopRightCorner, BottomRightCorner, TopLeftCorner, BottomLeftCorner>
+{
+};
+
+// {top, width - right, bottom, width - left}
+template <>
+struct RotationTransform<DXGI_MODE_ROTATION_ROTATE270>
+    : RotationTransformBase<1, false, true, NoExtent, WidthExtent,
+        TopLeftCorner, TopRightCorner, BottomLeftCorner, BottomRightCorner>
+{
+};
+
+// Calls visitor with the transform for the rotation, unspecified is treated as identity
+template <typename Visitor>
+decltype(auto) VisitRotation(DXGI_MODE_ROTATION rotation, Visitor&& visitor)
+{
+    switch (rotation)
+    {
+    case DXGI_MODE_ROTATION_ROTATE90:
+        return visitor(RotationTransform<DXGI_MODE_ROTATION_ROTATE90>{});
+    case DXGI_MODE_ROTATION_ROTATE180:
+        return visitor(RotationTransform<DXGI_MODE_ROTATION_ROTATE180>{});
+    case DXGI_MODE_ROTATION_ROTATE270:
+        return visitor(RotationTransform<DXGI_MODE_ROTATION_ROTATE270>{});
+    case DXGI_MODE_ROTATION_IDENTITY:
+    case DXGI_MODE_ROTATION_UNSPECIFIED:
+    default:
+        return visitor(RotationTransform<DXGI_MODE_ROTATION_IDENTITY>{});
+    }
+}
+
+// Rotates count rects from desktop image into desktop coordinates
+void RotateRects(
+    DXGI_MODE_ROTATION rotation,
+    const RECT* rects,
+    size_t count,
+    LONG imageWidth,
+    LONG imageHeight,
+    RECT* result);
+
+// Rotates the source and destination rects of count move rects
+void RotateMoveRects(
+    DXGI_MODE_ROTATION rotation,
+    const DXGI_OUTDUPL_MOVE_RECT* moveRects,
+    size_t count,
+    LONG imageWidth,
+    LONG imageHeight,
+    RECT* sourceRects,
+    RECT* destinationRects);
@@ -27,7 +27,7 @@ ScreenDuplicator::ScreenDuplicator(
     : mDevice {monitor.Adapter().Device() }
     , mOutput{ monitor.Output()}
     , mDesktopPointer{ desktopPointer }
-    , mRectBuffer{ std::make_shared<std::vector<byte>>() }
+    , mMetadataPool{ std::make_shared<FrameMetadataPool>() }
     , mOutputIndex{ monitor.OutputIndex() }
 {
     HRESULT hr = mOutput->DuplicateOutput(mDevice.get(), mDupl.put());
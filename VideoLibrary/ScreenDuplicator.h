@@ -22,6 +22,7 @@
 #include "DesktopPointer.h"
 #include "DisplayAdapter.h"
 #include "DesktopMonitor.h"
+#include "FrameMetadataPool.h"
 
 class ScreenDuplicator
 {
@@ -42,7 +43,7 @@ public:
 
     winrt::com_ptr<IDXGIOutputDuplication> Duplication() const { return mDupl; }
 
-    std::shared_ptr<std::vector<byte>> Buffer() const { return mRectBuffer; };
+    std::shared_ptr<FrameMetadataPool> MetadataPool() const { return mMetadataPool; }
 
     ~ScreenDuplicator();
 
@@ -54,8 +55,8 @@ private:
     std::wstring mOutputName;
     int mOutputIndex;
 
-    // Holds move and dirty rects
-    std::shared_ptr<std::vector<byte>> mRectBuffer;
+    // Holds move and dirty rects, one block per frame in flight
+    std::shared_ptr<FrameMetadataPool> mMetadataPool;
 
     std::shared_ptr<DesktopPointer> mDesktopPointer;
 };
\ No newline at end of file
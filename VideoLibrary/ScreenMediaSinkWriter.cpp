@@ -152,6 +152,11 @@ void ScreenMediaSinkWriter::Begin()
 }
 
 void ScreenMediaSinkWriter::SignalGap()
+{
+    SignalGap(std::chrono::high_resolution_clock::now());
+}
+
+void ScreenMediaSinkWriter::SignalGap(std::chrono::high_resolution_clock::time_point gapTime)
 {
     std::lock_guard<std::mutex> lock{ mMutex };
     if (!mIsWriting)
@@ -159,8 +164,7 @@ void ScreenMediaSinkWriter::SignalGap()
         throw std::bad_function_call();
     }
 
-    auto frameCaptureTime = std::chrono::high_resolution_clock::now();
-    auto frameTime = (frameCaptureTime - mWriteStartTime).count() / 100;
+    auto frameTime = (gapTime - mWriteStartTime).count() / 100;
 
     mSinkWriter->SendStreamTick(mVideoStreamIndex, frameTime);
 }
@@ -178,6 +182,11 @@ void ScreenMediaSinkWriter::ResetDevice(winrt::com_ptr<ID3D11Device> device)
 }
 
 void ScreenMediaSinkWriter::WriteSample(IMFSample* sample)
+{
+    WriteSample(sample, std::chrono::high_resolution_clock::now());
+}
+
+void ScreenMediaSinkWriter::WriteSample(IMFSample* sample, std::chrono::high_resolution_clock::time_point captureTime)
 {
     std::lock_guard<std::mutex> lock{ mMutex };
     if (!mIsWriting)
@@ -190,8 +199,7 @@ void ScreenMediaSinkWriter::WriteSample(IMFSample* sample)
 
     if (sampleType == MFMediaType_Video)
     {
-        auto frameCaptureTime = std::chrono::high_resolution_clock::now();
-        auto frameTime = (frameCaptureTime - mWriteStartTime).count() / 100;
+        auto frameTime = (captureTime - mWriteStartTime).count() / 100;
 
         winrt::check_hresult(sample->SetSampleTime(frameTime));
         winrt::check_hresult(sample->SetSampleDuration(mVideoFrameDuration));
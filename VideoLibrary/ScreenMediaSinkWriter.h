@@ -32,10 +32,17 @@ public:
 
     void SignalGap();
 
+    // Tells the encoder no video follows until the next sample, timed like WriteSample
+    void SignalGap(std::chrono::high_resolution_clock::time_point gapTime);
+
     void ResetDevice(winrt::com_ptr<ID3D11Device> device);
 
     void WriteSample(IMFSample* sample);
 
+    // Times a video sample by when it was captured instead of when it is written,
+    // for samples that waited in a queue
+    void WriteSample(IMFSample* sample, std::chrono::high_resolution_clock::time_point captureTime);
+
     void End();
 
     virtual ~ScreenMediaSinkWriter();
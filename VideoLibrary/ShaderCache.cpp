@@ -54,6 +54,34 @@ void ShaderCache::Initialize(winrt::com_ptr<ID3D11Device> device)
     device->GetImmediateContext(context.put());
     context->IASetInputLayout(mVertexShaderInputLayout.get());
 
+    // create the instanced dirty rect vertex shader
+    const auto instancedRectShaderArraySize = ARRAYSIZE(g_InstancedRectVertexShaderRawData);
+    winrt::check_hresult(device->CreateVertexShader(
+        g_InstancedRectVertexShaderRawData,
+        instancedRectShaderArraySize,
+        nullptr,
+        mInstancedRectVertexShader.put())
+    );
+
+    // One PackedRect per instance, the vertex id selects the corner
+    // Name                 Index   Mask Register SysValue  Format   Used
+    // -------------------- ----- ------ -------- -------- ------- ------
+    // SOURCE                   0   xyzw        0     NONE    uint   xyzw
+    // DESTINATION              0   xyzw        1     NONE    uint   xyzw
+    // SV_VertexID              0   x           2   VERTID    uint   x
+    //
+    const std::vector<D3D11_INPUT_ELEMENT_DESC> instancedRectDesc = {
+        D3D11_INPUT_ELEMENT_DESC{ "SOURCE", 0, DXGI_FORMAT_R16G16B16A16_UINT, 0, 0, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+        D3D11_INPUT_ELEMENT_DESC{ "DESTINATION", 0, DXGI_FORMAT_R16G16B16A16_UINT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 }
+    };
+    winrt::check_hresult(device->CreateInputLayout(
+        instancedRectDesc.data(),
+        static_cast<UINT>(instancedRectDesc.size()),
+        g_InstancedRectVertexShaderRawData,
+        instancedRectShaderArraySize,
+        mInstancedRectInputLayout.put()
+    ));
+
     // create pixel shader
     auto pixelShaderArraySize = ARRAYSIZE(g_PixelShaderRawData);
     winrt::check_hresult(device->CreatePixelShader(
@@ -110,6 +138,16 @@ winrt::com_ptr<ID3D11InputLayout> ShaderCache::VertexShaderInputLayout()
     return mVertexShaderInputLayout;
 }
 
+winrt::com_ptr<ID3D11VertexShader> ShaderCache::InstancedRectVertexShader()
+{
+    return mInstancedRectVertexShader;
+}
+
+winrt::com_ptr<ID3D11InputLayout> ShaderCache::InstancedRectInputLayout()
+{
+    return mInstancedRectInputLayout;
+}
+
 winrt::com_ptr<ID3D11PixelShader> ShaderCache::PixelShader()
 {
     return mPixelShader;
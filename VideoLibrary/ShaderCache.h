@@ -30,6 +30,11 @@ public:
 
     winrt::com_ptr<ID3D11InputLayout> VertexShaderInputLayout();
 
+    // Expands one PackedRect instance into a quad
+    winrt::com_ptr<ID3D11VertexShader> InstancedRectVertexShader();
+
+    winrt::com_ptr<ID3D11InputLayout> InstancedRectInputLayout();
+
     winrt::com_ptr<ID3D11PixelShader> PixelShader();
 
     winrt::com_ptr<ID3D11SamplerState> LinearSampler();
@@ -42,6 +47,8 @@ private:
 
     winrt::com_ptr<ID3D11VertexShader> mVertexShader;
     winrt::com_ptr<ID3D11InputLayout> mVertexShaderInputLayout;
+    winrt::com_ptr<ID3D11VertexShader> mInstancedRectVertexShader;
+    winrt::com_ptr<ID3D11InputLayout> mInstancedRectInputLayout;
     winrt::com_ptr<ID3D11PixelShader> mPixelShader;
     winrt::com_ptr<ID3D11SamplerState> mLinearSampler;
     winrt::com_ptr<ID3D11BlendState> mBlendState;
@@ -21,13 +21,19 @@
 #include "SharedSurface.h"
 
 SharedSurface::SharedSurface(winrt::com_ptr<ID3D11Device> device, int width, int height)
+    : SharedSurface(device, width, height, std::make_shared<RotatingKeys>())
+{
+}
+
+SharedSurface::SharedSurface(winrt::com_ptr<ID3D11Device> device, int width, int height, std::shared_ptr<RotatingKeys> rotatingKeys)
     : mDevice{ device }
     , mSharedSurface{ nullptr }
     , mMutex { nullptr }
-    , mRotatingKeys { new RotatingKeys }
+    , mRotatingKeys { rotatingKeys }
     , mWidth{ width }
     , mHeight{ height }
 {
+    winrt::check_pointer(mRotatingKeys.get());
     D3D11_TEXTURE2D_DESC desc;
     RtlZeroMemory(&desc, sizeof(D3D11_TEXTURE2D_DESC));
     desc.Width = static_cast<UINT>(width);
@@ -25,6 +25,9 @@ class SharedSurface
 {
 public:
     SharedSurface(winrt::com_ptr<ID3D11Device> device, int width, int height);
+
+    // Pass RotatingKeys{ 0, 0 } when more than two devices write to the surface
+    SharedSurface(winrt::com_ptr<ID3D11Device> device, int width, int height, std::shared_ptr<RotatingKeys> rotatingKeys);
     SharedSurface(winrt::com_ptr<ID3D11Device> device, winrt::com_ptr<ID3D11Texture2D> texture, std::shared_ptr<RotatingKeys> rotatingKeys, int width, int height);
 
     winrt::com_ptr<ID3D11Device> Device() const { return mDevice; }
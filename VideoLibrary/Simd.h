@@ -0,0 +1,72 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+//
+// Simd.h
+// Selects the vector instruction set available at compile time.
+// SSE2 is always present on x86 and x64, NEON on ARM64.
+// Code without either falls back to scalar loops.
+// AVX2 is compiled in on x86 and x64 but has to be checked with SimdHasAvx2()
+// before use, functions using it are marked with SIMD_TARGET_AVX2.
+//
+
+#pragma once
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define SIMD_SSE2 1
+#include <emmintrin.h>
+
+#define SIMD_AVX2 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define SIMD_TARGET_AVX2
+#else
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+inline bool SimdHasAvx2()
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+    {
+        return false;
+    }
+
+    // the OS has to save the YMM registers too
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 6) != 6)
+    {
+        return false;
+    }
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#elif defined(_M_ARM64) || defined(__ARM_NEON)
+#define SIMD_NEON 1
+#include <arm_neon.h>
+#endif
@@ -0,0 +1,426 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "MpmcQueue.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// What the stage in front does when a stage's queue is full
+enum class StageOverflow
+{
+    // wait for the stage to take an item
+    Block,
+
+    // drop the item that did not fit
+    DropNewest,
+
+    // drop the oldest queued item to make room
+    DropOldest
+};
+
+struct StageOptions
+{
+    // Items queued for the stage at most
+    size_t QueueCapacity = 2;
+
+    StageOverflow Overflow = StageOverflow::Block;
+};
+
+struct StageStats
+{
+    std::string Name;
+
+    uint64_t Processed;
+
+    // Items the stage turned down, they go no further
+    uint64_t Rejected;
+
+    // Items dropped at the stage's full queue
+    uint64_t Dropped;
+
+    // Queued items now, at most, and on average when an item was queued
+    size_t Depth;
+    size_t PeakDepth;
+    double MeanDepth;
+
+    // Time running items, waiting for an item, and the stage in front spent
+    // blocked on the full queue
+    std::chrono::nanoseconds Busy;
+    std::chrono::nanoseconds Starved;
+    std::chrono::nanoseconds Blocked;
+};
+
+/*
+    Runs the stages of a frame on their own threads with bounded queues between
+    them, so while one frame is encoded the next is composed and the one after
+    captured. Frame latency is then set by the slowest stage instead of the sum.
+
+    Every queue has one producer and one consumer. It is the lock-free MpmcQueue
+    because DropOldest has the producer take the oldest item back out. Threads
+    only lock to sleep when a queue is empty, or full under Block.
+
+    Stages are added before Start. Submit feeds the first stage and is called
+    from one thread. Stop lets every queued item through and joins the threads.
+*/
+template<typename Item>
+class StagedExecutor
+{
+public:
+    // Returns false to turn the item down
+    using Stage = std::function<bool(Item&)>;
+
+    StagedExecutor()
+        : mRunning{ false }
+        , mStopped{ false }
+    {
+    }
+
+    StagedExecutor(const StagedExecutor&) = delete;
+    StagedExecutor& operator=(const StagedExecutor&) = delete;
+
+    ~StagedExecutor()
+    {
+        Stop();
+    }
+
+    void AddStage(std::string name, Stage stage, StageOptions options = {})
+    {
+        if (mRunning || mStopped)
+        {
+            throw std::logic_error("stages are added before the executor starts");
+        }
+
+        if (!stage)
+        {
+            throw std::invalid_argument("null stage");
+        }
+
+        if (options.QueueCapacity == 0)
+        {
+            throw std::invalid_argument("stage queue capacity must not be zero");
+        }
+
+        mStages.emplace_back(std::make_unique<StageState>(std::move(name), std::move(stage), options));
+    }
+
+    void Start()
+    {
+        if (mRunning || mStopped)
+        {
+            throw std::logic_error("the executor starts once");
+        }
+
+        if (mStages.empty())
+        {
+            throw std::logic_error("the executor has no stages");
+        }
+
+        mRunning = true;
+        for (size_t i = 0; i < mStages.size(); ++i)
+        {
+            mStages[i]->Thread = std::thread{ [this, i]() { Run(i); } };
+        }
+    }
+
+    // False when the item was dropped at the first queue or the executor is not running
+    bool Submit(Item item)
+    {
+        if (!mRunning)
+        {
+            return false;
+        }
+
+        return Push(*mStages.front(), item);
+    }
+
+    void Stop()
+    {
+        if (!mRunning)
+        {
+            return;
+        }
+
+        mRunning = false;
+        mStopped = true;
+        Finish(*mStages.front());
+        for (auto& stage : mStages)
+        {
+            stage->Thread.join();
+        }
+    }
+
+    std::vector<StageStats> Stats() const
+    {
+        std::vector<StageStats> stats;
+        for (const auto& stage : mStages)
+        {
+            StageStats stageStats{};
+            stageStats.Name = stage->Name;
+            stageStats.Processed = stage->Processed.load(std::memory_order_relaxed);
+            stageStats.Rejected = stage->Rejected.load(std::memory_order_relaxed);
+            stageStats.Dropped = stage->Dropped.load(std::memory_order_relaxed);
+            stageStats.Depth = stage->Depth.load(std::memory_order_relaxed);
+            stageStats.PeakDepth = stage->PeakDepth.load(std::memory_order_relaxed);
+            const uint64_t queued = stage->Queued.load(std::memory_order_relaxed);
+            stageStats.MeanDepth = queued != 0 ? static_cast<double>(stage->DepthSum.load(std::memory_order_relaxed)) / queued : 0.0;
+            stageStats.Busy = std::chrono::nanoseconds{ stage->Busy.load(std::memory_order_relaxed) };
+            stageStats.Starved = std::chrono::nanoseconds{ stage->Starved.load(std::memory_order_relaxed) };
+            stageStats.Blocked = std::chrono::nanoseconds{ stage->Blocked.load(std::memory_order_relaxed) };
+            stats.push_back(stageStats);
+        }
+        return stats;
+    }
+
+private:
+    struct StageState
+    {
+        StageState(std::string name, Stage run, StageOptions options)
+            : Name{ std::move(name) }
+            , Run{ std::move(run) }
+            , Options{ options }
+            , Input{ options.QueueCapacity }
+        {
+        }
+
+        // Whether a queued item or the end of the input can be seen
+        bool Ready() const
+        {
+            return Depth.load(std::memory_order_acquire) != 0 || UpstreamDone.load(std::memory_order_acquire);
+        }
+
+        bool HasRoom() const
+        {
+            return Depth.load(std::memory_order_acquire) < Options.QueueCapacity;
+        }
+
+        std::string Name;
+        Stage Run;
+        StageOptions Options;
+
+        // Rounded up to a power of two, Depth keeps the configured capacity
+        MpmcQueue<Item> Input;
+        std::atomic<size_t> Depth{ 0 };
+        std::atomic<bool> UpstreamDone{ false };
+
+        std::mutex WaitMutex;
+        std::condition_variable Changed;
+        std::atomic<uint32_t> Waiters{ 0 };
+
+        std::atomic<uint64_t> Processed{ 0 };
+        std::atomic<uint64_t> Rejected{ 0 };
+        std::atomic<uint64_t> Dropped{ 0 };
+        std::atomic<uint64_t> Queued{ 0 };
+        std::atomic<uint64_t> DepthSum{ 0 };
+        std::atomic<size_t> PeakDepth{ 0 };
+        std::atomic<int64_t> Busy{ 0 };
+        std::atomic<int64_t> Starved{ 0 };
+        std::atomic<int64_t> Blocked{ 0 };
+
+        std::thread Thread;
+    };
+
+    static int64_t Since(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Wakes the threads sleeping on the stage's queue, if any
+    static void Notify(StageState& stage)
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (stage.Waiters.load(std::memory_order_relaxed) != 0)
+        {
+            {
+                std::lock_guard<std::mutex> lock{ stage.WaitMutex };
+            }
+            stage.Changed.notify_all();
+        }
+    }
+
+    template<typename Predicate>
+    static void Wait(StageState& stage, Predicate ready)
+    {
+        std::unique_lock<std::mutex> lock{ stage.WaitMutex };
+        stage.Waiters.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        stage.Changed.wait(lock, ready);
+        stage.Waiters.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // Counts the item in only when it fits the configured capacity
+    static bool TryQueue(StageState& stage, Item& item)
+    {
+        const size_t capacity = stage.Options.QueueCapacity;
+        size_t depth = stage.Depth.load(std::memory_order_relaxed);
+        do
+        {
+            if (depth == capacity)
+            {
+                return false;
+            }
+        } while (!stage.Depth.compare_exchange_weak(depth, depth + 1, std::memory_order_acq_rel));
+
+        // the queue holds at least the capacity, a push only fails while the
+        // consumer is between claiming and emptying a cell
+        while (!stage.Input.TryPush(std::move(item)))
+        {
+            std::this_thread::yield();
+        }
+
+        stage.Queued.fetch_add(1, std::memory_order_relaxed);
+        stage.DepthSum.fetch_add(depth + 1, std::memory_order_relaxed);
+        size_t peak = stage.PeakDepth.load(std::memory_order_relaxed);
+        while (depth + 1 > peak && !stage.PeakDepth.compare_exchange_weak(peak, depth + 1, std::memory_order_relaxed))
+        {
+        }
+
+        Notify(stage);
+        return true;
+    }
+
+    static bool TryTake(StageState& stage, Item& item)
+    {
+        if (stage.Depth.load(std::memory_order_acquire) == 0 || !stage.Input.TryPop(item))
+        {
+            return false;
+        }
+
+        stage.Depth.fetch_sub(1, std::memory_order_acq_rel);
+        Notify(stage);
+        return true;
+    }
+
+    static bool Push(StageState& stage, Item& item)
+    {
+        if (TryQueue(stage, item))
+        {
+            return true;
+        }
+
+        switch (stage.Options.Overflow)
+        {
+        case StageOverflow::DropOldest:
+        {
+            Item oldest;
+            while (!TryQueue(stage, item))
+            {
+                if (TryTake(stage, oldest))
+                {
+                    stage.Dropped.fetch_add(1, std::memory_order_relaxed);
+                    oldest = Item{};
+                }
+            }
+            return true;
+        }
+        case StageOverflow::Block:
+        {
+            const auto start = std::chrono::steady_clock::now();
+            do
+            {
+                Wait(stage, [&stage]() { return stage.HasRoom(); });
+            } while (!TryQueue(stage, item));
+            stage.Blocked.fetch_add(Since(start), std::memory_order_relaxed);
+            return true;
+        }
+        case StageOverflow::DropNewest:
+        default:
+            stage.Dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    }
+
+    // False once the stage in front finished and everything it queued was taken
+    static bool Pop(StageState& stage, Item& item)
+    {
+        if (TryTake(stage, item))
+        {
+            return true;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        for (;;)
+        {
+            Wait(stage, [&stage]() { return stage.Ready(); });
+            if (TryTake(stage, item))
+            {
+                stage.Starved.fetch_add(Since(start), std::memory_order_relaxed);
+                return true;
+            }
+
+            if (stage.UpstreamDone.load(std::memory_order_acquire) && stage.Depth.load(std::memory_order_acquire) == 0)
+            {
+                stage.Starved.fetch_add(Since(start), std::memory_order_relaxed);
+                return false;
+            }
+        }
+    }
+
+    static void Finish(StageState& stage)
+    {
+        stage.UpstreamDone.store(true, std::memory_order_release);
+        Notify(stage);
+    }
+
+    void Run(size_t index)
+    {
+        StageState& stage = *mStages[index];
+        StageState* next = index + 1 < mStages.size() ? mStages[index + 1].get() : nullptr;
+
+        Item item;
+        while (Pop(stage, item))
+        {
+            const auto start = std::chrono::steady_clock::now();
+            const bool accepted = stage.Run(item);
+            stage.Busy.fetch_add(Since(start), std::memory_order_relaxed);
+            stage.Processed.fetch_add(1, std::memory_order_relaxed);
+
+            if (!accepted)
+            {
+                stage.Rejected.fetch_add(1, std::memory_order_relaxed);
+            }
+            else if (next != nullptr)
+            {
+                Push(*next, item);
+            }
+
+            // let go of what the item holds before waiting for the next one
+            item = Item{};
+        }
+
+        if (next != nullptr)
+        {
+            Finish(*next);
+        }
+    }
+
+    std::vector<std::unique_ptr<StageState>> mStages;
+    bool mRunning;
+    bool mStopped;
+};
@@ -0,0 +1,296 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "pch.h"
+#include "StepGraph.h"
+
+#include <algorithm>
+
+void StepContext::Check(size_t port, bool write) const
+{
+    const bool output = std::find(mOutputs.begin(), mOutputs.end(), port) != mOutputs.end();
+    const bool input = std::find(mInputs.begin(), mInputs.end(), port) != mInputs.end();
+    if (write ? !output : !(input || output))
+    {
+        throw std::logic_error("step " + mName + (write ? " writes" : " reads") + " a port it did not declare");
+    }
+}
+
+StepGraph::StepGraph()
+{
+}
+
+StepGraph::~StepGraph()
+{
+}
+
+void StepGraph::AddStep(std::string name, std::vector<StepPortId> inputs, std::vector<StepPortId> outputs, Step step, StepOptions options)
+{
+    Insert(mSteps.size(), std::move(name), std::move(inputs), std::move(outputs), std::move(step), options);
+}
+
+void StepGraph::InsertBefore(const std::string& next, std::string name, std::vector<StepPortId> inputs, std::vector<StepPortId> outputs, Step step, StepOptions options)
+{
+    Insert(Find(next), std::move(name), std::move(inputs), std::move(outputs), std::move(step), options);
+}
+
+void StepGraph::InsertAfter(const std::string& previous, std::string name, std::vector<StepPortId> inputs, std::vector<StepPortId> outputs, Step step, StepOptions options)
+{
+    Insert(Find(previous) + 1, std::move(name), std::move(inputs), std::move(outputs), std::move(step), options);
+}
+
+void StepGraph::RemoveStep(const std::string& name)
+{
+    std::vector<std::unique_ptr<StepState>> steps;
+    const size_t removed = Find(name);
+    for (size_t i = 0; i < mSteps.size(); ++i)
+    {
+        if (i != removed)
+        {
+            steps.push_back(std::move(mSteps[i]));
+        }
+    }
+
+    // the steps after it may read what it wrote
+    try
+    {
+        Validate(steps);
+    }
+    catch (...)
+    {
+        steps.insert(steps.begin() + removed, std::move(mSteps[removed]));
+        mSteps = std::move(steps);
+        throw;
+    }
+
+    mSteps = std::move(steps);
+}
+
+bool StepGraph::HasStep(const std::string& name) const
+{
+    return std::any_of(mSteps.begin(), mSteps.end(), [&name](const auto& step) { return step->Name == name; });
+}
+
+bool StepGraph::Run()
+{
+    return RunSteps(0);
+}
+
+bool StepGraph::RunFrom(const std::string& name)
+{
+    return RunSteps(Find(name));
+}
+
+std::vector<StepTiming> StepGraph::Timings() const
+{
+    std::vector<StepTiming> timings;
+    for (const auto& step : mSteps)
+    {
+        timings.push_back(step->Timing);
+    }
+    return timings;
+}
+
+const StepGraph::PortState& StepGraph::PortAt(size_t index) const
+{
+    if (index >= mPorts.size())
+    {
+        throw std::invalid_argument("the port is not in this graph");
+    }
+
+    return mPorts[index];
+}
+
+StepGraph::PortState& StepGraph::PortAt(size_t index)
+{
+    return const_cast<PortState&>(static_cast<const StepGraph*>(this)->PortAt(index));
+}
+
+void StepGraph::Insert(size_t position, std::string name, std::vector<StepPortId> inputs, std::vector<StepPortId> outputs, Step step, StepOptions options)
+{
+    if (!step)
+    {
+        throw std::invalid_argument("null step");
+    }
+
+    if (HasStep(name))
+    {
+        throw std::invalid_argument("the graph already has a step named " + name);
+    }
+
+    auto state = std::make_unique<StepState>();
+    state->Name = std::move(name);
+    for (StepPortId input : inputs)
+    {
+        state->Inputs.push_back(input.Index);
+        PortAt(input.Index);
+    }
+    for (StepPortId output : outputs)
+    {
+        state->Outputs.push_back(output.Index);
+        PortAt(output.Index);
+    }
+    state->Function = std::move(step);
+    state->Options = options;
+    state->SeenVersions.resize(state->Inputs.size());
+    state->HasRun = false;
+    state->Timing = StepTiming{};
+    state->Timing.Name = state->Name;
+
+    std::vector<std::unique_ptr<StepState>> steps;
+    for (size_t i = 0; i <= mSteps.size(); ++i)
+    {
+        if (i == position)
+        {
+            steps.push_back(std::move(state));
+        }
+        if (i < mSteps.size())
+        {
+            steps.push_back(std::move(mSteps[i]));
+        }
+    }
+
+    try
+    {
+        Validate(steps);
+    }
+    catch (...)
+    {
+        steps.erase(steps.begin() + position);
+        mSteps = std::move(steps);
+        throw;
+    }
+
+    mSteps = std::move(steps);
+}
+
+size_t StepGraph::Find(const std::string& name) const
+{
+    for (size_t i = 0; i < mSteps.size(); ++i)
+    {
+        if (mSteps[i]->Name == name)
+        {
+            return i;
+        }
+    }
+
+    throw std::invalid_argument("the graph has no step named " + name);
+}
+
+void StepGraph::Validate(const std::vector<std::unique_ptr<StepState>>& steps) const
+{
+    std::vector<bool> writtenByAny(mPorts.size(), false);
+    for (const auto& step : steps)
+    {
+        for (size_t output : step->Outputs)
+        {
+            writtenByAny[output] = true;
+        }
+    }
+
+    // a port some step writes has to be written before it is read, ports no step
+    // writes are set by the owner of the graph
+    std::vector<bool> written(mPorts.size(), false);
+    for (const auto& step : steps)
+    {
+        for (size_t input : step->Inputs)
+        {
+            if (writtenByAny[input] && !written[input])
+            {
+                throw std::logic_error("step " + step->Name + " reads " + mPorts[input].Name + " before a step writes it");
+            }
+        }
+
+        for (size_t output : step->Outputs)
+        {
+            written[output] = true;
+        }
+    }
+}
+
+bool StepGraph::InputsUnchanged(const StepState& step) const
+{
+    for (size_t i = 0; i < step.Inputs.size(); ++i)
+    {
+        if (mPorts[step.Inputs[i]].Version != step.SeenVersions[i])
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool StepGraph::RunSteps(size_t first)
+{
+    // also when a step throws, so values like locks do not outlive the run
+    struct RunPortsReset
+    {
+        StepGraph& Graph;
+        ~RunPortsReset() { Graph.ResetRunPorts(); }
+    } reset{ *this };
+
+    for (size_t i = first; i < mSteps.size(); ++i)
+    {
+        StepState& step = *mSteps[i];
+        if (step.Options.SkipUnchanged && step.HasRun && InputsUnchanged(step))
+        {
+            ++step.Timing.Skipped;
+            continue;
+        }
+
+        StepContext context{ *this, step.Inputs, step.Outputs, step.Name };
+        const auto start = std::chrono::steady_clock::now();
+        const bool carryOn = step.Function(context);
+        const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+
+        ++step.Timing.Runs;
+        step.Timing.Total += elapsed;
+        step.Timing.Last = elapsed;
+        step.Timing.Max = (std::max)(step.Timing.Max, elapsed);
+
+        if (!carryOn)
+        {
+            // runs again next time, whatever its inputs
+            ++step.Timing.Stopped;
+            step.HasRun = false;
+            return false;
+        }
+
+        // after the step, so a step that writes its own input does not run again for it
+        for (size_t input = 0; input < step.Inputs.size(); ++input)
+        {
+            step.SeenVersions[input] = mPorts[step.Inputs[input]].Version;
+        }
+        step.HasRun = true;
+    }
+
+    return true;
+}
+
+void StepGraph::ResetRunPorts()
+{
+    for (size_t i = mPorts.size(); i-- > 0;)
+    {
+        if (mPorts[i].Lifetime == PortLifetime::Run)
+        {
+            mPorts[i].Value = mPorts[i].Initial;
+        }
+    }
+}
@@ -0,0 +1,255 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+//
+// StepGraph.h
+// The steps of a frame, built once and run in order for every frame. Steps
+// declare the typed ports they read and write, so a step can be skipped when
+// none of its inputs changed, and optional steps like scaling or overlays can
+// be inserted between two others without changing the code that built the
+// graph. Every step that runs is timed.
+//
+// A graph is run by one thread at a time.
+//
+
+#pragma once
+
+#include <any>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <typeindex>
+#include <vector>
+
+struct StepPortId
+{
+    size_t Index = (std::numeric_limits<size_t>::max)();
+};
+
+// A value of type T passed between steps
+template<typename T>
+struct StepPort : StepPortId
+{
+};
+
+enum class PortLifetime
+{
+    // the value is kept from run to run
+    Kept,
+
+    // the value only lives for one run, it goes back to its initial value when the
+    // run ends. Ports are reset in the reverse order they were made, like locals.
+    Run
+};
+
+struct StepOptions
+{
+    // Skip the step while none of its inputs were written since it last ran
+    bool SkipUnchanged = false;
+};
+
+struct StepTiming
+{
+    std::string Name;
+
+    uint64_t Runs;
+
+    // Runs skipped because the inputs did not change, and runs the step ended early
+    uint64_t Skipped;
+    uint64_t Stopped;
+
+    std::chrono::nanoseconds Total;
+    std::chrono::nanoseconds Last;
+    std::chrono::nanoseconds Max;
+};
+
+class StepGraph;
+
+// What a running step sees of the graph, only the ports it declared
+class StepContext
+{
+public:
+    template<typename T>
+    const T& Read(StepPort<T> port) const;
+
+    // Marks the port written, steps reading it run again
+    template<typename T>
+    T& Write(StepPort<T> port);
+
+    template<typename T>
+    void Write(StepPort<T> port, T value)
+    {
+        Write(port) = std::move(value);
+    }
+
+private:
+    friend class StepGraph;
+
+    StepContext(StepGraph& graph, const std::vector<size_t>& inputs, const std::vector<size_t>& outputs, const std::string& name)
+        : mGraph{ graph }
+        , mInputs{ inputs }
+        , mOutputs{ outputs }
+        , mName{ name }
+    {
+    }
+
+    void Check(size_t port, bool write) const;
+
+    StepGraph& mGraph;
+    const std::vector<size_t>& mInputs;
+    const std::vector<size_t>& mOutputs;
+    const std::string& mName;
+};
+
+class StepGraph
+{
+public:
+    // Returns false to end the run, the steps after it do not run
+    using Step = std::function<bool(StepContext&)>;
+
+    StepGraph();
+    ~StepGraph();
+
+    StepGraph(const StepGraph&) = delete;
+    StepGraph& operator=(const StepGraph&) = delete;
+
+    // Makes the port, or finds the one with that name. Looking a port up as another type throws.
+    template<typename T>
+    StepPort<T> Port(const std::string& name, PortLifetime lifetime = PortLifetime::Kept, T initial = T{})
+    {
+        StepPort<T> port;
+        for (size_t i = 0; i < mPorts.size(); ++i)
+        {
+            if (mPorts[i].Name == name)
+            {
+                if (mPorts[i].Type != std::type_index{ typeid(T) })
+                {
+                    throw std::logic_error("port " + name + " holds another type");
+                }
+
+                port.Index = i;
+                return port;
+            }
+        }
+
+        port.Index = mPorts.size();
+        mPorts.push_back(PortState{ name, std::type_index{ typeid(T) }, lifetime, initial, std::move(initial), 0 });
+        return port;
+    }
+
+    template<typename T>
+    const T& Value(StepPort<T> port) const
+    {
+        return *std::any_cast<T>(&PortAt(port.Index).Value);
+    }
+
+    // Writes the port from outside the graph, steps reading it run again
+    template<typename T>
+    void Set(StepPort<T> port, T value)
+    {
+        *Written<T>(port.Index) = std::move(value);
+    }
+
+    // Adds the step after all the others. Every input has to be written by a step
+    // before it, or by no step at all when the owner of the graph sets it.
+    void AddStep(std::string name, std::vector<StepPortId> inputs, std::vector<StepPortId> outputs, Step step, StepOptions options = {});
+
+    void InsertBefore(const std::string& next, std::string name, std::vector<StepPortId> inputs, std::vector<StepPortId> outputs, Step step, StepOptions options = {});
+    void InsertAfter(const std::string& previous, std::string name, std::vector<StepPortId> inputs, std::vector<StepPortId> outputs, Step step, StepOptions options = {});
+
+    void RemoveStep(const std::string& name);
+
+    bool HasStep(const std::string& name) const;
+
+    // Runs every step in order, false when a step ended the run
+    bool Run();
+
+    // Runs the named step and the ones after it, the ports written before it keep their values
+    bool RunFrom(const std::string& name);
+
+    // In the order the steps run
+    std::vector<StepTiming> Timings() const;
+
+private:
+    friend class StepContext;
+
+    struct PortState
+    {
+        std::string Name;
+        std::type_index Type;
+        PortLifetime Lifetime;
+        std::any Initial;
+        std::any Value;
+        uint64_t Version;
+    };
+
+    struct StepState
+    {
+        std::string Name;
+        std::vector<size_t> Inputs;
+        std::vector<size_t> Outputs;
+        Step Function;
+        StepOptions Options;
+
+        // Versions of the inputs when the step last ran to the end
+        std::vector<uint64_t> SeenVersions;
+        bool HasRun;
+
+        StepTiming Timing;
+    };
+
+    template<typename T>
+    T* Written(size_t index)
+    {
+        PortState& port = PortAt(index);
+        ++port.Version;
+        return std::any_cast<T>(&port.Value);
+    }
+
+    const PortState& PortAt(size_t index) const;
+    PortState& PortAt(size_t index);
+
+    void Insert(size_t position, std::string name, std::vector<StepPortId> inputs, std::vector<StepPortId> outputs, Step step, StepOptions options);
+    size_t Find(const std::string& name) const;
+    void Validate(const std::vector<std::unique_ptr<StepState>>& steps) const;
+    bool InputsUnchanged(const StepState& step) const;
+    bool RunSteps(size_t first);
+    void ResetRunPorts();
+
+    std::vector<PortState> mPorts;
+    std::vector<std::unique_ptr<StepState>> mSteps;
+};
+
+template<typename T>
+const T& StepContext::Read(StepPort<T> port) const
+{
+    Check(port.Index, false);
+    return mGraph.Value(port);
+}
+
+template<typename T>
+T& StepContext::Write(StepPort<T> port)
+{
+    Check(port.Index, true);
+    return *mGraph.Written<T>(port.Index);
+}
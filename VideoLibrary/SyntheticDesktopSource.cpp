@@ -0,0 +1,474 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "SyntheticDesktopSource.h"
+#include "Region.h"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+    constexpr LONG GlyphWidth = 8;
+    constexpr LONG GlyphHeight = 16;
+    constexpr LONG ScrollStep = 16;
+    constexpr uint64_t RotationPeriod = 30;
+    constexpr uint64_t IdlePointerPeriod = 15;
+
+    constexpr SyntheticScenario MixedScenarios[] = {
+        SyntheticScenario::Typing,
+        SyntheticScenario::Scrolling,
+        SyntheticScenario::Video,
+        SyntheticScenario::WindowDrag,
+        SyntheticScenario::Idle,
+        SyntheticScenario::Rotation
+    };
+
+    // Cheap integer hash, the generator must not depend on the standard library's distributions
+    uint32_t Hash(uint32_t value)
+    {
+        value ^= value >> 16;
+        value *= 0x7FEB352D;
+        value ^= value >> 15;
+        value *= 0x846CA68B;
+        value ^= value >> 16;
+        return value;
+    }
+
+    // Bounces between 0 and range - 1
+    LONG Triangle(uint64_t step, LONG range)
+    {
+        const uint64_t period = static_cast<uint64_t>(range - 1) * 2;
+        const LONG position = static_cast<LONG>(step % period);
+        return position < range ? position : static_cast<LONG>(period) - position;
+    }
+}
+
+class SyntheticDesktopSource::Frame : public SourceFrame
+{
+public:
+    bool captured = false;
+    int64_t presentationTime = 0;
+    RECT monitorBounds{};
+    DXGI_MODE_ROTATION rotation = DXGI_MODE_ROTATION_IDENTITY;
+    std::vector<DXGI_OUTDUPL_MOVE_RECT> moveRects;
+    std::vector<RECT> dirtyRects;
+    DXGI_OUTDUPL_POINTER_POSITION pointerPosition{};
+    int64_t pointerUpdateTime = 0;
+    bool pointerShapeUpdated = false;
+    std::shared_ptr<const std::vector<uint32_t>> pixels;
+    size_t pitch = 0;
+
+    bool Captured() const override { return captured; }
+    int64_t PresentationTime() const override { return presentationTime; }
+    RECT DesktopMonitorBounds() const override { return monitorBounds; }
+    DXGI_MODE_ROTATION Rotation() const override { return rotation; }
+    const DXGI_OUTDUPL_MOVE_RECT* MoveRects() const override { return moveRects.data(); }
+    size_t MoveRectsCount() const override { return moveRects.size(); }
+    const RECT* DirtyRects() const override { return dirtyRects.data(); }
+    size_t DirtyRectsCount() const override { return dirtyRects.size(); }
+    DXGI_OUTDUPL_POINTER_POSITION PointerPosition() const override { return pointerPosition; }
+    int64_t PointerUpdateTime() const override { return pointerUpdateTime; }
+    bool PointerShapeUpdated() const override { return pointerShapeUpdated; }
+    const byte* Pixels() const override { return reinterpret_cast<const byte*>(pixels->data()); }
+    size_t Pitch() const override { return pitch; }
+};
+
+SyntheticDesktopSource::SyntheticDesktopSource(SyntheticDesktopOptions options)
+    : mOptions{ options }
+    , mRandom{ Hash(options.Seed) | 1 }
+    , mFrameNumber{ 0 }
+    , mScenario{ options.Scenario }
+    , mRotation{ DXGI_MODE_ROTATION_IDENTITY }
+    , mCaret{ 0, 0 }
+    , mWindow{}
+    , mWindowShown{ false }
+    , mWindowVelocity{ 7, 5 }
+    , mScrollLine{ 0 }
+    , mPointer{}
+    , mPointerMoved{ false }
+{
+    if (mOptions.Width < 64 || mOptions.Height < 64)
+    {
+        throw std::invalid_argument("synthetic desktop must be at least 64x64");
+    }
+
+    if (mOptions.FramesPerSecond == 0 || mOptions.TicksPerSecond <= 0 || mOptions.FramesPerScenario == 0)
+    {
+        throw std::invalid_argument("invalid synthetic desktop timing");
+    }
+
+    mCanvas = std::make_shared<std::vector<uint32_t>>(static_cast<size_t>(mOptions.Width) * mOptions.Height);
+
+    const LONG windowWidth = mOptions.Width / 4;
+    const LONG windowHeight = mOptions.Height / 4;
+    mWindow = RECT{ mOptions.Width / 8, mOptions.Height / 8, mOptions.Width / 8 + windowWidth, mOptions.Height / 8 + windowHeight };
+}
+
+std::shared_ptr<SourceFrame> SyntheticDesktopSource::AcquireFrame()
+{
+    const uint64_t frameNumber = mFrameNumber;
+
+    mDirtyRects.clear();
+    mMoveRects.clear();
+    mPointerMoved = false;
+
+    mScenario = mOptions.Scenario == SyntheticScenario::Mixed ?
+        MixedScenarios[(frameNumber / mOptions.FramesPerScenario) % (sizeof(MixedScenarios) / sizeof(MixedScenarios[0]))] :
+        mOptions.Scenario;
+
+    bool captured = true;
+    if (frameNumber == 0)
+    {
+        // like the duplication API, the first frame covers the whole desktop
+        FillBackground(RECT{ 0, 0, mOptions.Width, mOptions.Height });
+        MovePointer();
+    }
+    else
+    {
+        switch (mScenario)
+        {
+        case SyntheticScenario::Typing:
+            Typing();
+            break;
+        case SyntheticScenario::Scrolling:
+            Scrolling();
+            break;
+        case SyntheticScenario::Video:
+            Video();
+            break;
+        case SyntheticScenario::WindowDrag:
+            WindowDrag();
+            break;
+        case SyntheticScenario::Rotation:
+            Rotation();
+            break;
+        case SyntheticScenario::Idle:
+        default:
+            captured = Idle();
+            break;
+        }
+    }
+
+    if (mScenario != SyntheticScenario::WindowDrag)
+    {
+        mWindowShown = false;
+    }
+
+    ++mFrameNumber;
+
+    auto frame = std::make_shared<Frame>();
+    frame->captured = captured;
+    if (!captured)
+    {
+        return frame;
+    }
+
+    const int64_t time = 1 + static_cast<int64_t>(frameNumber) * mOptions.TicksPerSecond / mOptions.FramesPerSecond;
+
+    // frames with only a pointer update have no present time
+    const bool imageUpdated = !mDirtyRects.empty() || !mMoveRects.empty();
+    frame->presentationTime = imageUpdated ? time : 0;
+    frame->monitorBounds = RECT{ 0, 0, mOptions.Width, mOptions.Height };
+    frame->rotation = mRotation;
+    frame->moveRects = mMoveRects;
+    frame->dirtyRects = mDirtyRects;
+    frame->pointerPosition = mPointer;
+    frame->pointerUpdateTime = mPointerMoved ? time : 0;
+    frame->pointerShapeUpdated = frameNumber == 0;
+    frame->pixels = mCanvas;
+    frame->pitch = static_cast<size_t>(mOptions.Width) * sizeof(uint32_t);
+    return frame;
+}
+
+int64_t SyntheticDesktopSource::TicksPerSecond() const
+{
+    return mOptions.TicksPerSecond;
+}
+
+const SyntheticDesktopOptions& SyntheticDesktopSource::Options() const
+{
+    return mOptions;
+}
+
+uint64_t SyntheticDesktopSource::FrameNumber() const
+{
+    return mFrameNumber;
+}
+
+SyntheticScenario SyntheticDesktopSource::CurrentScenario() const
+{
+    return mScenario;
+}
+
+uint32_t SyntheticDesktopSource::BackgroundPixel(LONG x, LONG y)
+{
+    // a checkerboard of 32 pixel squares, opaque
+    return ((x / 32 + y / 32) % 2 == 0) ? 0xFF3A6EA5 : 0xFF2F5C8A;
+}
+
+uint32_t SyntheticDesktopSource::NextRandom()
+{
+    // xorshift32
+    mRandom ^= mRandom << 13;
+    mRandom ^= mRandom >> 17;
+    mRandom ^= mRandom << 5;
+    return mRandom;
+}
+
+uint32_t SyntheticDesktopSource::NextRandom(uint32_t bound)
+{
+    return NextRandom() % bound;
+}
+
+uint32_t* SyntheticDesktopSource::WritableCanvas()
+{
+    if (mCanvas.use_count() > 1)
+    {
+        mCanvas = std::make_shared<std::vector<uint32_t>>(*mCanvas);
+    }
+    return mCanvas->data();
+}
+
+void SyntheticDesktopSource::Fill(const RECT& rect, uint32_t seed)
+{
+    uint32_t* canvas = WritableCanvas();
+    for (LONG y = rect.top; y < rect.bottom; ++y)
+    {
+        uint32_t* row = canvas + static_cast<size_t>(y) * mOptions.Width;
+        const uint32_t rowSeed = Hash(seed + static_cast<uint32_t>(y));
+        for (LONG x = rect.left; x < rect.right; ++x)
+        {
+            row[x] = 0xFF000000 | (rowSeed ^ (static_cast<uint32_t>(x) * 0x9E3779B1));
+        }
+    }
+    MarkDirty(rect);
+}
+
+void SyntheticDesktopSource::FillBackground(const RECT& rect)
+{
+    uint32_t* canvas = WritableCanvas();
+    for (LONG y = rect.top; y < rect.bottom; ++y)
+    {
+        uint32_t* row = canvas + static_cast<size_t>(y) * mOptions.Width;
+        for (LONG x = rect.left; x < rect.right; ++x)
+        {
+            row[x] = BackgroundPixel(x, y);
+        }
+    }
+    MarkDirty(rect);
+}
+
+void SyntheticDesktopSource::Move(const RECT& source, POINT destination)
+{
+    uint32_t* canvas = WritableCanvas();
+    const LONG width = source.right - source.left;
+    const LONG height = source.bottom - source.top;
+    const size_t rowSize = static_cast<size_t>(width) * sizeof(uint32_t);
+
+    // walk rows away from the overlap so no source row is overwritten before it is copied
+    for (LONG i = 0; i < height; ++i)
+    {
+        const LONG row = destination.y > source.top ? height - 1 - i : i;
+        std::memmove(
+            canvas + static_cast<size_t>(destination.y + row) * mOptions.Width + destination.x,
+            canvas + static_cast<size_t>(source.top + row) * mOptions.Width + source.left,
+            rowSize);
+    }
+
+    MarkMoved(source, destination);
+}
+
+void SyntheticDesktopSource::MarkDirty(const RECT& rect)
+{
+    if (rect.right > rect.left && rect.bottom > rect.top)
+    {
+        mDirtyRects.push_back(rect);
+    }
+}
+
+void SyntheticDesktopSource::MarkMoved(const RECT& source, POINT destination)
+{
+    DXGI_OUTDUPL_MOVE_RECT moveRect;
+    moveRect.SourcePoint = POINT{ source.left, source.top };
+    moveRect.DestinationRect = RECT{
+        destination.x,
+        destination.y,
+        destination.x + source.right - source.left,
+        destination.y + source.bottom - source.top };
+    mMoveRects.push_back(moveRect);
+}
+
+void SyntheticDesktopSource::Typing()
+{
+    const RECT editor{ mOptions.Width / 16, mOptions.Height / 8, mOptions.Width / 2, mOptions.Height * 7 / 8 };
+    const LONG columns = (editor.right - editor.left) / GlyphWidth;
+    const LONG lines = (editor.bottom - editor.top) / GlyphHeight;
+
+    // a couple of keystrokes per frame at most, sometimes none
+    const uint32_t keystrokes = NextRandom(3);
+    for (uint32_t i = 0; i < keystrokes; ++i)
+    {
+        if (mCaret.x >= columns || NextRandom(40) == 0)
+        {
+            mCaret.x = 0;
+            ++mCaret.y;
+        }
+
+        if (mCaret.y >= lines)
+        {
+            // page full, clear the editor
+            mCaret.y = 0;
+            Fill(editor, 0);
+        }
+
+        const RECT glyph{
+            editor.left + mCaret.x * GlyphWidth,
+            editor.top + mCaret.y * GlyphHeight,
+            editor.left + (mCaret.x + 1) * GlyphWidth,
+            editor.top + (mCaret.y + 1) * GlyphHeight };
+        Fill(glyph, NextRandom());
+        ++mCaret.x;
+    }
+
+    // caret blink
+    if (mFrameNumber % 30 == 0)
+    {
+        const LONG caretX = editor.left + (std::min)(mCaret.x, columns - 1) * GlyphWidth;
+        const LONG caretY = editor.top + (std::min)(mCaret.y, lines - 1) * GlyphHeight;
+        Fill(RECT{ caretX, caretY, caretX + 2, caretY + GlyphHeight }, static_cast<uint32_t>(mFrameNumber));
+    }
+
+    MovePointer();
+}
+
+void SyntheticDesktopSource::Scrolling()
+{
+    const RECT page{ mOptions.Width / 2 + mOptions.Width / 16, mOptions.Height / 8, mOptions.Width * 15 / 16, mOptions.Height * 7 / 8 };
+
+    Move(RECT{ page.left, page.top + ScrollStep, page.right, page.bottom }, POINT{ page.left, page.top });
+    Fill(RECT{ page.left, page.bottom - ScrollStep, page.right, page.bottom }, 0x5C011 + mScrollLine++);
+
+    MovePointer();
+}
+
+void SyntheticDesktopSource::Video()
+{
+    const LONG width = (std::min)(mOptions.Width / 2, static_cast<LONG>(640));
+    const LONG height = width * 9 / 16;
+    const LONG left = (mOptions.Width - width) / 2;
+    const LONG top = (mOptions.Height - height) / 2;
+    Fill(RECT{ left, top, left + width, top + height }, NextRandom());
+}
+
+void SyntheticDesktopSource::WindowDrag()
+{
+    if (!mWindowShown)
+    {
+        // show the window at the start of the drag, moves are applied before
+        // dirty rects so the window cannot also move in this frame
+        Fill(mWindow, 0x817D0);
+        mWindowShown = true;
+        return;
+    }
+
+    RECT next = mWindow;
+    next.left += mWindowVelocity.x;
+    next.right += mWindowVelocity.x;
+    next.top += mWindowVelocity.y;
+    next.bottom += mWindowVelocity.y;
+
+    if (next.left < 0 || next.right > mOptions.Width)
+    {
+        mWindowVelocity.x = -mWindowVelocity.x;
+        next.left = mWindow.left + mWindowVelocity.x;
+        next.right = mWindow.right + mWindowVelocity.x;
+    }
+
+    if (next.top < 0 || next.bottom > mOptions.Height)
+    {
+        mWindowVelocity.y = -mWindowVelocity.y;
+        next.top = mWindow.top + mWindowVelocity.y;
+        next.bottom = mWindow.bottom + mWindowVelocity.y;
+    }
+
+    Move(mWindow, POINT{ next.left, next.top });
+
+    // repaint the background the window uncovered
+    Region uncovered{ mWindow };
+    uncovered.Subtract(next);
+    for (size_t i = 0; i < uncovered.RectsCount(); ++i)
+    {
+        FillBackground(uncovered.Rects()[i]);
+    }
+
+    mWindow = next;
+
+    // the pointer drags the window by its title bar
+    mPointer.Position = POINT{ mWindow.left + 20, mWindow.top + 8 };
+    mPointer.Visible = 1;
+    mPointerMoved = true;
+}
+
+void SyntheticDesktopSource::Rotation()
+{
+    if (mFrameNumber % RotationPeriod == 0)
+    {
+        switch (mRotation)
+        {
+        case DXGI_MODE_ROTATION_IDENTITY:
+            mRotation = DXGI_MODE_ROTATION_ROTATE90;
+            break;
+        case DXGI_MODE_ROTATION_ROTATE90:
+            mRotation = DXGI_MODE_ROTATION_ROTATE180;
+            break;
+        case DXGI_MODE_ROTATION_ROTATE180:
+            mRotation = DXGI_MODE_ROTATION_ROTATE270;
+            break;
+        default:
+            mRotation = DXGI_MODE_ROTATION_IDENTITY;
+            break;
+        }
+
+        // a mode change repaints the whole desktop
+        FillBackground(RECT{ 0, 0, mOptions.Width, mOptions.Height });
+        return;
+    }
+
+    // a clock in the corner keeps ticking in between
+    Fill(RECT{ mOptions.Width - 80, 0, mOptions.Width, 24 }, static_cast<uint32_t>(mFrameNumber / 10));
+}
+
+bool SyntheticDesktopSource::Idle()
+{
+    if (mFrameNumber % IdlePointerPeriod != 0)
+    {
+        return false;
+    }
+
+    MovePointer();
+    return true;
+}
+
+void SyntheticDesktopSource::MovePointer()
+{
+    mPointer.Position = POINT{ Triangle(mFrameNumber * 5, mOptions.Width), Triangle(mFrameNumber * 3, mOptions.Height) };
+    mPointer.Visible = 1;
+    mPointerMoved = true;
+}
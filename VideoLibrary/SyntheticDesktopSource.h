@@ -0,0 +1,126 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "FrameSource.h"
+#include <vector>
+
+enum class SyntheticScenario
+{
+    // Glyph sized dirty rects along a line of text and a blinking caret
+    Typing,
+
+    // A page scrolling up: one large move rect and a new strip at the bottom
+    Scrolling,
+
+    // One fixed region repainted every frame
+    Video,
+
+    // A window moved around: a move rect plus the uncovered background
+    WindowDrag,
+
+    // The display rotating, which repaints everything
+    Rotation,
+
+    // No new frames, with occasional pointer-only updates
+    Idle,
+
+    // Cycles through all of the above
+    Mixed
+};
+
+struct SyntheticDesktopOptions
+{
+    LONG Width = 1280;
+    LONG Height = 720;
+    SyntheticScenario Scenario = SyntheticScenario::Mixed;
+    uint32_t Seed = 1;
+    UINT FramesPerSecond = 60;
+    int64_t TicksPerSecond = 10'000'000;
+
+    // How long each scenario runs in the Mixed scenario
+    uint64_t FramesPerScenario = 120;
+};
+
+/*
+    Deterministic generator of desktop frames: pixels plus the dirty and move rects
+    the duplication API would report for them.
+
+    The same options always produce the same frames on every platform.
+*/
+class SyntheticDesktopSource : public FrameSource
+{
+public:
+    explicit SyntheticDesktopSource(SyntheticDesktopOptions options = SyntheticDesktopOptions{});
+
+    // Inherited via FrameSource
+    std::shared_ptr<SourceFrame> AcquireFrame() override;
+    int64_t TicksPerSecond() const override;
+
+    const SyntheticDesktopOptions& Options() const;
+
+    // Number of frames generated so far
+    uint64_t FrameNumber() const;
+
+    // The scenario that produced the last frame
+    SyntheticScenario CurrentScenario() const;
+
+    static uint32_t BackgroundPixel(LONG x, LONG y);
+
+private:
+    class Frame;
+
+    uint32_t NextRandom();
+    uint32_t NextRandom(uint32_t bound);
+
+    // Copies the canvas first if a previous frame still references it
+    uint32_t* WritableCanvas();
+
+    void Fill(const RECT& rect, uint32_t seed);
+    void FillBackground(const RECT& rect);
+    void Move(const RECT& source, POINT destination);
+    void MarkDirty(const RECT& rect);
+    void MarkMoved(const RECT& source, POINT destination);
+
+    void Typing();
+    void Scrolling();
+    void Video();
+    void WindowDrag();
+    void Rotation();
+    bool Idle();
+    void MovePointer();
+
+    SyntheticDesktopOptions mOptions;
+    std::shared_ptr<std::vector<uint32_t>> mCanvas;
+    uint32_t mRandom;
+    uint64_t mFrameNumber;
+    SyntheticScenario mScenario;
+
+    std::vector<RECT> mDirtyRects;
+    std::vector<DXGI_OUTDUPL_MOVE_RECT> mMoveRects;
+
+    DXGI_MODE_ROTATION mRotation;
+    POINT mCaret;
+    RECT mWindow;
+    bool mWindowShown;
+    POINT mWindowVelocity;
+    uint32_t mScrollLine;
+    DXGI_OUTDUPL_POINTER_POSITION mPointer;
+    bool mPointerMoved;
+};
@@ -24,23 +24,50 @@
 #include "VirtualDesktop.h"
 #include "TexturePool.h"
 
-TexturePool::TexturePool(winrt::com_ptr<ID3D11Device> device, const D3D11_TEXTURE2D_DESC desc)
+TexturePoolEntry::TexturePoolEntry(winrt::com_ptr<ID3D11Texture2D> texture, std::shared_ptr<D3D11ViewDevice> viewDevice)
+    : mTexture{ texture }
+    , mViewDevice{ viewDevice }
+{
+    winrt::check_pointer(mTexture.get());
+}
+
+const winrt::com_ptr<ID3D11Texture2D>& TexturePoolEntry::Texture() const
+{
+    return mTexture;
+}
+
+ID3D11RenderTargetView* TexturePoolEntry::RenderTargetView()
+{
+    return D3D11ViewDevice::RenderTargetView(mViews.Get(*mViewDevice, mTexture.get(), ViewKind::RenderTarget));
+}
+
+ID3D11ShaderResourceView* TexturePoolEntry::ShaderResourceView()
+{
+    return D3D11ViewDevice::ShaderResourceView(mViews.Get(*mViewDevice, mTexture.get(), ViewKind::ShaderResource));
+}
+
+TexturePool::TexturePool(winrt::com_ptr<ID3D11Device> device, const D3D11_TEXTURE2D_DESC desc, BoundedPoolOptions options)
     : mDevice{ device }
+    , mViewDevice{ std::make_shared<D3D11ViewDevice>(device) }
     , mTextureDesc{ desc }
+    , mTexturePool{ [this]() { return CreateEntry(); }, options }
     , m_refCount{ 1 }
 {
 }
 
-winrt::com_ptr<ID3D11Texture2D> TexturePool::Acquire()
+std::shared_ptr<TexturePoolEntry> TexturePool::Acquire()
 {
-    std::lock_guard<std::mutex> lock{ mMutex };
-    if (mTexturePool.empty()) {
-        return CreateTexture();
+    std::shared_ptr<TexturePoolEntry> entry;
+    if (!mTexturePool.Acquire(entry)) {
+        return nullptr;
     }
 
-    auto texture = mTexturePool.front();
-    mTexturePool.pop();
-    return texture;
+    return entry;
+}
+
+BoundedPoolStats TexturePool::Stats() const
+{
+    return mTexturePool.Stats();
 }
 
 HRESULT __stdcall TexturePool::GetParameters(DWORD * pdwFlags, DWORD * pdwQueue)
@@ -65,22 +92,22 @@ HRESULT __stdcall TexturePool::Invoke(IMFAsyncResult * pAsyncResult)
     winrt::com_ptr<ID3D11Texture2D> texture;
     winrt::check_hresult(dxgiBuffer->GetResource(IID_PPV_ARGS(texture.put())));
 
+    mTexturePool.ReleaseMatching([&texture](const std::shared_ptr<TexturePoolEntry>& entry)
     {
-        std::lock_guard<std::mutex> lock{ mMutex };
-        mTexturePool.push(texture);
-    }
+        return entry->Texture() == texture;
+    });
 
     return S_OK;
 }
 
-winrt::com_ptr<ID3D11Texture2D> TexturePool::CreateTexture()
+std::shared_ptr<TexturePoolEntry> TexturePool::CreateEntry()
 {
     D3D11_TEXTURE2D_DESC moveDesc = mTextureDesc;
     moveDesc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
     moveDesc.MiscFlags = D3D11_RESOURCE_MISC_SHARED;
     winrt::com_ptr<ID3D11Texture2D> texture;
-    mDevice->CreateTexture2D(&moveDesc, nullptr, texture.put());
-    return texture;
+    winrt::check_hresult(mDevice->CreateTexture2D(&moveDesc, nullptr, texture.put()));
+    return std::make_shared<TexturePoolEntry>(texture, mViewDevice);
 }
 
 HRESULT TexturePool::QueryInterface(REFIID riid, void** ppv) noexcept
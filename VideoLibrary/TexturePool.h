@@ -20,14 +20,39 @@
 #pragma once
 
 #include "DesktopMonitor.h"
+#include "BoundedPool.h"
+#include "ViewCache.h"
+#include "D3D11ViewDevice.h"
+
+// A pooled texture with the views drawing to it needs, each created once for the texture
+class TexturePoolEntry
+{
+public:
+    TexturePoolEntry(winrt::com_ptr<ID3D11Texture2D> texture, std::shared_ptr<D3D11ViewDevice> viewDevice);
+
+    const winrt::com_ptr<ID3D11Texture2D>& Texture() const;
+
+    ID3D11RenderTargetView* RenderTargetView();
+    ID3D11ShaderResourceView* ShaderResourceView();
+
+private:
+    friend class TexturePool;
+
+    winrt::com_ptr<ID3D11Texture2D> mTexture;
+    std::shared_ptr<D3D11ViewDevice> mViewDevice;
+    TextureViews mViews;
+};
 
 class TexturePool : public IMFAsyncCallback
 {
 public:
 
-    TexturePool(winrt::com_ptr<ID3D11Device> device, D3D11_TEXTURE2D_DESC desc);
+    TexturePool(winrt::com_ptr<ID3D11Device> device, D3D11_TEXTURE2D_DESC desc, BoundedPoolOptions options = {});
+
+    // Null when the pool is exhausted and its policy dropped the frame
+    std::shared_ptr<TexturePoolEntry> Acquire();
 
-    winrt::com_ptr<ID3D11Texture2D> Acquire();
+    BoundedPoolStats Stats() const;
 
     virtual HRESULT STDMETHODCALLTYPE GetParameters(DWORD* pdwFlags, DWORD* pdwQueue) override;
 
@@ -50,12 +75,12 @@ public:
 
 private:
 
-    winrt::com_ptr<ID3D11Texture2D> CreateTexture();
+    std::shared_ptr<TexturePoolEntry> CreateEntry();
 
     winrt::com_ptr<ID3D11Device> mDevice;
+    std::shared_ptr<D3D11ViewDevice> mViewDevice;
     const D3D11_TEXTURE2D_DESC mTextureDesc;
-    std::queue<winrt::com_ptr<ID3D11Texture2D>> mTexturePool;
-    std::mutex mMutex;
+    BoundedPool<std::shared_ptr<TexturePoolEntry>> mTexturePool;
     volatile long   m_refCount;
 
 };
@@ -0,0 +1,80 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "TraceFrameSource.h"
+
+class TraceFrameSource::Frame : public SourceFrame
+{
+public:
+    Frame(std::shared_ptr<CaptureTraceReader> reader, const CaptureTraceFrame& frame, bool captured)
+        : mReader{ reader }
+        , mFrame{ frame }
+        , mCaptured{ captured }
+    {
+    }
+
+    bool Captured() const override { return mCaptured; }
+    int64_t PresentationTime() const override { return mFrame.PresentTime; }
+    RECT DesktopMonitorBounds() const override { return mFrame.MonitorBounds; }
+    DXGI_MODE_ROTATION Rotation() const override { return mFrame.Rotation; }
+    const DXGI_OUTDUPL_MOVE_RECT* MoveRects() const override { return mFrame.MoveRects; }
+    size_t MoveRectsCount() const override { return mFrame.MoveRectsCount; }
+    const RECT* DirtyRects() const override { return mFrame.DirtyRects; }
+    size_t DirtyRectsCount() const override { return mFrame.DirtyRectsCount; }
+    DXGI_OUTDUPL_POINTER_POSITION PointerPosition() const override { return mFrame.PointerPosition; }
+    int64_t PointerUpdateTime() const override { return mFrame.PointerUpdateTime; }
+    bool PointerShapeUpdated() const override { return mFrame.HasPointerShape; }
+
+private:
+    // keeps the mapping the frame points into alive
+    std::shared_ptr<CaptureTraceReader> mReader;
+    CaptureTraceFrame mFrame;
+    bool mCaptured;
+};
+
+TraceFrameSource::TraceFrameSource(std::shared_ptr<CaptureTraceReader> reader, ReplayPacing pacing)
+    : mReader{ reader }
+    , mReplay{ reader, pacing }
+    , mFinished{ false }
+{
+}
+
+std::shared_ptr<SourceFrame> TraceFrameSource::AcquireFrame()
+{
+    CaptureTraceFrame frame;
+    const bool captured = mReplay.Next(frame);
+    mFinished = !captured;
+    return std::make_shared<Frame>(mReader, frame, captured);
+}
+
+int64_t TraceFrameSource::TicksPerSecond() const
+{
+    return mReader->TicksPerSecond();
+}
+
+bool TraceFrameSource::Finished() const
+{
+    return mFinished;
+}
+
+void TraceFrameSource::Rewind()
+{
+    mReplay.Rewind();
+    mFinished = false;
+}
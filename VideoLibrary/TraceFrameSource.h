@@ -0,0 +1,45 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "FrameSource.h"
+#include "CaptureTraceReplay.h"
+
+// Frames read back from a capture trace. Recorded pixels only cover dirty rects, so Pixels() is null.
+class TraceFrameSource : public FrameSource
+{
+public:
+    TraceFrameSource(std::shared_ptr<CaptureTraceReader> reader, ReplayPacing pacing = ReplayPacing::FullSpeed);
+
+    // Inherited via FrameSource
+    // Returns a frame that was not captured once the trace is exhausted
+    std::shared_ptr<SourceFrame> AcquireFrame() override;
+    int64_t TicksPerSecond() const override;
+
+    bool Finished() const;
+
+    void Rewind();
+
+private:
+    class Frame;
+
+    std::shared_ptr<CaptureTraceReader> mReader;
+    CaptureTraceReplay mReplay;
+    bool mFinished;
+};
@@ -0,0 +1,79 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "pch.h"
+#include "ViewCache.h"
+
+#include <stdexcept>
+
+TextureView& TextureViews::Get(ViewDevice& device, void* texture, ViewKind kind)
+{
+    std::shared_ptr<TextureView>& view = mViews[static_cast<size_t>(kind)];
+    if (view == nullptr)
+    {
+        view = device.CreateView(texture, kind);
+        if (view == nullptr)
+        {
+            throw std::runtime_error("view device returned a null view");
+        }
+    }
+    return *view;
+}
+
+uint64_t TextureViews::Created() const
+{
+    return (mViews[0] != nullptr ? 1 : 0) + (mViews[1] != nullptr ? 1 : 0);
+}
+
+ViewCache::ViewCache(std::shared_ptr<ViewDevice> device, size_t capacity)
+    : mDevice{ device }
+    , mViews{ capacity }
+{
+    if (mDevice == nullptr)
+    {
+        throw std::invalid_argument("null view device");
+    }
+}
+
+TextureView& ViewCache::View(void* texture, ViewKind kind)
+{
+    const Key key{ texture, kind };
+    std::shared_ptr<TextureView>* cached = mViews.Find(key);
+    if (cached != nullptr)
+    {
+        return **cached;
+    }
+
+    std::shared_ptr<TextureView> view = mDevice->CreateView(texture, kind);
+    if (view == nullptr)
+    {
+        throw std::runtime_error("view device returned a null view");
+    }
+    return *mViews.Insert(key, view);
+}
+
+uint64_t ViewCache::Hits() const
+{
+    return mViews.Hits();
+}
+
+uint64_t ViewCache::Created() const
+{
+    return mViews.Misses();
+}
@@ -0,0 +1,81 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include "ViewDevice.h"
+#include "LruCache.h"
+#include <cstdint>
+#include <functional>
+
+// The views of one texture, each created the first time it is used
+class TextureViews
+{
+public:
+    TextureView& Get(ViewDevice& device, void* texture, ViewKind kind);
+
+    // Views created, at most one of each kind
+    uint64_t Created() const;
+
+private:
+    std::shared_ptr<TextureView> mViews[2];
+};
+
+/*
+    Views of textures the renderers do not own, such as the desktop image that
+    duplication hands out again every frame. Views are found by texture address.
+    A cached view holds a reference to its texture, so the address cannot be
+    reused by another texture while the view is cached.
+*/
+class ViewCache
+{
+public:
+    // Duplication cycles through a few desktop images
+    static constexpr size_t DefaultCapacity = 8;
+
+    explicit ViewCache(std::shared_ptr<ViewDevice> device, size_t capacity = DefaultCapacity);
+
+    // Creates the view on a miss
+    TextureView& View(void* texture, ViewKind kind);
+
+    uint64_t Hits() const;
+    uint64_t Created() const;
+
+private:
+    struct Key
+    {
+        void* Texture;
+        ViewKind Kind;
+
+        bool operator==(const Key& other) const
+        {
+            return Texture == other.Texture && Kind == other.Kind;
+        }
+    };
+
+    struct KeyHash
+    {
+        size_t operator()(const Key& key) const
+        {
+            return std::hash<void*>{}(key.Texture) ^ static_cast<size_t>(key.Kind);
+        }
+    };
+
+    std::shared_ptr<ViewDevice> mDevice;
+    LruCache<Key, std::shared_ptr<TextureView>, KeyHash> mViews;
+};
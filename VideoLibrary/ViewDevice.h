@@ -0,0 +1,49 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+//
+// ViewDevice.h
+// Creates the render target and shader resource views the renderers bind
+// textures through.
+//
+
+#pragma once
+#include <memory>
+
+enum class ViewKind
+{
+    RenderTarget,
+    ShaderResource
+};
+
+// A render target or shader resource view of a texture, created by a ViewDevice
+class TextureView
+{
+public:
+    virtual ~TextureView() = default;
+};
+
+class ViewDevice
+{
+public:
+    virtual ~ViewDevice() = default;
+
+    // The texture is the device's own texture type. A view keeps its texture alive.
+    virtual std::shared_ptr<TextureView> CreateView(void* texture, ViewKind kind) = 0;
+};
@@ -48,5 +48,6 @@
 #include <mutex>
 
 #include "VertexShader.h"
+#include "InstancedRectVertexShader.h"
 #include "PixelShader.h"
 #include "Vertex.h"
@@ -0,0 +1,178 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+#include "..\VideoLibrary\BoundedPool.h"
+#include <atomic>
+#include <memory>
+#include <thread>
+
+namespace VideoLibraryTests
+{
+namespace
+{
+    typedef std::shared_ptr<int> Texture;
+
+    // Stands in for the texture factory, numbering what it creates
+    struct CountingFactory
+    {
+        std::shared_ptr<int> Created = std::make_shared<int>(0);
+
+        BoundedPool<Texture>::Factory Make() const
+        {
+            auto created = Created;
+            return [created]() { return std::make_shared<int>((*created)++); };
+        }
+    };
+
+    BoundedPoolOptions Options(size_t low, size_t high, PoolExhaustedPolicy policy)
+    {
+        BoundedPoolOptions options;
+        options.LowWatermark = low;
+        options.HighWatermark = high;
+        options.Policy = policy;
+        options.BlockTimeout = std::chrono::milliseconds{ 20 };
+        return options;
+    }
+}
+
+    TEST_CLASS(BoundedPoolTests)
+    {
+    public:
+        TEST_METHOD(PrewarmsAndRecycles)
+        {
+            CountingFactory factory;
+            BoundedPool<Texture> pool{ factory.Make(), Options(3, 6, PoolExhaustedPolicy::Drop) };
+            Assert::AreEqual(3, *factory.Created);
+
+            // an encoder that keeps two frames in flight never needs more than the prewarmed three
+            std::deque<Texture> inFlight;
+            for (int frame = 0; frame < 1000; ++frame)
+            {
+                Texture texture;
+                Assert::IsTrue(pool.Acquire(texture));
+                inFlight.push_back(texture);
+                if (inFlight.size() > 2)
+                {
+                    pool.Release(inFlight.front());
+                    inFlight.pop_front();
+                }
+            }
+
+            const BoundedPoolStats stats = pool.Stats();
+            Assert::AreEqual(static_cast<uint64_t>(3), stats.Allocations);
+            Assert::AreEqual(static_cast<size_t>(3), stats.PeakDepth);
+            Assert::AreEqual(static_cast<size_t>(2), stats.Outstanding);
+            Assert::AreEqual(static_cast<size_t>(1), stats.Free);
+            Assert::AreEqual(static_cast<uint64_t>(0), stats.Drops);
+
+            pool.Prewarm(10);
+            Assert::AreEqual(static_cast<uint64_t>(6), pool.Stats().Allocations);
+        }
+
+        TEST_METHOD(DropsAtTheHighWatermark)
+        {
+            CountingFactory factory;
+            BoundedPool<Texture> pool{ factory.Make(), Options(0, 4, PoolExhaustedPolicy::Drop) };
+            Assert::AreEqual(0, *factory.Created);
+
+            // the encoder stopped returning textures
+            std::vector<Texture> held;
+            for (int frame = 0; frame < 100; ++frame)
+            {
+                Texture texture;
+                if (pool.Acquire(texture))
+                {
+                    held.push_back(texture);
+                }
+            }
+
+            Assert::AreEqual(static_cast<size_t>(4), held.size());
+            Assert::AreEqual(4, *factory.Created);
+            Assert::AreEqual(static_cast<uint64_t>(96), pool.Stats().Drops);
+
+            pool.Release(held.back());
+            Texture texture;
+            Assert::IsTrue(pool.Acquire(texture));
+            Assert::IsTrue(texture == held.back());
+            Assert::ExpectException<std::invalid_argument>([&pool]() { pool.Release(std::make_shared<int>(7)); });
+        }
+
+        TEST_METHOD(ReusesTheOldest)
+        {
+            CountingFactory factory;
+            BoundedPool<Texture> pool{ factory.Make(), Options(2, 2, PoolExhaustedPolicy::ReuseOldest) };
+
+            Texture first, second, third;
+            Assert::IsTrue(pool.Acquire(first));
+            Assert::IsTrue(pool.Acquire(second));
+            Assert::IsTrue(pool.Acquire(third));
+            Assert::IsTrue(third == first);
+            Assert::AreEqual(static_cast<uint64_t>(1), pool.Stats().Reuses);
+            Assert::AreEqual(static_cast<uint64_t>(2), pool.Stats().Allocations);
+
+            // free again only once both holders released it
+            pool.Release(first);
+            Assert::AreEqual(static_cast<size_t>(0), pool.Stats().Free);
+            pool.Release(third);
+            Assert::AreEqual(static_cast<size_t>(1), pool.Stats().Free);
+            Assert::AreEqual(static_cast<size_t>(1), pool.Stats().Outstanding);
+        }
+
+        TEST_METHOD(BlocksUntilReleasedOrTimeout)
+        {
+            CountingFactory factory;
+            BoundedPool<Texture> pool{ factory.Make(), Options(1, 1, PoolExhaustedPolicy::Block) };
+
+            Texture held;
+            Assert::IsTrue(pool.Acquire(held));
+
+            // nothing comes back, the wait times out and the frame is dropped
+            Texture texture;
+            Assert::IsFalse(pool.Acquire(texture));
+            Assert::AreEqual(static_cast<uint64_t>(1), pool.Stats().Drops);
+
+            // the encoder returns the texture from its own thread
+            std::thread encoder{ [&pool, held]() {
+                std::this_thread::sleep_for(std::chrono::milliseconds{ 5 });
+                pool.Release(held);
+            } };
+            Assert::IsTrue(pool.Acquire(texture));
+            encoder.join();
+            Assert::IsTrue(texture == held);
+
+            const BoundedPoolStats stats = pool.Stats();
+            Assert::AreEqual(static_cast<uint64_t>(2), stats.Waits);
+            Assert::AreEqual(static_cast<uint64_t>(1), stats.Allocations);
+            Assert::IsTrue(stats.WaitTime >= std::chrono::milliseconds{ 20 });
+        }
+
+        TEST_METHOD(RejectsBadOptions)
+        {
+            CountingFactory factory;
+            Assert::ExpectException<std::invalid_argument>([&factory]() { BoundedPool<Texture> pool{ factory.Make(), Options(0, 0, PoolExhaustedPolicy::Drop) }; });
+            Assert::ExpectException<std::invalid_argument>([&factory]() { BoundedPool<Texture> pool{ factory.Make(), Options(3, 2, PoolExhaustedPolicy::Drop) }; });
+            Assert::ExpectException<std::invalid_argument>([]() { BoundedPool<Texture> pool{ nullptr }; });
+        }
+    };
+}
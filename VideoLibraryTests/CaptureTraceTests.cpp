@@ -0,0 +1,272 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+#include "..\VideoLibrary\CaptureTraceWriter.h"
+#include "..\VideoLibrary\CaptureTraceReader.h"
+#include "..\VideoLibrary\CaptureTraceReplay.h"
+#include "..\VideoLibrary\DirtyRectCoalescer.h"
+#include "..\VideoLibrary\Region.h"
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <string>
+
+namespace VideoLibraryTests
+{
+namespace
+{
+    constexpr LONG DesktopWidth = 256;
+    constexpr LONG DesktopHeight = 128;
+
+    std::filesystem::path TracePath(const char* name)
+    {
+        return std::filesystem::temp_directory_path() / name;
+    }
+
+    // A desktop whose pixels are a function of the frame number, so pixels can be checked after replay
+    uint32_t PixelValue(int frame, LONG x, LONG y)
+    {
+        return static_cast<uint32_t>(frame * 7919 + y * DesktopWidth + x);
+    }
+
+    struct SyntheticFrame
+    {
+        std::vector<RECT> dirty;
+        std::vector<DXGI_OUTDUPL_MOVE_RECT> moves;
+        std::vector<byte> pixels;
+        std::vector<byte> shape;
+        CaptureTraceFrame frame;
+    };
+
+    SyntheticFrame MakeFrame(int index, std::mt19937& random)
+    {
+        SyntheticFrame synthetic;
+        std::uniform_int_distribution<LONG> x{ 0, DesktopWidth - 33 };
+        std::uniform_int_distribution<LONG> y{ 0, DesktopHeight - 33 };
+        std::uniform_int_distribution<LONG> size{ 1, 32 };
+
+        for (int i = 0; i < 1 + index % 5; ++i)
+        {
+            const LONG left = x(random);
+            const LONG top = y(random);
+            synthetic.dirty.push_back(RECT{ left, top, left + size(random), top + size(random) });
+        }
+
+        if (index % 3 == 0)
+        {
+            synthetic.moves.push_back(DXGI_OUTDUPL_MOVE_RECT{ { 0, 10 }, { 0, 0, 64, 20 } });
+        }
+
+        for (const RECT& rect : synthetic.dirty)
+        {
+            for (LONG row = rect.top; row < rect.bottom; ++row)
+            {
+                for (LONG column = rect.left; column < rect.right; ++column)
+                {
+                    const uint32_t value = PixelValue(index, column, row);
+                    const byte* bytes = reinterpret_cast<const byte*>(&value);
+                    synthetic.pixels.insert(synthetic.pixels.end(), bytes, bytes + 4);
+                }
+            }
+        }
+
+        CaptureTraceFrame& frame = synthetic.frame;
+        frame.PresentTime = 1000 + index * 10;
+        frame.PointerUpdateTime = frame.PresentTime;
+        frame.MonitorBounds = RECT{ 0, 0, DesktopWidth, DesktopHeight };
+        frame.Rotation = DXGI_MODE_ROTATION_IDENTITY;
+        frame.PointerPosition.Position = POINT{ index, index * 2 };
+        frame.PointerPosition.Visible = 1;
+        frame.DirtyRects = synthetic.dirty.data();
+        frame.DirtyRectsCount = synthetic.dirty.size();
+        frame.MoveRects = synthetic.moves.data();
+        frame.MoveRectsCount = synthetic.moves.size();
+        frame.Pixels = synthetic.pixels.data();
+        frame.PixelsSize = synthetic.pixels.size();
+
+        if (index == 0)
+        {
+            synthetic.shape.assign(32 * 32 * 4, 0x7F);
+            frame.HasPointerShape = true;
+            frame.PointerShapeInfo.Type = DXGI_OUTDUPL_POINTER_SHAPE_TYPE_COLOR;
+            frame.PointerShapeInfo.Width = 32;
+            frame.PointerShapeInfo.Height = 32;
+            frame.PointerShapeInfo.Pitch = 32 * 4;
+            frame.PointerShape = synthetic.shape.data();
+            frame.PointerShapeSize = synthetic.shape.size();
+        }
+
+        return synthetic;
+    }
+
+    void WriteTrace(const std::filesystem::path& path, int frames, bool recordPixels, int64_t ticksPerSecond)
+    {
+        std::mt19937 random{ 5 };
+        CaptureTraceWriter writer{ path, recordPixels, ticksPerSecond };
+        for (int i = 0; i < frames; ++i)
+        {
+            writer.Write(MakeFrame(i, random).frame);
+        }
+    }
+}
+
+    TEST_CLASS(CaptureTraceTests)
+    {
+    public:
+        TEST_METHOD(RoundTripPreservesFrames)
+        {
+            const auto path = TracePath("roundtrip.drtrace");
+            WriteTrace(path, 20, true, 1000);
+
+            CaptureTraceReader reader{ path };
+            Assert::IsTrue(reader.HasPixels());
+            Assert::AreEqual(static_cast<int64_t>(1000), reader.TicksPerSecond());
+            Assert::AreEqual(static_cast<size_t>(20), reader.FrameCount());
+
+            std::mt19937 random{ 5 };
+            for (size_t i = 0; i < reader.FrameCount(); ++i)
+            {
+                const SyntheticFrame expected = MakeFrame(static_cast<int>(i), random);
+                const CaptureTraceFrame frame = reader.Frame(i);
+
+                Assert::AreEqual(expected.frame.PresentTime, frame.PresentTime);
+                Assert::AreEqual(static_cast<long>(expected.frame.PointerPosition.Position.y), static_cast<long>(frame.PointerPosition.Position.y));
+                Assert::AreEqual(expected.dirty.size(), frame.DirtyRectsCount);
+                Assert::AreEqual(expected.moves.size(), frame.MoveRectsCount);
+                Assert::AreEqual(0, std::memcmp(expected.dirty.data(), frame.DirtyRects, expected.dirty.size() * sizeof(RECT)));
+                Assert::AreEqual(expected.pixels.size(), frame.PixelsSize);
+                Assert::AreEqual(0, std::memcmp(expected.pixels.data(), frame.Pixels, frame.PixelsSize));
+                Assert::AreEqual(i == 0, frame.HasPointerShape);
+            }
+        }
+
+        TEST_METHOD(PixelsAreOptional)
+        {
+            const auto path = TracePath("metadata.drtrace");
+            const auto pixelsPath = TracePath("pixels.drtrace");
+            WriteTrace(path, 10, false, 1000);
+            WriteTrace(pixelsPath, 10, true, 1000);
+
+            CaptureTraceReader reader{ path };
+            Assert::IsFalse(reader.HasPixels());
+            Assert::IsTrue(reader.Frame(3).Pixels == nullptr);
+            Assert::IsTrue(std::filesystem::file_size(path) * 4 < std::filesystem::file_size(pixelsPath));
+        }
+
+        TEST_METHOD(TruncatedRecordIsIgnored)
+        {
+            const auto path = TracePath("truncated.drtrace");
+            WriteTrace(path, 5, true, 1000);
+            std::filesystem::resize_file(path, std::filesystem::file_size(path) - 16);
+
+            CaptureTraceReader reader{ path };
+            Assert::AreEqual(static_cast<size_t>(4), reader.FrameCount());
+        }
+
+        TEST_METHOD(ReplayRebuildsTheDesktop)
+        {
+            const auto path = TracePath("replay.drtrace");
+            WriteTrace(path, 30, true, 1000);
+
+            // apply every frame's dirty pixels to a canvas, then compare against the last writes
+            std::vector<uint32_t> canvas(DesktopWidth * DesktopHeight, 0);
+            std::vector<int> lastWrite(DesktopWidth * DesktopHeight, -1);
+
+            CaptureTraceReplay replay{ std::make_shared<CaptureTraceReader>(path) };
+            CaptureTraceFrame frame;
+            int index = 0;
+            while (replay.Next(frame))
+            {
+                const byte* pixels = frame.Pixels;
+                for (size_t i = 0; i < frame.DirtyRectsCount; ++i)
+                {
+                    const RECT& rect = frame.DirtyRects[i];
+                    for (LONG y = rect.top; y < rect.bottom; ++y)
+                    {
+                        const size_t rowSize = (rect.right - rect.left) * 4;
+                        std::memcpy(&canvas[y * DesktopWidth + rect.left], pixels, rowSize);
+                        pixels += rowSize;
+                        for (LONG x = rect.left; x < rect.right; ++x)
+                        {
+                            lastWrite[y * DesktopWidth + x] = index;
+                        }
+                    }
+                }
+                ++index;
+            }
+
+            Assert::AreEqual(30, index);
+            for (LONG y = 0; y < DesktopHeight; ++y)
+            {
+                for (LONG x = 0; x < DesktopWidth; ++x)
+                {
+                    const int written = lastWrite[y * DesktopWidth + x];
+                    const uint32_t expected = written < 0 ? 0 : PixelValue(written, x, y);
+                    Assert::AreEqual(expected, canvas[y * DesktopWidth + x]);
+                }
+            }
+        }
+
+        TEST_METHOD(RealTimeReplayKeepsPresentTimes)
+        {
+            // frames are 10 ticks apart at 1000 ticks per second
+            const auto path = TracePath("realtime.drtrace");
+            WriteTrace(path, 4, false, 1000);
+
+            CaptureTraceReplay replay{ std::make_shared<CaptureTraceReader>(path), ReplayPacing::RealTime };
+            CaptureTraceFrame frame;
+            const auto start = std::chrono::steady_clock::now();
+            while (replay.Next(frame))
+            {
+            }
+            const auto elapsed = std::chrono::steady_clock::now() - start;
+            Assert::IsTrue(elapsed >= std::chrono::milliseconds{ 30 });
+        }
+
+        TEST_METHOD(ReplayComposeBenchmark)
+        {
+            const auto path = TracePath("benchmark.drtrace");
+            WriteTrace(path, 500, false, 1000);
+
+            auto reader = std::make_shared<CaptureTraceReader>(path);
+            CaptureTraceReplay replay{ reader };
+            Region damage;
+            DirtyRectCoalescer coalescer;
+            CaptureTraceFrame frame;
+            size_t rects = 0;
+
+            const auto start = std::chrono::steady_clock::now();
+            while (replay.Next(frame))
+            {
+                damage.Reset(frame.DirtyRects, frame.DirtyRectsCount);
+                coalescer.Coalesce(damage.Rects(), damage.RectsCount());
+                rects += coalescer.RectsCount();
+            }
+            const auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+            const std::string message = "replayed " + std::to_string(reader->FrameCount()) + " frames (" +
+                std::to_string(rects) + " rects) in " + std::to_string(elapsed) + " us";
+            Logger::WriteMessage(message.c_str());
+        }
+    };
+}
@@ -0,0 +1,237 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+#include "..\VideoLibrary\ChangeDetector.h"
+#include "..\VideoLibrary\SyntheticDesktopSource.h"
+#include <string>
+
+using namespace std::chrono_literals;
+
+namespace VideoLibraryTests
+{
+namespace
+{
+    // A frame that only reports the pointer
+    class PointerFrame : public SourceFrame
+    {
+    public:
+        PointerFrame(LONG x, LONG y, bool visible, int64_t updateTime = 1, bool shapeUpdated = false)
+            : mPosition{}
+            , mUpdateTime{ updateTime }
+            , mShapeUpdated{ shapeUpdated }
+        {
+            mPosition.Position = POINT{ x, y };
+            mPosition.Visible = visible;
+        }
+
+        bool Captured() const override { return true; }
+        int64_t PresentationTime() const override { return 0; }
+        RECT DesktopMonitorBounds() const override { return RECT{ 0, 0, 640, 480 }; }
+        DXGI_MODE_ROTATION Rotation() const override { return DXGI_MODE_ROTATION_IDENTITY; }
+        const DXGI_OUTDUPL_MOVE_RECT* MoveRects() const override { return nullptr; }
+        size_t MoveRectsCount() const override { return 0; }
+        const RECT* DirtyRects() const override { return nullptr; }
+        size_t DirtyRectsCount() const override { return 0; }
+        DXGI_OUTDUPL_POINTER_POSITION PointerPosition() const override { return mPosition; }
+        int64_t PointerUpdateTime() const override { return mUpdateTime; }
+        bool PointerShapeUpdated() const override { return mShapeUpdated; }
+
+    private:
+        DXGI_OUTDUPL_POINTER_POSITION mPosition;
+        int64_t mUpdateTime;
+        bool mShapeUpdated;
+    };
+
+    struct RecordingLoad
+    {
+        uint64_t Ticks;
+        uint64_t Composed;
+        KeepAliveStats KeepAlive;
+    };
+
+    // Two desktop frames per tick of a 30 fps recording, composing only what changed
+    RecordingLoad Record(SyntheticScenario scenario, uint64_t ticks)
+    {
+        SyntheticDesktopOptions options;
+        options.Scenario = scenario;
+        options.FramesPerSecond = 60;
+        SyntheticDesktopSource desktop{ options };
+
+        ChangeDetector changes;
+        KeepAliveTimer keepAlive;
+        RecordingLoad load{ ticks, 0, {} };
+        for (uint64_t tick = 0; tick < ticks; ++tick)
+        {
+            for (int i = 0; i < 2; ++i)
+            {
+                std::shared_ptr<SourceFrame> frame = desktop.AcquireFrame();
+                if (!frame->Captured())
+                {
+                    continue;
+                }
+
+                changes.ObservePointer(*frame);
+                if (frame->DirtyRectsCount() != 0 || frame->MoveRectsCount() != 0)
+                {
+                    changes.MarkChanged();
+                }
+            }
+
+            const std::chrono::nanoseconds now = tick * 1s / 30;
+            if (changes.TakeChange() || keepAlive.Idle(now) == IdleTick::KeepAlive)
+            {
+                ++load.Composed;
+                keepAlive.Written(now);
+            }
+        }
+        load.KeepAlive = keepAlive.Stats();
+        return load;
+    }
+}
+
+    TEST_CLASS(ChangeDetectorTests)
+    {
+    public:
+        TEST_METHOD(FirstFrameIsAChange)
+        {
+            ChangeDetector changes;
+            Assert::IsTrue(changes.Pending());
+            Assert::IsTrue(changes.TakeChange());
+            Assert::IsFalse(changes.TakeChange());
+
+            changes.MarkChanged();
+            changes.MarkChanged();
+            Assert::IsTrue(changes.TakeChange());
+            Assert::IsFalse(changes.Pending());
+
+            const ChangeDetectorStats stats = changes.Stats();
+            Assert::AreEqual(static_cast<uint64_t>(2), stats.Changed);
+            Assert::AreEqual(static_cast<uint64_t>(1), stats.Unchanged);
+        }
+
+        TEST_METHOD(OnlyVisiblePointerUpdatesAreChanges)
+        {
+            ChangeDetector changes;
+            changes.ObservePointer(PointerFrame{ 10, 10, true });
+            changes.TakeChange();
+
+            // without an update time the position means nothing
+            changes.ObservePointer(PointerFrame{ 50, 50, true, 0 });
+            Assert::IsFalse(changes.Pending());
+
+            changes.ObservePointer(PointerFrame{ 10, 10, true });
+            Assert::IsFalse(changes.Pending());
+
+            changes.ObservePointer(PointerFrame{ 11, 10, true });
+            Assert::IsTrue(changes.TakeChange());
+
+            changes.ObservePointer(PointerFrame{ 11, 10, false });
+            Assert::IsTrue(changes.TakeChange());
+
+            changes.ObservePointer(PointerFrame{ 90, 90, false });
+            Assert::IsFalse(changes.Pending());
+
+            changes.ObservePointer(PointerFrame{ 90, 90, false, 1, true });
+            Assert::IsTrue(changes.TakeChange());
+
+            Assert::AreEqual(static_cast<uint64_t>(4), changes.Stats().PointerChanges);
+        }
+
+        TEST_METHOD(PointerRecordedApartIsNotAChange)
+        {
+            ChangeDetector changes;
+            changes.PointerDrawn(false);
+            changes.ObservePointer(PointerFrame{ 10, 10, true });
+            changes.TakeChange();
+
+            changes.ObservePointer(PointerFrame{ 20, 10, true });
+            changes.ObservePointer(PointerFrame{ 20, 10, false });
+            changes.ObservePointer(PointerFrame{ 20, 10, true, 1, true });
+            Assert::IsFalse(changes.Pending());
+            Assert::AreEqual(static_cast<uint64_t>(0), changes.Stats().PointerChanges);
+
+            // the pixels still change
+            changes.MarkChanged();
+            Assert::IsTrue(changes.TakeChange());
+
+            // drawing the pointer again changes the frames, then its moves do too
+            changes.PointerDrawn(true);
+            Assert::IsTrue(changes.TakeChange());
+            changes.ObservePointer(PointerFrame{ 30, 10, true });
+            Assert::IsTrue(changes.TakeChange());
+        }
+
+        TEST_METHOD(IdleTicksSignalOneGapThenKeepAlive)
+        {
+            KeepAliveTimer keepAlive{ 1s };
+
+            // no frame was written yet
+            Assert::IsTrue(keepAlive.Idle(0ms) == IdleTick::KeepAlive);
+            keepAlive.Written(0ms);
+
+            Assert::IsTrue(keepAlive.Idle(33ms) == IdleTick::SignalGap);
+            Assert::IsTrue(keepAlive.Idle(66ms) == IdleTick::Nothing);
+            Assert::IsTrue(keepAlive.Idle(999ms) == IdleTick::Nothing);
+            Assert::IsTrue(keepAlive.Idle(1000ms) == IdleTick::KeepAlive);
+            Assert::IsTrue(keepAlive.Idle(1033ms) == IdleTick::KeepAlive);
+            keepAlive.Written(1033ms);
+
+            // a changed frame starts a new stretch
+            Assert::IsTrue(keepAlive.Idle(1066ms) == IdleTick::SignalGap);
+
+            const KeepAliveStats stats = keepAlive.Stats();
+            Assert::AreEqual(static_cast<uint64_t>(2), stats.Written);
+            Assert::AreEqual(static_cast<uint64_t>(7), stats.Idle);
+            Assert::AreEqual(static_cast<uint64_t>(2), stats.Gaps);
+            Assert::AreEqual(static_cast<uint64_t>(3), stats.KeptAlive);
+
+            Assert::ExpectException<std::invalid_argument>([]() { KeepAliveTimer{ 0s }; });
+        }
+
+        TEST_METHOD(IdleDesktopIsOnlyComposedForThePointer)
+        {
+            const uint64_t ticks = 30 * 60;
+            const RecordingLoad idle = Record(SyntheticScenario::Idle, ticks);
+            const RecordingLoad typing = Record(SyntheticScenario::Typing, ticks);
+
+            // an idle desktop is only composed when the pointer moves, four times a second,
+            // with a gap signaled after each of them
+            Assert::IsTrue(idle.Composed < ticks / 5);
+            Assert::AreEqual(idle.Composed, idle.KeepAlive.Gaps);
+            Assert::AreEqual(static_cast<uint64_t>(0), idle.KeepAlive.KeptAlive);
+
+            // a changing desktop is composed at every tick
+            Assert::AreEqual(ticks, typing.Composed);
+            Assert::AreEqual(static_cast<uint64_t>(0), typing.KeepAlive.Idle);
+
+            for (const auto& run : { std::make_pair("idle", idle), std::make_pair("typing", typing) })
+            {
+                const std::string message = std::string{ run.first } + ": composed " + std::to_string(run.second.Composed) + " of " +
+                    std::to_string(run.second.Ticks) + " ticks, " + std::to_string(run.second.KeepAlive.KeptAlive) + " to keep alive, " +
+                    std::to_string(run.second.KeepAlive.Gaps) + " gaps signaled";
+                Logger::WriteMessage(message.c_str());
+            }
+        }
+    };
+}
@@ -0,0 +1,98 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+#include "..\VideoLibrary\DamageAccumulator.h"
+
+namespace VideoLibraryTests
+{
+    TEST_CLASS(DamageAccumulatorTests)
+    {
+    public:
+        TEST_METHOD(NoPendingDamageKeepsMoves)
+        {
+            const RECT dirty[] = { { 0, 0, 10, 10 } };
+            const DXGI_OUTDUPL_MOVE_RECT moves[] = { { { 0, 100 }, { 0, 50, 100, 150 } } };
+
+            DamageAccumulator accumulator;
+            Region damage;
+            Assert::IsTrue(accumulator.Apply(dirty, 1, moves, 1, damage));
+            Assert::AreEqual(static_cast<int64_t>(100), damage.Area());
+            Assert::AreEqual(static_cast<int64_t>(0), accumulator.AppliedArea());
+        }
+
+        TEST_METHOD(SkippedFramesAreAppliedAsOneUnion)
+        {
+            const RECT first[] = { { 0, 0, 100, 100 } };
+            const RECT second[] = { { 50, 50, 150, 150 } };
+            const DXGI_OUTDUPL_MOVE_RECT moves[] = { { { 500, 500 }, { 300, 300, 310, 310 } } };
+
+            DamageAccumulator accumulator;
+            accumulator.Accumulate(first, 1, nullptr, 0);
+            accumulator.Accumulate(second, 1, moves, 1);
+
+            Assert::IsTrue(accumulator.HasPendingDamage());
+            Assert::AreEqual(static_cast<uint64_t>(2), accumulator.SkippedFrames());
+
+            // the overlap between the two frames is only counted once
+            const int64_t expected = 100 * 100 + 100 * 100 - 50 * 50 + 10 * 10;
+            Assert::AreEqual(expected, accumulator.AccumulatedArea());
+
+            const RECT current[] = { { 1000, 0, 1010, 10 } };
+            Region damage;
+            accumulator.Apply(current, 1, nullptr, 0, damage);
+
+            Assert::IsFalse(accumulator.HasPendingDamage());
+            Assert::AreEqual(expected, accumulator.AppliedArea());
+            Assert::AreEqual(expected + 100, damage.Area());
+            Assert::AreEqual(static_cast<uint64_t>(1), accumulator.RecoveredFrames());
+        }
+
+        TEST_METHOD(MovesBecomeDamageWhilePending)
+        {
+            const RECT skipped[] = { { 0, 0, 10, 10 } };
+            const DXGI_OUTDUPL_MOVE_RECT moves[] = { { { 0, 0 }, { 0, 20, 40, 60 } } };
+
+            DamageAccumulator accumulator;
+            accumulator.Accumulate(skipped, 1, nullptr, 0);
+
+            Region damage;
+            Assert::IsFalse(accumulator.Apply(nullptr, 0, moves, 1, damage));
+            Assert::IsTrue(damage.Contains(POINT{ 5, 5 }));
+            Assert::IsTrue(damage.Contains(POINT{ 39, 59 }));
+            Assert::AreEqual(static_cast<int64_t>(100 + 40 * 40), damage.Area());
+
+            // the next frame draws its moves again
+            Assert::IsTrue(accumulator.Apply(nullptr, 0, moves, 1, damage));
+            Assert::IsTrue(damage.IsEmpty());
+        }
+
+        TEST_METHOD(ResetDropsPendingDamage)
+        {
+            const RECT skipped[] = { { 0, 0, 10, 10 } };
+            DamageAccumulator accumulator;
+            accumulator.Accumulate(skipped, 1, nullptr, 0);
+            accumulator.Reset();
+            Assert::IsFalse(accumulator.HasPendingDamage());
+        }
+    };
+}
@@ -0,0 +1,198 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+#include "..\VideoLibrary\DamageHistory.h"
+#include <random>
+#include <stdexcept>
+
+namespace VideoLibraryTests
+{
+namespace
+{
+    constexpr LONG SurfaceWidth = 320;
+    constexpr LONG SurfaceHeight = 200;
+
+    // One value per pixel
+    class Image
+    {
+    public:
+        Image() : mPixels(SurfaceWidth * SurfaceHeight, 0) {}
+
+        void Fill(const RECT& rect, uint32_t value)
+        {
+            for (LONG y = rect.top; y < rect.bottom; ++y)
+            {
+                for (LONG x = rect.left; x < rect.right; ++x)
+                {
+                    mPixels[y * SurfaceWidth + x] = value;
+                }
+            }
+        }
+
+        void CopyFrom(const Image& source, const RECT& rect)
+        {
+            for (LONG y = rect.top; y < rect.bottom; ++y)
+            {
+                for (LONG x = rect.left; x < rect.right; ++x)
+                {
+                    mPixels[y * SurfaceWidth + x] = source.mPixels[y * SurfaceWidth + x];
+                }
+            }
+        }
+
+        bool operator==(const Image& other) const { return mPixels == other.mPixels; }
+
+    private:
+        std::vector<uint32_t> mPixels;
+    };
+
+    // A pooled copy of the surface and what the history needs to know about it
+    struct PooledImage
+    {
+        Image Pixels;
+        uint64_t Generation = DamageHistory::UnknownGeneration;
+        RECT Overlay{};
+    };
+
+    RECT RandomRect(std::mt19937& random, LONG maxSize)
+    {
+        std::uniform_int_distribution<LONG> x{ 0, SurfaceWidth - 1 };
+        std::uniform_int_distribution<LONG> y{ 0, SurfaceHeight - 1 };
+        std::uniform_int_distribution<LONG> size{ 1, maxSize };
+        const LONG left = x(random);
+        const LONG top = y(random);
+        return RECT{ left, top, (std::min)(SurfaceWidth, left + size(random)), (std::min)(SurfaceHeight, top + size(random)) };
+    }
+
+    const RECT SurfaceBounds{ 0, 0, SurfaceWidth, SurfaceHeight };
+}
+
+    TEST_CLASS(DamageHistoryTests)
+    {
+    public:
+        TEST_METHOD(PartialCopiesMatchTheSurface)
+        {
+            std::mt19937 random{ 17 };
+            DamageHistory history{ SurfaceBounds };
+            Image surface;
+            std::vector<PooledImage> pool(3);
+
+            for (uint32_t frame = 1; frame <= 2000; ++frame)
+            {
+                // a few small changes, now and then a large one
+                Region damage;
+                const int changes = frame % 97 == 0 ? 1 : 1 + static_cast<int>(random() % 4);
+                for (int i = 0; i < changes; ++i)
+                {
+                    const RECT rect = RandomRect(random, frame % 97 == 0 ? SurfaceWidth : 24);
+                    surface.Fill(rect, frame * 16 + i);
+                    damage.Union(rect);
+                }
+                history.Add(damage);
+
+                // the encoder holds on to the textures for a varying number of frames
+                PooledImage& pooled = pool[random() % pool.size()];
+                Region copy;
+                copy.Union(pooled.Overlay);
+                if (history.DamageSince(pooled.Generation, copy))
+                {
+                    for (size_t i = 0; i < copy.RectsCount(); ++i)
+                    {
+                        pooled.Pixels.CopyFrom(surface, copy.Rects()[i]);
+                    }
+                }
+                else
+                {
+                    pooled.Pixels = surface;
+                }
+                Assert::IsTrue(pooled.Pixels == surface);
+
+                // the pointer is drawn over the copy
+                pooled.Overlay = RandomRect(random, 32);
+                pooled.Pixels.Fill(pooled.Overlay, 0xFFFFFFFF);
+                pooled.Generation = history.Generation();
+            }
+
+            Assert::IsTrue(history.PartialCopies() > history.FullCopies() * 10);
+            Assert::IsTrue(history.AreaSaved() > 0);
+        }
+
+        TEST_METHOD(FallsBackToFullCopies)
+        {
+            DamageHistory history{ SurfaceBounds, 4 };
+            Region damage;
+
+            // contents unknown
+            Assert::IsFalse(history.DamageSince(DamageHistory::UnknownGeneration, damage));
+
+            const uint64_t start = history.Generation();
+            Assert::IsTrue(history.DamageSince(start, damage));
+            Assert::IsTrue(damage.IsEmpty());
+
+            for (LONG i = 0; i < 4; ++i)
+            {
+                history.Add(Region{ RECT{ i * 10, 0, i * 10 + 5, 5 } });
+            }
+            Assert::IsTrue(history.DamageSince(start, damage));
+            Assert::AreEqual(static_cast<int64_t>(4 * 25), damage.Area());
+
+            // older than the history
+            history.Add(Region{ RECT{ 0, 0, 1, 1 } });
+            damage.Clear();
+            Assert::IsFalse(history.DamageSince(start, damage));
+            damage.Clear();
+            Assert::IsTrue(history.DamageSince(start + 1, damage));
+
+            // more than half the surface
+            const uint64_t beforeLarge = history.Generation();
+            history.Add(Region{ RECT{ 0, 0, SurfaceWidth, SurfaceHeight / 2 + 1 } });
+            damage.Clear();
+            Assert::IsFalse(history.DamageSince(beforeLarge, damage));
+
+            // too many pieces
+            const uint64_t beforeScattered = history.Generation();
+            Region scattered;
+            for (LONG i = 0; i <= static_cast<LONG>(DamageHistory::MaxRects); ++i)
+            {
+                scattered.Union(RECT{ (i % 40) * 8, (i / 40) * 8, (i % 40) * 8 + 2, (i / 40) * 8 + 2 });
+            }
+            history.Add(scattered);
+            damage.Clear();
+            Assert::IsFalse(history.DamageSince(beforeScattered, damage));
+
+            // damage outside the surface is ignored
+            const uint64_t beforeOutside = history.Generation();
+            history.Add(Region{ RECT{ -50, -50, 10, 10 } });
+            damage.Clear();
+            Assert::IsTrue(history.DamageSince(beforeOutside, damage));
+            Assert::AreEqual(static_cast<int64_t>(100), damage.Area());
+        }
+
+        TEST_METHOD(RejectsBadArguments)
+        {
+            Assert::ExpectException<std::invalid_argument>([]() { DamageHistory history{ SurfaceBounds, 0 }; });
+            Assert::ExpectException<std::invalid_argument>([]() { DamageHistory history{ RECT{ 0, 0, 0, 10 } }; });
+        }
+    };
+}
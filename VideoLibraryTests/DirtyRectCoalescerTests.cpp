@@ -0,0 +1,175 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+#include "..\VideoLibrary\DirtyRectCoalescer.h"
+#include <chrono>
+#include <random>
+#include <string>
+
+namespace VideoLibraryTests
+{
+    TEST_CLASS(DirtyRectCoalescerTests)
+    {
+    public:
+        TEST_METHOD(OverlappingRectsAreMerged)
+        {
+            const std::vector<RECT> rects = {
+                { 0, 0, 100, 20 },
+                { 0, 10, 100, 30 },
+            };
+
+            DirtyRectCoalescer coalescer{ 0 };
+            coalescer.Coalesce(rects.data(), rects.size());
+
+            Assert::AreEqual(static_cast<size_t>(1), coalescer.RectsCount());
+            Assert::AreEqual(0L, static_cast<long>(coalescer.Rects()[0].top));
+            Assert::AreEqual(30L, static_cast<long>(coalescer.Rects()[0].bottom));
+            Assert::IsTrue(coalescer.OutputArea() < coalescer.InputArea());
+        }
+
+        TEST_METHOD(AdjacentRectsAreMerged)
+        {
+            // a row of glyph sized rects like the ones reported while typing
+            std::vector<RECT> rects;
+            for (LONG i = 0; i < 10; ++i)
+            {
+                rects.push_back(RECT{ i * 8, 100, i * 8 + 8, 116 });
+            }
+
+            DirtyRectCoalescer coalescer{ 0 };
+            coalescer.Coalesce(rects.data(), rects.size());
+
+            Assert::AreEqual(static_cast<size_t>(1), coalescer.RectsCount());
+            Assert::AreEqual(coalescer.InputArea(), coalescer.OutputArea());
+        }
+
+        TEST_METHOD(ThresholdControlsNearlyAdjacentMerges)
+        {
+            // 10x10 rects with a 2 pixel gap, merging adds 20 unchanged pixels
+            const std::vector<RECT> rects = {
+                { 0, 0, 10, 10 },
+                { 12, 0, 22, 10 },
+            };
+
+            DirtyRectCoalescer strict{ 19 };
+            strict.Coalesce(rects.data(), rects.size());
+            Assert::AreEqual(static_cast<size_t>(2), strict.RectsCount());
+
+            DirtyRectCoalescer relaxed{ 20 };
+            relaxed.Coalesce(rects.data(), rects.size());
+            Assert::AreEqual(static_cast<size_t>(1), relaxed.RectsCount());
+        }
+
+        TEST_METHOD(DistantRectsAreKept)
+        {
+            const std::vector<RECT> rects = {
+                { 0, 0, 16, 16 },
+                { 1000, 700, 1016, 716 },
+                { 0, 0, 0, 0 },
+            };
+
+            DirtyRectCoalescer coalescer;
+            coalescer.Coalesce(rects.data(), rects.size());
+
+            Assert::AreEqual(static_cast<size_t>(2), coalescer.RectsCount());
+        }
+
+        TEST_METHOD(OutputCoversEveryInputPixel)
+        {
+            constexpr LONG size = 128;
+            std::mt19937 random{ 1234 };
+            std::uniform_int_distribution<LONG> position{ 0, size - 1 };
+
+            for (int run = 0; run < 50; ++run)
+            {
+                std::vector<RECT> rects;
+                for (int i = 0; i < 40; ++i)
+                {
+                    const LONG x = position(random);
+                    const LONG y = position(random);
+                    rects.push_back(RECT{ x, y, (std::min)(size, x + 1 + position(random) / 8), (std::min)(size, y + 1 + position(random) / 8) });
+                }
+
+                DirtyRectCoalescer coalescer{ 256 };
+                coalescer.Coalesce(rects.data(), rects.size());
+
+                std::vector<int> covered(size * size, 0);
+                for (size_t i = 0; i < coalescer.RectsCount(); ++i)
+                {
+                    const RECT& r = coalescer.Rects()[i];
+                    for (LONG y = r.top; y < r.bottom; ++y)
+                    {
+                        for (LONG x = r.left; x < r.right; ++x)
+                        {
+                            covered[y * size + x] = 1;
+                        }
+                    }
+                }
+
+                for (const RECT& r : rects)
+                {
+                    for (LONG y = r.top; y < r.bottom; ++y)
+                    {
+                        for (LONG x = r.left; x < r.right; ++x)
+                        {
+                            Assert::AreEqual(1, covered[y * size + x]);
+                        }
+                    }
+                }
+            }
+        }
+
+        TEST_METHOD(CoalesceBenchmark)
+        {
+            // a busy desktop: many small rects clustered in a few windows
+            std::mt19937 random{ 42 };
+            std::uniform_int_distribution<LONG> cluster{ 0, 3 };
+            std::uniform_int_distribution<LONG> offset{ 0, 400 };
+            std::uniform_int_distribution<LONG> extent{ 4, 24 };
+
+            std::vector<RECT> rects;
+            for (int i = 0; i < 500; ++i)
+            {
+                const LONG x = cluster(random) * 480 + offset(random);
+                const LONG y = cluster(random) * 270 + offset(random) / 2;
+                rects.push_back(RECT{ x, y, x + extent(random), y + extent(random) });
+            }
+
+            DirtyRectCoalescer coalescer;
+            constexpr int iterations = 200;
+            const auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < iterations; ++i)
+            {
+                coalescer.Coalesce(rects.data(), rects.size());
+            }
+            const auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+            const std::string message = "coalesced " + std::to_string(rects.size()) + " rects into " +
+                std::to_string(coalescer.RectsCount()) + " in " + std::to_string(elapsed / iterations) + " us";
+            Logger::WriteMessage(message.c_str());
+
+            Assert::IsTrue(coalescer.RectsCount() < rects.size());
+        }
+    };
+}
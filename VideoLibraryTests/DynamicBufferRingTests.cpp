@@ -0,0 +1,205 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+#include "..\VideoLibrary\DynamicBufferRing.h"
+#include "..\VideoLibrary\SyntheticDesktopSource.h"
+#include "..\VideoLibrary\FramePlanner.h"
+#include "..\VideoLibrary\PackedRect.h"
+#include <cstring>
+#include <stdexcept>
+
+namespace VideoLibraryTests
+{
+namespace
+{
+    // Keeps buffers in memory and counts what the renderers ask of the device
+    class CountingBufferDevice : public DynamicBufferDevice
+    {
+    public:
+        class Buffer : public DynamicBuffer
+        {
+        public:
+            explicit Buffer(size_t size) : Contents(size), Mapped{ false } {}
+
+            size_t Size() const override { return Contents.size(); }
+
+            std::vector<uint8_t> Contents;
+            bool Mapped;
+        };
+
+        std::shared_ptr<DynamicBuffer> CreateBuffer(DynamicBufferBinding binding, size_t size) override
+        {
+            ++Creations;
+            return std::make_shared<Buffer>(size);
+        }
+
+        void* Map(DynamicBuffer& buffer, BufferMapMode mode) override
+        {
+            Buffer& mapped = static_cast<Buffer&>(buffer);
+            Assert::IsFalse(mapped.Mapped, L"buffer mapped twice");
+            mapped.Mapped = true;
+            ++(mode == BufferMapMode::Discard ? DiscardMaps : NoOverwriteMaps);
+            return mapped.Contents.data();
+        }
+
+        void Unmap(DynamicBuffer& buffer) override
+        {
+            Buffer& mapped = static_cast<Buffer&>(buffer);
+            Assert::IsTrue(mapped.Mapped, L"buffer unmapped without a map");
+            mapped.Mapped = false;
+        }
+
+        uint64_t Creations = 0;
+        uint64_t DiscardMaps = 0;
+        uint64_t NoOverwriteMaps = 0;
+    };
+
+    bool Holds(const BufferSpan& span, const void* data)
+    {
+        const auto& contents = static_cast<CountingBufferDevice::Buffer*>(span.Buffer)->Contents;
+        return std::memcmp(contents.data() + span.Offset, data, span.Size) == 0;
+    }
+}
+
+    TEST_CLASS(DynamicBufferRingTests)
+    {
+    public:
+        TEST_METHOD(SteadyStateCreatesNoBuffers)
+        {
+            auto device = std::make_shared<CountingBufferDevice>();
+            DynamicBufferRing ring{ device };
+            auto constants = device->CreateBuffer(DynamicBufferBinding::Constant, sizeof(PackedRectConstants));
+
+            SyntheticDesktopOptions options;
+            options.Width = 640;
+            options.Height = 360;
+            options.FramesPerScenario = 60;
+            SyntheticDesktopSource source{ options };
+            FramePlanner planner;
+
+            DirtyRectVertexLayout layout{ 640, 360, 0, 0, 640, 360 };
+            std::vector<PackedRect> instances;
+            std::vector<Vertex> pointer(g_VerticesPerRect);
+
+            uint64_t creationsAfterWarmup = 0;
+            for (int frameNumber = 0; frameNumber < 3000; ++frameNumber)
+            {
+                // every scenario has been seen once after warming up
+                if (frameNumber == 600)
+                {
+                    creationsAfterWarmup = device->Creations;
+                }
+
+                auto frame = source.AcquireFrame();
+                if (!frame->Captured())
+                {
+                    continue;
+                }
+
+                planner.Plan(*frame);
+                instances.resize(planner.DirtyRectsCount());
+                PackDirtyRects(frame->Rotation(), planner.DirtyRects(), planner.DirtyRectsCount(), layout, instances.data());
+
+                const BufferSpan dirty = ring.Write(instances.data(), instances.size() * sizeof(PackedRect), sizeof(PackedRect));
+                const PackedRectConstants values = MakePackedRectConstants(frame->Rotation(), layout);
+                device->Update(*constants, &values, sizeof(values));
+
+                pointer[0].pos.x = static_cast<float>(frameNumber);
+                const BufferSpan pointerSpan = ring.Write(pointer.data(), pointer.size() * sizeof(Vertex), 16);
+
+                Assert::AreEqual(static_cast<size_t>(0), dirty.Offset % sizeof(PackedRect));
+                Assert::AreEqual(static_cast<size_t>(0), pointerSpan.Offset % 16);
+                Assert::IsTrue(Holds(dirty, instances.data()));
+                Assert::IsTrue(Holds(pointerSpan, pointer.data()));
+            }
+
+            Assert::AreEqual(creationsAfterWarmup, device->Creations);
+            Assert::IsTrue(device->NoOverwriteMaps > 10 * ring.Discards(), L"the ring should mostly append");
+        }
+
+        TEST_METHOD(AppendsUntilTheRingWraps)
+        {
+            auto device = std::make_shared<CountingBufferDevice>();
+            DynamicBufferRing ring{ device, 1024 };
+
+            const std::vector<uint8_t> data(100, 7);
+            BufferSpan previous = ring.Write(data.data(), data.size(), 16);
+            Assert::AreEqual(static_cast<size_t>(0), previous.Offset);
+            Assert::AreEqual(static_cast<uint64_t>(1), device->DiscardMaps);
+
+            for (int i = 0; i < 20; ++i)
+            {
+                const BufferSpan span = ring.Write(data.data(), data.size(), 16);
+                if (span.Offset == 0)
+                {
+                    // wrapped, the whole buffer was discarded
+                    Assert::IsTrue(previous.Offset + previous.Size + 100 > ring.Capacity());
+                }
+                else
+                {
+                    Assert::IsTrue(span.Offset >= previous.Offset + previous.Size, L"no-overwrite writes must not overlap");
+                }
+                previous = span;
+            }
+
+            Assert::AreEqual(ring.Discards(), device->DiscardMaps);
+            Assert::AreEqual(static_cast<uint64_t>(1), device->Creations);
+        }
+
+        TEST_METHOD(GrowsFromTheHighWaterMark)
+        {
+            auto device = std::make_shared<CountingBufferDevice>();
+            DynamicBufferRing ring{ device, 1024 };
+
+            const std::vector<uint8_t> large(5000, 1);
+            const BufferSpan span = ring.Write(large.data(), large.size(), 16);
+            Assert::IsTrue(Holds(span, large.data()));
+            Assert::AreEqual(static_cast<size_t>(5000), ring.HighWaterMark());
+            Assert::IsTrue(ring.Capacity() >= 5000 * DynamicBufferRing::WritesPerRing);
+            Assert::AreEqual(static_cast<uint64_t>(1), ring.Grows());
+
+            // smaller writes reuse the buffer
+            const std::vector<uint8_t> small(64, 2);
+            for (int i = 0; i < 1000; ++i)
+            {
+                ring.Write(small.data(), small.size(), 16);
+            }
+            Assert::AreEqual(static_cast<uint64_t>(1), device->Creations);
+        }
+
+        TEST_METHOD(RejectsBadArguments)
+        {
+            auto device = std::make_shared<CountingBufferDevice>();
+            Assert::ExpectException<std::invalid_argument>([]() { DynamicBufferRing ring{ nullptr }; });
+            Assert::ExpectException<std::invalid_argument>([&]() { DynamicBufferRing ring{ device, 0 }; });
+
+            DynamicBufferRing ring{ device };
+            const uint8_t data[4] = {};
+            Assert::ExpectException<std::invalid_argument>([&]() { ring.Write(data, sizeof(data), 3); });
+
+            auto constants = device->CreateBuffer(DynamicBufferBinding::Constant, 16);
+            const uint8_t tooLarge[32] = {};
+            Assert::ExpectException<std::invalid_argument>([&]() { device->Update(*constants, tooLarge, sizeof(tooLarge)); });
+        }
+    };
+}
@@ -0,0 +1,138 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+#include "..\VideoLibrary\FrameMetadataPool.h"
+#include <cstring>
+#include <thread>
+
+namespace VideoLibraryTests
+{
+    TEST_CLASS(FrameMetadataPoolTests)
+    {
+    public:
+        TEST_METHOD(BlocksAreRecycled)
+        {
+            auto pool = std::make_shared<FrameMetadataPool>(2, 256);
+            const byte* first = nullptr;
+            {
+                FrameMetadata metadata = pool->Acquire();
+                first = metadata.Data();
+                Assert::AreEqual(static_cast<size_t>(1), pool->FreeCount());
+            }
+            Assert::AreEqual(static_cast<size_t>(2), pool->FreeCount());
+
+            FrameMetadata again = pool->Acquire();
+            Assert::IsTrue(again.Data() == first);
+            Assert::AreEqual(static_cast<size_t>(0), pool->Allocations());
+        }
+
+        TEST_METHOD(FramesInFlightKeepTheirData)
+        {
+            // each frame's rects must survive the capture of the next frames
+            auto pool = std::make_shared<FrameMetadataPool>(3, 64);
+            FrameMetadata frames[3];
+            for (int i = 0; i < 3; ++i)
+            {
+                frames[i] = pool->Acquire();
+                frames[i].Resize(64);
+                std::memset(frames[i].Data(), i + 1, 64);
+            }
+
+            for (int i = 0; i < 3; ++i)
+            {
+                for (size_t j = 0; j < 64; ++j)
+                {
+                    Assert::AreEqual(static_cast<int>(i + 1), static_cast<int>(frames[i].Data()[j]));
+                }
+            }
+            Assert::AreEqual(static_cast<size_t>(0), pool->FreeCount());
+        }
+
+        TEST_METHOD(HandlesShareOneBlock)
+        {
+            auto pool = std::make_shared<FrameMetadataPool>(1, 16);
+            FrameMetadata metadata = pool->Acquire();
+            {
+                FrameMetadata copy = metadata;
+                Assert::AreEqual(2u, static_cast<unsigned>(metadata.UseCount()));
+                Assert::IsTrue(copy.Data() == metadata.Data());
+            }
+            Assert::AreEqual(1u, static_cast<unsigned>(metadata.UseCount()));
+            Assert::AreEqual(static_cast<size_t>(0), pool->FreeCount());
+
+            FrameMetadata moved = std::move(metadata);
+            Assert::IsFalse(static_cast<bool>(metadata));
+            moved = FrameMetadata{};
+            Assert::AreEqual(static_cast<size_t>(1), pool->FreeCount());
+        }
+
+        TEST_METHOD(PoolGrowsWhenExhausted)
+        {
+            auto pool = std::make_shared<FrameMetadataPool>(1, 16);
+            FrameMetadata a = pool->Acquire();
+            FrameMetadata b = pool->Acquire();
+            b.Resize(1024);
+
+            Assert::AreEqual(static_cast<size_t>(2), pool->BlockCount());
+            Assert::AreEqual(static_cast<size_t>(2), pool->Allocations());
+            Assert::IsTrue(b.Capacity() >= 1024);
+        }
+
+        TEST_METHOD(SteadyStateDoesNotAllocate)
+        {
+            auto pool = std::make_shared<FrameMetadataPool>();
+            FrameMetadata previous;
+            for (int frame = 0; frame < 10000; ++frame)
+            {
+                // two frames in flight: the one being processed and the one being captured
+                FrameMetadata current = pool->Acquire();
+                current.Resize(static_cast<size_t>(frame % 100) * 16);
+                previous = std::move(current);
+            }
+            Assert::AreEqual(static_cast<size_t>(0), pool->Allocations());
+        }
+
+        TEST_METHOD(BlocksOutliveThePool)
+        {
+            FrameMetadata metadata;
+            {
+                auto pool = std::make_shared<FrameMetadataPool>(1, 32);
+                metadata = pool->Acquire();
+            }
+            metadata.Resize(32);
+            metadata.Data()[31] = 7;
+        }
+
+        TEST_METHOD(ReleaseFromOtherThreads)
+        {
+            auto pool = std::make_shared<FrameMetadataPool>(3, 64);
+            for (int i = 0; i < 1000; ++i)
+            {
+                FrameMetadata metadata = pool->Acquire();
+                std::thread worker{ [m = std::move(metadata)]() mutable { m = FrameMetadata{}; } };
+                worker.join();
+            }
+            Assert::AreEqual(static_cast<size_t>(3), pool->FreeCount());
+        }
+    };
+}
@@ -0,0 +1,221 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+#include "..\VideoLibrary\FramePacer.h"
+#include <string>
+
+using namespace std::chrono_literals;
+
+namespace VideoLibraryTests
+{
+namespace
+{
+    // Time only moves when the pacer sleeps or spins, or when the test does work
+    class VirtualClock : public PacerClock
+    {
+    public:
+        explicit VirtualClock(std::chrono::nanoseconds granularity = 1ms) : mGranularity{ granularity } {}
+
+        virtual std::chrono::nanoseconds Now() override
+        {
+            return mTime;
+        }
+
+        // Wakes on the next timer interrupt after the duration, like a coarse OS timer
+        virtual void Sleep(std::chrono::nanoseconds duration) override
+        {
+            const auto wake = mTime + duration;
+            mTime = (wake / mGranularity + (wake % mGranularity != 0ns ? 1 : 0)) * mGranularity;
+        }
+
+        virtual void Pause() override
+        {
+            mTime += SpinStep;
+        }
+
+        void Work(std::chrono::nanoseconds duration)
+        {
+            mTime += duration;
+        }
+
+        static constexpr std::chrono::nanoseconds SpinStep{ 1000 };
+
+    private:
+        std::chrono::nanoseconds mTime{ 5ms };
+        std::chrono::nanoseconds mGranularity;
+    };
+
+    FramePacerOptions Options(uint32_t frameRate, LateTickPolicy policy, std::chrono::nanoseconds spinThreshold)
+    {
+        FramePacerOptions options;
+        options.FrameRate = frameRate;
+        options.LatePolicy = policy;
+        options.SpinThreshold = spinThreshold;
+        return options;
+    }
+
+    std::chrono::nanoseconds DeadlineAt(uint64_t index, uint32_t frameRate)
+    {
+        return 5ms + std::chrono::nanoseconds{ static_cast<int64_t>(index * 1000000000ull / frameRate) };
+    }
+}
+
+    TEST_CLASS(FramePacerTests)
+    {
+    public:
+        TEST_METHOD(DeadlinesDoNotDriftWithWork)
+        {
+            auto clock = std::make_shared<VirtualClock>();
+            FramePacer pacer{ clock, Options(30, LateTickPolicy::Drop, 2ms) };
+
+            for (uint64_t i = 0; i < 3000; ++i)
+            {
+                const FrameTick tick = pacer.WaitForTick();
+                Assert::AreEqual(i, tick.Index);
+                Assert::IsTrue(DeadlineAt(i, 30) == tick.Deadline);
+                Assert::IsTrue(tick.Lateness < VirtualClock::SpinStep);
+                clock->Work(10ms);
+            }
+
+            // 100 seconds of ticks end 100 seconds in, whatever the work took
+            const FramePacerStats stats = pacer.Stats();
+            Assert::AreEqual(static_cast<uint64_t>(3000), stats.Ticks);
+            Assert::AreEqual(static_cast<uint64_t>(0), stats.Dropped);
+            Assert::AreEqual(static_cast<uint64_t>(0), stats.Late);
+            Assert::IsTrue(clock->Now() - DeadlineAt(2999, 30) < 10ms + VirtualClock::SpinStep);
+            Assert::IsTrue(stats.MaxJitter < VirtualClock::SpinStep);
+        }
+
+        TEST_METHOD(SpinningHidesTimerGranularity)
+        {
+            // a 15.6 ms timer, as Windows has by default
+            auto coarse = std::make_shared<VirtualClock>(15600us);
+            FramePacer sleepOnly{ coarse, Options(30, LateTickPolicy::CatchUp, 0ns) };
+            for (int i = 0; i < 600; ++i)
+            {
+                sleepOnly.WaitForTick();
+                coarse->Work(1ms);
+            }
+
+            auto hybridClock = std::make_shared<VirtualClock>(15600us);
+            FramePacer hybrid{ hybridClock, Options(30, LateTickPolicy::CatchUp, 16ms) };
+            for (int i = 0; i < 600; ++i)
+            {
+                hybrid.WaitForTick();
+                hybridClock->Work(1ms);
+            }
+
+            const FramePacerStats sleepStats = sleepOnly.Stats();
+            const FramePacerStats hybridStats = hybrid.Stats();
+            Assert::IsTrue(sleepStats.MaxJitter > 5ms);
+            Assert::AreEqual(static_cast<uint64_t>(0), hybridStats.Late);
+            Assert::IsTrue(hybridStats.MaxJitter < VirtualClock::SpinStep);
+            Assert::IsTrue(hybridStats.Spun > 0ns && hybridStats.Slept > 0ns);
+
+            const std::string message = "30 fps on a 15.6 ms timer: sleeping jitter mean " +
+                std::to_string(sleepStats.MeanJitter.count() / 1000) + " us, max " + std::to_string(sleepStats.MaxJitter.count() / 1000) +
+                " us, hybrid max " + std::to_string(hybridStats.MaxJitter.count()) + " ns";
+            Logger::WriteMessage(message.c_str());
+        }
+
+        TEST_METHOD(DropSkipsToTheNewestDueTick)
+        {
+            auto clock = std::make_shared<VirtualClock>();
+            FramePacer pacer{ clock, Options(30, LateTickPolicy::Drop, 2ms) };
+
+            Assert::AreEqual(static_cast<uint64_t>(0), pacer.WaitForTick().Index);
+            clock->Work(100ms + 1us);
+
+            const FrameTick late = pacer.WaitForTick();
+            Assert::AreEqual(static_cast<uint64_t>(3), late.Index);
+            Assert::AreEqual(static_cast<uint64_t>(2), late.Dropped);
+            Assert::IsTrue(late.Lateness == 1us);
+
+            const FrameTick next = pacer.WaitForTick();
+            Assert::AreEqual(static_cast<uint64_t>(4), next.Index);
+            Assert::IsTrue(next.Lateness < VirtualClock::SpinStep);
+
+            const FramePacerStats stats = pacer.Stats();
+            Assert::AreEqual(static_cast<uint64_t>(3), stats.Ticks);
+            Assert::AreEqual(static_cast<uint64_t>(2), stats.Dropped);
+            Assert::AreEqual(static_cast<uint64_t>(1), stats.Late);
+        }
+
+        TEST_METHOD(CatchUpRunsLateTicksThenDrops)
+        {
+            auto clock = std::make_shared<VirtualClock>();
+            FramePacerOptions options = Options(30, LateTickPolicy::CatchUp, 2ms);
+            options.MaxCatchUp = 2;
+            FramePacer pacer{ clock, options };
+
+            pacer.WaitForTick();
+            clock->Work(170ms);
+
+            // two late ticks back to back, then the pacer gives up on 3 and 4
+            const FrameTick first = pacer.WaitForTick();
+            const FrameTick second = pacer.WaitForTick();
+            const FrameTick third = pacer.WaitForTick();
+            Assert::AreEqual(static_cast<uint64_t>(1), first.Index);
+            Assert::AreEqual(static_cast<uint64_t>(2), second.Index);
+            Assert::AreEqual(static_cast<uint64_t>(0), second.Dropped);
+            Assert::AreEqual(static_cast<uint64_t>(5), third.Index);
+            Assert::AreEqual(static_cast<uint64_t>(2), third.Dropped);
+            Assert::IsTrue(clock->Now() == 175ms);
+
+            const FrameTick onTime = pacer.WaitForTick();
+            Assert::AreEqual(static_cast<uint64_t>(6), onTime.Index);
+            Assert::IsTrue(onTime.Lateness < VirtualClock::SpinStep);
+            Assert::AreEqual(static_cast<uint64_t>(3), pacer.Stats().Late);
+        }
+
+        TEST_METHOD(ClosestFrameKeepsTheNearestCandidate)
+        {
+            ClosestFrame<int> closest;
+            int frame = 0;
+            closest.Reset(100ms);
+            Assert::IsFalse(closest.Take(frame));
+
+            Assert::IsTrue(closest.Offer(70ms, 1));
+            Assert::IsTrue(closest.Offer(95ms, 2));
+            Assert::IsFalse(closest.Offer(110ms, 3));
+            Assert::IsTrue(closest.Take(frame));
+            Assert::AreEqual(2, frame);
+            Assert::IsFalse(closest.Take(frame));
+
+            // a tie goes to the newer frame
+            closest.Reset(200ms);
+            closest.Offer(190ms, 4);
+            Assert::IsTrue(closest.Offer(210ms, 5));
+            Assert::IsTrue(closest.Take(frame));
+            Assert::AreEqual(5, frame);
+        }
+
+        TEST_METHOD(RejectsBadOptions)
+        {
+            auto clock = std::make_shared<VirtualClock>();
+            Assert::ExpectException<std::invalid_argument>([clock]() { FramePacer pacer{ clock, Options(0, LateTickPolicy::Drop, 0ns) }; });
+            Assert::ExpectException<std::invalid_argument>([]() { FramePacer pacer{ nullptr }; });
+        }
+    };
+}
@@ -0,0 +1,268 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+#include "..\VideoLibrary\SyntheticDesktopSource.h"
+#include "..\VideoLibrary\TraceFrameSource.h"
+#include "..\VideoLibrary\CaptureTraceWriter.h"
+#include "..\VideoLibrary\FramePlanner.h"
+#include <chrono>
+#include <cstring>
+#include <string>
+
+namespace VideoLibraryTests
+{
+namespace
+{
+    // Composes planned frames onto a CPU surface the same way the pipeline does on the GPU
+    class SurfaceCompositor
+    {
+    public:
+        SurfaceCompositor(LONG width, LONG height)
+            : mWidth{ width }
+            , mHeight{ height }
+            , mSurface(static_cast<size_t>(width) * height, 0)
+            , mScratch(static_cast<size_t>(width) * height, 0)
+        {
+        }
+
+        void Compose(const SourceFrame& frame, const FramePlanner& planner)
+        {
+            const uint32_t* pixels = reinterpret_cast<const uint32_t*>(frame.Pixels());
+
+            for (size_t i = 0; i < planner.MoveRectsCount(); ++i)
+            {
+                const DXGI_OUTDUPL_MOVE_RECT& move = planner.MoveRects()[i];
+                const RECT& destination = move.DestinationRect;
+                const LONG width = destination.right - destination.left;
+
+                // through a scratch copy, like the staging texture, because source and destination overlap
+                for (LONG y = 0; y < destination.bottom - destination.top; ++y)
+                {
+                    std::memcpy(&mScratch[y * width], &mSurface[(move.SourcePoint.y + y) * mWidth + move.SourcePoint.x], width * 4);
+                }
+                for (LONG y = 0; y < destination.bottom - destination.top; ++y)
+                {
+                    std::memcpy(&mSurface[(destination.top + y) * mWidth + destination.left], &mScratch[y * width], width * 4);
+                }
+            }
+
+            for (size_t i = 0; i < planner.DirtyRectsCount(); ++i)
+            {
+                const RECT& rect = planner.DirtyRects()[i];
+                for (LONG y = rect.top; y < rect.bottom; ++y)
+                {
+                    std::memcpy(&mSurface[y * mWidth + rect.left], &pixels[y * mWidth + rect.left], (rect.right - rect.left) * 4);
+                }
+            }
+        }
+
+        bool Matches(const SourceFrame& frame) const
+        {
+            return std::memcmp(mSurface.data(), frame.Pixels(), mSurface.size() * 4) == 0;
+        }
+
+    private:
+        LONG mWidth;
+        LONG mHeight;
+        std::vector<uint32_t> mSurface;
+        std::vector<uint32_t> mScratch;
+    };
+
+    SyntheticDesktopOptions SmallDesktop(SyntheticScenario scenario)
+    {
+        SyntheticDesktopOptions options;
+        options.Width = 320;
+        options.Height = 200;
+        options.Scenario = scenario;
+        options.FramesPerScenario = 40;
+        return options;
+    }
+}
+
+    TEST_CLASS(FrameSourceTests)
+    {
+    public:
+        TEST_METHOD(SyntheticSourceIsDeterministic)
+        {
+            SyntheticDesktopSource first{ SmallDesktop(SyntheticScenario::Mixed) };
+            SyntheticDesktopSource second{ SmallDesktop(SyntheticScenario::Mixed) };
+
+            for (int i = 0; i < 300; ++i)
+            {
+                auto a = first.AcquireFrame();
+                auto b = second.AcquireFrame();
+                Assert::AreEqual(a->Captured(), b->Captured());
+                if (!a->Captured())
+                {
+                    continue;
+                }
+
+                Assert::AreEqual(a->DirtyRectsCount(), b->DirtyRectsCount());
+                Assert::AreEqual(a->MoveRectsCount(), b->MoveRectsCount());
+                for (size_t r = 0; r < a->DirtyRectsCount(); ++r)
+                {
+                    Assert::IsTrue(std::memcmp(&a->DirtyRects()[r], &b->DirtyRects()[r], sizeof(RECT)) == 0);
+                }
+                Assert::AreEqual(0, std::memcmp(a->Pixels(), b->Pixels(), 320 * 200 * 4));
+            }
+        }
+
+        TEST_METHOD(ScenariosReportExpectedMetadata)
+        {
+            SyntheticDesktopSource scrolling{ SmallDesktop(SyntheticScenario::Scrolling) };
+            scrolling.AcquireFrame();
+            auto frame = scrolling.AcquireFrame();
+            Assert::AreEqual(static_cast<size_t>(1), frame->MoveRectsCount());
+            Assert::AreEqual(static_cast<size_t>(1), frame->DirtyRectsCount());
+
+            SyntheticDesktopSource idle{ SmallDesktop(SyntheticScenario::Idle) };
+            idle.AcquireFrame();
+            int captured = 0;
+            for (int i = 0; i < 30; ++i)
+            {
+                auto idleFrame = idle.AcquireFrame();
+                if (idleFrame->Captured())
+                {
+                    ++captured;
+                    Assert::AreEqual(static_cast<size_t>(0), idleFrame->DirtyRectsCount());
+                    Assert::AreEqual(static_cast<int64_t>(0), idleFrame->PresentationTime());
+                    Assert::AreNotEqual(static_cast<int64_t>(0), idleFrame->PointerUpdateTime());
+                }
+            }
+            Assert::AreEqual(2, captured);
+
+            SyntheticDesktopSource rotation{ SmallDesktop(SyntheticScenario::Rotation) };
+            bool rotated = false;
+            for (int i = 0; i < 31; ++i)
+            {
+                rotated = rotated || rotation.AcquireFrame()->Rotation() == DXGI_MODE_ROTATION_ROTATE90;
+            }
+            Assert::IsTrue(rotated);
+        }
+
+        TEST_METHOD(PlannedFramesRebuildTheDesktop)
+        {
+            const SyntheticScenario scenarios[] = {
+                SyntheticScenario::Typing,
+                SyntheticScenario::Scrolling,
+                SyntheticScenario::Video,
+                SyntheticScenario::WindowDrag,
+                SyntheticScenario::Rotation,
+                SyntheticScenario::Idle,
+                SyntheticScenario::Mixed
+            };
+
+            for (SyntheticScenario scenario : scenarios)
+            {
+                SyntheticDesktopSource source{ SmallDesktop(scenario) };
+                FramePlanner planner;
+                SurfaceCompositor surface{ 320, 200 };
+
+                for (int i = 0; i < 400; ++i)
+                {
+                    auto frame = source.AcquireFrame();
+                    if (!frame->Captured())
+                    {
+                        continue;
+                    }
+
+                    // every seventh frame the shared surface is busy
+                    if (i % 7 == 3)
+                    {
+                        planner.Skip(*frame);
+                        continue;
+                    }
+
+                    planner.Plan(*frame);
+                    surface.Compose(*frame, planner);
+                    Assert::IsTrue(surface.Matches(*frame), (L"surface differs at frame " + std::to_wstring(i) + L" of scenario " + std::to_wstring(static_cast<int>(scenario))).c_str());
+                }
+            }
+        }
+
+        TEST_METHOD(TraceSourceReplaysRecordedMetadata)
+        {
+            const auto path = std::filesystem::temp_directory_path() / "synthetic.drtrace";
+            SyntheticDesktopSource source{ SmallDesktop(SyntheticScenario::Mixed) };
+            size_t recorded = 0;
+            {
+                CaptureTraceWriter writer{ path, false, source.TicksPerSecond() };
+                for (int i = 0; i < 200; ++i)
+                {
+                    auto frame = source.AcquireFrame();
+                    if (!frame->Captured())
+                    {
+                        continue;
+                    }
+
+                    CaptureTraceFrame traceFrame;
+                    traceFrame.PresentTime = frame->PresentationTime();
+                    traceFrame.DirtyRects = frame->DirtyRects();
+                    traceFrame.DirtyRectsCount = frame->DirtyRectsCount();
+                    traceFrame.MoveRects = frame->MoveRects();
+                    traceFrame.MoveRectsCount = frame->MoveRectsCount();
+                    writer.Write(traceFrame);
+                    ++recorded;
+                }
+            }
+
+            TraceFrameSource trace{ std::make_shared<CaptureTraceReader>(path) };
+            size_t replayed = 0;
+            while (trace.AcquireFrame()->Captured())
+            {
+                ++replayed;
+            }
+            Assert::AreEqual(recorded, replayed);
+            Assert::IsTrue(trace.Finished());
+        }
+
+        TEST_METHOD(PlannerBenchmark)
+        {
+            SyntheticDesktopOptions options;
+            options.Scenario = SyntheticScenario::Mixed;
+            SyntheticDesktopSource source{ options };
+            FramePlanner planner;
+
+            size_t rects = 0;
+            constexpr int frames = 1200;
+            double planning = 0;
+            for (int i = 0; i < frames; ++i)
+            {
+                auto frame = source.AcquireFrame();
+                if (!frame->Captured())
+                {
+                    continue;
+                }
+
+                const auto start = std::chrono::steady_clock::now();
+                planner.Plan(*frame);
+                planning += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+                rects += planner.DirtyRectsCount();
+            }
+
+            const std::string message = "planned " + std::to_string(frames) + " synthetic 1280x720 frames (" +
+                std::to_string(rects) + " dirty rects) in " + std::to_string(planning) + " us";
+            Logger::WriteMessage(message.c_str());
+        }
+    };
+}
@@ -0,0 +1,77 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+#include "..\VideoLibrary\LruCache.h"
+#include <memory>
+#include <string>
+
+namespace VideoLibraryTests
+{
+    TEST_CLASS(LruCacheTests)
+    {
+    public:
+        TEST_METHOD(EvictsLeastRecentlyUsed)
+        {
+            LruCache<int, std::string> cache{ 3 };
+            cache.Insert(1, "one");
+            cache.Insert(2, "two");
+            cache.Insert(3, "three");
+
+            // touching 1 makes 2 the oldest
+            Assert::IsNotNull(cache.Find(1));
+            cache.Insert(4, "four");
+
+            Assert::IsNull(cache.Find(2));
+            Assert::AreEqual(std::string("one"), *cache.Find(1));
+            Assert::AreEqual(std::string("three"), *cache.Find(3));
+            Assert::AreEqual(std::string("four"), *cache.Find(4));
+            Assert::AreEqual(static_cast<size_t>(3), cache.Size());
+            Assert::AreEqual(static_cast<uint64_t>(1), cache.Evictions());
+            Assert::AreEqual(static_cast<uint64_t>(4), cache.Hits());
+            Assert::AreEqual(static_cast<uint64_t>(1), cache.Misses());
+        }
+
+        TEST_METHOD(InsertReplacesExistingKey)
+        {
+            LruCache<int, std::unique_ptr<int>> cache{ 2 };
+            cache.Insert(1, std::make_unique<int>(10));
+            int* value = cache.Find(1)->get();
+            cache.Insert(1, std::make_unique<int>(11));
+
+            Assert::AreEqual(static_cast<size_t>(1), cache.Size());
+            Assert::AreEqual(11, **cache.Find(1));
+            Assert::IsFalse(value == cache.Find(1)->get());
+
+            cache.Erase(1);
+            Assert::IsNull(cache.Find(1));
+            Assert::AreEqual(static_cast<size_t>(0), cache.Size());
+        }
+
+        TEST_METHOD(ZeroCapacityThrows)
+        {
+            Assert::ExpectException<std::invalid_argument>([]() {
+                LruCache<int, int> cache{ 0 };
+            });
+        }
+    };
+}
@@ -0,0 +1,292 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+#include "..\VideoLibrary\MotionDetectingSource.h"
+#include "..\VideoLibrary\SyntheticDesktopSource.h"
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <string>
+
+namespace VideoLibraryTests
+{
+namespace
+{
+    class TestFrame : public SourceFrame
+    {
+    public:
+        RECT bounds{};
+        std::vector<DXGI_OUTDUPL_MOVE_RECT> moveRects;
+        std::vector<RECT> dirtyRects;
+        std::shared_ptr<const SourceFrame> original;
+        std::shared_ptr<std::vector<uint32_t>> pixels;
+
+        bool Captured() const override { return true; }
+        int64_t PresentationTime() const override { return 1; }
+        RECT DesktopMonitorBounds() const override { return bounds; }
+        DXGI_MODE_ROTATION Rotation() const override { return DXGI_MODE_ROTATION_IDENTITY; }
+        const DXGI_OUTDUPL_MOVE_RECT* MoveRects() const override { return moveRects.data(); }
+        size_t MoveRectsCount() const override { return moveRects.size(); }
+        const RECT* DirtyRects() const override { return dirtyRects.data(); }
+        size_t DirtyRectsCount() const override { return dirtyRects.size(); }
+        DXGI_OUTDUPL_POINTER_POSITION PointerPosition() const override { return DXGI_OUTDUPL_POINTER_POSITION{}; }
+        int64_t PointerUpdateTime() const override { return 0; }
+        bool PointerShapeUpdated() const override { return false; }
+        const byte* Pixels() const override { return original ? original->Pixels() : reinterpret_cast<const byte*>(pixels->data()); }
+        size_t Pitch() const override { return static_cast<size_t>(bounds.right - bounds.left) * 4; }
+    };
+
+    // Reports the synthetic desktop's moves as dirty rects, like a source without move rects would
+    class DirtyOnlySource : public FrameSource
+    {
+    public:
+        explicit DirtyOnlySource(SyntheticDesktopOptions options) : mSource{ options } {}
+
+        std::shared_ptr<SourceFrame> AcquireFrame() override
+        {
+            auto frame = mSource.AcquireFrame();
+            if (!frame->Captured())
+            {
+                return frame;
+            }
+
+            auto dirtyOnly = std::make_shared<TestFrame>();
+            dirtyOnly->bounds = frame->DesktopMonitorBounds();
+            dirtyOnly->original = frame;
+            dirtyOnly->dirtyRects.assign(frame->DirtyRects(), frame->DirtyRects() + frame->DirtyRectsCount());
+            for (size_t i = 0; i < frame->MoveRectsCount(); ++i)
+            {
+                dirtyOnly->dirtyRects.push_back(frame->MoveRects()[i].DestinationRect);
+            }
+            return dirtyOnly;
+        }
+
+        int64_t TicksPerSecond() const override { return mSource.TicksPerSecond(); }
+
+    private:
+        SyntheticDesktopSource mSource;
+    };
+
+    // Applies a frame's moves, all reading the previous image, then copies its dirty rects
+    class Compositor
+    {
+    public:
+        Compositor(LONG width, LONG height) : mWidth{ width }, mSurface(static_cast<size_t>(width) * height, 0) {}
+
+        void Compose(const SourceFrame& frame)
+        {
+            const std::vector<uint32_t> before = mSurface;
+            const uint32_t* pixels = reinterpret_cast<const uint32_t*>(frame.Pixels());
+            for (size_t i = 0; i < frame.MoveRectsCount(); ++i)
+            {
+                const DXGI_OUTDUPL_MOVE_RECT& move = frame.MoveRects()[i];
+                const RECT& destination = move.DestinationRect;
+                for (LONG y = 0; y < destination.bottom - destination.top; ++y)
+                {
+                    std::memcpy(
+                        &mSurface[(destination.top + y) * mWidth + destination.left],
+                        &before[(move.SourcePoint.y + y) * mWidth + move.SourcePoint.x],
+                        (destination.right - destination.left) * 4);
+                }
+            }
+
+            for (size_t i = 0; i < frame.DirtyRectsCount(); ++i)
+            {
+                const RECT& rect = frame.DirtyRects()[i];
+                for (LONG y = rect.top; y < rect.bottom; ++y)
+                {
+                    std::memcpy(&mSurface[y * mWidth + rect.left], &pixels[y * mWidth + rect.left], (rect.right - rect.left) * 4);
+                }
+            }
+        }
+
+        bool Matches(const SourceFrame& frame) const
+        {
+            return std::memcmp(mSurface.data(), frame.Pixels(), mSurface.size() * 4) == 0;
+        }
+
+    private:
+        LONG mWidth;
+        std::vector<uint32_t> mSurface;
+    };
+
+    SyntheticDesktopOptions SmallDesktop(SyntheticScenario scenario)
+    {
+        SyntheticDesktopOptions options;
+        options.Width = 320;
+        options.Height = 200;
+        options.Scenario = scenario;
+        options.FramesPerScenario = 40;
+        return options;
+    }
+
+    int64_t Area(const RECT* rects, size_t count)
+    {
+        int64_t area = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            area += static_cast<int64_t>(rects[i].right - rects[i].left) * (rects[i].bottom - rects[i].top);
+        }
+        return area;
+    }
+}
+
+    TEST_CLASS(MotionDetectorTests)
+    {
+    public:
+        TEST_METHOD(DetectsScrolling)
+        {
+            auto dirtyOnly = std::make_shared<DirtyOnlySource>(SmallDesktop(SyntheticScenario::Scrolling));
+            MotionDetectingSource source{ dirtyOnly };
+            Compositor compositor{ 320, 200 };
+
+            int64_t reported = 0;
+            int64_t redrawn = 0;
+            for (int i = 0; i < 60; ++i)
+            {
+                auto frame = source.AcquireFrame();
+                compositor.Compose(*frame);
+                Assert::IsTrue(compositor.Matches(*frame));
+                if (i == 0)
+                {
+                    continue;
+                }
+
+                Assert::AreEqual(static_cast<size_t>(1), frame->MoveRectsCount());
+                const DXGI_OUTDUPL_MOVE_RECT& move = frame->MoveRects()[0];
+                Assert::AreEqual(16L, static_cast<long>(move.SourcePoint.y - move.DestinationRect.top));
+                Assert::AreEqual(0L, static_cast<long>(move.SourcePoint.x - move.DestinationRect.left));
+
+                reported += static_cast<int64_t>(source.Detector().PixelsMoved()) + Area(frame->DirtyRects(), frame->DirtyRectsCount());
+                redrawn += Area(frame->DirtyRects(), frame->DirtyRectsCount());
+            }
+
+            // only the new strip at the bottom of the page is left to redraw
+            Assert::IsTrue(redrawn * 4 < reported);
+        }
+
+        TEST_METHOD(DetectsHorizontalShifts)
+        {
+            const LONG width = 256;
+            const LONG height = 128;
+            std::mt19937 random{ 3 };
+            auto pixels = std::make_shared<std::vector<uint32_t>>(static_cast<size_t>(width) * height);
+            for (uint32_t& pixel : *pixels)
+            {
+                pixel = random();
+            }
+
+            MotionDetector detector;
+            TestFrame first;
+            first.bounds = RECT{ 0, 0, width, height };
+            first.dirtyRects.push_back(first.bounds);
+            first.pixels = pixels;
+            detector.Detect(first);
+            Assert::AreEqual(static_cast<size_t>(0), detector.MoveRectsCount());
+
+            // content inside the rect slides 24 pixels left, the uncovered columns are new
+            const RECT rect{ 32, 16, 224, 112 };
+            TestFrame second = first;
+            second.pixels = std::make_shared<std::vector<uint32_t>>(*pixels);
+            second.dirtyRects = { rect };
+            for (LONG y = rect.top; y < rect.bottom; ++y)
+            {
+                for (LONG x = rect.left; x < rect.right; ++x)
+                {
+                    (*second.pixels)[y * width + x] = x + 24 < rect.right ? (*pixels)[y * width + x + 24] : random();
+                }
+            }
+            detector.Detect(second);
+
+            Assert::AreEqual(static_cast<size_t>(1), detector.MoveRectsCount());
+            const DXGI_OUTDUPL_MOVE_RECT& move = detector.MoveRects()[0];
+            Assert::AreEqual(56L, static_cast<long>(move.SourcePoint.x));
+            Assert::AreEqual(16L, static_cast<long>(move.SourcePoint.y));
+            Assert::AreEqual(32L, static_cast<long>(move.DestinationRect.left));
+            Assert::AreEqual(200L, static_cast<long>(move.DestinationRect.right));
+            Assert::AreEqual(static_cast<uint64_t>(168 * 96), detector.PixelsMoved());
+            Assert::AreEqual(static_cast<int64_t>(24 * 96), Area(detector.DirtyRects(), detector.DirtyRectsCount()));
+        }
+
+        TEST_METHOD(IgnoresUnrelatedChanges)
+        {
+            // video and typing repaint content that never moved
+            for (SyntheticScenario scenario : { SyntheticScenario::Video, SyntheticScenario::Typing })
+            {
+                auto dirtyOnly = std::make_shared<DirtyOnlySource>(SmallDesktop(scenario));
+                MotionDetectingSource source{ dirtyOnly };
+                Compositor compositor{ 320, 200 };
+                for (int i = 0; i < 60; ++i)
+                {
+                    auto frame = source.AcquireFrame();
+                    if (!frame->Captured())
+                    {
+                        continue;
+                    }
+
+                    compositor.Compose(*frame);
+                    Assert::IsTrue(compositor.Matches(*frame));
+                    Assert::AreEqual(static_cast<size_t>(0), frame->MoveRectsCount());
+                }
+            }
+        }
+
+        TEST_METHOD(ComposedMixedScenariosMatch)
+        {
+            auto dirtyOnly = std::make_shared<DirtyOnlySource>(SmallDesktop(SyntheticScenario::Mixed));
+            MotionDetectingSource source{ dirtyOnly };
+            Compositor compositor{ 320, 200 };
+            for (int i = 0; i < 400; ++i)
+            {
+                auto frame = source.AcquireFrame();
+                if (frame->Captured())
+                {
+                    compositor.Compose(*frame);
+                    Assert::IsTrue(compositor.Matches(*frame));
+                }
+            }
+        }
+
+        TEST_METHOD(MotionDetectorBenchmark)
+        {
+            SyntheticDesktopOptions options;
+            options.Scenario = SyntheticScenario::Scrolling;
+            MotionDetectingSource source{ std::make_shared<DirtyOnlySource>(options) };
+            source.AcquireFrame();
+
+            const int iterations = 200;
+            uint64_t moved = 0;
+            const auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < iterations; ++i)
+            {
+                source.AcquireFrame();
+                moved += source.Detector().PixelsMoved();
+            }
+            const auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+            const std::string message = "1280x720 scrolling: " + std::to_string(elapsed / iterations) + " us per frame, " +
+                std::to_string(moved / iterations) + " dirty pixels per frame turned into moves";
+            Logger::WriteMessage(message.c_str());
+        }
+    };
+}
@@ -0,0 +1,245 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+#include "..\VideoLibrary\MoveRectPlanner.h"
+#include <chrono>
+#include <random>
+#include <string>
+
+namespace VideoLibraryTests
+{
+namespace
+{
+    constexpr LONG SurfaceSize = 64;
+
+    // One value per pixel, every pixel starts out unique
+    std::vector<int> NumberedSurface()
+    {
+        std::vector<int> pixels(SurfaceSize * SurfaceSize);
+        for (size_t i = 0; i < pixels.size(); ++i)
+        {
+            pixels[i] = static_cast<int>(i);
+        }
+        return pixels;
+    }
+
+    void Copy(const std::vector<int>& from, const RECT& source, std::vector<int>& to, POINT destination)
+    {
+        for (LONG y = source.top; y < source.bottom; ++y)
+        {
+            for (LONG x = source.left; x < source.right; ++x)
+            {
+                to[(destination.y + y - source.top) * SurfaceSize + destination.x + x - source.left] = from[y * SurfaceSize + x];
+            }
+        }
+    }
+
+    // Every move reads the surface as it was before the frame
+    std::vector<int> ApplyReference(const std::vector<RECT>& sources, const std::vector<RECT>& destinations)
+    {
+        const std::vector<int> before = NumberedSurface();
+        std::vector<int> after = before;
+        for (size_t i = 0; i < sources.size(); ++i)
+        {
+            Copy(before, sources[i], after, POINT{ destinations[i].left, destinations[i].top });
+        }
+        return after;
+    }
+
+    std::vector<int> ApplyPlan(const MoveRectPlanner& planner)
+    {
+        std::vector<int> surface = NumberedSurface();
+        std::vector<int> staging(surface.size(), -1);
+        for (size_t i = 0; i < planner.CopiesCount(); ++i)
+        {
+            const MoveCopy& copy = planner.Copies()[i];
+            switch (copy.Kind)
+            {
+            case MoveCopyKind::SurfaceToStaging:
+                Copy(surface, copy.Source, staging, copy.Destination);
+                break;
+            case MoveCopyKind::SurfaceToSurface:
+                Copy(surface, copy.Source, surface, copy.Destination);
+                break;
+            case MoveCopyKind::StagingToSurface:
+                Copy(staging, copy.Source, surface, copy.Destination);
+                break;
+            }
+        }
+        return surface;
+    }
+
+    bool Overlaps(const RECT& a, const RECT& b)
+    {
+        return a.left < b.right && b.left < a.right && a.top < b.bottom && b.top < a.bottom;
+    }
+
+    RECT Moved(const RECT& rect, LONG x, LONG y)
+    {
+        return RECT{ rect.left + x, rect.top + y, rect.right + x, rect.bottom + y };
+    }
+
+    // Moves whose destinations do not overlap, as Desktop Duplication reports them
+    void RandomMoves(std::mt19937& random, size_t count, std::vector<RECT>& sources, std::vector<RECT>& destinations)
+    {
+        std::uniform_int_distribution<LONG> extent{ 1, 16 };
+        std::uniform_int_distribution<LONG> delta{ -12, 12 };
+        sources.clear();
+        destinations.clear();
+        for (size_t attempt = 0; attempt < count * 8 && sources.size() < count; ++attempt)
+        {
+            const LONG width = extent(random);
+            const LONG height = extent(random);
+            std::uniform_int_distribution<LONG> x{ 0, SurfaceSize - width };
+            std::uniform_int_distribution<LONG> y{ 0, SurfaceSize - height };
+            const RECT source{ x(random), y(random), 0, 0 };
+            const RECT sized{ source.left, source.top, source.left + width, source.top + height };
+            const RECT destination = Moved(sized, delta(random), delta(random));
+            if (destination.left < 0 || destination.top < 0 || destination.right > SurfaceSize || destination.bottom > SurfaceSize)
+            {
+                continue;
+            }
+
+            bool overlaps = false;
+            for (const RECT& other : destinations)
+            {
+                overlaps = overlaps || Overlaps(other, destination);
+            }
+
+            if (!overlaps)
+            {
+                sources.push_back(sized);
+                destinations.push_back(destination);
+            }
+        }
+    }
+}
+
+    TEST_CLASS(MoveRectPlannerTests)
+    {
+    public:
+        TEST_METHOD(PlannedCopiesMatchReference)
+        {
+            std::mt19937 random{ 11 };
+            MoveRectPlanner planner;
+            std::vector<RECT> sources, destinations;
+            for (int run = 0; run < 500; ++run)
+            {
+                RandomMoves(random, 1 + run % 9, sources, destinations);
+                planner.Plan(sources.data(), destinations.data(), sources.size());
+
+                Assert::IsTrue(ApplyPlan(planner) == ApplyReference(sources, destinations));
+                for (size_t i = 0; i < planner.CopiesCount(); ++i)
+                {
+                    const MoveCopy& copy = planner.Copies()[i];
+                    if (copy.Kind == MoveCopyKind::SurfaceToSurface)
+                    {
+                        const RECT destination = Moved(copy.Source, copy.Destination.x - copy.Source.left, copy.Destination.y - copy.Source.top);
+                        Assert::IsFalse(Overlaps(copy.Source, destination), L"direct copies must not overlap themselves");
+                    }
+                }
+            }
+        }
+
+        TEST_METHOD(DropsAndMergesMoves)
+        {
+            // a scrolled window reported as three strips, a no-op and an empty move
+            const std::vector<RECT> sources = {
+                { 0, 10, 40, 20 }, { 0, 20, 40, 30 }, { 0, 30, 40, 40 }, { 50, 50, 60, 60 }, { 5, 5, 5, 9 } };
+            const std::vector<RECT> destinations = {
+                { 0, 0, 40, 10 }, { 0, 10, 40, 20 }, { 0, 20, 40, 30 }, { 50, 50, 60, 60 }, { 6, 5, 6, 9 } };
+
+            MoveRectPlanner planner;
+            planner.Plan(sources.data(), destinations.data(), sources.size());
+
+            Assert::AreEqual(static_cast<size_t>(2), planner.DroppedMoves());
+            Assert::AreEqual(static_cast<size_t>(2), planner.MergedMoves());
+            Assert::AreEqual(static_cast<size_t>(1), planner.StagedMoves());
+            Assert::AreEqual(static_cast<size_t>(2), planner.CopiesCount());
+            Assert::IsTrue(ApplyPlan(planner) == ApplyReference(sources, destinations));
+
+            // staging all four non-empty moves copies 2 x (3 x 400 + 100) pixels, the plan 2 x 1200
+            Assert::AreEqual(static_cast<uint64_t>(2 * 1200 * 4), planner.BytesCopied());
+            Assert::AreEqual(static_cast<uint64_t>(2 * 100 * 4), planner.BytesSaved());
+        }
+
+        TEST_METHOD(DisjointMovesAreCopiedDirectly)
+        {
+            // the second move reads where the first writes, so it has to go first
+            const std::vector<RECT> sources = { { 0, 0, 10, 10 }, { 20, 0, 30, 10 } };
+            const std::vector<RECT> destinations = { { 20, 0, 30, 10 }, { 40, 0, 50, 10 } };
+
+            MoveRectPlanner planner;
+            planner.Plan(sources.data(), destinations.data(), sources.size());
+
+            Assert::AreEqual(static_cast<size_t>(0), planner.StagedMoves());
+            Assert::AreEqual(static_cast<size_t>(2), planner.CopiesCount());
+            Assert::AreEqual(20L, static_cast<long>(planner.Copies()[0].Source.left));
+            Assert::AreEqual(static_cast<uint64_t>(200 * 4), planner.BytesSaved());
+            Assert::IsTrue(ApplyPlan(planner) == ApplyReference(sources, destinations));
+        }
+
+        TEST_METHOD(SwappedMovesBreakTheCycle)
+        {
+            const std::vector<RECT> sources = { { 0, 0, 10, 10 }, { 20, 0, 28, 8 } };
+            const std::vector<RECT> destinations = { { 20, 0, 30, 10 }, { 0, 0, 8, 8 } };
+
+            MoveRectPlanner planner;
+            planner.Plan(sources.data(), destinations.data(), sources.size());
+
+            // the smaller move is staged, the larger one is copied directly
+            Assert::AreEqual(static_cast<size_t>(1), planner.StagedMoves());
+            Assert::AreEqual(static_cast<size_t>(3), planner.CopiesCount());
+            Assert::AreEqual(static_cast<uint64_t>(100 * 4), planner.BytesSaved());
+            Assert::IsTrue(ApplyPlan(planner) == ApplyReference(sources, destinations));
+        }
+
+        TEST_METHOD(MoveRectPlannerBenchmark)
+        {
+            std::mt19937 random{ 5 };
+            std::vector<std::vector<RECT>> sources(64), destinations(64);
+            for (size_t i = 0; i < sources.size(); ++i)
+            {
+                RandomMoves(random, 8, sources[i], destinations[i]);
+            }
+
+            MoveRectPlanner planner;
+            uint64_t saved = 0;
+            uint64_t copied = 0;
+            const int iterations = 20000;
+            const auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < iterations; ++i)
+            {
+                const size_t frame = i % sources.size();
+                planner.Plan(sources[frame].data(), destinations[frame].data(), sources[frame].size());
+                saved += planner.BytesSaved();
+                copied += planner.BytesCopied();
+            }
+            const auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+            const std::string message = "8 moves: planned in " + std::to_string(elapsed / iterations) + " us, " +
+                std::to_string(100.0 * saved / (saved + copied)) + "% of staged copy bytes saved";
+            Logger::WriteMessage(message.c_str());
+        }
+    };
+}
@@ -0,0 +1,275 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+#include "..\VideoLibrary\MpmcQueue.h"
+#include "..\VideoLibrary\BoundedPool.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace VideoLibraryTests
+{
+namespace
+{
+    constexpr int Producers = 4;
+    constexpr int Consumers = 4;
+    constexpr uint32_t ValuesPerProducer = 100000;
+
+    // The free list the pool used before, bounded the same way for comparison
+    class LockedQueue
+    {
+    public:
+        explicit LockedQueue(size_t capacity) : mCapacity{ capacity } {}
+
+        bool TryPush(uint32_t value)
+        {
+            std::lock_guard<std::mutex> lock{ mMutex };
+            if (mValues.size() == mCapacity)
+            {
+                return false;
+            }
+
+            mValues.push(value);
+            return true;
+        }
+
+        bool TryPop(uint32_t& value)
+        {
+            std::lock_guard<std::mutex> lock{ mMutex };
+            if (mValues.empty())
+            {
+                return false;
+            }
+
+            value = mValues.front();
+            mValues.pop();
+            return true;
+        }
+
+    private:
+        size_t mCapacity;
+        std::mutex mMutex;
+        std::queue<uint32_t> mValues;
+    };
+
+    struct Totals
+    {
+        uint64_t Sum;
+        uint64_t Count;
+    };
+
+    // Pushes distinct values from every producer and pops them from every consumer
+    template<typename Queue>
+    Totals Exchange(Queue& queue)
+    {
+        std::atomic<uint64_t> sum{ 0 };
+        std::atomic<uint64_t> count{ 0 };
+        std::atomic<int> producing{ Producers };
+        std::vector<std::thread> threads;
+        for (int p = 0; p < Producers; ++p)
+        {
+            threads.emplace_back([&queue, &producing, p]()
+            {
+                for (uint32_t i = 0; i < ValuesPerProducer; ++i)
+                {
+                    const uint32_t value = p * ValuesPerProducer + i;
+                    while (!queue.TryPush(value))
+                    {
+                        std::this_thread::yield();
+                    }
+                }
+                --producing;
+            });
+        }
+
+        for (int c = 0; c < Consumers; ++c)
+        {
+            threads.emplace_back([&queue, &producing, &sum, &count]()
+            {
+                uint64_t localSum = 0;
+                uint64_t localCount = 0;
+                uint32_t value;
+                for (;;)
+                {
+                    if (queue.TryPop(value))
+                    {
+                        localSum += value;
+                        ++localCount;
+                    }
+                    else if (producing.load() == 0)
+                    {
+                        // drain what was pushed after the last failed pop
+                        while (queue.TryPop(value))
+                        {
+                            localSum += value;
+                            ++localCount;
+                        }
+                        break;
+                    }
+                    else
+                    {
+                        std::this_thread::yield();
+                    }
+                }
+                sum += localSum;
+                count += localCount;
+            });
+        }
+
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+        return Totals{ sum.load(), count.load() };
+    }
+}
+
+    TEST_CLASS(MpmcQueueTests)
+    {
+    public:
+        TEST_METHOD(FifoUntilFullThenEmpty)
+        {
+            MpmcQueue<int> queue{ 5 };
+            Assert::AreEqual(static_cast<size_t>(8), queue.Capacity());
+
+            for (int i = 0; i < 8; ++i)
+            {
+                Assert::IsTrue(queue.TryPush(i));
+            }
+            Assert::IsFalse(queue.TryPush(8));
+
+            int value = -1;
+            for (int lap = 0; lap < 3; ++lap)
+            {
+                // wrap around a few times
+                Assert::IsTrue(queue.TryPop(value));
+                Assert::AreEqual(lap, value);
+                Assert::IsTrue(queue.TryPush(8 + lap));
+            }
+
+            for (int i = 3; i < 11; ++i)
+            {
+                Assert::IsTrue(queue.TryPop(value));
+                Assert::AreEqual(i, value);
+            }
+            Assert::IsFalse(queue.TryPop(value));
+            Assert::ExpectException<std::invalid_argument>([]() { MpmcQueue<int> empty{ 0 }; });
+        }
+
+        TEST_METHOD(EveryValueArrivesOnce)
+        {
+            // small enough that producers keep running into a full queue
+            MpmcQueue<uint32_t> queue{ 64 };
+            const Totals totals = Exchange(queue);
+
+            const uint64_t values = static_cast<uint64_t>(Producers) * ValuesPerProducer;
+            Assert::AreEqual(values, totals.Count);
+            Assert::AreEqual(values * (values - 1) / 2, totals.Sum);
+        }
+
+        TEST_METHOD(PoolSurvivesConcurrentRecycling)
+        {
+            auto created = std::make_shared<std::atomic<int>>(0);
+            BoundedPoolOptions options;
+            options.LowWatermark = 1;
+            options.HighWatermark = 6;
+            options.Policy = PoolExhaustedPolicy::ReuseOldest;
+            BoundedPool<std::shared_ptr<int>> pool{ [created]() { return std::make_shared<int>((*created)++); }, options };
+
+            // each thread holds at most two items, more threads than items so reuse happens
+            std::vector<std::thread> threads;
+            std::atomic<uint64_t> acquired{ 0 };
+            for (int t = 0; t < 8; ++t)
+            {
+                threads.emplace_back([&pool, &acquired]()
+                {
+                    std::shared_ptr<int> first, second;
+                    for (int i = 0; i < 20000; ++i)
+                    {
+                        if (pool.Acquire(first))
+                        {
+                            if (pool.Acquire(second))
+                            {
+                                pool.Release(second);
+                                ++acquired;
+                            }
+                            pool.Release(first);
+                            ++acquired;
+                        }
+                    }
+                });
+            }
+
+            for (std::thread& thread : threads)
+            {
+                thread.join();
+            }
+
+            const BoundedPoolStats stats = pool.Stats();
+            Assert::AreEqual(static_cast<size_t>(0), stats.Outstanding);
+            Assert::AreEqual(static_cast<uint64_t>(created->load()), stats.Allocations);
+            Assert::IsTrue(stats.Allocations <= 6);
+            Assert::IsTrue(stats.PeakDepth <= 6);
+            Assert::IsTrue(acquired.load() > 0);
+
+            // every item came back to the free list exactly once
+            std::vector<std::shared_ptr<int>> items(static_cast<size_t>(stats.Allocations));
+            for (auto& item : items)
+            {
+                Assert::IsTrue(pool.Acquire(item));
+            }
+            for (size_t i = 0; i < items.size(); ++i)
+            {
+                for (size_t j = i + 1; j < items.size(); ++j)
+                {
+                    Assert::IsTrue(items[i] != items[j]);
+                }
+            }
+        }
+
+        TEST_METHOD(ContentionBenchmark)
+        {
+            MpmcQueue<uint32_t> lockFree{ 64 };
+            LockedQueue locked{ 64 };
+
+            const auto start = std::chrono::steady_clock::now();
+            Exchange(lockFree);
+            const auto middle = std::chrono::steady_clock::now();
+            Exchange(locked);
+            const auto end = std::chrono::steady_clock::now();
+
+            const double operations = 2.0 * Producers * ValuesPerProducer;
+            const double lockFreeNs = std::chrono::duration<double, std::nano>(middle - start).count() / operations;
+            const double lockedNs = std::chrono::duration<double, std::nano>(end - middle).count() / operations;
+            const std::string message = std::to_string(Producers) + " producers, " + std::to_string(Consumers) +
+                " consumers: lock-free " + std::to_string(lockFreeNs) + " ns/op, mutex " + std::to_string(lockedNs) + " ns/op";
+            Logger::WriteMessage(message.c_str());
+        }
+    };
+}
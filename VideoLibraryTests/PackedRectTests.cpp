@@ -0,0 +1,283 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+#include "..\VideoLibrary\PackedRect.h"
+#include "..\VideoLibrary\RotationTransform.h"
+#include <chrono>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+namespace VideoLibraryTests
+{
+namespace
+{
+    const DXGI_MODE_ROTATION PackedRotations[] = {
+        DXGI_MODE_ROTATION_IDENTITY,
+        DXGI_MODE_ROTATION_ROTATE90,
+        DXGI_MODE_ROTATION_ROTATE180,
+        DXGI_MODE_ROTATION_ROTATE270
+    };
+
+    /*
+        Corners of the rotated rect the source corners are drawn at:
+
+        Identity and unspecified:
+        2                4
+        +---------------+
+        |               |
+        |               |
+        +---------------+
+        1               3
+
+        90 CCW:
+        2        4
+        +--------+
+        |        |
+        |        |
+        |        |
+        |        |
+        +--------+
+        1        3
+
+
+        180 CCW:
+        4               1
+        +---------------+
+        |               |
+        |               |
+        +---------------+
+        2               3
+
+        270 CCW:
+        1        3
+        +--------+
+        |        |
+        |        |
+        |        |
+        |        |
+        +--------+
+        4        2
+
+    */
+    template <typename Transform>
+    void WriteVertices(
+        Vertex* vertices,
+        float left, float top, float right, float bottom,
+        float u0, float v0, float u1, float v1)
+    {
+        const float u[4] = { u0, u0, u1, u1 };
+        const float v[4] = { v1, v0, v1, v0 };
+        constexpr RectCorner bottomLeft = Transform::SourceCorners[BottomLeftCorner];
+        constexpr RectCorner topLeft = Transform::SourceCorners[TopLeftCorner];
+        constexpr RectCorner bottomRight = Transform::SourceCorners[BottomRightCorner];
+        constexpr RectCorner topRight = Transform::SourceCorners[TopRightCorner];
+
+        // Set the vertices of the two triangles that make up the dirty rectangle
+        // The second triangle shares a side with the first triangle
+        // vertices proceed clockwise
+        static_assert(sizeof(Vertex) == 5 * sizeof(float), "vertices must be tightly packed");
+        float* out = &vertices[0].pos.x;
+
+        // bottomLeft -> topLeft -> bottomRight
+        out[0] = left; out[1] = bottom; out[2] = 0.0f; out[3] = u[bottomLeft]; out[4] = v[bottomLeft];
+        out[5] = left; out[6] = top; out[7] = 0.0f; out[8] = u[topLeft]; out[9] = v[topLeft];
+        out[10] = right; out[11] = bottom; out[12] = 0.0f; out[13] = u[bottomRight]; out[14] = v[bottomRight];
+
+        // bottomRight -> topLeft -> topRight
+        out[15] = right; out[16] = bottom; out[17] = 0.0f; out[18] = u[bottomRight]; out[19] = v[bottomRight];
+        out[20] = left; out[21] = top; out[22] = 0.0f; out[23] = u[topLeft]; out[24] = v[topLeft];
+        out[25] = right; out[26] = top; out[27] = 0.0f; out[28] = u[topRight]; out[29] = v[topRight];
+    }
+
+    // The six vertices per rect that were drawn before the instanced draw
+    void TriangleListVertices(
+        DXGI_MODE_ROTATION rotation,
+        const RECT* rects,
+        size_t count,
+        const DirtyRectVertexLayout& layout,
+        Vertex* vertices)
+    {
+        const LONG centerX = layout.TargetWidth / 2;
+        const LONG centerY = layout.TargetHeight / 2;
+
+        VisitRotation(rotation, [&](auto transform) {
+            using Transform = decltype(transform);
+            for (size_t i = 0; i < count; ++i)
+            {
+                const RECT& rect = rects[i];
+                const RECT rotated = Transform::Rect(rect, layout.ImageWidth, layout.ImageHeight);
+                WriteVertices<Transform>(
+                    vertices + i * g_VerticesPerRect,
+                    (rotated.left + layout.OriginX - centerX) / static_cast<FLOAT>(centerX),
+                    -1 * (rotated.top + layout.OriginY - centerY) / static_cast<FLOAT>(centerY),
+                    (rotated.right + layout.OriginX - centerX) / static_cast<FLOAT>(centerX),
+                    -1 * (rotated.bottom + layout.OriginY - centerY) / static_cast<FLOAT>(centerY),
+                    rect.left / static_cast<FLOAT>(layout.ImageWidth),
+                    rect.top / static_cast<FLOAT>(layout.ImageHeight),
+                    rect.right / static_cast<FLOAT>(layout.ImageWidth),
+                    rect.bottom / static_cast<FLOAT>(layout.ImageHeight));
+            }
+        });
+    }
+
+    DirtyRectVertexLayout RotatedMonitorLayout(DXGI_MODE_ROTATION rotation)
+    {
+        // a 2560x1440 panel below and right of the virtual desktop origin
+        const bool portrait = rotation == DXGI_MODE_ROTATION_ROTATE90 || rotation == DXGI_MODE_ROTATION_ROTATE270;
+        DirtyRectVertexLayout layout;
+        layout.ImageWidth = 2560;
+        layout.ImageHeight = 1440;
+        layout.OriginX = 1920;
+        layout.OriginY = 120;
+        layout.TargetWidth = 1920 + (portrait ? 1440 : 2560);
+        layout.TargetHeight = 120 + (portrait ? 2560 : 1440);
+        return layout;
+    }
+
+    std::vector<RECT> RandomDirtyRects(std::mt19937& random, size_t count, const DirtyRectVertexLayout& layout)
+    {
+        std::uniform_int_distribution<LONG> x{ 0, layout.ImageWidth - 1 };
+        std::uniform_int_distribution<LONG> y{ 0, layout.ImageHeight - 1 };
+        std::uniform_int_distribution<LONG> extent{ 1, 400 };
+        std::vector<RECT> rects;
+        for (size_t i = 0; i < count; ++i)
+        {
+            const LONG left = x(random);
+            const LONG top = y(random);
+            rects.push_back(RECT{
+                left,
+                top,
+                (std::min)(layout.ImageWidth, left + extent(random)),
+                (std::min)(layout.ImageHeight, top + extent(random)) });
+        }
+        return rects;
+    }
+}
+
+    TEST_CLASS(PackedRectTests)
+    {
+    public:
+        TEST_METHOD(ExpansionMatchesTriangleList)
+        {
+            std::mt19937 random{ 5 };
+            for (DXGI_MODE_ROTATION rotation : PackedRotations)
+            {
+                const DirtyRectVertexLayout layout = RotatedMonitorLayout(rotation);
+                auto rects = RandomDirtyRects(random, 500, layout);
+                rects.push_back(RECT{ 0, 0, layout.ImageWidth, layout.ImageHeight });
+
+                std::vector<Vertex> expected(rects.size() * g_VerticesPerRect);
+                TriangleListVertices(rotation, rects.data(), rects.size(), layout, expected.data());
+
+                std::vector<PackedRect> packed(rects.size());
+                PackDirtyRects(rotation, rects.data(), rects.size(), layout, packed.data());
+
+                std::vector<Vertex> expanded(rects.size() * g_VerticesPerRect);
+                ExpandPackedRects(packed.data(), packed.size(), MakePackedRectConstants(rotation, layout), expanded.data());
+
+                for (size_t i = 0; i < expected.size(); ++i)
+                {
+                    Assert::AreEqual(expected[i].pos.x, expanded[i].pos.x, 1e-6f);
+                    Assert::AreEqual(expected[i].pos.y, expanded[i].pos.y, 1e-6f);
+                    Assert::AreEqual(expected[i].pos.z, expanded[i].pos.z);
+                    Assert::AreEqual(expected[i].texCoord.u, expanded[i].texCoord.u, 1e-6f);
+                    Assert::AreEqual(expected[i].texCoord.v, expanded[i].texCoord.v, 1e-6f);
+                }
+            }
+        }
+
+        TEST_METHOD(FullImageCoversTheMonitor)
+        {
+            const DirtyRectVertexLayout layout{ 800, 600, 0, 0, 800, 600 };
+            const RECT image{ 0, 0, 800, 600 };
+            PackedRect packed;
+            PackDirtyRects(DXGI_MODE_ROTATION_IDENTITY, &image, 1, layout, &packed);
+
+            Vertex vertices[g_VerticesPerRect];
+            ExpandPackedRects(&packed, 1, MakePackedRectConstants(DXGI_MODE_ROTATION_IDENTITY, layout), vertices);
+
+            // bottom left of the screen samples the bottom left of the image
+            Assert::AreEqual(-1.0f, vertices[0].pos.x);
+            Assert::AreEqual(-1.0f, vertices[0].pos.y);
+            Assert::AreEqual(0.0f, vertices[0].texCoord.u);
+            Assert::AreEqual(1.0f, vertices[0].texCoord.v);
+            Assert::AreEqual(1.0f, vertices[5].pos.x);
+            Assert::AreEqual(1.0f, vertices[5].pos.y);
+            Assert::AreEqual(1.0f, vertices[5].texCoord.u);
+            Assert::AreEqual(0.0f, vertices[5].texCoord.v);
+        }
+
+        TEST_METHOD(UploadIsSevenTimesSmaller)
+        {
+            const size_t triangleList = g_VerticesPerRect * sizeof(Vertex);
+            Assert::AreEqual(static_cast<size_t>(120), triangleList);
+            Assert::IsTrue(triangleList >= 7 * sizeof(PackedRect));
+        }
+
+        TEST_METHOD(LayoutsBeyondSixteenBitsAreRejected)
+        {
+            DirtyRectVertexLayout layout = RotatedMonitorLayout(DXGI_MODE_ROTATION_IDENTITY);
+            layout.TargetWidth = 70000;
+            Assert::ExpectException<std::invalid_argument>([&]() {
+                MakePackedRectConstants(DXGI_MODE_ROTATION_IDENTITY, layout);
+            });
+
+            layout = RotatedMonitorLayout(DXGI_MODE_ROTATION_IDENTITY);
+            layout.ImageHeight = 0;
+            Assert::ExpectException<std::invalid_argument>([&]() {
+                MakePackedRectConstants(DXGI_MODE_ROTATION_IDENTITY, layout);
+            });
+        }
+
+        TEST_METHOD(PackingBenchmark)
+        {
+            std::mt19937 random{ 17 };
+            const DirtyRectVertexLayout layout = RotatedMonitorLayout(DXGI_MODE_ROTATION_ROTATE90);
+            const auto rects = RandomDirtyRects(random, 4096, layout);
+            std::vector<PackedRect> packed(rects.size());
+            std::vector<Vertex> vertices(rects.size() * g_VerticesPerRect);
+
+            constexpr int iterations = 200;
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < iterations; ++i)
+            {
+                PackDirtyRects(DXGI_MODE_ROTATION_ROTATE90, rects.data(), rects.size(), layout, packed.data());
+            }
+            const double packing = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            start = std::chrono::steady_clock::now();
+            for (int i = 0; i < iterations; ++i)
+            {
+                TriangleListVertices(DXGI_MODE_ROTATION_ROTATE90, rects.data(), rects.size(), layout, vertices.data());
+            }
+            const double triangles = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            const double rectCount = static_cast<double>(rects.size()) * iterations;
+            const std::string message = "packed rects " + std::to_string(rectCount / packing / 1e6) + " M rects/s (" +
+                std::to_string(sizeof(PackedRect)) + " bytes each), triangle list " + std::to_string(rectCount / triangles / 1e6) +
+                " M rects/s (" + std::to_string(g_VerticesPerRect * sizeof(Vertex)) + " bytes each)";
+            Logger::WriteMessage(message.c_str());
+        }
+    };
+}
@@ -0,0 +1,382 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+#include "..\VideoLibrary\ParallelCapture.h"
+#include "..\VideoLibrary\SyntheticDesktopSource.h"
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace VideoLibraryTests
+{
+namespace
+{
+    // The virtual desktop surface in memory, guarded like the keyed mutex guards the real one
+    struct CpuSurface
+    {
+        CpuSurface(LONG width, LONG height)
+            : Width{ width }
+            , Height{ height }
+            , Pixels(static_cast<size_t>(width) * height, 0)
+        {
+        }
+
+        LONG Width;
+        LONG Height;
+        std::vector<uint32_t> Pixels;
+        std::mutex Mutex;
+    };
+
+    class TimedSurfaceLock : public SurfaceLock
+    {
+    public:
+        TimedSurfaceLock(std::shared_ptr<CpuSurface> surface, std::chrono::milliseconds timeout)
+            : mSurface{ surface }
+            , mTimeout{ timeout }
+        {
+        }
+
+        bool Lock() override
+        {
+            const auto giveUp = std::chrono::steady_clock::now() + mTimeout;
+            while (!mSurface->Mutex.try_lock())
+            {
+                if (std::chrono::steady_clock::now() >= giveUp)
+                {
+                    return false;
+                }
+                std::this_thread::sleep_for(50us);
+            }
+            return true;
+        }
+
+        void Unlock() override { mSurface->Mutex.unlock(); }
+
+    private:
+        std::shared_ptr<CpuSurface> mSurface;
+        std::chrono::milliseconds mTimeout;
+    };
+
+    // Copies the rects of region from one image to another, both in surface coordinates
+    void CopyRegion(const Region& region, const uint32_t* from, size_t fromPitch, POINT fromOrigin, std::vector<uint32_t>& to, LONG toWidth)
+    {
+        for (size_t i = 0; i < region.RectsCount(); ++i)
+        {
+            const RECT& rect = region.Rects()[i];
+            for (LONG y = rect.top; y < rect.bottom; ++y)
+            {
+                const uint32_t* row = from + (y - fromOrigin.y) * fromPitch + (rect.left - fromOrigin.x);
+                std::memcpy(&to[static_cast<size_t>(y) * toWidth + rect.left], row, (rect.right - rect.left) * sizeof(uint32_t));
+            }
+        }
+    }
+
+    // A monitor at origin on the surface, refreshing every interval
+    class SyntheticMonitor : public CaptureSource
+    {
+    public:
+        SyntheticMonitor(SyntheticDesktopOptions options, POINT origin, std::chrono::milliseconds interval, std::shared_ptr<CpuSurface> surface)
+            : mDesktop{ options }
+            , mOrigin{ origin }
+            , mInterval{ interval }
+            , mSurface{ surface }
+        {
+        }
+
+        bool Capture() override
+        {
+            std::this_thread::sleep_for(mInterval);
+            mFrame = mDesktop.AcquireFrame();
+            if (!mFrame->Captured())
+            {
+                mFrame = nullptr;
+                return false;
+            }
+            return true;
+        }
+
+        void Write(Region& damage) override
+        {
+            AddDamage();
+            mPending.Translate(mOrigin.x, mOrigin.y);
+            CopyRegion(
+                mPending,
+                reinterpret_cast<const uint32_t*>(mFrame->Pixels()),
+                mFrame->Pitch() / sizeof(uint32_t),
+                mOrigin,
+                mSurface->Pixels,
+                mSurface->Width);
+            damage.Union(mPending);
+            mPending.Clear();
+            mLastWritten = mFrame;
+            mFrame = nullptr;
+        }
+
+        void Skip() override
+        {
+            AddDamage();
+            mFrame = nullptr;
+        }
+
+        // Whether the monitor's region of the surface shows the last frame written
+        bool SurfaceShowsLastFrame() const
+        {
+            const SyntheticDesktopOptions& options = mDesktop.Options();
+            const uint32_t* pixels = reinterpret_cast<const uint32_t*>(mLastWritten->Pixels());
+            const size_t pitch = mLastWritten->Pitch() / sizeof(uint32_t);
+            for (LONG y = 0; y < options.Height; ++y)
+            {
+                const uint32_t* surfaceRow = &mSurface->Pixels[static_cast<size_t>(y + mOrigin.y) * mSurface->Width + mOrigin.x];
+                if (std::memcmp(surfaceRow, pixels + y * pitch, options.Width * sizeof(uint32_t)) != 0)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+    private:
+        // Dirty rects and move destinations, in desktop image coordinates
+        void AddDamage()
+        {
+            mPending.Union(mFrame->DirtyRects(), mFrame->DirtyRectsCount());
+            for (size_t i = 0; i < mFrame->MoveRectsCount(); ++i)
+            {
+                mPending.Union(mFrame->MoveRects()[i].DestinationRect);
+            }
+        }
+
+        SyntheticDesktopSource mDesktop;
+        POINT mOrigin;
+        std::chrono::milliseconds mInterval;
+        std::shared_ptr<CpuSurface> mSurface;
+        std::shared_ptr<SourceFrame> mFrame;
+        std::shared_ptr<SourceFrame> mLastWritten;
+        Region mPending;
+    };
+
+    class FailingMonitor : public CaptureSource
+    {
+    public:
+        bool Capture() override { return true; }
+        void Write(Region&) override { throw std::runtime_error("device removed"); }
+        void Skip() override {}
+    };
+
+    struct MonitorSetup
+    {
+        SyntheticScenario Scenario;
+        std::chrono::milliseconds Interval;
+    };
+
+    // Monitors of 320x200 side by side, each with its own lock on the surface
+    std::vector<std::shared_ptr<SyntheticMonitor>> AddMonitors(
+        ParallelCapture& capture,
+        std::shared_ptr<CpuSurface> surface,
+        const std::vector<MonitorSetup>& setups,
+        std::chrono::milliseconds lockTimeout)
+    {
+        std::vector<std::shared_ptr<SyntheticMonitor>> monitors;
+        for (size_t i = 0; i < setups.size(); ++i)
+        {
+            SyntheticDesktopOptions options;
+            options.Width = 320;
+            options.Height = 200;
+            options.Scenario = setups[i].Scenario;
+            options.Seed = static_cast<uint32_t>(i + 1);
+            auto monitor = std::make_shared<SyntheticMonitor>(options, POINT{ static_cast<LONG>(i) * 320, 0 }, setups[i].Interval, surface);
+            capture.AddSource("monitor " + std::to_string(i), monitor, std::make_shared<TimedSurfaceLock>(surface, lockTimeout));
+            monitors.push_back(monitor);
+        }
+        return monitors;
+    }
+
+    // Copies what the monitors wrote to the encoder's image until stop,
+    // holding the surface for hold every time
+    void Compose(ParallelCapture& capture, CpuSurface& surface, std::vector<uint32_t>& encoded, std::chrono::milliseconds hold, std::chrono::steady_clock::time_point stop)
+    {
+        Region damage;
+        while (std::chrono::steady_clock::now() < stop)
+        {
+            {
+                std::lock_guard<std::mutex> lock{ surface.Mutex };
+                if (capture.TakeDamage(damage))
+                {
+                    CopyRegion(damage, surface.Pixels.data(), surface.Width, POINT{ 0, 0 }, encoded, surface.Width);
+                }
+                std::this_thread::sleep_for(hold);
+            }
+            std::this_thread::sleep_for(1ms);
+        }
+    }
+}
+
+    TEST_CLASS(ParallelCaptureTests)
+    {
+    public:
+        TEST_METHOD(EveryMonitorReachesTheSurface)
+        {
+            auto surface = std::make_shared<CpuSurface>(3 * 320, 200);
+            ParallelCapture capture;
+            const auto monitors = AddMonitors(capture, surface, {
+                { SyntheticScenario::Typing, 1ms },
+                { SyntheticScenario::WindowDrag, 3ms },
+                { SyntheticScenario::Scrolling, 12ms } }, 10s);
+
+            std::vector<uint32_t> encoded(surface->Pixels.size(), 0);
+            capture.Start();
+            Compose(capture, *surface, encoded, 0ms, std::chrono::steady_clock::now() + 300ms);
+            capture.Stop();
+
+            Region damage;
+            if (capture.TakeDamage(damage))
+            {
+                CopyRegion(damage, surface->Pixels.data(), surface->Width, POINT{ 0, 0 }, encoded, surface->Width);
+            }
+
+            // the reported damage covered every pixel drawn, and nothing was left out of the surface
+            Assert::IsTrue(encoded == surface->Pixels);
+            for (const auto& monitor : monitors)
+            {
+                Assert::IsTrue(monitor->SurfaceShowsLastFrame());
+            }
+
+            const auto stats = capture.Stats();
+            Assert::AreEqual(monitors.size(), stats.size());
+            uint64_t written = 0;
+            for (const CaptureSourceStats& monitorStats : stats)
+            {
+                Assert::IsTrue(monitorStats.Written > 0);
+                Assert::AreEqual(static_cast<uint64_t>(0), monitorStats.Skipped);
+                Assert::AreEqual(monitorStats.Captured, monitorStats.Written);
+                written += monitorStats.Written;
+
+                const std::string message = monitorStats.Name + ": " + std::to_string(monitorStats.FrameRate) + " fps, waited " +
+                    std::to_string(std::chrono::duration<double, std::micro>(monitorStats.LockWait).count()) + " us for the surface, at most " +
+                    std::to_string(std::chrono::duration<double, std::micro>(monitorStats.MaxLockWait).count()) + " us";
+                Logger::WriteMessage(message.c_str());
+            }
+            Assert::AreEqual(written, capture.Written());
+
+            // a monitor refreshing more often is not held up by a slower one
+            Assert::IsTrue(stats[0].FrameRate > stats[2].FrameRate);
+        }
+
+        TEST_METHOD(BusySurfaceCarriesDamageForward)
+        {
+            auto surface = std::make_shared<CpuSurface>(2 * 320, 200);
+            ParallelCapture capture;
+            const auto monitors = AddMonitors(capture, surface, {
+                { SyntheticScenario::Video, 1ms },
+                { SyntheticScenario::Typing, 2ms } }, 1ms);
+
+            // the compositor keeps the surface long enough for captures to give up on it
+            std::vector<uint32_t> encoded(surface->Pixels.size(), 0);
+            capture.Start();
+            Compose(capture, *surface, encoded, 8ms, std::chrono::steady_clock::now() + 300ms);
+            capture.Stop();
+
+            Region damage;
+            if (capture.TakeDamage(damage))
+            {
+                CopyRegion(damage, surface->Pixels.data(), surface->Width, POINT{ 0, 0 }, encoded, surface->Width);
+            }
+
+            Assert::IsTrue(encoded == surface->Pixels);
+            for (const auto& monitor : monitors)
+            {
+                // skipped frames were drawn with the next frame that got the surface
+                Assert::IsTrue(monitor->SurfaceShowsLastFrame());
+            }
+
+            for (const CaptureSourceStats& monitorStats : capture.Stats())
+            {
+                Assert::IsTrue(monitorStats.Skipped > 0);
+                Assert::IsTrue(monitorStats.Written > 0);
+                Assert::AreEqual(monitorStats.Captured, monitorStats.Written + monitorStats.Skipped);
+                Assert::IsTrue(monitorStats.MaxLockWait >= 1ms);
+                Assert::IsTrue(monitorStats.LockWait >= monitorStats.MaxLockWait);
+            }
+        }
+
+        TEST_METHOD(FailedMonitorIsReported)
+        {
+            auto surface = std::make_shared<CpuSurface>(320, 200);
+            ParallelCapture capture;
+            capture.AddSource("failing", std::make_shared<FailingMonitor>(), std::make_shared<TimedSurfaceLock>(surface, 10ms));
+            capture.Start();
+
+            Region damage;
+            bool thrown = false;
+            const auto giveUp = std::chrono::steady_clock::now() + 10s;
+            while (!thrown && std::chrono::steady_clock::now() < giveUp)
+            {
+                try
+                {
+                    capture.TakeDamage(damage);
+                    std::this_thread::sleep_for(1ms);
+                }
+                catch (const std::runtime_error&)
+                {
+                    thrown = true;
+                }
+            }
+            capture.Stop();
+
+            Assert::IsTrue(thrown);
+
+            // the failed write let go of the surface
+            Assert::IsTrue(surface->Mutex.try_lock());
+            surface->Mutex.unlock();
+        }
+
+        TEST_METHOD(RejectsMisuse)
+        {
+            auto surface = std::make_shared<CpuSurface>(320, 200);
+            ParallelCapture capture;
+            Assert::ExpectException<std::logic_error>([&capture]() { capture.Start(); });
+            Assert::ExpectException<std::invalid_argument>([&capture, &surface]()
+            {
+                capture.AddSource("no source", nullptr, std::make_shared<TimedSurfaceLock>(surface, 10ms));
+            });
+
+            AddMonitors(capture, surface, { { SyntheticScenario::Idle, 1ms } }, 10ms);
+            capture.Start();
+            Assert::ExpectException<std::logic_error>([&capture]() { capture.Start(); });
+            Assert::ExpectException<std::logic_error>([&capture, &surface]()
+            {
+                AddMonitors(capture, surface, { { SyntheticScenario::Idle, 1ms } }, 10ms);
+            });
+
+            capture.Stop();
+            Assert::IsFalse(capture.Running());
+        }
+    };
+}
@@ -0,0 +1,275 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+#include "..\VideoLibrary\PointerKernels.h"
+#include <chrono>
+#include <random>
+#include <string>
+
+namespace VideoLibraryTests
+{
+namespace
+{
+    const PointerKernel VectorKernels[] = { PointerKernel::Sse2, PointerKernel::Avx2, PointerKernel::Neon };
+
+    // A desktop with padding at the end of every row, like a mapped texture
+    struct Desktop
+    {
+        Desktop(std::mt19937& random, UINT width, UINT height)
+            : Pitch{ (width + 3) * static_cast<UINT>(sizeof(UINT)) }
+            , Pixels((width + 3) * height)
+        {
+            for (UINT& pixel : Pixels)
+            {
+                pixel = random();
+            }
+        }
+
+        UINT Pitch;
+        std::vector<UINT> Pixels;
+    };
+
+    // Monochrome shapes are two 1 bpp masks, rows padded to a multiple of 16 bits like a DIB
+    std::vector<byte> MonochromeShape(std::mt19937& random, UINT width, UINT height, UINT& pitch)
+    {
+        pitch = ((width + 15) / 16) * 2;
+        std::vector<byte> shape(pitch * height * 2);
+        for (byte& bits : shape)
+        {
+            bits = static_cast<byte>(random());
+        }
+        return shape;
+    }
+
+    // Masked color shapes only use alpha 0 and 0xFF, other values are checked too
+    std::vector<UINT> MaskedColorShape(std::mt19937& random, UINT width, UINT height)
+    {
+        const UINT alphas[] = { 0, 0xFF000000, 0xFF000000, 0, 0x01000000, 0x80000000 };
+        std::vector<UINT> shape(width * height);
+        for (UINT& pixel : shape)
+        {
+            pixel = (random() & 0x00FFFFFF) | alphas[random() % 6];
+        }
+        return shape;
+    }
+}
+
+    TEST_CLASS(PointerKernelsTests)
+    {
+    public:
+        TEST_METHOD(ScalarKernelIsAlwaysSupported)
+        {
+            Assert::IsTrue(PointerKernelSupported(PointerKernel::Scalar));
+            Assert::IsTrue(PointerKernelSupported(BestPointerKernel()));
+        }
+
+        TEST_METHOD(MonochromeKernelsMatchScalar)
+        {
+            std::mt19937 random{ 21 };
+            for (UINT shapeWidth : { 1u, 7u, 8u, 9u, 16u, 31u, 32u, 33u, 48u, 64u, 100u })
+            {
+                const UINT shapeHeight = 24;
+                UINT maskPitch;
+                const std::vector<byte> shape = MonochromeShape(random, shapeWidth, shapeHeight, maskPitch);
+                const Desktop desktop{ random, shapeWidth, shapeHeight };
+
+                // every clipping offset at the top left, and clipping at the bottom right
+                for (UINT maskX = 0; maskX < (std::min)(shapeWidth, 17u); ++maskX)
+                {
+                    for (UINT maskY = 0; maskY < 4; ++maskY)
+                    {
+                        for (UINT clip = 0; clip < 2; ++clip)
+                        {
+                            const UINT width = shapeWidth - maskX - (clip && shapeWidth - maskX > 1 ? 1 : 0);
+                            const UINT height = shapeHeight - maskY - clip;
+                            std::vector<UINT> expected(width * height, 0);
+                            ComposeMonochromePointer(expected.data(), desktop.Pixels.data(), desktop.Pitch, shape.data(), maskPitch, width, height, maskX, maskY, shapeHeight, PointerKernel::Scalar);
+
+                            for (PointerKernel kernel : VectorKernels)
+                            {
+                                if (!PointerKernelSupported(kernel))
+                                {
+                                    continue;
+                                }
+
+                                std::vector<UINT> actual(width * height, 0);
+                                ComposeMonochromePointer(actual.data(), desktop.Pixels.data(), desktop.Pitch, shape.data(), maskPitch, width, height, maskX, maskY, shapeHeight, kernel);
+                                Assert::IsTrue(expected == actual);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        TEST_METHOD(MaskedColorKernelsMatchScalar)
+        {
+            std::mt19937 random{ 22 };
+            for (UINT shapeWidth : { 1u, 3u, 4u, 5u, 8u, 13u, 32u, 33u, 64u, 100u })
+            {
+                const UINT shapeHeight = 24;
+                const std::vector<UINT> shape = MaskedColorShape(random, shapeWidth, shapeHeight);
+                const Desktop desktop{ random, shapeWidth, shapeHeight };
+
+                for (UINT maskX = 0; maskX < (std::min)(shapeWidth, 17u); ++maskX)
+                {
+                    for (UINT maskY = 0; maskY < 4; ++maskY)
+                    {
+                        const UINT width = shapeWidth - maskX;
+                        const UINT height = shapeHeight - maskY;
+                        std::vector<UINT> expected(width * height, 0);
+                        ComposeMaskedColorPointer(expected.data(), desktop.Pixels.data(), desktop.Pitch, shape.data(), shapeWidth * 4, width, height, maskX, maskY, PointerKernel::Scalar);
+
+                        for (PointerKernel kernel : VectorKernels)
+                        {
+                            if (!PointerKernelSupported(kernel))
+                            {
+                                continue;
+                            }
+
+                            std::vector<UINT> actual(width * height, 0);
+                            ComposeMaskedColorPointer(actual.data(), desktop.Pixels.data(), desktop.Pitch, shape.data(), shapeWidth * 4, width, height, maskX, maskY, kernel);
+                            Assert::IsTrue(expected == actual);
+                        }
+                    }
+                }
+            }
+        }
+
+        TEST_METHOD(DecodedShapesMatchTheirKernels)
+        {
+            std::mt19937 random{ 24 };
+            for (UINT shapeWidth : { 1u, 5u, 8u, 13u, 32u, 33u })
+            {
+                const UINT shapeHeight = 20;
+                UINT maskPitch;
+                const std::vector<byte> monochrome = MonochromeShape(random, shapeWidth, shapeHeight, maskPitch);
+                const std::vector<UINT> maskedColor = MaskedColorShape(random, shapeWidth, shapeHeight);
+                const Desktop desktop{ random, shapeWidth, shapeHeight };
+
+                DXGI_OUTDUPL_POINTER_SHAPE_INFO monochromeInfo{};
+                monochromeInfo.Type = DXGI_OUTDUPL_POINTER_SHAPE_TYPE_MONOCHROME;
+                monochromeInfo.Width = shapeWidth;
+                monochromeInfo.Height = shapeHeight * 2;
+                monochromeInfo.Pitch = maskPitch;
+
+                DXGI_OUTDUPL_POINTER_SHAPE_INFO maskedColorInfo{};
+                maskedColorInfo.Type = DXGI_OUTDUPL_POINTER_SHAPE_TYPE_MASKED_COLOR;
+                maskedColorInfo.Width = shapeWidth;
+                maskedColorInfo.Height = shapeHeight;
+                maskedColorInfo.Pitch = shapeWidth * 4;
+
+                DecodedPointerShape decodedMonochrome;
+                DecodedPointerShape decodedMaskedColor;
+                DecodePointerShape(monochromeInfo, monochrome.data(), decodedMonochrome, PointerKernel::Scalar);
+                DecodePointerShape(maskedColorInfo, reinterpret_cast<const byte*>(maskedColor.data()), decodedMaskedColor);
+                Assert::AreEqual(shapeHeight, decodedMonochrome.Height);
+
+                for (UINT maskX = 0; maskX < (std::min)(shapeWidth, 9u); ++maskX)
+                {
+                    for (UINT maskY = 0; maskY < 3; ++maskY)
+                    {
+                        const UINT width = shapeWidth - maskX;
+                        const UINT height = shapeHeight - maskY;
+                        std::vector<UINT> expected(width * height);
+                        std::vector<UINT> actual(width * height);
+                        for (PointerKernel kernel : { PointerKernel::Scalar, PointerKernel::Sse2, PointerKernel::Avx2, PointerKernel::Neon })
+                        {
+                            if (!PointerKernelSupported(kernel))
+                            {
+                                continue;
+                            }
+
+                            ComposeMonochromePointer(expected.data(), desktop.Pixels.data(), desktop.Pitch, monochrome.data(), maskPitch, width, height, maskX, maskY, shapeHeight, PointerKernel::Scalar);
+                            ComposeDecodedPointer(actual.data(), desktop.Pixels.data(), desktop.Pitch, decodedMonochrome, width, height, maskX, maskY, kernel);
+                            Assert::IsTrue(expected == actual);
+
+                            ComposeMaskedColorPointer(expected.data(), desktop.Pixels.data(), desktop.Pitch, maskedColor.data(), shapeWidth * 4, width, height, maskX, maskY, PointerKernel::Scalar);
+                            ComposeDecodedPointer(actual.data(), desktop.Pixels.data(), desktop.Pitch, decodedMaskedColor, width, height, maskX, maskY, kernel);
+                            Assert::IsTrue(expected == actual);
+                        }
+                    }
+                }
+            }
+        }
+
+        TEST_METHOD(UnsupportedKernelThrows)
+        {
+            for (PointerKernel kernel : VectorKernels)
+            {
+                if (PointerKernelSupported(kernel))
+                {
+                    continue;
+                }
+
+                UINT pixel = 0;
+                const byte mask[4] = {};
+                Assert::ExpectException<std::invalid_argument>([&]() {
+                    ComposeMonochromePointer(&pixel, &pixel, 4, mask, 2, 1, 1, 0, 0, 1, kernel);
+                });
+            }
+        }
+
+        TEST_METHOD(PointerKernelsBenchmark)
+        {
+            std::mt19937 random{ 23 };
+            for (UINT size : { 32u, 64u, 128u, 256u })
+            {
+                UINT maskPitch;
+                const std::vector<byte> monochrome = MonochromeShape(random, size, size, maskPitch);
+                const std::vector<UINT> maskedColor = MaskedColorShape(random, size, size);
+                const Desktop desktop{ random, size, size };
+                std::vector<UINT> destination(size * size);
+
+                const int iterations = static_cast<int>(4'000'000 / (size * size));
+                for (PointerKernel kernel : { PointerKernel::Scalar, PointerKernel::Sse2, PointerKernel::Avx2, PointerKernel::Neon })
+                {
+                    if (!PointerKernelSupported(kernel))
+                    {
+                        continue;
+                    }
+
+                    auto start = std::chrono::steady_clock::now();
+                    for (int i = 0; i < iterations; ++i)
+                    {
+                        ComposeMonochromePointer(destination.data(), desktop.Pixels.data(), desktop.Pitch, monochrome.data(), maskPitch, size, size, 0, 0, size, kernel);
+                    }
+                    const auto monochromeElapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+                    start = std::chrono::steady_clock::now();
+                    for (int i = 0; i < iterations; ++i)
+                    {
+                        ComposeMaskedColorPointer(destination.data(), desktop.Pixels.data(), desktop.Pitch, maskedColor.data(), size * 4, size, size, 0, 0, kernel);
+                    }
+                    const auto maskedColorElapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+                    const char* names[] = { "scalar", "sse2", "avx2", "neon" };
+                    const std::string message = std::to_string(size) + "x" + std::to_string(size) + " " + names[static_cast<int>(kernel)] +
+                        ": monochrome " + std::to_string(monochromeElapsed / iterations) + " us, masked color " +
+                        std::to_string(maskedColorElapsed / iterations) + " us";
+                    Logger::WriteMessage(message.c_str());
+                }
+            }
+        }
+    };
+}
@@ -0,0 +1,165 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+#include "..\VideoLibrary\PointerShapeCache.h"
+#include <random>
+
+namespace VideoLibraryTests
+{
+namespace
+{
+    std::vector<byte> RandomShape(std::mt19937& random, const DXGI_OUTDUPL_POINTER_SHAPE_INFO& info)
+    {
+        std::vector<byte> shape(PointerShapeSize(info));
+        for (byte& value : shape)
+        {
+            value = static_cast<byte>(random());
+        }
+        return shape;
+    }
+
+    DXGI_OUTDUPL_POINTER_SHAPE_INFO ShapeInfo(UINT type, UINT width, UINT height)
+    {
+        DXGI_OUTDUPL_POINTER_SHAPE_INFO info{};
+        info.Type = type;
+        info.Width = width;
+        info.Height = type == DXGI_OUTDUPL_POINTER_SHAPE_TYPE_MONOCHROME ? height * 2 : height;
+        info.Pitch = type == DXGI_OUTDUPL_POINTER_SHAPE_TYPE_MONOCHROME ? ((width + 15) / 16) * 2 : width * 4;
+        return info;
+    }
+}
+
+    TEST_CLASS(PointerShapeCacheTests)
+    {
+    public:
+        TEST_METHOD(KeyedByContent)
+        {
+            std::mt19937 random{ 31 };
+            const auto info = ShapeInfo(DXGI_OUTDUPL_POINTER_SHAPE_TYPE_COLOR, 32, 32);
+            std::vector<byte> shape = RandomShape(random, info);
+
+            PointerShapeCache<int> cache;
+            Assert::IsNull(cache.Find(info, shape.data()));
+            cache.Insert(info, shape.data(), 7);
+
+            // a copy in another buffer, with another hot spot, is the same cursor
+            const std::vector<byte> copy = shape;
+            auto moved = info;
+            moved.HotSpot = POINT{ 5, 9 };
+            Assert::AreEqual(7, *cache.Find(moved, copy.data()));
+
+            // one changed pixel or a different type is another cursor
+            shape[shape.size() - 1] ^= 1;
+            Assert::IsNull(cache.Find(info, shape.data()));
+            auto masked = info;
+            masked.Type = DXGI_OUTDUPL_POINTER_SHAPE_TYPE_MASKED_COLOR;
+            Assert::IsNull(cache.Find(masked, copy.data()));
+
+            Assert::AreEqual(static_cast<uint64_t>(1), cache.Hits());
+            Assert::AreEqual(static_cast<uint64_t>(3), cache.Misses());
+        }
+
+        TEST_METHOD(LastValueIsKeptUntilTheNextLookup)
+        {
+            std::mt19937 random{ 33 };
+            const auto info = ShapeInfo(DXGI_OUTDUPL_POINTER_SHAPE_TYPE_MONOCHROME, 32, 32);
+            const std::vector<byte> arrow = RandomShape(random, info);
+            const std::vector<byte> beam = RandomShape(random, info);
+
+            PointerShapeCache<int> cache;
+            Assert::IsNull(cache.Last());
+            cache.Insert(info, arrow.data(), 1);
+            Assert::AreEqual(1, *cache.Last());
+
+            // a pointer that keeps its shape reuses the value without hashing it
+            for (int frame = 0; frame < 10; ++frame)
+            {
+                Assert::AreEqual(1, *cache.Last());
+            }
+            Assert::AreEqual(static_cast<uint64_t>(0), cache.Hits() + cache.Misses());
+
+            cache.Insert(info, beam.data(), 2);
+            Assert::AreEqual(2, *cache.Last());
+            Assert::AreEqual(1, *cache.Find(info, arrow.data()));
+            Assert::AreEqual(1, *cache.Last());
+
+            auto other = info;
+            other.Width = 16;
+            Assert::IsNull(cache.Find(other, arrow.data()));
+            Assert::IsNull(cache.Last());
+
+            cache.Find(info, beam.data());
+            cache.Clear();
+            Assert::IsNull(cache.Last());
+        }
+
+        TEST_METHOD(HashCoversTheWholeShape)
+        {
+            std::mt19937 random{ 32 };
+            for (UINT width : { 1u, 3u, 17u, 32u })
+            {
+                const auto info = ShapeInfo(DXGI_OUTDUPL_POINTER_SHAPE_TYPE_MONOCHROME, width, width);
+                std::vector<byte> shape = RandomShape(random, info);
+                const uint64_t hash = HashPointerShape(info, shape.data());
+                for (size_t i = 0; i < shape.size(); ++i)
+                {
+                    shape[i] ^= 0x10;
+                    Assert::IsTrue(hash != HashPointerShape(info, shape.data()));
+                    shape[i] ^= 0x10;
+                }
+                Assert::IsTrue(hash == HashPointerShape(info, shape.data()));
+            }
+        }
+
+        TEST_METHOD(CommonCursorSetStaysCached)
+        {
+            // arrow, I-beam, hand, wait and four resize cursors, switched between over and over
+            std::mt19937 random{ 33 };
+            std::vector<DXGI_OUTDUPL_POINTER_SHAPE_INFO> infos;
+            std::vector<std::vector<byte>> shapes;
+            for (int i = 0; i < 8; ++i)
+            {
+                infos.push_back(ShapeInfo(i % 3 == 0 ? DXGI_OUTDUPL_POINTER_SHAPE_TYPE_MONOCHROME : DXGI_OUTDUPL_POINTER_SHAPE_TYPE_COLOR, 32, 32));
+                shapes.push_back(RandomShape(random, infos.back()));
+            }
+
+            PointerShapeCache<size_t> cache;
+            for (int i = 0; i < 1000; ++i)
+            {
+                const size_t cursor = random() % shapes.size();
+                const size_t* cached = cache.Find(infos[cursor], shapes[cursor].data());
+                if (cached == nullptr)
+                {
+                    cache.Insert(infos[cursor], shapes[cursor].data(), cursor);
+                }
+                else
+                {
+                    Assert::AreEqual(cursor, *cached);
+                }
+            }
+
+            Assert::AreEqual(static_cast<uint64_t>(8), cache.Misses());
+            Assert::AreEqual(static_cast<uint64_t>(0), cache.Evictions());
+        }
+    };
+}
@@ -0,0 +1,147 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+#include "..\VideoLibrary\PointerTrackWriter.h"
+#include "..\VideoLibrary\PointerTrackReader.h"
+#include <fstream>
+#include <stdexcept>
+
+namespace VideoLibraryTests
+{
+namespace
+{
+    std::filesystem::path TrackPath(const char* name)
+    {
+        return std::filesystem::temp_directory_path() / name;
+    }
+
+    struct TestShape
+    {
+        DXGI_OUTDUPL_POINTER_SHAPE_INFO Info;
+        std::vector<byte> Buffer;
+    };
+
+    TestShape ColorShape(UINT size, byte fill, POINT hotSpot = POINT{ 0, 0 })
+    {
+        TestShape shape;
+        shape.Info = DXGI_OUTDUPL_POINTER_SHAPE_INFO{ DXGI_OUTDUPL_POINTER_SHAPE_TYPE_COLOR, size, size, size * 4, hotSpot };
+        shape.Buffer.assign(size * size * 4, fill);
+        return shape;
+    }
+}
+
+    TEST_CLASS(PointerTrackTests)
+    {
+    public:
+        TEST_METHOD(RoundTripsSamplesAndShapes)
+        {
+            const auto path = TrackPath("pointer_track_round_trip.pointer");
+            const TestShape arrow = ColorShape(32, 0x11);
+            const TestShape beam = ColorShape(16, 0x22, POINT{ 8, 8 });
+            {
+                PointerTrackWriter writer{ path, 1000, 500 };
+
+                // a sample before any shape arrived
+                writer.WriteSample(500, true, POINT{ 1, 1 });
+                writer.WriteShape(arrow.Info, arrow.Buffer.data());
+                writer.WriteSample(510, true, POINT{ 10, 20 });
+                writer.WriteSample(520, true, POINT{ 10, 20 });
+                writer.WriteShape(beam.Info, beam.Buffer.data());
+                writer.WriteSample(530, true, POINT{ 10, 20 });
+                writer.WriteShape(arrow.Info, arrow.Buffer.data());
+                writer.WriteSample(540, false, POINT{ 10, 20 });
+
+                Assert::AreEqual(static_cast<uint64_t>(2), writer.ShapesWritten());
+                Assert::AreEqual(static_cast<uint64_t>(4), writer.SamplesWritten());
+            }
+
+            PointerTrackReader reader{ path };
+            Assert::AreEqual(static_cast<int64_t>(1000), reader.TicksPerSecond());
+            Assert::AreEqual(static_cast<int64_t>(500), reader.StartTime());
+            Assert::AreEqual(static_cast<size_t>(2), reader.ShapeCount());
+            Assert::IsTrue(reader.Shape(0) == arrow.Buffer);
+            Assert::IsTrue(reader.Shape(1) == beam.Buffer);
+            Assert::AreEqual(static_cast<LONG>(8), reader.ShapeInfo(1).HotSpot.x);
+
+            const auto& samples = reader.Samples();
+            Assert::AreEqual(static_cast<size_t>(4), samples.size());
+            Assert::AreEqual(PointerTrackNoShape, samples[0].ShapeId);
+            Assert::AreEqual(static_cast<uint32_t>(0), samples[1].ShapeId);
+            Assert::AreEqual(static_cast<uint32_t>(1), samples[2].ShapeId);
+            Assert::AreEqual(static_cast<uint32_t>(0), samples[3].ShapeId);
+            Assert::AreEqual(0, samples[3].Visible);
+
+            Assert::IsNull(reader.At(499));
+            Assert::AreEqual(static_cast<int64_t>(510), reader.At(525)->Time);
+            Assert::AreEqual(static_cast<int64_t>(530), reader.At(530)->Time);
+            Assert::AreEqual(static_cast<int64_t>(540), reader.At(100000)->Time);
+
+            std::filesystem::remove(path);
+        }
+
+        TEST_METHOD(ShapesDifferingOnlyInHotSpotAreKept)
+        {
+            const auto path = TrackPath("pointer_track_hot_spot.pointer");
+            const TestShape left = ColorShape(8, 0x33, POINT{ 0, 0 });
+            const TestShape right = ColorShape(8, 0x33, POINT{ 7, 0 });
+            {
+                PointerTrackWriter writer{ path, 1000, 0 };
+                for (int i = 0; i < 100; ++i)
+                {
+                    const TestShape& shape = i % 2 == 0 ? left : right;
+                    writer.WriteShape(shape.Info, shape.Buffer.data());
+                    writer.WriteSample(i, true, POINT{ 0, 0 });
+                }
+                Assert::AreEqual(static_cast<uint64_t>(2), writer.ShapesWritten());
+                Assert::AreEqual(static_cast<uint64_t>(100), writer.SamplesWritten());
+            }
+
+            PointerTrackReader reader{ path };
+            Assert::AreEqual(static_cast<size_t>(2), reader.ShapeCount());
+            Assert::AreEqual(static_cast<LONG>(7), reader.ShapeInfo(1).HotSpot.x);
+            std::filesystem::remove(path);
+        }
+
+        TEST_METHOD(RejectsCorruptTracks)
+        {
+            const auto path = TrackPath("pointer_track_corrupt.pointer");
+            {
+                std::ofstream file{ path, std::ios::binary };
+                file << "not a pointer track at all, just text";
+            }
+            Assert::ExpectException<std::runtime_error>([&path]() { PointerTrackReader reader{ path }; });
+
+            const TestShape arrow = ColorShape(32, 0x11);
+            {
+                PointerTrackWriter writer{ path, 1000, 0 };
+                writer.WriteShape(arrow.Info, arrow.Buffer.data());
+            }
+            std::filesystem::resize_file(path, std::filesystem::file_size(path) - 16);
+            Assert::ExpectException<std::runtime_error>([&path]() { PointerTrackReader reader{ path }; });
+
+            Assert::ExpectException<std::invalid_argument>([&path]() { PointerTrackWriter writer{ path, 0, 0 }; });
+            std::filesystem::remove(path);
+        }
+    };
+}
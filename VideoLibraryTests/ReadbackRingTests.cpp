@@ -0,0 +1,273 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+#include "..\VideoLibrary\ReadbackRing.h"
+#include <stdexcept>
+#include <thread>
+
+namespace VideoLibraryTests
+{
+namespace
+{
+    // A GPU that finishes each copy a fixed number of frames after it was queued.
+    // The surface's pixels hold their own index so readbacks can be checked.
+    class DelayedReadbackDevice : public ReadbackDevice
+    {
+    public:
+        static constexpr UINT SurfaceWidth = 256;
+
+        class Buffer : public ReadbackBuffer
+        {
+        public:
+            Buffer(UINT width, UINT height) : Pixels(width * height), mWidth{ width }, mHeight{ height }, FinishedAt{ 0 }, Mapped{ false } {}
+
+            UINT Width() const override { return mWidth; }
+            UINT Height() const override { return mHeight; }
+
+            std::vector<UINT> Pixels;
+            UINT mWidth;
+            UINT mHeight;
+            uint64_t FinishedAt;
+            bool Mapped;
+        };
+
+        explicit DelayedReadbackDevice(uint64_t delay) : Delay{ delay } {}
+
+        std::shared_ptr<ReadbackBuffer> CreateBuffer(UINT width, UINT height) override
+        {
+            ++Creations;
+            return std::make_shared<Buffer>(width, height);
+        }
+
+        void Copy(ReadbackBuffer& buffer, const RECT& region) override
+        {
+            Buffer& target = static_cast<Buffer&>(buffer);
+            Assert::IsFalse(target.Mapped, L"copy to a mapped buffer");
+            Assert::IsTrue(static_cast<UINT>(region.right - region.left) <= target.Width());
+            Assert::IsTrue(static_cast<UINT>(region.bottom - region.top) <= target.Height());
+            for (LONG y = region.top; y < region.bottom; ++y)
+            {
+                for (LONG x = region.left; x < region.right; ++x)
+                {
+                    target.Pixels[(y - region.top) * target.Width() + (x - region.left)] = y * SurfaceWidth + x;
+                }
+            }
+            target.FinishedAt = Frame + Delay;
+        }
+
+        bool Map(ReadbackBuffer& buffer, bool wait, MappedReadback& mapped) override
+        {
+            Buffer& source = static_cast<Buffer&>(buffer);
+            Assert::IsFalse(source.Mapped, L"buffer mapped twice");
+            if (Frame < source.FinishedAt)
+            {
+                if (!wait)
+                {
+                    return false;
+                }
+
+                FramesWaited += source.FinishedAt - Frame;
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+
+            source.Mapped = true;
+            mapped.Data = reinterpret_cast<const byte*>(source.Pixels.data());
+            mapped.Pitch = source.Width() * sizeof(UINT);
+            return true;
+        }
+
+        void Unmap(ReadbackBuffer& buffer) override
+        {
+            Buffer& source = static_cast<Buffer&>(buffer);
+            Assert::IsTrue(source.Mapped, L"buffer unmapped without a map");
+            source.Mapped = false;
+        }
+
+        uint64_t Delay;
+        uint64_t Frame = 0;
+        uint64_t Creations = 0;
+        uint64_t FramesWaited = 0;
+    };
+
+    void AssertHoldsRegion(const ReadbackResult& result)
+    {
+        const RECT& region = result.Request.Region;
+        for (LONG y = region.top; y < region.bottom; ++y)
+        {
+            const UINT* row = reinterpret_cast<const UINT*>(result.Pixels.Data + (y - region.top) * result.Pixels.Pitch);
+            for (LONG x = region.left; x < region.right; ++x)
+            {
+                Assert::AreEqual(static_cast<UINT>(y * DelayedReadbackDevice::SurfaceWidth + x), row[x - region.left]);
+            }
+        }
+    }
+
+    ReadbackRequest PointerAt(LONG x, LONG y, LONG size = 32)
+    {
+        return ReadbackRequest{ RECT{ x, y, x + size, y + size }, POINT{ 0, 0 } };
+    }
+}
+
+    TEST_CLASS(ReadbackRingTests)
+    {
+    public:
+        TEST_METHOD(SteadyStateNeverStalls)
+        {
+            auto device = std::make_shared<DelayedReadbackDevice>(1);
+            ReadbackRing ring{ device };
+
+            // the first frame has nothing to fall back to
+            ring.Submit(PointerAt(0, 0));
+            ReadbackResult result;
+            Assert::IsTrue(ring.Acquire(result, true));
+            Assert::AreEqual(static_cast<size_t>(0), result.Age);
+            AssertHoldsRegion(result);
+            Assert::AreEqual(static_cast<uint64_t>(1), ring.Stalls());
+
+            // the second has nothing new finished yet and keeps the first frame's result
+            ++device->Frame;
+            ring.Submit(PointerAt(1, 1));
+            Assert::IsFalse(ring.Acquire(result));
+
+            for (LONG frame = 2; frame < 1000; ++frame)
+            {
+                ++device->Frame;
+                ring.Submit(PointerAt(frame % 200, frame % 150));
+                Assert::IsTrue(ring.Acquire(result));
+
+                // the copy queued on the previous frame is the newest finished one
+                Assert::AreEqual(static_cast<size_t>(1), result.Age);
+                Assert::AreEqual(static_cast<LONG>((frame - 1) % 200), result.Request.Region.left);
+                AssertHoldsRegion(result);
+            }
+            ring.Release();
+
+            Assert::AreEqual(static_cast<uint64_t>(1), ring.Stalls());
+            Assert::AreEqual(static_cast<uint64_t>(998), ring.Hits());
+            Assert::AreEqual(static_cast<uint64_t>(1), ring.Misses());
+            Assert::AreEqual(static_cast<uint64_t>(0), ring.Dropped());
+            Assert::AreEqual(static_cast<uint64_t>(1000), ring.Submits());
+            Assert::AreEqual(static_cast<uint64_t>(ReadbackRing::DefaultLatency + 1), device->Creations);
+            Assert::AreEqual(static_cast<size_t>(1), ring.Pending());
+        }
+
+        TEST_METHOD(SlowGpuStallsOnlyAtTheLatency)
+        {
+            auto device = std::make_shared<DelayedReadbackDevice>(5);
+            ReadbackRing ring{ device, 2 };
+            ReadbackResult result;
+
+            // younger than the latency, the caller keeps drawing what it had
+            ring.Submit(PointerAt(0, 0));
+            Assert::IsFalse(ring.Acquire(result));
+            ++device->Frame;
+            ring.Submit(PointerAt(1, 0));
+            Assert::IsFalse(ring.Acquire(result));
+            ++device->Frame;
+
+            // the first copy reached the latency and is waited on
+            ring.Submit(PointerAt(2, 0));
+            Assert::IsTrue(ring.Acquire(result));
+            Assert::AreEqual(static_cast<size_t>(2), result.Age);
+            Assert::AreEqual(static_cast<LONG>(0), result.Request.Region.left);
+            AssertHoldsRegion(result);
+
+            Assert::AreEqual(static_cast<uint64_t>(2), ring.Misses());
+            Assert::AreEqual(static_cast<uint64_t>(1), ring.Stalls());
+            Assert::AreEqual(static_cast<uint64_t>(3), device->FramesWaited);
+            Assert::IsTrue(ring.StallTime().count() > 0);
+            Assert::AreEqual(static_cast<size_t>(2), ring.Pending());
+        }
+
+        TEST_METHOD(OlderReadbacksAreDropped)
+        {
+            auto device = std::make_shared<DelayedReadbackDevice>(1);
+            ReadbackRing ring{ device, 3 };
+            ReadbackResult result;
+
+            ring.Submit(PointerAt(0, 0));
+            ++device->Frame;
+            ring.Submit(PointerAt(1, 0));
+            ++device->Frame;
+            ring.Submit(PointerAt(2, 0));
+
+            // both older copies finished, only the newer one is used
+            Assert::IsTrue(ring.Acquire(result));
+            Assert::AreEqual(static_cast<LONG>(1), result.Request.Region.left);
+            Assert::AreEqual(static_cast<uint64_t>(1), ring.Dropped());
+
+            // waiting only accepts the latest request even when an older one finished
+            ++device->Frame;
+            ring.Submit(PointerAt(3, 0));
+            Assert::IsTrue(ring.Acquire(result, true));
+            Assert::AreEqual(static_cast<size_t>(0), result.Age);
+            Assert::AreEqual(static_cast<LONG>(3), result.Request.Region.left);
+            Assert::AreEqual(static_cast<uint64_t>(2), ring.Dropped());
+            Assert::AreEqual(static_cast<uint64_t>(1), ring.Stalls());
+            Assert::AreEqual(static_cast<size_t>(0), ring.Pending());
+
+            // a caller that never acquires has its readbacks overwritten
+            for (LONG frame = 0; frame < 10; ++frame)
+            {
+                ring.Submit(PointerAt(frame, 0));
+            }
+            Assert::AreEqual(static_cast<uint64_t>(2 + 10 - 4), ring.Dropped());
+        }
+
+        TEST_METHOD(BuffersGrowToTheLargestRegion)
+        {
+            auto device = std::make_shared<DelayedReadbackDevice>(0);
+            ReadbackRing ring{ device, 1 };
+            ReadbackResult result;
+
+            const LONG sizes[] = { 16, 32, 24, 48, 8, 48, 32 };
+            for (LONG size : sizes)
+            {
+                ring.Submit(ReadbackRequest{ RECT{ 10, 20, 10 + size, 20 + size / 2 }, POINT{ size, 1 } });
+                Assert::IsTrue(ring.Acquire(result));
+                Assert::AreEqual(size, result.Request.Origin.x);
+                AssertHoldsRegion(result);
+            }
+
+            // two slots, each grown for 16, 32 and 48 at most
+            Assert::IsTrue(ring.Grows() <= 6);
+            Assert::AreEqual(ring.Grows(), device->Creations);
+            Assert::AreEqual(static_cast<uint64_t>(0), ring.Stalls());
+        }
+
+        TEST_METHOD(RejectsBadArguments)
+        {
+            auto device = std::make_shared<DelayedReadbackDevice>(0);
+            Assert::ExpectException<std::invalid_argument>([]() { ReadbackRing ring{ nullptr }; });
+            Assert::ExpectException<std::invalid_argument>([device]() { ReadbackRing ring{ device, 0 }; });
+
+            ReadbackRing ring{ device };
+            Assert::ExpectException<std::invalid_argument>([&ring]() { ring.Submit(ReadbackRequest{ RECT{ 4, 4, 4, 8 }, POINT{} }); });
+
+            ReadbackResult result;
+            Assert::IsFalse(ring.Acquire(result, true));
+            Assert::AreEqual(static_cast<uint64_t>(1), ring.Misses());
+        }
+    };
+}
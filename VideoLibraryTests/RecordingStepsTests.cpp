@@ -54,8 +54,9 @@ namespace VideoLibraryTests
             int i = 0;
             for (auto& duplicator : duplicators) {
 
+                DuplicationFrameSource frameSource{ duplicator };
                 for (int j = 0; j < 100; ++i, ++j) {
-                    recordingStep.reset(new CaptureFrameStep{ *duplicator });
+                    recordingStep.reset(new CaptureFrameStep{ frameSource });
                     recordingStep->Perform();
                 }
             }
@@ -0,0 +1,234 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+#include "..\VideoLibrary\Region.h"
+#include <chrono>
+#include <random>
+#include <string>
+
+namespace VideoLibraryTests
+{
+namespace
+{
+    // Reference implementation: one byte per pixel
+    class Bitmap
+    {
+    public:
+        static constexpr LONG Size = 96;
+
+        Bitmap() : mPixels(Size * Size, 0) {}
+
+        explicit Bitmap(const Region& region) : Bitmap()
+        {
+            for (size_t i = 0; i < region.RectsCount(); ++i)
+            {
+                Fill(region.Rects()[i], 1);
+            }
+        }
+
+        void Fill(const RECT& rect, char value)
+        {
+            for (LONG y = (std::max)(rect.top, static_cast<LONG>(0)); y < (std::min)(rect.bottom, static_cast<LONG>(Size)); ++y)
+            {
+                for (LONG x = (std::max)(rect.left, static_cast<LONG>(0)); x < (std::min)(rect.right, static_cast<LONG>(Size)); ++x)
+                {
+                    mPixels[y * Size + x] = value;
+                }
+            }
+        }
+
+        char At(LONG x, LONG y) const { return mPixels[y * Size + x]; }
+
+        bool operator==(const Bitmap& other) const { return mPixels == other.mPixels; }
+
+    private:
+        std::vector<char> mPixels;
+    };
+
+    std::vector<RECT> RandomRects(std::mt19937& random, size_t count, LONG size)
+    {
+        std::uniform_int_distribution<LONG> position{ 0, size - 1 };
+        std::uniform_int_distribution<LONG> extent{ 1, 24 };
+        std::vector<RECT> rects;
+        for (size_t i = 0; i < count; ++i)
+        {
+            const LONG x = position(random);
+            const LONG y = position(random);
+            rects.push_back(RECT{ x, y, (std::min)(size, x + extent(random)), (std::min)(size, y + extent(random)) });
+        }
+        return rects;
+    }
+
+    // Checks the banding invariants every region must keep
+    void AssertWellFormed(const Region& region)
+    {
+        const RECT* rects = region.Rects();
+        for (size_t i = 0; i < region.RectsCount(); ++i)
+        {
+            Assert::IsTrue(rects[i].left < rects[i].right && rects[i].top < rects[i].bottom);
+            if (i == 0)
+            {
+                continue;
+            }
+
+            const RECT& previous = rects[i - 1];
+            if (previous.top == rects[i].top)
+            {
+                Assert::AreEqual(previous.bottom, rects[i].bottom);
+                Assert::IsTrue(previous.right < rects[i].left, L"spans in a band must not touch");
+            }
+            else
+            {
+                Assert::IsTrue(previous.bottom <= rects[i].top, L"bands must not overlap");
+            }
+        }
+    }
+}
+
+    TEST_CLASS(RegionTests)
+    {
+    public:
+        TEST_METHOD(OperationsMatchBitmapReference)
+        {
+            std::mt19937 random{ 7 };
+            for (int run = 0; run < 200; ++run)
+            {
+                const auto rectsA = RandomRects(random, 1 + run % 20, Bitmap::Size);
+                const auto rectsB = RandomRects(random, 1 + run % 13, Bitmap::Size);
+
+                Bitmap bitmapA, bitmapB;
+                for (const RECT& r : rectsA) bitmapA.Fill(r, 1);
+                for (const RECT& r : rectsB) bitmapB.Fill(r, 1);
+
+                Region a, b;
+                a.Reset(rectsA.data(), rectsA.size());
+                for (const RECT& r : rectsB) b.Union(r);
+                AssertWellFormed(a);
+                AssertWellFormed(b);
+                Assert::IsTrue(Bitmap{ a } == bitmapA);
+                Assert::IsTrue(Bitmap{ b } == bitmapB);
+
+                Region unionRegion = a;
+                unionRegion.Union(b);
+                Region intersectRegion = a;
+                intersectRegion.Intersect(b);
+                Region subtractRegion = a;
+                subtractRegion.Subtract(b);
+
+                AssertWellFormed(unionRegion);
+                AssertWellFormed(intersectRegion);
+                AssertWellFormed(subtractRegion);
+
+                const Bitmap unionBitmap{ unionRegion };
+                const Bitmap intersectBitmap{ intersectRegion };
+                const Bitmap subtractBitmap{ subtractRegion };
+                int64_t unionArea = 0;
+                for (LONG y = 0; y < Bitmap::Size; ++y)
+                {
+                    for (LONG x = 0; x < Bitmap::Size; ++x)
+                    {
+                        const bool inA = bitmapA.At(x, y) != 0;
+                        const bool inB = bitmapB.At(x, y) != 0;
+                        Assert::AreEqual(inA || inB, unionBitmap.At(x, y) != 0);
+                        Assert::AreEqual(inA && inB, intersectBitmap.At(x, y) != 0);
+                        Assert::AreEqual(inA && !inB, subtractBitmap.At(x, y) != 0);
+                        Assert::AreEqual(inA || inB, unionRegion.Contains(POINT{ x, y }));
+                        unionArea += (inA || inB) ? 1 : 0;
+                    }
+                }
+                Assert::AreEqual(unionArea, unionRegion.Area());
+            }
+        }
+
+        TEST_METHOD(RepresentationIsCanonical)
+        {
+            // the same pixels built in different orders produce identical rects
+            Region horizontal;
+            horizontal.Union(RECT{ 0, 0, 10, 10 });
+            horizontal.Union(RECT{ 10, 0, 20, 10 });
+            horizontal.Union(RECT{ 0, 10, 20, 20 });
+
+            Region vertical;
+            vertical.Union(RECT{ 0, 0, 20, 5 });
+            vertical.Union(RECT{ 0, 15, 20, 20 });
+            vertical.Union(RECT{ 0, 5, 20, 15 });
+
+            Assert::AreEqual(static_cast<size_t>(1), horizontal.RectsCount());
+            Assert::IsTrue(horizontal == vertical);
+        }
+
+        TEST_METHOD(TranslateAndClip)
+        {
+            Region region;
+            const std::vector<RECT> rects = { { 0, 0, 10, 10 }, { 20, 20, 30, 30 } };
+            region.Reset(rects.data(), rects.size());
+
+            region.Translate(5, -5);
+            Assert::AreEqual(5L, static_cast<long>(region.Extents().left));
+            Assert::AreEqual(-5L, static_cast<long>(region.Extents().top));
+            Assert::AreEqual(35L, static_cast<long>(region.Extents().right));
+            Assert::AreEqual(25L, static_cast<long>(region.Extents().bottom));
+
+            region.Clip(RECT{ 0, 0, 30, 30 });
+            Assert::AreEqual(static_cast<int64_t>(10 * 5 + 5 * 10), region.Area());
+            Assert::IsTrue(region.Intersects(RECT{ 26, 16, 40, 40 }));
+            Assert::IsFalse(region.Intersects(RECT{ 16, 0, 24, 14 }));
+
+            region.Clip(RECT{ 100, 100, 200, 200 });
+            Assert::IsTrue(region.IsEmpty());
+        }
+
+        TEST_METHOD(RegionOperationsBenchmark)
+        {
+            std::mt19937 random{ 99 };
+            for (size_t count : { static_cast<size_t>(10), static_cast<size_t>(100), static_cast<size_t>(1000), static_cast<size_t>(10000) })
+            {
+                const auto rectsA = RandomRects(random, count, 4096);
+                const auto rectsB = RandomRects(random, count, 4096);
+
+                Region a, b, work;
+                b.Reset(rectsB.data(), rectsB.size());
+
+                const int iterations = static_cast<int>((std::max)(static_cast<size_t>(1), 20000 / count));
+                const auto start = std::chrono::steady_clock::now();
+                for (int i = 0; i < iterations; ++i)
+                {
+                    a.Reset(rectsA.data(), rectsA.size());
+                    work = a;
+                    work.Union(b);
+                    work = a;
+                    work.Intersect(b);
+                    work = a;
+                    work.Subtract(b);
+                    work.Translate(3, 7);
+                }
+                const auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+                const std::string message = std::to_string(count) + " rects: build + union + intersect + subtract + translate in " +
+                    std::to_string(elapsed / iterations) + " us (" + std::to_string(a.RectsCount()) + " banded rects)";
+                Logger::WriteMessage(message.c_str());
+            }
+        }
+    };
+}
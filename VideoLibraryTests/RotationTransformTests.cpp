@@ -0,0 +1,189 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+#include "..\VideoLibrary\RotationTransform.h"
+
+namespace VideoLibraryTests
+{
+namespace
+{
+    const DXGI_MODE_ROTATION Rotations[] = {
+        DXGI_MODE_ROTATION_IDENTITY,
+        DXGI_MODE_ROTATION_ROTATE90,
+        DXGI_MODE_ROTATION_ROTATE180,
+        DXGI_MODE_ROTATION_ROTATE270
+    };
+
+    // Reference: where a point on the desktop image lands on the desktop
+    POINT RotatePoint(DXGI_MODE_ROTATION rotation, POINT point, LONG width, LONG height)
+    {
+        switch (rotation)
+        {
+        case DXGI_MODE_ROTATION_ROTATE90:
+            return POINT{ height - point.y, point.x };
+        case DXGI_MODE_ROTATION_ROTATE180:
+            return POINT{ width - point.x, height - point.y };
+        case DXGI_MODE_ROTATION_ROTATE270:
+            return POINT{ point.y, width - point.x };
+        default:
+            return point;
+        }
+    }
+
+    POINT Corner(const RECT& rect, RectCorner corner)
+    {
+        switch (corner)
+        {
+        case BottomLeftCorner:
+            return POINT{ rect.left, rect.bottom };
+        case TopLeftCorner:
+            return POINT{ rect.left, rect.top };
+        case BottomRightCorner:
+            return POINT{ rect.right, rect.bottom };
+        default:
+            return POINT{ rect.right, rect.top };
+        }
+    }
+
+    RECT ReferenceRect(DXGI_MODE_ROTATION rotation, const RECT& rect, LONG width, LONG height)
+    {
+        const POINT a = RotatePoint(rotation, POINT{ rect.left, rect.top }, width, height);
+        const POINT b = RotatePoint(rotation, POINT{ rect.right, rect.bottom }, width, height);
+        return RECT{ (std::min)(a.x, b.x), (std::min)(a.y, b.y), (std::max)(a.x, b.x), (std::max)(a.y, b.y) };
+    }
+
+    bool Equal(const RECT& a, const RECT& b)
+    {
+        return a.left == b.left && a.top == b.top && a.right == b.right && a.bottom == b.bottom;
+    }
+
+    std::vector<RECT> AllRects(LONG width, LONG height)
+    {
+        std::vector<RECT> rects;
+        for (LONG top = 0; top < height; ++top)
+            for (LONG bottom = top + 1; bottom <= height; ++bottom)
+                for (LONG left = 0; left < width; ++left)
+                    for (LONG right = left + 1; right <= width; ++right)
+                        rects.push_back(RECT{ left, top, right, bottom });
+        return rects;
+    }
+}
+
+    TEST_CLASS(RotationTransformTests)
+    {
+    public:
+        TEST_METHOD(RectsMatchReference)
+        {
+            constexpr LONG width = 7;
+            constexpr LONG height = 5;
+            const std::vector<RECT> rects = AllRects(width, height);
+            std::vector<RECT> batch(rects.size());
+
+            for (DXGI_MODE_ROTATION rotation : Rotations)
+            {
+                RotateRects(rotation, rects.data(), rects.size(), width, height, batch.data());
+
+                VisitRotation(rotation, [&](auto transform) {
+                    using Transform = decltype(transform);
+                    for (size_t i = 0; i < rects.size(); ++i)
+                    {
+                        const RECT expected = ReferenceRect(rotation, rects[i], width, height);
+                        Assert::IsTrue(Equal(expected, Transform::Rect(rects[i], width, height)));
+                        Assert::IsTrue(Equal(expected, batch[i]));
+
+                        // rotated rects stay on the rotated desktop
+                        const LONG desktopWidth = Transform::SwapsDimensions ? height : width;
+                        const LONG desktopHeight = Transform::SwapsDimensions ? width : height;
+                        Assert::IsTrue(expected.left >= 0 && expected.top >= 0);
+                        Assert::IsTrue(expected.right <= desktopWidth && expected.bottom <= desktopHeight);
+                    }
+                });
+            }
+        }
+
+        TEST_METHOD(TexCoordsFollowTheRotatedCorners)
+        {
+            constexpr LONG width = 6;
+            constexpr LONG height = 4;
+            for (DXGI_MODE_ROTATION rotation : Rotations)
+            {
+                VisitRotation(rotation, [&](auto transform) {
+                    using Transform = decltype(transform);
+                    for (const RECT& rect : AllRects(width, height))
+                    {
+                        const RECT rotated = Transform::Rect(rect, width, height);
+
+                        TexCoord texCoords[4];
+                        Transform::TexCoords(rect, 1.0f / width, 1.0f / height, texCoords);
+
+                        for (int corner = 0; corner < 4; ++corner)
+                        {
+                            // the image corner sampled at this corner of the quad must land on it
+                            const POINT source = Corner(rect, Transform::SourceCorners[corner]);
+                            const POINT expected = RotatePoint(rotation, source, width, height);
+                            const POINT actual = Corner(rotated, static_cast<RectCorner>(corner));
+                            Assert::AreEqual(expected.x, actual.x);
+                            Assert::AreEqual(expected.y, actual.y);
+
+                            Assert::AreEqual(source.x / static_cast<float>(width), texCoords[corner].u, 1e-6f);
+                            Assert::AreEqual(source.y / static_cast<float>(height), texCoords[corner].v, 1e-6f);
+                        }
+                    }
+                });
+            }
+        }
+
+        TEST_METHOD(MoveRectsRotateSourceAndDestination)
+        {
+            constexpr LONG width = 40;
+            constexpr LONG height = 30;
+            std::vector<DXGI_OUTDUPL_MOVE_RECT> moveRects;
+            for (LONG i = 0; i < 9; ++i)
+            {
+                DXGI_OUTDUPL_MOVE_RECT moveRect;
+                moveRect.SourcePoint = POINT{ i, 2 * i };
+                moveRect.DestinationRect = RECT{ 3 + i, 1 + i, 13 + 2 * i, 6 + i };
+                moveRects.push_back(moveRect);
+            }
+
+            std::vector<RECT> sources(moveRects.size());
+            std::vector<RECT> destinations(moveRects.size());
+            for (DXGI_MODE_ROTATION rotation : Rotations)
+            {
+                RotateMoveRects(rotation, moveRects.data(), moveRects.size(), width, height, sources.data(), destinations.data());
+                for (size_t i = 0; i < moveRects.size(); ++i)
+                {
+                    const RECT& destination = moveRects[i].DestinationRect;
+                    const RECT source{
+                        moveRects[i].SourcePoint.x,
+                        moveRects[i].SourcePoint.y,
+                        moveRects[i].SourcePoint.x + destination.right - destination.left,
+                        moveRects[i].SourcePoint.y + destination.bottom - destination.top };
+
+                    Assert::IsTrue(Equal(ReferenceRect(rotation, source, width, height), sources[i]));
+                    Assert::IsTrue(Equal(ReferenceRect(rotation, destination, width, height), destinations[i]));
+                }
+            }
+        }
+    };
+}
@@ -0,0 +1,235 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+#include "..\VideoLibrary\StagedExecutor.h"
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace VideoLibraryTests
+{
+namespace
+{
+    // Synthetic frames, the token counts frames alive like pooled textures would
+    struct TestFrame
+    {
+        int Number = -1;
+        std::shared_ptr<int> Token;
+    };
+
+    // What the last stage saw, in order
+    class Sink
+    {
+    public:
+        StagedExecutor<TestFrame>::Stage Stage(std::chrono::milliseconds work = 0ms)
+        {
+            return [this, work](TestFrame& frame)
+            {
+                std::this_thread::sleep_for(work);
+                std::lock_guard<std::mutex> lock{ mMutex };
+                mNumbers.push_back(frame.Number);
+                return true;
+            };
+        }
+
+        std::vector<int> Numbers()
+        {
+            std::lock_guard<std::mutex> lock{ mMutex };
+            return mNumbers;
+        }
+
+    private:
+        std::mutex mMutex;
+        std::vector<int> mNumbers;
+    };
+
+    StagedExecutor<TestFrame>::Stage Work(std::chrono::milliseconds work)
+    {
+        return [work](TestFrame&) { std::this_thread::sleep_for(work); return true; };
+    }
+
+    StageOptions Queue(size_t capacity, StageOverflow overflow)
+    {
+        StageOptions options;
+        options.QueueCapacity = capacity;
+        options.Overflow = overflow;
+        return options;
+    }
+}
+
+    TEST_CLASS(StagedExecutorTests)
+    {
+    public:
+        TEST_METHOD(StagesOverlap)
+        {
+            Sink sink;
+            StagedExecutor<TestFrame> executor;
+            executor.AddStage("capture", Work(10ms));
+            executor.AddStage("compose", Work(10ms));
+            executor.AddStage("encode", sink.Stage(10ms));
+            executor.Start();
+
+            const auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < 30; ++i)
+            {
+                Assert::IsTrue(executor.Submit(TestFrame{ i }));
+            }
+            executor.Stop();
+            const auto elapsed = std::chrono::steady_clock::now() - start;
+
+            // in series 30 frames would take 900 ms, pipelined about 320 ms
+            Assert::IsTrue(elapsed < 700ms);
+            const std::vector<int> numbers = sink.Numbers();
+            Assert::AreEqual(static_cast<size_t>(30), numbers.size());
+            for (int i = 0; i < 30; ++i)
+            {
+                Assert::AreEqual(i, numbers[i]);
+            }
+
+            const auto stats = executor.Stats();
+            Assert::AreEqual(std::string{ "compose" }, stats[1].Name);
+            for (const StageStats& stage : stats)
+            {
+                Assert::AreEqual(static_cast<uint64_t>(30), stage.Processed);
+                Assert::AreEqual(static_cast<uint64_t>(0), stage.Dropped);
+                Assert::AreEqual(static_cast<size_t>(0), stage.Depth);
+                Assert::IsTrue(stage.PeakDepth <= 2);
+                Assert::IsTrue(stage.Busy >= 300ms);
+            }
+
+            const std::string message = "3 stages of 10 ms, 30 frames in " +
+                std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count()) + " ms";
+            Logger::WriteMessage(message.c_str());
+        }
+
+        TEST_METHOD(BlockHoldsTheProducerBack)
+        {
+            Sink sink;
+            StagedExecutor<TestFrame> executor;
+            executor.AddStage("encode", sink.Stage(2ms), Queue(1, StageOverflow::Block));
+            executor.Start();
+
+            for (int i = 0; i < 20; ++i)
+            {
+                Assert::IsTrue(executor.Submit(TestFrame{ i }));
+            }
+            executor.Stop();
+
+            const StageStats stats = executor.Stats()[0];
+            Assert::AreEqual(static_cast<size_t>(20), sink.Numbers().size());
+            Assert::AreEqual(static_cast<uint64_t>(0), stats.Dropped);
+            Assert::AreEqual(static_cast<size_t>(1), stats.PeakDepth);
+            Assert::IsTrue(stats.Blocked > 10ms);
+        }
+
+        TEST_METHOD(DropNewestKeepsTheFirstFrames)
+        {
+            Sink sink;
+            StagedExecutor<TestFrame> executor;
+            executor.AddStage("encode", sink.Stage(20ms), Queue(2, StageOverflow::DropNewest));
+            executor.Start();
+
+            int accepted = 0;
+            for (int i = 0; i < 50; ++i)
+            {
+                accepted += executor.Submit(TestFrame{ i }) ? 1 : 0;
+            }
+            executor.Stop();
+
+            const std::vector<int> numbers = sink.Numbers();
+            const StageStats stats = executor.Stats()[0];
+            Assert::AreEqual(static_cast<size_t>(accepted), numbers.size());
+            Assert::AreEqual(static_cast<uint64_t>(50 - accepted), stats.Dropped);
+            Assert::IsTrue(accepted < 50);
+            Assert::AreEqual(0, numbers.front());
+            Assert::AreNotEqual(49, numbers.back());
+        }
+
+        TEST_METHOD(DropOldestKeepsTheLatestFrame)
+        {
+            auto token = std::make_shared<int>(0);
+            Sink sink;
+            StagedExecutor<TestFrame> executor;
+            executor.AddStage("compose", Work(0ms));
+            executor.AddStage("encode", sink.Stage(20ms), Queue(2, StageOverflow::DropOldest));
+            executor.Start();
+
+            for (int i = 0; i < 50; ++i)
+            {
+                Assert::IsTrue(executor.Submit(TestFrame{ i, token }));
+            }
+            executor.Stop();
+
+            const std::vector<int> numbers = sink.Numbers();
+            const auto stats = executor.Stats();
+            Assert::AreEqual(49, numbers.back());
+            Assert::AreEqual(static_cast<uint64_t>(50), stats[0].Processed);
+            Assert::AreEqual(static_cast<uint64_t>(50), stats[1].Processed + stats[1].Dropped);
+            Assert::IsTrue(stats[1].Dropped > 0);
+            for (size_t i = 1; i < numbers.size(); ++i)
+            {
+                Assert::IsTrue(numbers[i - 1] < numbers[i]);
+            }
+
+            // nothing dropped or done is kept alive by the executor
+            Assert::AreEqual(1L, static_cast<long>(token.use_count()));
+        }
+
+        TEST_METHOD(RejectedFramesGoNoFurther)
+        {
+            Sink sink;
+            StagedExecutor<TestFrame> executor;
+            executor.AddStage("capture", [](TestFrame& frame) { return frame.Number % 2 == 0; });
+            executor.AddStage("encode", sink.Stage());
+            executor.Start();
+            for (int i = 0; i < 10; ++i)
+            {
+                executor.Submit(TestFrame{ i });
+            }
+            executor.Stop();
+
+            Assert::IsTrue(sink.Numbers() == std::vector<int>({ 0, 2, 4, 6, 8 }));
+            Assert::AreEqual(static_cast<uint64_t>(5), executor.Stats()[0].Rejected);
+            Assert::IsFalse(executor.Submit(TestFrame{ 10 }));
+        }
+
+        TEST_METHOD(RejectsMisuse)
+        {
+            StagedExecutor<TestFrame> executor;
+            Assert::ExpectException<std::logic_error>([&executor]() { executor.Start(); });
+            Assert::ExpectException<std::invalid_argument>([&executor]() { executor.AddStage("null", nullptr); });
+            Assert::ExpectException<std::invalid_argument>([&executor]() { executor.AddStage("empty", Work(0ms), Queue(0, StageOverflow::Block)); });
+            Assert::IsFalse(executor.Submit(TestFrame{ 0 }));
+
+            executor.AddStage("encode", Work(0ms));
+            executor.Start();
+            Assert::ExpectException<std::logic_error>([&executor]() { executor.AddStage("late", Work(0ms)); });
+        }
+    };
+}
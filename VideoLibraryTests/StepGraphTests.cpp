@@ -0,0 +1,313 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+#include "..\VideoLibrary\StepGraph.h"
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace VideoLibraryTests
+{
+namespace
+{
+    // Stands in for a frame's surface lock, alive while the token is held
+    struct Token
+    {
+        explicit Token(int& alive) : Alive{ alive } { ++Alive; }
+        ~Token() { --Alive; }
+        int& Alive;
+    };
+
+    const StepTiming& TimingOf(const std::vector<StepTiming>& timings, const std::string& name)
+    {
+        for (const StepTiming& timing : timings)
+        {
+            if (timing.Name == name)
+            {
+                return timing;
+            }
+        }
+
+        throw std::invalid_argument("no timing for " + name);
+    }
+
+    // capture -> draw -> encode, drawing only when the captured frame changed
+    struct FrameGraph
+    {
+        FrameGraph()
+        {
+            frame = graph.Port<int>("frame");
+            image = graph.Port<int>("image");
+            encoded = graph.Port<std::vector<int>>("encoded");
+            desktop = graph.Port<int>("desktop");
+
+            graph.AddStep("capture", { desktop }, { frame }, [this](StepContext& context)
+                {
+                    // an unchanged desktop leaves the frame alone
+                    if (context.Read(desktop) != lastDesktop)
+                    {
+                        lastDesktop = context.Read(desktop);
+                        context.Write(frame, lastDesktop);
+                    }
+                    return true;
+                });
+
+            graph.AddStep("draw", { frame }, { image }, [this](StepContext& context)
+                {
+                    ++draws;
+                    context.Write(image, context.Read(frame) * 10);
+                    return true;
+                }, StepOptions{ true });
+
+            graph.AddStep("encode", { image }, { encoded }, [this](StepContext& context)
+                {
+                    context.Write(encoded).push_back(context.Read(image));
+                    return true;
+                }, StepOptions{ true });
+        }
+
+        StepGraph graph;
+        StepPort<int> desktop;
+        StepPort<int> frame;
+        StepPort<int> image;
+        StepPort<std::vector<int>> encoded;
+        int lastDesktop = -1;
+        int draws = 0;
+    };
+}
+
+    TEST_CLASS(StepGraphTests)
+    {
+    public:
+        TEST_METHOD(StepsPassValuesInOrder)
+        {
+            FrameGraph frames;
+            frames.graph.Set(frames.desktop, 1);
+            Assert::IsTrue(frames.graph.Run());
+
+            Assert::AreEqual(1, frames.graph.Value(frames.frame));
+            Assert::AreEqual(10, frames.graph.Value(frames.image));
+            Assert::AreEqual(static_cast<size_t>(1), frames.graph.Value(frames.encoded).size());
+
+            const auto timings = frames.graph.Timings();
+            Assert::AreEqual(static_cast<size_t>(3), timings.size());
+            Assert::AreEqual(std::string{ "capture" }, timings[0].Name);
+            Assert::AreEqual(std::string{ "encode" }, timings[2].Name);
+            for (const StepTiming& timing : timings)
+            {
+                Assert::AreEqual(static_cast<uint64_t>(1), timing.Runs);
+                Assert::IsTrue(timing.Max >= timing.Last && timing.Total >= timing.Max);
+            }
+        }
+
+        TEST_METHOD(UnchangedInputsAreSkipped)
+        {
+            FrameGraph frames;
+            const int desktops[] = { 1, 1, 1, 2, 2, 3, 3, 3 };
+            for (int desktop : desktops)
+            {
+                frames.graph.Set(frames.desktop, desktop);
+                Assert::IsTrue(frames.graph.Run());
+            }
+
+            // the desktop port is set every run, so capture always runs
+            const auto timings = frames.graph.Timings();
+            Assert::AreEqual(static_cast<uint64_t>(8), TimingOf(timings, "capture").Runs);
+            Assert::AreEqual(static_cast<uint64_t>(3), TimingOf(timings, "draw").Runs);
+            Assert::AreEqual(static_cast<uint64_t>(5), TimingOf(timings, "draw").Skipped);
+            Assert::AreEqual(static_cast<uint64_t>(3), TimingOf(timings, "encode").Runs);
+            Assert::AreEqual(3, frames.draws);
+
+            const std::vector<int> expected = { 10, 20, 30 };
+            Assert::IsTrue(frames.graph.Value(frames.encoded) == expected);
+
+            // writing a port from outside runs its readers again
+            frames.graph.Set(frames.frame, 4);
+            Assert::IsTrue(frames.graph.RunFrom("draw"));
+            Assert::AreEqual(40, frames.graph.Value(frames.encoded).back());
+        }
+
+        TEST_METHOD(OptionalStepsAreInsertedBetweenOthers)
+        {
+            FrameGraph frames;
+
+            // scales the image in place, encode reads it without knowing
+            frames.graph.InsertBefore("encode", "scale", { frames.image }, { frames.image }, [&frames](StepContext& context)
+                {
+                    context.Write(frames.image) *= 2;
+                    return true;
+                }, StepOptions{ true });
+
+            auto overlays = frames.graph.Port<int>("overlays");
+            frames.graph.InsertAfter("draw", "count overlays", {}, { overlays }, [&frames, overlays](StepContext& context)
+                {
+                    ++context.Write(overlays);
+                    return true;
+                });
+
+            frames.graph.Set(frames.desktop, 1);
+            frames.graph.Run();
+            frames.graph.Set(frames.desktop, 1);
+            frames.graph.Run();
+            frames.graph.Set(frames.desktop, 2);
+            frames.graph.Run();
+
+            // the scaled image was not rescaled by the run that found no new frame
+            const std::vector<int> expected = { 20, 40 };
+            Assert::IsTrue(frames.graph.Value(frames.encoded) == expected);
+            Assert::AreEqual(3, frames.graph.Value(overlays));
+
+            const auto timings = frames.graph.Timings();
+            Assert::AreEqual(std::string{ "count overlays" }, timings[2].Name);
+            Assert::AreEqual(std::string{ "scale" }, timings[3].Name);
+            Assert::AreEqual(static_cast<uint64_t>(1), TimingOf(timings, "scale").Skipped);
+
+            frames.graph.RemoveStep("scale");
+            frames.graph.Set(frames.desktop, 3);
+            frames.graph.Run();
+            Assert::AreEqual(30, frames.graph.Value(frames.encoded).back());
+        }
+
+        TEST_METHOD(RunPortsDoNotOutliveTheRun)
+        {
+            int alive = 0;
+            bool surfaceBusy = false;
+            bool fail = false;
+            int drawn = 0;
+
+            StepGraph graph;
+            auto lock = graph.Port<std::shared_ptr<Token>>("lock", PortLifetime::Run);
+            graph.AddStep("lock", {}, { lock }, [&](StepContext& context)
+                {
+                    if (surfaceBusy)
+                    {
+                        return false;
+                    }
+
+                    context.Write(lock, std::make_shared<Token>(alive));
+                    return true;
+                });
+            graph.AddStep("draw", { lock }, {}, [&](StepContext& context)
+                {
+                    Assert::AreEqual(1, alive);
+                    Assert::IsTrue(context.Read(lock) != nullptr);
+                    if (fail)
+                    {
+                        throw std::runtime_error("device removed");
+                    }
+                    ++drawn;
+                    return true;
+                });
+
+            Assert::IsTrue(graph.Run());
+            Assert::AreEqual(0, alive);
+            Assert::IsTrue(graph.Value(lock) == nullptr);
+
+            surfaceBusy = true;
+            Assert::IsFalse(graph.Run());
+            Assert::AreEqual(static_cast<uint64_t>(1), graph.Timings()[0].Stopped);
+            Assert::AreEqual(1, drawn);
+
+            surfaceBusy = false;
+            fail = true;
+            auto run = [&graph]() { graph.Run(); };
+            Assert::ExpectException<std::runtime_error>(run);
+            Assert::AreEqual(0, alive);
+
+            fail = false;
+            Assert::IsTrue(graph.Run());
+            Assert::AreEqual(2, drawn);
+            Assert::AreEqual(0, alive);
+        }
+
+        TEST_METHOD(RejectsMisuse)
+        {
+            StepGraph graph;
+            auto frame = graph.Port<int>("frame");
+            auto image = graph.Port<int>("image");
+
+            auto wrongType = [&graph]() { graph.Port<double>("frame"); };
+            Assert::ExpectException<std::logic_error>(wrongType);
+            Assert::AreEqual(frame.Index, graph.Port<int>("frame").Index);
+
+            graph.AddStep("capture", {}, { frame }, [&](StepContext& context) { context.Write(frame, 1); return true; });
+
+            // image is written later, reading it first would see the last frame's
+            auto readsEarly = [&]() { graph.InsertBefore("capture", "early", { image }, {}, [](StepContext&) { return true; }); };
+            graph.AddStep("draw", { frame }, { image }, [&](StepContext& context) { context.Write(image, context.Read(frame)); return true; });
+            Assert::ExpectException<std::logic_error>(readsEarly);
+            Assert::IsFalse(graph.HasStep("early"));
+
+            auto duplicate = [&]() { graph.AddStep("draw", {}, {}, [](StepContext&) { return true; }); };
+            Assert::ExpectException<std::invalid_argument>(duplicate);
+            auto nullStep = [&]() { graph.AddStep("null", {}, {}, nullptr); };
+            Assert::ExpectException<std::invalid_argument>(nullStep);
+            auto unknownStep = [&]() { graph.RunFrom("encode"); };
+            Assert::ExpectException<std::invalid_argument>(unknownStep);
+            auto unknownPort = [&]() { graph.AddStep("encode", { StepPort<int>{} }, {}, [](StepContext&) { return true; }); };
+            Assert::ExpectException<std::invalid_argument>(unknownPort);
+
+            // steps only touch the ports they declared
+            graph.AddStep("sneaky", { image }, {}, [&](StepContext& context) { context.Write(frame, 2); return true; });
+            auto run = [&graph]() { graph.Run(); };
+            Assert::ExpectException<std::logic_error>(run);
+            Assert::AreEqual(1, graph.Value(frame));
+        }
+
+        TEST_METHOD(StepGraphOverheadBenchmark)
+        {
+            StepGraph graph;
+            std::vector<StepPort<int>> ports;
+            for (int i = 0; i < 8; ++i)
+            {
+                ports.push_back(graph.Port<int>("port " + std::to_string(i)));
+            }
+
+            graph.AddStep("step 0", {}, { ports[0] }, [&ports](StepContext& context) { ++context.Write(ports[0]); return true; });
+            for (size_t i = 1; i < ports.size(); ++i)
+            {
+                graph.AddStep("step " + std::to_string(i), { ports[i - 1] }, { ports[i] }, [&ports, i](StepContext& context)
+                    {
+                        context.Write(ports[i], context.Read(ports[i - 1]) + 1);
+                        return true;
+                    }, StepOptions{ true });
+            }
+
+            const int iterations = 100000;
+            const auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < iterations; ++i)
+            {
+                graph.Run();
+            }
+            const auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            Assert::AreEqual(iterations + 7, graph.Value(ports.back()));
+
+            const std::string message = std::to_string(ports.size()) + " steps: " +
+                std::to_string(elapsed / iterations / ports.size()) + " ns per timed step";
+            Logger::WriteMessage(message.c_str());
+        }
+    };
+}
@@ -0,0 +1,160 @@
+/*
+    Copyright (C) 2022 by Julio Gutierrez (desktoprecorderapp@gmail.com)
+
+    This file is part of DesktopRecorderLibrary.
+
+    DesktopRecorderLibrary is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by the
+    Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    DesktopRecorderLibrary is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DesktopRecorderLibrary. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+#include "..\VideoLibrary\ViewCache.h"
+#include "..\VideoLibrary\BoundedPool.h"
+#include <memory>
+#include <vector>
+
+namespace VideoLibraryTests
+{
+namespace
+{
+    struct FakeView : TextureView
+    {
+        FakeView(void* texture, ViewKind kind) : Texture{ texture }, Kind{ kind } {}
+
+        void* Texture;
+        ViewKind Kind;
+    };
+
+    // Counts the views it creates
+    class CountingViewDevice : public ViewDevice
+    {
+    public:
+        virtual std::shared_ptr<TextureView> CreateView(void* texture, ViewKind kind) override
+        {
+            ++Created;
+            return std::make_shared<FakeView>(texture, kind);
+        }
+
+        uint64_t Created = 0;
+    };
+
+    // Stands in for a texture pool entry
+    struct FakeEntry
+    {
+        int Texture;
+        TextureViews Views;
+    };
+
+    const FakeView& AsFake(const TextureView& view)
+    {
+        return static_cast<const FakeView&>(view);
+    }
+}
+
+    TEST_CLASS(ViewCacheTests)
+    {
+    public:
+        TEST_METHOD(TextureViewsAreCreatedOncePerKind)
+        {
+            CountingViewDevice device;
+            int texture = 0;
+            TextureViews views;
+
+            const TextureView& rtv = views.Get(device, &texture, ViewKind::RenderTarget);
+            Assert::IsTrue(&rtv == &views.Get(device, &texture, ViewKind::RenderTarget));
+            Assert::AreEqual(static_cast<uint64_t>(1), device.Created);
+
+            const TextureView& srv = views.Get(device, &texture, ViewKind::ShaderResource);
+            Assert::IsTrue(ViewKind::ShaderResource == AsFake(srv).Kind);
+            Assert::IsTrue(&texture == AsFake(srv).Texture);
+            Assert::AreEqual(static_cast<uint64_t>(2), device.Created);
+            Assert::AreEqual(static_cast<uint64_t>(2), views.Created());
+        }
+
+        TEST_METHOD(CacheKeysOnTextureAndKind)
+        {
+            auto device = std::make_shared<CountingViewDevice>();
+            ViewCache cache{ device, 2 };
+            int first = 0, second = 0, third = 0;
+
+            const TextureView& view = cache.View(&first, ViewKind::ShaderResource);
+            Assert::IsTrue(&view == &cache.View(&first, ViewKind::ShaderResource));
+            Assert::IsTrue(&view != &cache.View(&first, ViewKind::RenderTarget));
+            Assert::AreEqual(static_cast<uint64_t>(2), device->Created);
+
+            // the least recently used view goes when another texture shows up
+            cache.View(&first, ViewKind::ShaderResource);
+            cache.View(&second, ViewKind::ShaderResource);
+            cache.View(&first, ViewKind::ShaderResource);
+            Assert::AreEqual(static_cast<uint64_t>(3), device->Created);
+            cache.View(&third, ViewKind::ShaderResource);
+            Assert::AreEqual(static_cast<uint64_t>(4), device->Created);
+            Assert::IsTrue(&first == AsFake(cache.View(&first, ViewKind::ShaderResource)).Texture);
+            Assert::AreEqual(static_cast<uint64_t>(4), device->Created);
+            Assert::AreEqual(device->Created, cache.Created());
+
+            Assert::ExpectException<std::invalid_argument>([]() { ViewCache nullDevice{ nullptr }; });
+        }
+
+        TEST_METHOD(SteadyStateCreatesNoViews)
+        {
+            // pooled output textures and the few desktop images duplication cycles through
+            CountingViewDevice entryDevice;
+            int created = 0;
+            BoundedPoolOptions options;
+            options.LowWatermark = 2;
+            options.HighWatermark = 4;
+            BoundedPool<std::shared_ptr<FakeEntry>> pool{
+                [&created]() { auto entry = std::make_shared<FakeEntry>(); entry->Texture = created++; return entry; },
+                options };
+
+            auto desktopDevice = std::make_shared<CountingViewDevice>();
+            ViewCache desktopViews{ desktopDevice };
+            int desktopImages[3] = {};
+            int pointer = 0;
+
+            uint64_t warmCreated = 0;
+            std::vector<std::shared_ptr<FakeEntry>> encoding;
+            for (int frame = 0; frame < 1000; ++frame)
+            {
+                desktopViews.View(&desktopImages[frame % 3], ViewKind::ShaderResource);
+
+                std::shared_ptr<FakeEntry> entry;
+                Assert::IsTrue(pool.Acquire(entry));
+                entry->Views.Get(entryDevice, &entry->Texture, ViewKind::RenderTarget);
+                desktopViews.View(&pointer, ViewKind::ShaderResource);
+
+                // the encoder gives textures back two frames later
+                encoding.push_back(entry);
+                if (encoding.size() > 2)
+                {
+                    pool.Release(encoding.front());
+                    encoding.erase(encoding.begin());
+                }
+
+                if (frame == 9)
+                {
+                    warmCreated = entryDevice.Created + desktopDevice->Created;
+                }
+            }
+
+            Assert::AreEqual(static_cast<uint64_t>(3), entryDevice.Created);
+            Assert::AreEqual(static_cast<uint64_t>(4), desktopDevice->Created);
+            Assert::AreEqual(warmCreated, entryDevice.Created + desktopDevice->Created);
+        }
+    };
+}